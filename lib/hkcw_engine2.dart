@@ -1,10 +1,15 @@
 import 'dart:async';
+import 'dart:typed_data';
 import 'package:flutter/services.dart';
 
 class HkcwEngine2 {
   static const MethodChannel _channel = MethodChannel('hkcw_engine2');
 
-  /// Initialize WebView2 as desktop wallpaper
+  /// Initialize WebView2 as desktop wallpaper.
+  ///
+  /// Static wallpapers can skip the browser entirely with a native
+  /// descriptor: `hkcw-color:#1e90ff`, `hkcw-gradient:#000000,#1e90ff,135`,
+  /// `hkcw-image:C:/path/photo.jpg?fit=cover` or a `file:///` image URL.
   static Future<bool> initializeWallpaper({
     required String url,
     bool enableMouseTransparent = true,
@@ -44,5 +49,239 @@ class HkcwEngine2 {
       return false;
     }
   }
-}
 
+  /// Load a URL rule file (one pattern per line, "@@" prefix = whitelist).
+  /// The file is compiled to a cached snapshot and reloaded when it changes.
+  static Future<bool> loadUrlRules(String path) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('loadUrlRules', {
+        'path': path,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error loading URL rules: $e');
+      return false;
+    }
+  }
+
+  /// Load an EasyList-style filter list for subresource blocking
+  static Future<bool> loadFilterList(String path) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('loadFilterList', {
+        'path': path,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error loading filter list: $e');
+      return false;
+    }
+  }
+
+  /// Remove all loaded filter rules
+  static Future<bool> clearFilterLists() async {
+    try {
+      final result = await _channel.invokeMethod<bool>('clearFilterLists');
+      return result ?? false;
+    } catch (e) {
+      print('Error clearing filter lists: $e');
+      return false;
+    }
+  }
+
+  /// Filter statistics: rule count, checked/blocked totals, per-rule hits
+  static Future<Map<String, dynamic>> getFilterStats() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getFilterStats');
+      return result ?? {};
+    } catch (e) {
+      print('Error getting filter stats: $e');
+      return {};
+    }
+  }
+
+  /// Web message counters: received, dispatched, coalesced and dropped
+  /// (rateLimited, queueFull, tooLarge), in total and per message type, plus
+  /// the number of SDK batches received (batchesCopied: those whose messages
+  /// had to be copied because no batch buffer was free)
+  static Future<Map<String, dynamic>> getMessageStats() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getMessageStats');
+      return result ?? {};
+    } catch (e) {
+      print('Error getting message stats: $e');
+      return {};
+    }
+  }
+
+  /// Native-to-page script counters and round-trip latency (avg/p95/max ms)
+  static Future<Map<String, dynamic>> getScriptStats() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getScriptStats');
+      return result ?? {};
+    } catch (e) {
+      print('Error getting script stats: $e');
+      return {};
+    }
+  }
+
+  /// Re-attaches after explorer.exe restarts: counts, reloads and the time
+  /// from noticing the loss to showing the wallpaper again (last/max ms)
+  static Future<Map<String, dynamic>> getShellStats() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getShellStats');
+      return result ?? {};
+    } catch (e) {
+      print('Error getting shell stats: $e');
+      return {};
+    }
+  }
+
+  /// Native wallpaper (`hkcw-color:`, `hkcw-gradient:`, `hkcw-image:`) shown
+  /// when the page keeps crashing; black by default
+  static Future<bool> setCrashFallback(String fallback) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('setCrashFallback', {
+        'url': fallback,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error setting crash fallback: $e');
+      return false;
+    }
+  }
+
+  /// WebView2 process failures and how the page came back: reloads,
+  /// controller rebuilds, static fallbacks and crash-to-restored time (ms).
+  /// A rebuild reopens the feeds and audio spectrum enabled from Dart;
+  /// `feedsRestored` / `feedsLost` count how that went
+  static Future<Map<String, dynamic>> getRecoveryStats() async {
+    try {
+      final result = await _channel.invokeMapMethod<String, dynamic>('getRecoveryStats');
+      return result ?? {};
+    } catch (e) {
+      print('Error getting recovery stats: $e');
+      return {};
+    }
+  }
+
+  /// Open a shared-memory feed the page reads with `HKCW.readFeed(name)` or
+  /// `HKCW.onFeedFrame(name, cb)`; frames up to [slotSize] bytes, the page may
+  /// lag up to [slotCount] - 1 frames
+  static Future<bool> openFeed(
+    String name, {
+    int slotSize = 65536,
+    int slotCount = 3,
+  }) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('openFeed', {
+        'name': name,
+        'slotSize': slotSize,
+        'slotCount': slotCount,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error opening feed: $e');
+      return false;
+    }
+  }
+
+  /// Publish one frame to an open feed (no JSON, no script on the page side)
+  static Future<bool> publishFeedFrame(String name, Uint8List data, {int tag = 0}) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('publishFeedFrame', {
+        'name': name,
+        'data': data,
+        'tag': tag,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error publishing feed frame: $e');
+      return false;
+    }
+  }
+
+  static Future<bool> closeFeed(String name) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('closeFeed', {'name': name});
+      return result ?? false;
+    } catch (e) {
+      print('Error closing feed: $e');
+      return false;
+    }
+  }
+
+  /// Stream a spectrum of the system audio output to the page
+  ///
+  /// [bands] log-spaced levels (1..256) are published ~60 times per second
+  /// to the "audio" feed; pages read them with HKCW.onAudioSpectrum.
+  static Future<bool> enableAudioSpectrum(bool enabled, {int bands = 64}) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('enableAudioSpectrum', {
+        'enabled': enabled,
+        'bands': bands,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error setting audio spectrum: $e');
+      return false;
+    }
+  }
+
+  /// Forward hotkeys pressed while the desktop has focus to the page
+  ///
+  /// Off by default. Pages choose their keys with HKCW.onKeyboard; repeats
+  /// are coalesced and delivered once per frame.
+  static Future<bool> enableKeyboardForwarding(bool enabled) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('enableKeyboardForwarding', {
+        'enabled': enabled,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error setting keyboard forwarding: $e');
+      return false;
+    }
+  }
+
+  /// Where desktop mouse input comes from while interaction is enabled
+  ///
+  /// [source] is 'hook' (default, low-level mouse hook), 'rawinput' (no
+  /// hook, nothing waits on the plugin) or 'replay', which plays the trace
+  /// at [tracePath] at [speed] times its recorded pace (0 = immediately).
+  static Future<bool> setInputSource(
+    String source, {
+    String? tracePath,
+    double speed = 1.0,
+  }) async {
+    try {
+      final result = await _channel.invokeMethod<bool>('setInputSource', {
+        'source': source,
+        if (tracePath != null) 'path': tracePath,
+        'speed': speed,
+      });
+      return result ?? false;
+    } catch (e) {
+      print('Error setting input source: $e');
+      return false;
+    }
+  }
+
+  /// PNG thumbnail of the running wallpaper, at most [maxWidth] x [maxHeight]
+  ///
+  /// Repeated calls for the same page are served from a cache; live pages
+  /// are re-captured at most once per second.
+  static Future<Uint8List?> capturePreview({
+    int maxWidth = 320,
+    int maxHeight = 180,
+  }) async {
+    try {
+      return await _channel.invokeMethod<Uint8List>('capturePreview', {
+        'maxWidth': maxWidth,
+        'maxHeight': maxHeight,
+      });
+    } catch (e) {
+      print('Error capturing preview: $e');
+      return null;
+    }
+  }
+}
@@ -0,0 +1,186 @@
+#include "audio_capture.h"
+
+#ifdef _WIN32
+
+#include <windows.h>
+#include <audioclient.h>
+#include <mmdeviceapi.h>
+#include <mmreg.h>
+#include <ks.h>
+#include <ksmedia.h>
+#include <wrl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// Polling period; loopback streams cannot use event callbacks everywhere
+const DWORD kPollMs = 10;
+const REFERENCE_TIME kBufferDuration = 2000000;  // 200 ms in 100 ns units
+const DWORD kReopenDelayMs = 1000;
+
+enum class SampleFormat { kUnsupported, kFloat32, kInt16, kInt32 };
+
+SampleFormat GetSampleFormat(const WAVEFORMATEX* format) {
+  WORD tag = format->wFormatTag;
+  if (tag == WAVE_FORMAT_EXTENSIBLE) {
+    const auto* extensible = reinterpret_cast<const WAVEFORMATEXTENSIBLE*>(format);
+    if (extensible->SubFormat == KSDATAFORMAT_SUBTYPE_IEEE_FLOAT) tag = WAVE_FORMAT_IEEE_FLOAT;
+    else if (extensible->SubFormat == KSDATAFORMAT_SUBTYPE_PCM) tag = WAVE_FORMAT_PCM;
+  }
+  if (tag == WAVE_FORMAT_IEEE_FLOAT && format->wBitsPerSample == 32) return SampleFormat::kFloat32;
+  if (tag == WAVE_FORMAT_PCM && format->wBitsPerSample == 16) return SampleFormat::kInt16;
+  if (tag == WAVE_FORMAT_PCM && format->wBitsPerSample == 32) return SampleFormat::kInt32;
+  return SampleFormat::kUnsupported;
+}
+
+class LoopbackCapture : public AudioCaptureSource {
+ public:
+  LoopbackCapture() : stop_event_(CreateEventW(nullptr, TRUE, FALSE, nullptr)) {}
+
+  ~LoopbackCapture() override {
+    Stop();
+    if (stop_event_) CloseHandle(stop_event_);
+  }
+
+  bool Start(DataCallback on_data) override {
+    if (thread_.joinable() || !stop_event_) return false;
+    on_data_ = std::move(on_data);
+    ResetEvent(stop_event_);
+    thread_ = std::thread(&LoopbackCapture::Run, this);
+    return true;
+  }
+
+  void Stop() override {
+    if (!thread_.joinable()) return;
+    SetEvent(stop_event_);
+    thread_.join();
+  }
+
+ private:
+  void Run() {
+    CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    while (WaitForSingleObject(stop_event_, 0) == WAIT_TIMEOUT) {
+      // Returns on stop, device loss or a default-device switch
+      if (!RunSession()) {
+        WaitForSingleObject(stop_event_, kReopenDelayMs);
+      }
+    }
+    CoUninitialize();
+  }
+
+  bool RunSession() {
+    using Microsoft::WRL::ComPtr;
+
+    ComPtr<IMMDeviceEnumerator> enumerator;
+    ComPtr<IMMDevice> device;
+    ComPtr<IAudioClient> client;
+    ComPtr<IAudioCaptureClient> capture;
+    if (FAILED(CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                                IID_PPV_ARGS(&enumerator))) ||
+        FAILED(enumerator->GetDefaultAudioEndpoint(eRender, eConsole, &device)) ||
+        FAILED(device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+                                reinterpret_cast<void**>(client.GetAddressOf())))) {
+      std::cout << "[HKCW] [Audio] No render device to capture" << std::endl;
+      return false;
+    }
+
+    WAVEFORMATEX* format = nullptr;
+    if (FAILED(client->GetMixFormat(&format))) return false;
+    SampleFormat sample_format = GetSampleFormat(format);
+    uint32_t channels = format->nChannels;
+    uint32_t sample_rate = format->nSamplesPerSec;
+
+    HRESULT hr = sample_format == SampleFormat::kUnsupported
+        ? E_NOTIMPL
+        : client->Initialize(AUDCLNT_SHAREMODE_SHARED, AUDCLNT_STREAMFLAGS_LOOPBACK,
+                             kBufferDuration, 0, format, nullptr);
+    CoTaskMemFree(format);
+    if (FAILED(hr) || FAILED(client->GetService(IID_PPV_ARGS(&capture))) ||
+        FAILED(client->Start())) {
+      std::cout << "[HKCW] [Audio] Failed to open loopback stream: " << std::hex << hr << std::dec
+                << std::endl;
+      return false;
+    }
+
+    std::cout << "[HKCW] [Audio] Loopback capture: " << sample_rate << " Hz, " << channels
+              << " channel(s)" << std::endl;
+
+    auto last_data = std::chrono::steady_clock::now();
+    bool ok = true;
+    while (ok && WaitForSingleObject(stop_event_, kPollMs) == WAIT_TIMEOUT) {
+      UINT32 packet = 0;
+      hr = capture->GetNextPacketSize(&packet);
+      while (SUCCEEDED(hr) && packet > 0) {
+        BYTE* data = nullptr;
+        UINT32 frames = 0;
+        DWORD flags = 0;
+        hr = capture->GetBuffer(&data, &frames, &flags, nullptr, nullptr);
+        if (FAILED(hr)) break;
+
+        Deliver(data, frames, channels, sample_rate, sample_format,
+                (flags & AUDCLNT_BUFFERFLAGS_SILENT) != 0);
+        capture->ReleaseBuffer(frames);
+        last_data = std::chrono::steady_clock::now();
+        hr = capture->GetNextPacketSize(&packet);
+      }
+      ok = SUCCEEDED(hr);  // AUDCLNT_E_DEVICE_INVALIDATED after a switch
+
+      // Loopback delivers nothing while the device is idle; keep the
+      // consumer's clock running with silence
+      auto now = std::chrono::steady_clock::now();
+      auto idle = std::chrono::duration_cast<std::chrono::milliseconds>(now - last_data);
+      if (ok && idle.count() >= 2 * static_cast<long long>(kPollMs)) {
+        uint32_t frames = static_cast<uint32_t>(idle.count() * sample_rate / 1000);
+        Deliver(nullptr, frames, channels, sample_rate, sample_format, true);
+        last_data = now;
+      }
+    }
+
+    client->Stop();
+    return ok;
+  }
+
+  void Deliver(const BYTE* data, uint32_t frames, uint32_t channels, uint32_t sample_rate,
+               SampleFormat format, bool silent) {
+    size_t samples = static_cast<size_t>(frames) * channels;
+    if (samples == 0) return;
+
+    const float* pcm = reinterpret_cast<const float*>(data);
+    if (silent || format != SampleFormat::kFloat32) {
+      scratch_.resize(samples);
+      if (silent) {
+        std::fill(scratch_.begin(), scratch_.end(), 0.0f);
+      } else if (format == SampleFormat::kInt16) {
+        const auto* in = reinterpret_cast<const int16_t*>(data);
+        for (size_t i = 0; i < samples; i++) scratch_[i] = in[i] * (1.0f / 32768.0f);
+      } else {
+        const auto* in = reinterpret_cast<const int32_t*>(data);
+        for (size_t i = 0; i < samples; i++) scratch_[i] = static_cast<float>(in[i]) * (1.0f / 2147483648.0f);
+      }
+      pcm = scratch_.data();
+    }
+    on_data_(pcm, frames, channels, sample_rate);
+  }
+
+  HANDLE stop_event_;
+  std::thread thread_;
+  DataCallback on_data_;
+  std::vector<float> scratch_;
+};
+
+}  // namespace
+
+std::unique_ptr<AudioCaptureSource> CreateLoopbackCapture() {
+  return std::make_unique<LoopbackCapture>();
+}
+
+}  // namespace hkcw_engine2
+
+#endif  // _WIN32
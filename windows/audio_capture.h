@@ -0,0 +1,34 @@
+#ifndef FLUTTER_PLUGIN_AUDIO_CAPTURE_H_
+#define FLUTTER_PLUGIN_AUDIO_CAPTURE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+namespace hkcw_engine2 {
+
+// Audio Capture: a source of interleaved float PCM, delivered on the
+// source's own thread. While nothing is playing, sources deliver silence
+// so consumers keep their frame clock running.
+class AudioCaptureSource {
+ public:
+  using DataCallback = std::function<void(const float* interleaved, size_t frames,
+                                          uint32_t channels, uint32_t sample_rate)>;
+
+  virtual ~AudioCaptureSource() = default;
+
+  virtual bool Start(DataCallback on_data) = 0;
+  // Joins the capture thread; no callback runs after Stop returns
+  virtual void Stop() = 0;
+};
+
+#ifdef _WIN32
+// WASAPI loopback of the default render device (what the user hears).
+// Reopens the stream (after a short delay) when the device goes away.
+std::unique_ptr<AudioCaptureSource> CreateLoopbackCapture();
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_AUDIO_CAPTURE_H_
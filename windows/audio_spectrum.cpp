@@ -0,0 +1,203 @@
+#include "audio_spectrum.h"
+
+#include "simd_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+size_t Log2(size_t value) {
+  size_t bits = 0;
+  while ((size_t{1} << bits) < value) bits++;
+  return bits;
+}
+
+}  // namespace
+
+Fft::Fft(size_t size) : size_(size) {
+  size_t bits = Log2(size_);
+  reverse_.resize(size_);
+  for (size_t i = 0; i < size_; i++) {
+    uint32_t reversed = 0;
+    for (size_t bit = 0; bit < bits; bit++) {
+      if (i & (size_t{1} << bit)) reversed |= 1u << (bits - 1 - bit);
+    }
+    reverse_[i] = reversed;
+  }
+
+  twiddle_re_.resize(size_ - 1);
+  twiddle_im_.resize(size_ - 1);
+  for (size_t half = 1; half < size_; half <<= 1) {
+    for (size_t k = 0; k < half; k++) {
+      double angle = -kPi * static_cast<double>(k) / static_cast<double>(half);
+      twiddle_re_[half - 1 + k] = static_cast<float>(std::cos(angle));
+      twiddle_im_[half - 1 + k] = static_cast<float>(std::sin(angle));
+    }
+  }
+}
+
+void Fft::Forward(float* re, float* im) const {
+  for (size_t i = 0; i < size_; i++) {
+    size_t j = reverse_[i];
+    if (i < j) {
+      std::swap(re[i], re[j]);
+      std::swap(im[i], im[j]);
+    }
+  }
+
+  for (size_t half = 1; half < size_; half <<= 1) {
+    const float* wr = twiddle_re_.data() + half - 1;
+    const float* wi = twiddle_im_.data() + half - 1;
+
+    for (size_t start = 0; start < size_; start += 2 * half) {
+      float* ar = re + start;
+      float* ai = im + start;
+      float* br = ar + half;
+      float* bi = ai + half;
+      size_t k = 0;
+#if HKCW_HAS_SSE2
+      for (; k + 4 <= half; k += 4) {
+        __m128 xr = _mm_loadu_ps(br + k);
+        __m128 xi = _mm_loadu_ps(bi + k);
+        __m128 cr = _mm_loadu_ps(wr + k);
+        __m128 ci = _mm_loadu_ps(wi + k);
+        __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+        __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+        __m128 yr = _mm_loadu_ps(ar + k);
+        __m128 yi = _mm_loadu_ps(ai + k);
+        _mm_storeu_ps(br + k, _mm_sub_ps(yr, tr));
+        _mm_storeu_ps(bi + k, _mm_sub_ps(yi, ti));
+        _mm_storeu_ps(ar + k, _mm_add_ps(yr, tr));
+        _mm_storeu_ps(ai + k, _mm_add_ps(yi, ti));
+      }
+#endif
+      for (; k < half; k++) {
+        float tr = br[k] * wr[k] - bi[k] * wi[k];
+        float ti = br[k] * wi[k] + bi[k] * wr[k];
+        br[k] = ar[k] - tr;
+        bi[k] = ai[k] - ti;
+        ar[k] += tr;
+        ai[k] += ti;
+      }
+    }
+  }
+}
+
+SpectrumAnalyzer::SpectrumAnalyzer(Options options)
+    : options_(options), fft_(size_t{1} << Log2((std::max)(options.fft_size, size_t{64}))) {
+  options_.fft_size = fft_.size();
+  options_.band_count = (std::max)(options_.band_count, size_t{1});
+  size_t n = options_.fft_size;
+
+  // Periodic Hann; its coherent gain is 1/2, so 4/n makes a full-scale
+  // sine on a bin centre come out at magnitude 1
+  window_.resize(n);
+  for (size_t i = 0; i < n; i++) {
+    double hann = 0.5 * (1.0 - std::cos(2.0 * kPi * static_cast<double>(i) / static_cast<double>(n)));
+    window_[i] = static_cast<float>(hann * 4.0 / static_cast<double>(n));
+  }
+
+  history_.assign(n, 0.0f);
+  re_.resize(n);
+  im_.resize(n);
+  frame_.bands.assign(options_.band_count, 0.0f);
+}
+
+void SpectrumAnalyzer::Configure(uint32_t sample_rate) {
+  sample_rate_ = sample_rate;
+  hop_ = (std::max)(size_t{1}, static_cast<size_t>(std::lround(static_cast<double>(sample_rate) / options_.frame_rate)));
+
+  size_t n = options_.fft_size;
+  double bin_hz = static_cast<double>(sample_rate) / static_cast<double>(n);
+  double nyquist = sample_rate / 2.0;
+  double low = (std::min)(static_cast<double>(options_.min_frequency), nyquist / 2);
+  double high = (std::min)(static_cast<double>(options_.max_frequency), nyquist);
+  high = (std::max)(high, low * 2);
+
+  size_t bands = options_.band_count;
+  band_low_.resize(bands);
+  band_high_.resize(bands);
+  for (size_t b = 0; b < bands; b++) {
+    double from = low * std::pow(high / low, static_cast<double>(b) / static_cast<double>(bands));
+    double to = low * std::pow(high / low, static_cast<double>(b + 1) / static_cast<double>(bands));
+    size_t first = (std::min)(static_cast<size_t>(from / bin_hz + 0.5), n / 2 - 1);
+    size_t last = (std::min)(static_cast<size_t>(to / bin_hz + 0.5), n / 2);
+    band_low_[b] = static_cast<uint32_t>((std::max)(first, size_t{1}));
+    band_high_[b] = static_cast<uint32_t>((std::max)(last, band_low_[b] + size_t{1}));
+  }
+}
+
+void SpectrumAnalyzer::Reset() {
+  std::fill(history_.begin(), history_.end(), 0.0f);
+  std::fill(frame_.bands.begin(), frame_.bands.end(), 0.0f);
+  history_pos_ = 0;
+  since_frame_ = 0;
+  energy_ = 0.0;
+  peak_ = 0.0f;
+}
+
+void SpectrumAnalyzer::Push(const float* interleaved, size_t frames, uint32_t channels,
+                            uint32_t sample_rate, const FrameCallback& on_frame) {
+  if (channels == 0 || sample_rate == 0) return;
+  if (sample_rate != sample_rate_) Configure(sample_rate);
+
+  size_t n = options_.fft_size;
+  float mix = 1.0f / static_cast<float>(channels);
+  for (size_t f = 0; f < frames; f++) {
+    const float* sample = interleaved + f * channels;
+    float mono = sample[0];
+    for (uint32_t c = 1; c < channels; c++) mono += sample[c];
+    mono *= mix;
+
+    history_[history_pos_] = mono;
+    history_pos_ = history_pos_ + 1 == n ? 0 : history_pos_ + 1;
+    energy_ += static_cast<double>(mono) * mono;
+    peak_ = (std::max)(peak_, std::fabs(mono));
+
+    if (++since_frame_ >= hop_) {
+      Analyze();
+      if (on_frame) on_frame(frame_);
+    }
+  }
+}
+
+void SpectrumAnalyzer::Analyze() {
+  if (sample_rate_ == 0) Configure(48000);
+  size_t n = options_.fft_size;
+
+  // Oldest sample first: the ring from history_pos_ wraps once
+  size_t tail = n - history_pos_;
+  for (size_t i = 0; i < tail; i++) re_[i] = history_[history_pos_ + i] * window_[i];
+  for (size_t i = tail; i < n; i++) re_[i] = history_[i - tail] * window_[i];
+  std::fill(im_.begin(), im_.end(), 0.0f);
+
+  fft_.Forward(re_.data(), im_.data());
+
+  float range = -options_.floor_db;
+  for (size_t b = 0; b < frame_.bands.size(); b++) {
+    float power = 0.0f;
+    for (uint32_t bin = band_low_[b]; bin < band_high_[b]; bin++) {
+      power += re_[bin] * re_[bin] + im_[bin] * im_[bin];
+    }
+    power /= static_cast<float>(band_high_[b] - band_low_[b]);
+
+    float db = 10.0f * std::log10(power + 1e-12f);
+    float level = (std::min)(1.0f, (std::max)(0.0f, (db - options_.floor_db) / range));
+    frame_.bands[b] = (std::max)(level, frame_.bands[b] * options_.release);
+  }
+
+  frame_.rms = since_frame_ > 0 ? static_cast<float>(std::sqrt(energy_ / static_cast<double>(since_frame_))) : 0.0f;
+  frame_.peak = peak_;
+  frame_.index++;
+  since_frame_ = 0;
+  energy_ = 0.0;
+  peak_ = 0.0f;
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,99 @@
+#ifndef FLUTTER_PLUGIN_AUDIO_SPECTRUM_H_
+#define FLUTTER_PLUGIN_AUDIO_SPECTRUM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Audio Spectrum: radix-2 complex FFT on split real/imaginary arrays.
+// Butterflies of stages with four or more twiddles run four at a time
+// with SSE; twiddles and the bit-reversal table are built once.
+class Fft {
+ public:
+  explicit Fft(size_t size);  // Power of two, >= 4
+
+  // In place, natural order in and out
+  void Forward(float* re, float* im) const;
+
+  size_t size() const { return size_; }
+
+ private:
+  size_t size_;
+  std::vector<uint32_t> reverse_;
+  // Stage with half-size h uses cos/sin at offset h - 1
+  std::vector<float> twiddle_re_;
+  std::vector<float> twiddle_im_;
+};
+
+struct SpectrumFrame {
+  std::vector<float> bands;  // 0..1, log-spaced from low to high frequency
+  float rms = 0.0f;          // Of the samples since the previous frame
+  float peak = 0.0f;
+  uint64_t index = 0;
+};
+
+// Audio Spectrum: PCM in, band levels out at a fixed frame rate.
+//
+// Interleaved samples are mixed to mono into a sliding window. Every
+// sample_rate / frame_rate samples the window is Hann-weighted and
+// transformed, bin power is averaged into log-spaced bands, converted to
+// dB and mapped to 0..1 with instant attack and exponential release.
+// Frames are paced by sample count, not wall time, so synthetic input
+// gives the same frames as live capture.
+class SpectrumAnalyzer {
+ public:
+  struct Options {
+    size_t fft_size = 1024;
+    size_t band_count = 64;
+    float min_frequency = 30.0f;
+    float max_frequency = 16000.0f;
+    float frame_rate = 60.0f;
+    float floor_db = -70.0f;  // Maps to 0; full-scale sine maps to 1
+    float release = 0.85f;    // Per frame; 0 = no smoothing
+  };
+
+  using FrameCallback = std::function<void(const SpectrumFrame& frame)>;
+
+  explicit SpectrumAnalyzer(Options options);
+
+  // Runs on_frame for each frame completed by these samples
+  void Push(const float* interleaved, size_t frames, uint32_t channels, uint32_t sample_rate,
+            const FrameCallback& on_frame);
+  void Reset();
+
+  const SpectrumFrame& frame() const { return frame_; }
+  const Options& options() const { return options_; }
+
+  // One transform of the current window; exposed for benchmarks
+  void Analyze();
+
+ private:
+  void Configure(uint32_t sample_rate);
+
+  Options options_;
+  Fft fft_;
+  uint32_t sample_rate_ = 0;
+  size_t hop_ = 0;
+
+  std::vector<float> window_;   // Hann, scaled so a full-scale sine is 0 dB
+  std::vector<float> history_;  // Ring of the last fft_size mono samples
+  size_t history_pos_ = 0;
+  size_t since_frame_ = 0;
+  double energy_ = 0.0;
+  float peak_ = 0.0f;
+
+  std::vector<float> re_;
+  std::vector<float> im_;
+  // Bins [band_low_, band_high_) per band; narrow low bands may share a bin
+  std::vector<uint32_t> band_low_;
+  std::vector<uint32_t> band_high_;
+
+  SpectrumFrame frame_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_AUDIO_SPECTRUM_H_
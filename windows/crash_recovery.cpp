@@ -0,0 +1,131 @@
+#include "crash_recovery.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace hkcw_engine2 {
+
+const char* RecoveryActionName(RecoveryAction action) {
+  switch (action) {
+    case RecoveryAction::kNone: return "none";
+    case RecoveryAction::kReload: return "reload";
+    case RecoveryAction::kRebuildController: return "rebuild";
+    case RecoveryAction::kStaticFrame: return "static";
+  }
+  return "unknown";
+}
+
+CrashRecovery::CrashRecovery(Hooks hooks, Options options)
+    : hooks_(std::move(hooks)), options_(options) {
+  options_.loop_limit = (std::max)(options_.loop_limit, static_cast<size_t>(1));
+  history_.assign(options_.loop_limit, 0);
+}
+
+RecoveryAction CrashRecovery::OnFailure(ProcessFailure failure, uint64_t now_ms) {
+  if (failure == ProcessFailure::kOther || state_ == State::kStaticFrame) {
+    stats_.ignored++;
+    return RecoveryAction::kNone;
+  }
+  stats_.failures++;
+
+  // Ring of the last loop_limit failures; +1 so time 0 is not "empty"
+  history_[history_next_] = now_ms + 1;
+  history_next_ = (history_next_ + 1) % history_.size();
+  size_t failures = FailuresInWindow(now_ms);
+
+  if (failures >= options_.loop_limit) {
+    state_ = State::kStaticFrame;
+    action_ = RecoveryAction::kStaticFrame;
+    stats_.static_frames++;
+    if (hooks_.show_static_frame) hooks_.show_static_frame();
+    return action_;
+  }
+
+  // Escalate: a browser failure needs a new controller, and so does a
+  // renderer that failed again while a reload was bringing it back
+  RecoveryAction needed = RecoveryAction::kReload;
+  if (failure == ProcessFailure::kBrowserExited ||
+      (state_ == State::kRecovering && action_ != RecoveryAction::kNone)) {
+    needed = RecoveryAction::kRebuildController;
+  }
+  if (state_ == State::kHealthy) {
+    incident_ms_ = now_ms;
+    action_ = needed;
+  } else {
+    action_ = (std::max)(action_, needed);
+  }
+
+  uint32_t delay = DelayFor(failures);
+  state_ = State::kWaiting;
+  due_ms_ = now_ms + delay;
+  if (hooks_.schedule) hooks_.schedule(delay);
+  return action_;
+}
+
+void CrashRecovery::OnTimer(uint64_t now_ms) {
+  if (state_ == State::kWaiting) {
+    if (now_ms < due_ms_) {
+      if (hooks_.schedule) hooks_.schedule(static_cast<uint32_t>(due_ms_ - now_ms));
+      return;
+    }
+    Run(now_ms);
+  } else if (state_ == State::kRecovering && now_ms >= due_ms_) {
+    // The page never came back: as good as another failure
+    OnFailure(ProcessFailure::kBrowserExited, now_ms);
+  }
+}
+
+void CrashRecovery::Run(uint64_t now_ms) {
+  bool started = false;
+  if (action_ == RecoveryAction::kReload) {
+    stats_.reloads++;
+    started = hooks_.reload && hooks_.reload();
+    if (!started) action_ = RecoveryAction::kRebuildController;  // Fall through
+  }
+  if (!started && action_ == RecoveryAction::kRebuildController) {
+    stats_.rebuilds++;
+    started = hooks_.rebuild_controller && hooks_.rebuild_controller();
+  }
+
+  state_ = State::kRecovering;
+  if (!started) {
+    OnFailure(ProcessFailure::kBrowserExited, now_ms);
+    return;
+  }
+  due_ms_ = now_ms + options_.restore_timeout_ms;
+  if (hooks_.schedule) hooks_.schedule(options_.restore_timeout_ms);
+}
+
+void CrashRecovery::OnRestored(uint64_t now_ms) {
+  if (state_ != State::kRecovering) return;
+
+  uint64_t elapsed = now_ms - incident_ms_;
+  stats_.restored++;
+  stats_.last_restore_ms = elapsed;
+  stats_.max_restore_ms = (std::max)(stats_.max_restore_ms, elapsed);
+  state_ = State::kHealthy;
+  action_ = RecoveryAction::kNone;
+}
+
+void CrashRecovery::Reset() {
+  state_ = State::kHealthy;
+  action_ = RecoveryAction::kNone;
+  std::fill(history_.begin(), history_.end(), 0);
+  history_next_ = 0;
+}
+
+size_t CrashRecovery::FailuresInWindow(uint64_t now_ms) const {
+  size_t count = 0;
+  for (uint64_t stamp : history_) {
+    if (stamp != 0 && now_ms + 1 - stamp < options_.loop_window_ms) count++;
+  }
+  return count;
+}
+
+uint32_t CrashRecovery::DelayFor(size_t failures) const {
+  if (failures <= 1) return options_.first_delay_ms;
+  uint64_t delay = static_cast<uint64_t>(options_.backoff_base_ms) << (std::min)(failures - 2, static_cast<size_t>(20));
+  return static_cast<uint32_t>((std::min)(delay, static_cast<uint64_t>(options_.max_delay_ms)));
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,108 @@
+#ifndef FLUTTER_PLUGIN_CRASH_RECOVERY_H_
+#define FLUTTER_PLUGIN_CRASH_RECOVERY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// What died, reduced to what recovery needs to know
+enum class ProcessFailure {
+  kRendererExited,
+  kRendererUnresponsive,
+  kBrowserExited,  // The controller is closed with it
+  kOther,          // GPU, utility, iframe renderers: WebView2 copes alone
+};
+
+enum class RecoveryAction {
+  kNone,
+  kReload,             // Same controller, new renderer
+  kRebuildController,  // New controller on the same host and environment
+  kStaticFrame,        // Crash loop: stop trying
+};
+
+const char* RecoveryActionName(RecoveryAction action);
+
+// Crash Recovery: Decides how and when to bring the page back after a
+// WebView2 process failure.
+//
+// Renderer failures reload in place; a browser failure, a reload that
+// cannot start and a recovery that does not restore the page within
+// restore_timeout_ms rebuild the controller. The first failure after a
+// quiet period is acted on at once; further failures inside
+// loop_window_ms back off exponentially, and loop_limit of them fall back
+// to a static frame until Reset.
+//
+// Time comes in from the caller; delays go out through Hooks::schedule,
+// after which the caller calls OnTimer. Not thread-safe.
+class CrashRecovery {
+ public:
+  struct Options {
+    uint32_t first_delay_ms = 0;  // The wallpaper is already blank
+    uint32_t backoff_base_ms = 250;  // Second failure in the window
+    uint32_t max_delay_ms = 8000;
+    uint32_t loop_window_ms = 60000;
+    size_t loop_limit = 5;
+    uint32_t restore_timeout_ms = 10000;
+  };
+
+  struct Hooks {
+    std::function<bool()> reload;              // False: could not start
+    std::function<bool()> rebuild_controller;  // False: could not start
+    std::function<void()> show_static_frame;
+    std::function<void(uint32_t delay_ms)> schedule;  // Call OnTimer after delay
+  };
+
+  enum class State {
+    kHealthy,
+    kWaiting,     // Action scheduled
+    kRecovering,  // Action started, page not back yet
+    kStaticFrame,
+  };
+
+  struct Stats {
+    uint64_t failures = 0;  // Counted failures (not kOther)
+    uint64_t ignored = 0;
+    uint64_t reloads = 0;
+    uint64_t rebuilds = 0;
+    uint64_t static_frames = 0;
+    uint64_t restored = 0;
+    uint64_t last_restore_ms = 0;  // First failure -> page back
+    uint64_t max_restore_ms = 0;
+  };
+
+  CrashRecovery(Hooks hooks, Options options);
+
+  // The action that will run (after a delay), or kNone
+  RecoveryAction OnFailure(ProcessFailure failure, uint64_t now_ms);
+  void OnTimer(uint64_t now_ms);
+  // The page finished loading; ends a recovery in progress
+  void OnRestored(uint64_t now_ms);
+  // New wallpaper: history forgotten, static frame left
+  void Reset();
+
+  State state() const { return state_; }
+  RecoveryAction pending() const { return action_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  void Run(uint64_t now_ms);
+  size_t FailuresInWindow(uint64_t now_ms) const;
+  uint32_t DelayFor(size_t failures) const;
+
+  Hooks hooks_;
+  Options options_;
+  State state_ = State::kHealthy;
+  RecoveryAction action_ = RecoveryAction::kNone;
+  uint64_t due_ms_ = 0;        // kWaiting: run at; kRecovering: give up at
+  uint64_t incident_ms_ = 0;   // First failure of the current incident
+  std::vector<uint64_t> history_;  // Ring of recent failure times
+  size_t history_next_ = 0;
+  Stats stats_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_CRASH_RECOVERY_H_
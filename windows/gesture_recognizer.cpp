@@ -0,0 +1,152 @@
+#include "gesture_recognizer.h"
+
+#include <cstdlib>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// Inside a width x height rectangle centred on (cx, cy)
+inline bool WithinRect(int x, int y, int cx, int cy, int width, int height) {
+  return std::abs(x - cx) <= width / 2 && std::abs(y - cy) <= height / 2;
+}
+
+// Tick counts wrap every ~49.7 days; unsigned subtraction handles it
+inline uint32_t Elapsed(uint32_t now, uint32_t then) {
+  return now - then;
+}
+
+}  // namespace
+
+const char* GestureTypeName(GestureEvent::Type type) {
+  switch (type) {
+    case GestureEvent::Type::kClick: return "click";
+    case GestureEvent::Type::kDoubleClick: return "dblclick";
+    case GestureEvent::Type::kContextClick: return "contextclick";
+    case GestureEvent::Type::kLongPress: return "longpress";
+    case GestureEvent::Type::kDragStart: return "dragstart";
+    case GestureEvent::Type::kDragMove: return "dragmove";
+    case GestureEvent::Type::kDragEnd: return "dragend";
+  }
+  return "unknown";
+}
+
+const char* PointerButtonName(PointerButton button) {
+  switch (button) {
+    case PointerButton::kLeft: return "left";
+    case PointerButton::kRight: return "right";
+    case PointerButton::kMiddle: return "middle";
+  }
+  return "unknown";
+}
+
+void GestureRecognizer::Emit(GestureEvent::Type type, int x, int y, const Handler& handler) const {
+  GestureEvent event;
+  event.type = type;
+  event.button = button_;
+  event.x = x;
+  event.y = y;
+  event.start_x = down_x_;
+  event.start_y = down_y_;
+  handler(event);
+}
+
+void GestureRecognizer::Process(const PointerEvent& event, const Handler& handler) {
+  switch (event.type) {
+    case PointerEvent::Type::kDown:
+      if (pressed_) return;  // Chorded press: keep tracking the first button
+      pressed_ = true;
+      dragging_ = false;
+      long_pressed_ = false;
+      button_ = event.button;
+      down_x_ = event.x;
+      down_y_ = event.y;
+      down_time_ = event.time_ms;
+      last_x_ = event.x;
+      last_y_ = event.y;
+      return;
+
+    case PointerEvent::Type::kMove:
+      if (!pressed_) return;
+      last_x_ = event.x;
+      last_y_ = event.y;
+      if (!dragging_) {
+        if (WithinRect(event.x, event.y, down_x_, down_y_, options_.drag_width,
+                       options_.drag_height)) {
+          return;
+        }
+        dragging_ = true;
+        has_click_ = false;
+        Emit(GestureEvent::Type::kDragStart, down_x_, down_y_, handler);
+      }
+      Emit(GestureEvent::Type::kDragMove, event.x, event.y, handler);
+      return;
+
+    case PointerEvent::Type::kUp:
+      if (!pressed_ || event.button != button_) return;
+      pressed_ = false;
+
+      if (dragging_) {
+        Emit(GestureEvent::Type::kDragEnd, event.x, event.y, handler);
+        return;
+      }
+      if (long_pressed_ || (options_.long_press_ms > 0 &&
+                            Elapsed(event.time_ms, down_time_) >= options_.long_press_ms)) {
+        // Held past the deadline without a Tick: still a long press
+        if (!long_pressed_) Emit(GestureEvent::Type::kLongPress, down_x_, down_y_, handler);
+        has_click_ = false;
+        return;
+      }
+
+      if (button_ == PointerButton::kRight) {
+        has_click_ = false;
+        Emit(GestureEvent::Type::kContextClick, event.x, event.y, handler);
+        return;
+      }
+
+      Emit(GestureEvent::Type::kClick, event.x, event.y, handler);
+      if (has_click_ && click_button_ == button_ &&
+          Elapsed(down_time_, click_time_) <= options_.double_click_ms &&
+          WithinRect(down_x_, down_y_, click_x_, click_y_, options_.double_click_width,
+                     options_.double_click_height)) {
+        // A third click starts a new pair, as in Windows
+        has_click_ = false;
+        Emit(GestureEvent::Type::kDoubleClick, event.x, event.y, handler);
+        return;
+      }
+      // Windows measures from the first press to the second press
+      has_click_ = true;
+      click_button_ = button_;
+      click_x_ = down_x_;
+      click_y_ = down_y_;
+      click_time_ = down_time_;
+      return;
+  }
+}
+
+void GestureRecognizer::Tick(uint32_t now_ms, const Handler& handler) {
+  uint32_t deadline = 0;
+  if (!long_press_deadline(deadline)) return;
+  if (Elapsed(now_ms, down_time_) < options_.long_press_ms) return;
+  long_pressed_ = true;
+  has_click_ = false;
+  Emit(GestureEvent::Type::kLongPress, down_x_, down_y_, handler);
+}
+
+void GestureRecognizer::Cancel(const Handler& handler) {
+  if (pressed_ && dragging_) {
+    Emit(GestureEvent::Type::kDragEnd, last_x_, last_y_, handler);
+  }
+  pressed_ = false;
+  dragging_ = false;
+  long_pressed_ = false;
+  has_click_ = false;
+}
+
+bool GestureRecognizer::long_press_deadline(uint32_t& deadline_ms) const {
+  if (!pressed_ || dragging_ || long_pressed_ || options_.long_press_ms == 0) return false;
+  deadline_ms = down_time_ + options_.long_press_ms;
+  return true;
+}
+
+}  // namespace hkcw_engine2
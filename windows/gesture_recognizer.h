@@ -0,0 +1,105 @@
+#ifndef FLUTTER_PLUGIN_GESTURE_RECOGNIZER_H_
+#define FLUTTER_PLUGIN_GESTURE_RECOGNIZER_H_
+
+#include <cstdint>
+#include <functional>
+
+namespace hkcw_engine2 {
+
+enum class PointerButton { kLeft, kRight, kMiddle };
+
+struct PointerEvent {
+  enum class Type { kDown, kUp, kMove };
+  Type type;
+  PointerButton button;  // Ignored for kMove
+  int x;
+  int y;
+  uint32_t time_ms;  // Tick count; wraps (MSLLHOOKSTRUCT::time)
+};
+
+struct GestureEvent {
+  enum class Type {
+    kClick,         // Left or middle press and release without dragging
+    kDoubleClick,   // Follows the second kClick
+    kContextClick,  // Right-button click
+    kLongPress,     // Held still past long_press_ms; no click follows
+    kDragStart,     // At the press position
+    kDragMove,
+    kDragEnd,
+  };
+  Type type;
+  PointerButton button;
+  int x;
+  int y;
+  int start_x;  // Press position
+  int start_y;
+};
+
+// Names used in hkcw:gesture events
+const char* GestureTypeName(GestureEvent::Type type);
+const char* PointerButtonName(PointerButton button);
+
+// Gesture Recognizer: raw button/move events in, high-level gestures out.
+//
+// One button is tracked at a time; presses of other buttons while it is
+// held are ignored. Thresholds follow Windows semantics: a drag starts once
+// the pointer leaves a drag_width x drag_height rectangle centred on the
+// press (SM_CXDRAG), and a second click is a double click when it comes
+// within double_click_ms (GetDoubleClickTime) and the SM_CXDOUBLECLK
+// rectangle of the first. Long presses need a clock: the caller calls
+// Tick() once long_press_deadline() has passed. Not thread-safe.
+class GestureRecognizer {
+ public:
+  struct Options {
+    uint32_t double_click_ms = 500;
+    int double_click_width = 4;
+    int double_click_height = 4;
+    int drag_width = 4;
+    int drag_height = 4;
+    uint32_t long_press_ms = 500;  // 0 disables long presses
+  };
+
+  using Handler = std::function<void(const GestureEvent& event)>;
+
+  explicit GestureRecognizer(Options options) : options_(options) {}
+
+  void Process(const PointerEvent& event, const Handler& handler);
+  void Tick(uint32_t now_ms, const Handler& handler);
+
+  // Input went elsewhere mid-gesture (occluded, handled natively): a drag
+  // in progress gets its kDragEnd, anything else is forgotten
+  void Cancel(const Handler& handler);
+
+  bool pressed() const { return pressed_; }
+  // True with the deadline while a long press can still fire
+  bool long_press_deadline(uint32_t& deadline_ms) const;
+
+  const Options& options() const { return options_; }
+  void set_options(Options options) { options_ = options; }
+
+ private:
+  void Emit(GestureEvent::Type type, int x, int y, const Handler& handler) const;
+
+  Options options_;
+
+  bool pressed_ = false;
+  bool dragging_ = false;
+  bool long_pressed_ = false;
+  PointerButton button_ = PointerButton::kLeft;
+  int down_x_ = 0;
+  int down_y_ = 0;
+  uint32_t down_time_ = 0;
+  int last_x_ = 0;
+  int last_y_ = 0;
+
+  // Last click, for double clicks
+  bool has_click_ = false;
+  PointerButton click_button_ = PointerButton::kLeft;
+  int click_x_ = 0;
+  int click_y_ = 0;
+  uint32_t click_time_ = 0;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_GESTURE_RECOGNIZER_H_
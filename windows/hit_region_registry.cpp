@@ -0,0 +1,158 @@
+#include "hit_region_registry.h"
+
+#include <algorithm>
+#include <charconv>
+#include <utility>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// Integer value of "key": in message; JSON numbers from the SDK are
+// rounded, but a fraction is tolerated and truncated
+template <typename T>
+bool FindInt(std::string_view message, std::string_view key, T& value) {
+  std::string pattern = "\"" + std::string(key) + "\":";
+  size_t pos = message.find(pattern);
+  if (pos == std::string_view::npos) return false;
+  const char* begin = message.data() + pos + pattern.size();
+  const char* end = message.data() + message.size();
+  return std::from_chars(begin, end, value).ec == std::errc();
+}
+
+}  // namespace
+
+bool ParseHitRegion(std::string_view message, HitRegion& region) {
+  HitRegion parsed;
+  if (!FindInt(message, "id", parsed.id) || !FindInt(message, "left", parsed.left) ||
+      !FindInt(message, "top", parsed.top) || !FindInt(message, "right", parsed.right) ||
+      !FindInt(message, "bottom", parsed.bottom)) {
+    return false;
+  }
+  FindInt(message, "z", parsed.z);
+
+  size_t tag_start = message.find("\"tag\":\"");
+  if (tag_start != std::string_view::npos) {
+    tag_start += 7;
+    // Up to the closing quote, skipping escaped ones
+    size_t tag_end = tag_start;
+    while (tag_end < message.size() && message[tag_end] != '"') {
+      tag_end += message[tag_end] == '\\' ? 2 : 1;
+    }
+    parsed.tag = std::string(message.substr(tag_start, (std::min)(tag_end, message.size()) - tag_start));
+  }
+  region = std::move(parsed);
+  return true;
+}
+
+bool ParseHitRegionId(std::string_view message, uint32_t& id) {
+  return FindInt(message, "id", id);
+}
+
+bool ParseHitRegions(std::string_view message, std::vector<HitRegion>& regions) {
+  regions.clear();
+  size_t pos = message.find("\"regions\":[");
+  if (pos == std::string_view::npos) return false;
+
+  // Each top-level object of the array is one region; tags may hold
+  // braces, so strings are skipped
+  int depth = 0;
+  size_t element_start = 0;
+  for (size_t i = pos + 11; i < message.size(); i++) {
+    char c = message[i];
+    if (c == '"') {
+      for (i++; i < message.size() && message[i] != '"'; i++) {
+        if (message[i] == '\\') i++;
+      }
+    } else if (c == '{') {
+      if (depth++ == 0) element_start = i;
+    } else if (c == '}') {
+      if (--depth == 0) {
+        HitRegion region;
+        if (ParseHitRegion(message.substr(element_start, i + 1 - element_start), region)) {
+          regions.push_back(std::move(region));
+        }
+      }
+    } else if (c == ']' && depth == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HitRegionRegistry::Set(const HitRegion& region) {
+  if (region.right < region.left || region.bottom < region.top) return false;
+
+  auto it = std::find_if(regions_.begin(), regions_.end(),
+                         [&region](const HitRegion& r) { return r.id == region.id; });
+  if (it != regions_.end()) {
+    *it = region;
+  } else {
+    if (regions_.size() >= kMaxRegions) return false;
+    regions_.push_back(region);
+  }
+  Rebuild();
+  return true;
+}
+
+bool HitRegionRegistry::Remove(uint32_t id) {
+  auto it = std::find_if(regions_.begin(), regions_.end(),
+                         [id](const HitRegion& r) { return r.id == id; });
+  if (it == regions_.end()) return false;
+  regions_.erase(it);
+  Rebuild();
+  return true;
+}
+
+size_t HitRegionRegistry::Replace(const std::vector<HitRegion>& regions) {
+  regions_.clear();
+  for (const HitRegion& region : regions) {
+    if (regions_.size() >= kMaxRegions) break;
+    if (region.right < region.left || region.bottom < region.top) continue;
+    auto it = std::find_if(regions_.begin(), regions_.end(),
+                           [&region](const HitRegion& r) { return r.id == region.id; });
+    if (it != regions_.end()) {
+      *it = region;  // A repeated id: the later entry wins, like Set
+    } else {
+      regions_.push_back(region);
+    }
+  }
+  Rebuild();
+  return regions_.size();
+}
+
+void HitRegionRegistry::Clear() {
+  regions_.clear();
+  has_bounds_ = false;
+}
+
+void HitRegionRegistry::Rebuild() {
+  std::stable_sort(regions_.begin(), regions_.end(), [](const HitRegion& a, const HitRegion& b) {
+    return a.z != b.z ? a.z > b.z : a.id < b.id;
+  });
+
+  has_bounds_ = !regions_.empty();
+  if (!has_bounds_) return;
+  union_left_ = regions_[0].left;
+  union_top_ = regions_[0].top;
+  union_right_ = regions_[0].right;
+  union_bottom_ = regions_[0].bottom;
+  for (const HitRegion& r : regions_) {
+    union_left_ = (std::min)(union_left_, r.left);
+    union_top_ = (std::min)(union_top_, r.top);
+    union_right_ = (std::max)(union_right_, r.right);
+    union_bottom_ = (std::max)(union_bottom_, r.bottom);
+  }
+}
+
+const HitRegion* HitRegionRegistry::HitTest(int x, int y) const {
+  if (!has_bounds_ || x < union_left_ || x > union_right_ || y < union_top_ || y > union_bottom_) {
+    return nullptr;
+  }
+  for (const HitRegion& r : regions_) {
+    if (x >= r.left && x <= r.right && y >= r.top && y <= r.bottom) return &r;
+  }
+  return nullptr;
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,72 @@
+#ifndef FLUTTER_PLUGIN_HIT_REGION_REGISTRY_H_
+#define FLUTTER_PLUGIN_HIT_REGION_REGISTRY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// One clickable page element, in physical pixels; edges are inclusive
+// like the SDK's own bounds test
+struct HitRegion {
+  uint32_t id = 0;  // Assigned by the page, unique per document
+  int left = 0;
+  int top = 0;
+  int right = 0;
+  int bottom = 0;
+  int z = 0;  // Higher wins; equal z: the earlier-registered (lower id) wins
+  std::string tag;  // Page-supplied label, for logs
+};
+
+// {"type":"HIT_REGION_SET","id":..,"left":..,"top":..,"right":..,
+// "bottom":..,"z":..,"tag":".."} as posted by the SDK. tag must come last:
+// fields are found by key, and a tag could contain one.
+bool ParseHitRegion(std::string_view message, HitRegion& region);
+// {"type":"HIT_REGION_REMOVE","id":..}
+bool ParseHitRegionId(std::string_view message, uint32_t& id);
+// {"type":"HIT_REGIONS","regions":[{"id":..,..,"tag":".."},..]}: the
+// page's whole set, each element laid out like HIT_REGION_SET. Malformed
+// elements are skipped; false if there is no regions array.
+bool ParseHitRegions(std::string_view message, std::vector<HitRegion>& regions);
+
+// Hit Region Registry: The page's click regions, resolved natively so a
+// click only reaches the page when it lands on one.
+//
+// Regions stay sorted topmost-first, so a hit test is an early-exit scan
+// behind a reject on the union of all regions (clicks on empty desktop
+// usually end there). Hit tests allocate nothing. Not thread-safe: the
+// input source and the web message handler share the UI thread.
+class HitRegionRegistry {
+ public:
+  static const size_t kMaxRegions = 256;
+
+  // Adds or replaces by id; false when full or the rectangle is empty
+  bool Set(const HitRegion& region);
+  bool Remove(uint32_t id);
+  void Clear();
+  // The whole set at once (one sort); returns how many were accepted
+  size_t Replace(const std::vector<HitRegion>& regions);
+
+  // Topmost region containing the point, or nullptr
+  const HitRegion* HitTest(int x, int y) const;
+
+  size_t size() const { return regions_.size(); }
+  bool empty() const { return regions_.empty(); }
+
+ private:
+  void Rebuild();
+
+  std::vector<HitRegion> regions_;  // Topmost first
+  bool has_bounds_ = false;
+  int union_left_ = 0;
+  int union_top_ = 0;
+  int union_right_ = 0;
+  int union_bottom_ = 0;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_HIT_REGION_REGISTRY_H_
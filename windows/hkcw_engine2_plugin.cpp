@@ -1,15 +1,22 @@
 #include "hkcw_engine2_plugin.h"
+#include "hkcw_sdk_embedded.h"
+#include "preview_encoder.h"
+#include "script_template.h"
+#include "utf_transcoder.h"
 #include <flutter/method_channel.h>
 #include <flutter/plugin_registrar_windows.h>
 #include <flutter/standard_method_codec.h>
 #include <windows.h>
 #include <shellapi.h>
 #include <string>
+#include <string_view>
 #include <memory>
 #include <iostream>
-#include <sstream>
+#include <iterator>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
 
 namespace hkcw_engine2 {
 
@@ -43,9 +50,28 @@ size_t ResourceTracker::GetTrackedCount() const {
 }
 
 // P0-3: URLValidator implementation
+URLValidator::~URLValidator() {
+  {
+    std::lock_guard<std::mutex> lock(reload_mutex_);
+    stop_reload_ = true;
+  }
+  reload_wake_.notify_all();
+  if (reload_thread_.joinable()) reload_thread_.join();
+}
+
 bool URLValidator::IsAllowed(const std::string& url) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  
+  std::string lower_url;
+  if (snapshot_.is_loaded()) {
+    lower_url = url;
+    std::transform(lower_url.begin(), lower_url.end(), lower_url.begin(),
+      [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+  }
+  
   // Empty whitelist = allow all (except blacklist)
-  bool allowed = whitelist_.empty();
+  bool has_whitelist = !whitelist_.empty() || snapshot_.count(UrlRuleSnapshot::kWhitelist) > 0;
+  bool allowed = !has_whitelist;
   
   // Check whitelist
   if (!whitelist_.empty()) {
@@ -56,6 +82,10 @@ bool URLValidator::IsAllowed(const std::string& url) {
       }
     }
   }
+  if (!allowed && snapshot_.is_loaded() &&
+      !snapshot_.Match(lower_url, UrlRuleSnapshot::kWhitelist).empty()) {
+    allowed = true;
+  }
   
   // Check blacklist (overrides whitelist)
   for (const auto& pattern : blacklist_) {
@@ -64,8 +94,15 @@ bool URLValidator::IsAllowed(const std::string& url) {
       return false;
     }
   }
+  if (snapshot_.is_loaded()) {
+    std::string_view rule = snapshot_.Match(lower_url, UrlRuleSnapshot::kBlacklist);
+    if (!rule.empty()) {
+      std::cout << "[HKCW] [Security] URL blocked by rule file (" << rule << "): " << url << std::endl;
+      return false;
+    }
+  }
   
-  if (!allowed && !whitelist_.empty()) {
+  if (!allowed && has_whitelist) {
     std::cout << "[HKCW] [Security] URL not in whitelist: " << url << std::endl;
   }
   
@@ -73,20 +110,24 @@ bool URLValidator::IsAllowed(const std::string& url) {
 }
 
 void URLValidator::AddWhitelist(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(mutex_);
   whitelist_.push_back(pattern);
   std::cout << "[HKCW] [Security] Added to whitelist: " << pattern << std::endl;
 }
 
 void URLValidator::AddBlacklist(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(mutex_);
   blacklist_.push_back(pattern);
   std::cout << "[HKCW] [Security] Added to blacklist: " << pattern << std::endl;
 }
 
 void URLValidator::ClearWhitelist() {
+  std::lock_guard<std::mutex> lock(mutex_);
   whitelist_.clear();
 }
 
 void URLValidator::ClearBlacklist() {
+  std::lock_guard<std::mutex> lock(mutex_);
   blacklist_.clear();
 }
 
@@ -110,11 +151,67 @@ bool URLValidator::MatchesPattern(const std::string& url, const std::string& pat
   return lower_url.find(lower_pattern) != std::string::npos;
 }
 
+// URL Rules: Snapshot lives next to the source file
+bool URLValidator::LoadRuleFile(const std::string& path) {
+  std::error_code ec;
+  auto file_time = std::filesystem::last_write_time(std::filesystem::u8path(path), ec);
+  if (ec) {
+    std::cout << "[HKCW] [URLRules] Rule file not found: " << path << std::endl;
+    return false;
+  }
+  
+  std::lock_guard<std::mutex> lock(reload_mutex_);
+  if (!ReplaceSnapshot(path)) {
+    return false;
+  }
+  
+  rule_file_path_ = path;
+  rule_file_time_ = file_time;
+  if (!reload_thread_.joinable()) {
+    reload_thread_ = std::thread(&URLValidator::WatchRuleFile, this);
+  }
+  return true;
+}
+
+// URL Rules: Hot-reload, polled every 2 seconds off the validating threads
+void URLValidator::WatchRuleFile() {
+  std::unique_lock<std::mutex> lock(reload_mutex_);
+  while (!reload_wake_.wait_for(lock, std::chrono::seconds(2), [this] { return stop_reload_; })) {
+    std::error_code ec;
+    auto file_time = std::filesystem::last_write_time(std::filesystem::u8path(rule_file_path_), ec);
+    if (ec || file_time == rule_file_time_) continue;
+    
+    std::cout << "[HKCW] [URLRules] Rule file changed, reloading: " << rule_file_path_ << std::endl;
+    
+    if (!ReplaceSnapshot(rule_file_path_)) {
+      // Timestamp left as-is, so the next check retries
+      std::cout << "[HKCW] [URLRules] Reload failed, keeping previous rules" << std::endl;
+      continue;
+    }
+    rule_file_time_ = file_time;
+  }
+}
+
+// URL Rules: Build into a separate instance; the live snapshot stays
+// mapped and in force until the swap. Caller holds reload_mutex_.
+bool URLValidator::ReplaceSnapshot(const std::string& path) {
+  UrlRuleSnapshot loaded;
+  if (!loaded.Load(path, path + ".snapshot")) {
+    return false;
+  }
+  
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshot_.swap(loaded);
+  // With the old mapping released, a rebuild Windows could not rename
+  // over it can take the snapshot name
+  loaded.Close();
+  snapshot_.FinishRename();
+  return true;
+}
+
 // P1-1: Shared WebView2 environment (static)
 Microsoft::WRL::ComPtr<ICoreWebView2Environment> HkcwEngine2Plugin::shared_environment_;
-
-// Mouse Hook instance
-HkcwEngine2Plugin* HkcwEngine2Plugin::hook_instance_ = nullptr;
+Async<Microsoft::WRL::ComPtr<ICoreWebView2Environment>> HkcwEngine2Plugin::pending_environment_;
 
 namespace {
 
@@ -124,6 +221,133 @@ const wchar_t kWebViewHostClassName[] = L"HKCWWebViewHost";
 // Global instance for callbacks
 HkcwEngine2Plugin* g_plugin_instance = nullptr;
 
+// Message Scheduler: Hidden window that drains queued web messages
+const wchar_t kDispatchWindowClassName[] = L"HKCWMessageDispatch";
+const UINT kDrainMessage = WM_APP + 1;
+const UINT_PTR kDrainTimerId = 1;
+const size_t kDrainMaxMessages = 16;  // Per UI-loop turn
+const auto kDrainBudget = std::chrono::milliseconds(2);
+
+// Script Templates: Native-to-page events, split into segments at compile time
+constexpr ScriptTemplate kInteractionModeScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:interactionMode',"
+    L"{detail:{enabled:{}}}));"
+    L"console.log('[HKCW] Interaction mode set to: ' + {});})();");
+static_assert(kInteractionModeScript.holes() == 2, "enabled, enabled");
+
+constexpr ScriptTemplate kMouseEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:mouse',"
+    L"{detail:{type:{},x:{},y:{},button:0}}));})();");  // button 0 = left
+static_assert(kMouseEventScript.holes() == 3, "type, x, y");
+
+constexpr ScriptTemplate kGestureEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:gesture',"
+    L"{detail:{type:{},button:{},x:{},y:{},startX:{},startY:{}}}));})();");
+static_assert(kGestureEventScript.holes() == 6, "type, button, x, y, startX, startY");
+
+constexpr ScriptTemplate kWheelEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:mouse',"
+    L"{detail:{type:'wheel',x:{},y:{},deltaX:{},deltaY:{}}}));})();");
+static_assert(kWheelEventScript.holes() == 4, "x, y, deltaX, deltaY");
+
+// Hit Regions: Only clicks that land on a registered region reach the page
+constexpr ScriptTemplate kRegionClickScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:click',"
+    L"{detail:{x:{},y:{},id:{}}}));})();");
+static_assert(kRegionClickScript.holes() == 3, "x, y, id");
+
+// Keyboard Forwarder: One script per frame, one detail object per entry
+constexpr ScriptTemplate kKeyboardEntryScript(
+    L"{type:{},code:{},repeat:{},ctrl:{},shift:{},alt:{},meta:{}},");
+static_assert(kKeyboardEntryScript.holes() == 7, "type, code, repeat, ctrl, shift, alt, meta");
+const wchar_t kKeyboardBatchPrefix[] = L"(function(){var e=[";
+const wchar_t kKeyboardBatchSuffix[] =
+    L"];for(var i=0;i<e.length;i++)"
+    L"window.dispatchEvent(new CustomEvent('hkcw:keyboard',{detail:e[i]}));})();";
+
+// Script Pipeline: Coalescing keys; a newer script replaces a queued one
+const uint32_t kScriptKeyMouseMove = 1;
+const uint32_t kScriptKeyInteractionMode = 2;
+const uint32_t kScriptKeyGestureDrag = 3;
+
+// Gesture Recognizer: Long-press timer on the dispatch window
+const UINT_PTR kGestureTimerId = 3;
+
+// Input Listeners: Event classes the page has listeners for
+const uint32_t kInputButtons = 1;  // mousedown/mouseup, gestures, onClick
+const uint32_t kInputMotion = 2;   // mousemove
+const uint32_t kInputWheel = 4;
+const uint32_t kInputRegions = 8;  // onClick regions, resolved natively
+const uint32_t kInputGestures = 16;  // onGesture: a long press replaces the click
+const uint32_t kInputAds = 32;  // Left releases on iframe ads, handled natively
+const UINT_PTR kInputLegacyTimerId = 4;
+const UINT kInputLegacyGraceMs = 2000;
+
+// Preview: Live pages are re-captured at most this often per generation
+const int kPreviewMinIntervalMs = 1000;
+const int kPreviewDefaultWidth = 320;
+const int kPreviewDefaultHeight = 180;
+const int kPreviewMaxSize = 1024;
+
+// Shared Feed: Limits for feeds opened from Dart
+const uint32_t kFeedMaxSlotSize = 16 * 1024 * 1024;
+const uint32_t kFeedMaxSlotCount = 8;
+const size_t kFeedMaxNameLength = 32;
+
+// Audio Spectrum: Frames from the capture thread; payload is float32 bands
+// followed by rms and peak, tagged with the band count
+const UINT kAudioFrameMessage = WM_APP + 2;
+const char kAudioFeedName[] = "audio";
+const size_t kAudioDefaultBands = 64;
+const size_t kAudioMaxBands = 256;
+
+// System Telemetry: Sampling interval requested by the page, clamped
+const UINT_PTR kTelemetryTimerId = 2;
+const UINT kTelemetryDefaultIntervalMs = 1000;
+const UINT kTelemetryMinIntervalMs = 250;
+const UINT kTelemetryMaxIntervalMs = 60000;
+
+// Keyboard Forwarder: Presses and releases leave on the next frame;
+// batches of only auto-repeats wait longer so repeats fold. At most
+// kKeyboardBatchMax entries per script.
+const UINT_PTR kKeyboardTimerId = 5;
+const UINT kKeyboardFrameMs = 16;
+const UINT kKeyboardRepeatFlushMs = 100;
+const size_t kKeyboardBatchMax = 32;
+
+// Occlusion Cache: The visible region is rebuilt once window events have
+// been quiet this long (closing or minimizing several windows at once)
+const UINT_PTR kOcclusionTimerId = 6;
+const UINT kOcclusionSettleMs = 100;
+
+// Shell Recovery: A watchdog notices the WorkerW going away with
+// explorer.exe; discovery is then retried until the new desktop answers.
+// Only after kShellSplitTimeoutMs without a WorkerW split does Progman
+// itself become the parent, as on first initialization.
+const UINT_PTR kShellWatchTimerId = 7;
+const UINT kShellWatchIntervalMs = 500;
+const UINT kShellRetryIntervalMs = 100;
+const UINT kShellRetryMessageTimeoutMs = 50;  // A restarting explorer may not answer yet
+const int64_t kShellSplitTimeoutMs = 10000;
+const wchar_t kShellWatchWindowTitle[] = L"HKCWShellWatch";
+
+// Crash Recovery: Delayed reloads / rebuilds and the restore watchdog;
+// after a crash loop the host shows this until the next wallpaper
+const UINT_PTR kRecoveryTimerId = 8;
+const char kDefaultCrashFallback[] = "hkcw-color:#000000";
+
+// Script Pipeline: While scripts are queued or in flight, expiry and the
+// hung-renderer timeout are enforced from here too, not only when the
+// next script or completion happens to arrive
+const UINT_PTR kScriptTimerId = 9;
+const UINT kScriptTickMs = 100;
+
+// Broadcast to top-level windows whenever explorer.exe (re)creates the taskbar
+UINT TaskbarCreatedMessage() {
+  static const UINT message = RegisterWindowMessageW(L"TaskbarCreated");
+  return message;
+}
+
 // Enum callback for finding WorkerW
 struct EnumWindowsContext {
   HWND shelldll_parent = nullptr;
@@ -170,6 +394,26 @@ BOOL CALLBACK EnumWindowsProc(HWND hwnd, LPARAM lParam) {
   return TRUE; // Continue enumeration
 }
 
+// Request Filter: Map WebView2 resource context to EasyList type. DOCUMENT
+// covers the wallpaper page and its iframes alike; main_frame tells them apart
+uint32_t ResourceTypeFromContext(COREWEBVIEW2_WEB_RESOURCE_CONTEXT context, bool main_frame) {
+  switch (context) {
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_DOCUMENT: return main_frame ? kResourceDocument : kResourceSubdocument;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_STYLESHEET: return kResourceStylesheet;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_IMAGE: return kResourceImage;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_MEDIA: return kResourceMedia;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_FONT: return kResourceFont;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_SCRIPT: return kResourceScript;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_XML_HTTP_REQUEST:
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_FETCH:
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_EVENT_SOURCE: return kResourceXhr;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_WEBSOCKET: return kResourceWebsocket;
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_PING:
+    case COREWEBVIEW2_WEB_RESOURCE_CONTEXT_CSP_VIOLATION_REPORT: return kResourcePing;
+    default: return kResourceOther;
+  }
+}
+
 bool IsWindows11OrGreater() {
   OSVERSIONINFOEXW osvi = { sizeof(osvi), 0, 0, 0, 0, {0}, 0, 0 };
   DWORDLONG const dwlConditionMask = VerSetConditionMask(
@@ -205,9 +449,6 @@ void HkcwEngine2Plugin::RegisterWithRegistrar(
 HkcwEngine2Plugin::HkcwEngine2Plugin() {
   std::cout << "[HKCW] Plugin initialized" << std::endl;
   
-  // Set hook instance
-  hook_instance_ = this;
-  
   // P1-2: Initialize cleanup timer
   last_cleanup_ = std::chrono::steady_clock::now();
   
@@ -219,13 +460,98 @@ HkcwEngine2Plugin::HkcwEngine2Plugin() {
   // Add common malicious patterns to blacklist
   url_validator_.AddBlacklist("file:///c:/windows");
   url_validator_.AddBlacklist("file:///c:/program");
+  
+  // URL Rules: Optional user rule file (large lists load from snapshot)
+  std::string rule_file = GetDefaultRuleFilePath();
+  if (!rule_file.empty() && std::filesystem::exists(std::filesystem::u8path(rule_file))) {
+    url_validator_.LoadRuleFile(rule_file);
+  }
+  
+  // URL Launcher: Shell launches run on a worker, validated there
+  UrlLauncher::Hooks launcher_hooks;
+  launcher_hooks.validate = [this](const std::string& url) {
+    return url_validator_.IsAllowed(url);
+  };
+  launcher_hooks.launch = [](const std::string& url) {
+    std::wstring wurl = Utf8ToWide(url);
+    HINSTANCE result = ShellExecuteW(nullptr, L"open", wurl.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
+    return reinterpret_cast<INT_PTR>(result) > 32;
+  };
+  launcher_hooks.thread_start = [] {
+    // ShellExecute may use COM to reach shell extensions
+    CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED | COINIT_DISABLE_OLE1DDE);
+  };
+  launcher_hooks.thread_stop = [] { CoUninitialize(); };
+  url_launcher_ = std::make_unique<UrlLauncher>(std::move(launcher_hooks), UrlLauncher::Options());
+  
+  // Script Pipeline: Completions come back on the UI thread
+  script_pipeline_.SetExecutor([this](const wchar_t* script, uint64_t ticket) {
+    if (!webview_) return false;
+    auto run = ExecuteScriptAsync(webview_.Get(), script);
+    if (run.done() && FAILED(run.status())) return false;
+    if (!script_timer_running_ && dispatch_hwnd_) {
+      script_timer_running_ = SetTimer(dispatch_hwnd_, kScriptTimerId, kScriptTickMs, nullptr) != 0;
+    }
+    // WebView Async: Tickets of a closed WebView are gone from the pipeline
+    run.Then(webview_session_.token(), [this, ticket](AsyncStatus status, bool) {
+      script_pipeline_.Complete(ticket, SUCCEEDED(status), std::chrono::steady_clock::now());
+    });
+    return true;
+  });
+  
+  // Crash Recovery: Actions run from the dispatch window timer
+  CrashRecovery::Hooks recovery_hooks;
+  recovery_hooks.reload = [this] {
+    if (!webview_) return false;
+    std::cout << "[HKCW] [Recovery] Reloading page" << std::endl;
+    script_pipeline_.Reset();  // Nothing in flight will ever complete
+    return SUCCEEDED(webview_->Reload());
+  };
+  recovery_hooks.rebuild_controller = [this] { return RebuildController(); };
+  recovery_hooks.show_static_frame = [this] { ShowCrashFallback(); };
+  recovery_hooks.schedule = [this](uint32_t delay_ms) {
+    if (dispatch_hwnd_) {
+      SetTimer(dispatch_hwnd_, kRecoveryTimerId, (std::max)(delay_ms, static_cast<uint32_t>(USER_TIMER_MINIMUM)), nullptr);
+    }
+  };
+  crash_recovery_ = std::make_unique<CrashRecovery>(std::move(recovery_hooks), CrashRecovery::Options());
+  crash_fallback_url_ = kDefaultCrashFallback;
+  
+  // Gesture Recognizer: Built once; the hook must not allocate
+  gesture_handler_ = [this](const GestureEvent& gesture) { OnGesture(gesture); };
+  
+  // Message Scheduler: Without the window, messages are drained inline
+  ConfigureMessageScheduler();
+  dispatch_hwnd_ = CreateDispatchWindow();
+  
+  // Shell Recovery: Shares the dispatch window class and procedure
+  shell_watch_hwnd_ = CreateShellWatchWindow();
 }
 
 HkcwEngine2Plugin::~HkcwEngine2Plugin() {
   std::cout << "[HKCW] Plugin destructor - starting cleanup" << std::endl;
   
-  // Remove mouse hook
-  RemoveMouseHook();
+  // Input Source: No events into a dying plugin
+  StopInputSource();
+  keyboard_source_.reset();
+  
+  // URL Launcher: Join the worker before the validator it uses goes away
+  url_launcher_.reset();
+  
+  // Audio Spectrum: Join the capture thread while its window still exists
+  StopAudioSpectrum();
+  
+  // Shell Recovery: No re-attach into a dying plugin
+  if (shell_watch_hwnd_) {
+    DestroyWindow(shell_watch_hwnd_);
+    shell_watch_hwnd_ = nullptr;
+  }
+  
+  // Message Scheduler: Nothing may be drained into a dying plugin
+  if (dispatch_hwnd_) {
+    DestroyWindow(dispatch_hwnd_);
+    dispatch_hwnd_ = nullptr;
+  }
   
   // P0: Cleanup
   StopWallpaper();
@@ -233,8 +559,6 @@ HkcwEngine2Plugin::~HkcwEngine2Plugin() {
   // P0-1: Cleanup all tracked resources
   ResourceTracker::Instance().CleanupAll();
   
-  hook_instance_ = nullptr;
-  
   std::cout << "[HKCW] Plugin cleanup complete" << std::endl;
 }
 
@@ -288,6 +612,333 @@ void HkcwEngine2Plugin::HandleMethodCall(
     bool success = NavigateToUrl(url);
     result->Success(flutter::EncodableValue(success));
   }
+  else if (method_call.method_name() == "loadUrlRules") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto path_it = arguments->find(flutter::EncodableValue("path"));
+    if (path_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'path' argument");
+      return;
+    }
+
+    bool success = url_validator_.LoadRuleFile(std::get<std::string>(path_it->second));
+    result->Success(flutter::EncodableValue(success));
+  }
+  else if (method_call.method_name() == "loadFilterList") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto path_it = arguments->find(flutter::EncodableValue("path"));
+    if (path_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'path' argument");
+      return;
+    }
+
+    bool success = LoadFilterList(std::get<std::string>(path_it->second));
+    result->Success(flutter::EncodableValue(success));
+  }
+  else if (method_call.method_name() == "clearFilterLists") {
+    request_filter_.Clear();
+    RemoveResourceFilter();
+    std::cout << "[HKCW] [Filter] Filter lists cleared" << std::endl;
+    result->Success(flutter::EncodableValue(true));
+  }
+  else if (method_call.method_name() == "getFilterStats") {
+    flutter::EncodableList top_rules;
+    for (const auto& stat : request_filter_.GetRuleStats(50)) {
+      top_rules.push_back(flutter::EncodableValue(flutter::EncodableMap{
+        {flutter::EncodableValue("rule"), flutter::EncodableValue(stat.rule)},
+        {flutter::EncodableValue("hits"), flutter::EncodableValue(static_cast<int64_t>(stat.hits))},
+        {flutter::EncodableValue("exception"), flutter::EncodableValue(stat.exception)},
+      }));
+    }
+
+    result->Success(flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("rules"), flutter::EncodableValue(static_cast<int64_t>(request_filter_.rule_count()))},
+      {flutter::EncodableValue("checked"), flutter::EncodableValue(static_cast<int64_t>(request_filter_.checked_count()))},
+      {flutter::EncodableValue("blocked"), flutter::EncodableValue(static_cast<int64_t>(request_filter_.blocked_count()))},
+      {flutter::EncodableValue("topRules"), flutter::EncodableValue(top_rules)},
+    }));
+  }
+  else if (method_call.method_name() == "getMessageStats") {
+    auto counters = [](const MessageScheduler::Stats& stats) {
+      return flutter::EncodableMap{
+        {flutter::EncodableValue("received"), flutter::EncodableValue(static_cast<int64_t>(stats.received))},
+        {flutter::EncodableValue("dispatched"), flutter::EncodableValue(static_cast<int64_t>(stats.dispatched))},
+        {flutter::EncodableValue("coalesced"), flutter::EncodableValue(static_cast<int64_t>(stats.coalesced))},
+        {flutter::EncodableValue("rateLimited"), flutter::EncodableValue(static_cast<int64_t>(stats.rate_limited))},
+        {flutter::EncodableValue("queueFull"), flutter::EncodableValue(static_cast<int64_t>(stats.queue_full))},
+        {flutter::EncodableValue("tooLarge"), flutter::EncodableValue(static_cast<int64_t>(stats.too_large))},
+        {flutter::EncodableValue("dropped"), flutter::EncodableValue(static_cast<int64_t>(stats.dropped()))},
+      };
+    };
+
+    flutter::EncodableMap types;
+    for (const auto& type : message_scheduler_.type_stats()) {
+      types[flutter::EncodableValue(type.type)] = flutter::EncodableValue(counters(type.stats));
+    }
+
+    flutter::EncodableMap stats = counters(message_scheduler_.totals());
+    stats[flutter::EncodableValue("batches")] =
+        flutter::EncodableValue(static_cast<int64_t>(message_scheduler_.batches()));
+    stats[flutter::EncodableValue("batchesCopied")] =
+        flutter::EncodableValue(static_cast<int64_t>(message_scheduler_.batches_copied()));
+    stats[flutter::EncodableValue("types")] = flutter::EncodableValue(types);
+    result->Success(flutter::EncodableValue(stats));
+  }
+  else if (method_call.method_name() == "getScriptStats") {
+    ScriptPipeline::Stats stats = script_pipeline_.stats();
+    result->Success(flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("submitted"), flutter::EncodableValue(static_cast<int64_t>(stats.submitted))},
+      {flutter::EncodableValue("completed"), flutter::EncodableValue(static_cast<int64_t>(stats.completed))},
+      {flutter::EncodableValue("failed"), flutter::EncodableValue(static_cast<int64_t>(stats.failed))},
+      {flutter::EncodableValue("coalesced"), flutter::EncodableValue(static_cast<int64_t>(stats.coalesced))},
+      {flutter::EncodableValue("dropped"), flutter::EncodableValue(static_cast<int64_t>(stats.dropped))},
+      {flutter::EncodableValue("expired"), flutter::EncodableValue(static_cast<int64_t>(stats.expired))},
+      {flutter::EncodableValue("timedOut"), flutter::EncodableValue(static_cast<int64_t>(stats.timed_out))},
+      {flutter::EncodableValue("inFlight"), flutter::EncodableValue(static_cast<int64_t>(stats.in_flight))},
+      {flutter::EncodableValue("queued"), flutter::EncodableValue(static_cast<int64_t>(stats.queued))},
+      {flutter::EncodableValue("latencyAvgMs"), flutter::EncodableValue(stats.latency_avg_ms)},
+      {flutter::EncodableValue("latencyP95Ms"), flutter::EncodableValue(stats.latency_p95_ms)},
+      {flutter::EncodableValue("latencyMaxMs"), flutter::EncodableValue(stats.latency_max_ms)},
+    }));
+  }
+  else if (method_call.method_name() == "setCrashFallback") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+    auto url_it = arguments->find(flutter::EncodableValue("url"));
+    const auto* url = url_it != arguments->end() ? std::get_if<std::string>(&url_it->second) : nullptr;
+    if (!url) {
+      result->Error("INVALID_ARGS", "Missing 'url' argument");
+      return;
+    }
+    if (!NativeWallpaperRenderer::IsNativeDescriptor(*url)) {
+      result->Error("INVALID_ARGS", "Fallback must be a native wallpaper (hkcw-color:, hkcw-gradient:, hkcw-image:)");
+      return;
+    }
+    crash_fallback_url_ = *url;
+    result->Success(flutter::EncodableValue(true));
+  }
+  else if (method_call.method_name() == "getRecoveryStats") {
+    const CrashRecovery::Stats& stats = crash_recovery_->stats();
+    result->Success(flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("failures"), flutter::EncodableValue(static_cast<int64_t>(stats.failures))},
+      {flutter::EncodableValue("ignored"), flutter::EncodableValue(static_cast<int64_t>(stats.ignored))},
+      {flutter::EncodableValue("reloads"), flutter::EncodableValue(static_cast<int64_t>(stats.reloads))},
+      {flutter::EncodableValue("rebuilds"), flutter::EncodableValue(static_cast<int64_t>(stats.rebuilds))},
+      {flutter::EncodableValue("staticFrames"), flutter::EncodableValue(static_cast<int64_t>(stats.static_frames))},
+      {flutter::EncodableValue("restored"), flutter::EncodableValue(static_cast<int64_t>(stats.restored))},
+      {flutter::EncodableValue("lastRestoreMs"), flutter::EncodableValue(static_cast<int64_t>(stats.last_restore_ms))},
+      {flutter::EncodableValue("maxRestoreMs"), flutter::EncodableValue(static_cast<int64_t>(stats.max_restore_ms))},
+      {flutter::EncodableValue("feedsRestored"), flutter::EncodableValue(static_cast<int64_t>(feeds_restored_))},
+      {flutter::EncodableValue("feedsLost"), flutter::EncodableValue(static_cast<int64_t>(feeds_lost_))},
+      {flutter::EncodableValue("recovering"), flutter::EncodableValue(crash_recovery_->state() != CrashRecovery::State::kHealthy && crash_recovery_->state() != CrashRecovery::State::kStaticFrame)},
+    }));
+  }
+  else if (method_call.method_name() == "getShellStats") {
+    result->Success(flutter::EncodableValue(flutter::EncodableMap{
+      {flutter::EncodableValue("recoveries"), flutter::EncodableValue(static_cast<int64_t>(shell_stats_.recoveries))},
+      {flutter::EncodableValue("reloads"), flutter::EncodableValue(static_cast<int64_t>(shell_stats_.reloads))},
+      {flutter::EncodableValue("hostsRecreated"), flutter::EncodableValue(static_cast<int64_t>(shell_stats_.hosts_recreated))},
+      {flutter::EncodableValue("lastRecoveryMs"), flutter::EncodableValue(shell_stats_.last_recovery_ms)},
+      {flutter::EncodableValue("maxRecoveryMs"), flutter::EncodableValue(shell_stats_.max_recovery_ms)},
+      {flutter::EncodableValue("recovering"), flutter::EncodableValue(shell_lost_)},
+    }));
+  }
+  else if (method_call.method_name() == "openFeed") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto name_it = arguments->find(flutter::EncodableValue("name"));
+    if (name_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'name' argument");
+      return;
+    }
+
+    SharedFeed::Options options;
+    auto size_it = arguments->find(flutter::EncodableValue("slotSize"));
+    auto count_it = arguments->find(flutter::EncodableValue("slotCount"));
+    if (size_it != arguments->end()) options.slot_size = static_cast<uint32_t>(std::get<int>(size_it->second));
+    if (count_it != arguments->end()) options.slot_count = static_cast<uint32_t>(std::get<int>(count_it->second));
+    if (options.slot_size == 0 || options.slot_size > kFeedMaxSlotSize ||
+        options.slot_count < 2 || options.slot_count > kFeedMaxSlotCount) {
+      result->Error("INVALID_ARGS", "slotSize must be 1..16777216 and slotCount 2..8");
+      return;
+    }
+
+    const std::string& name = std::get<std::string>(name_it->second);
+    bool opened = OpenFeed(name, options) != nullptr;
+    if (opened) {
+      app_feeds_[name] = options;
+    }
+    result->Success(flutter::EncodableValue(opened));
+  }
+  else if (method_call.method_name() == "publishFeedFrame") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto name_it = arguments->find(flutter::EncodableValue("name"));
+    auto data_it = arguments->find(flutter::EncodableValue("data"));
+    if (name_it == arguments->end() || data_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'name' or 'data' argument");
+      return;
+    }
+
+    int tag = 0;
+    auto tag_it = arguments->find(flutter::EncodableValue("tag"));
+    if (tag_it != arguments->end()) tag = std::get<int>(tag_it->second);
+
+    auto feed_it = feeds_.find(std::get<std::string>(name_it->second));
+    const auto& data = std::get<std::vector<uint8_t>>(data_it->second);
+    bool success = feed_it != feeds_.end() &&
+                   feed_it->second->Publish(data.data(), data.size(), static_cast<uint32_t>(tag));
+    result->Success(flutter::EncodableValue(success));
+  }
+  else if (method_call.method_name() == "closeFeed") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto name_it = arguments->find(flutter::EncodableValue("name"));
+    if (name_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'name' argument");
+      return;
+    }
+
+    const std::string& name = std::get<std::string>(name_it->second);
+    CloseFeed(name);
+    app_feeds_.erase(name);
+    if (name == kAudioFeedName) {
+      app_audio_bands_ = 0;  // The spectrum stops with its feed
+    }
+    result->Success(flutter::EncodableValue(true));
+  }
+  else if (method_call.method_name() == "enableAudioSpectrum") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto enabled_it = arguments->find(flutter::EncodableValue("enabled"));
+    if (enabled_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'enabled' argument");
+      return;
+    }
+
+    size_t band_count = kAudioDefaultBands;
+    auto bands_it = arguments->find(flutter::EncodableValue("bands"));
+    if (bands_it != arguments->end()) {
+      int bands = std::get<int>(bands_it->second);
+      if (bands < 1 || static_cast<size_t>(bands) > kAudioMaxBands) {
+        result->Error("INVALID_ARGS", "bands must be 1..256");
+        return;
+      }
+      band_count = static_cast<size_t>(bands);
+    }
+
+    if (!std::get<bool>(enabled_it->second)) {
+      StopAudioSpectrum();
+      app_audio_bands_ = 0;
+      result->Success(flutter::EncodableValue(true));
+      return;
+    }
+    bool started = StartAudioSpectrum(band_count);
+    app_audio_bands_ = started ? band_count : 0;
+    if (started) {
+      app_feeds_.erase(kAudioFeedName);  // Replaced by the spectrum's own
+    }
+    result->Success(flutter::EncodableValue(started));
+  }
+  else if (method_call.method_name() == "enableKeyboardForwarding") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto enabled_it = arguments->find(flutter::EncodableValue("enabled"));
+    if (enabled_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'enabled' argument");
+      return;
+    }
+
+    SetKeyboardForwarding(std::get<bool>(enabled_it->second));
+    result->Success(flutter::EncodableValue(true));
+  }
+  else if (method_call.method_name() == "setInputSource") {
+    const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments());
+    if (!arguments) {
+      result->Error("INVALID_ARGS", "Arguments must be a map");
+      return;
+    }
+
+    auto source_it = arguments->find(flutter::EncodableValue("source"));
+    if (source_it == arguments->end()) {
+      result->Error("INVALID_ARGS", "Missing 'source' argument");
+      return;
+    }
+    const std::string& source = std::get<std::string>(source_it->second);
+    if (source != "hook" && source != "rawinput" && source != "replay") {
+      result->Error("INVALID_ARGS", "source must be hook, rawinput or replay");
+      return;
+    }
+
+    std::string path;
+    double speed = 1.0;
+    if (source == "replay") {
+      auto path_it = arguments->find(flutter::EncodableValue("path"));
+      if (path_it == arguments->end()) {
+        result->Error("INVALID_ARGS", "Missing 'path' argument");
+        return;
+      }
+      path = std::get<std::string>(path_it->second);
+      auto speed_it = arguments->find(flutter::EncodableValue("speed"));
+      if (speed_it != arguments->end()) {
+        speed = std::get<double>(speed_it->second);
+        if (speed < 0.0) {
+          result->Error("INVALID_ARGS", "speed must be >= 0");
+          return;
+        }
+      }
+    }
+    result->Success(flutter::EncodableValue(SetInputSource(source, path, speed)));
+  }
+  else if (method_call.method_name() == "capturePreview") {
+    int max_width = kPreviewDefaultWidth;
+    int max_height = kPreviewDefaultHeight;
+    if (const auto* arguments = std::get_if<flutter::EncodableMap>(method_call.arguments())) {
+      auto width_it = arguments->find(flutter::EncodableValue("maxWidth"));
+      auto height_it = arguments->find(flutter::EncodableValue("maxHeight"));
+      if (width_it != arguments->end()) max_width = std::get<int>(width_it->second);
+      if (height_it != arguments->end()) max_height = std::get<int>(height_it->second);
+    }
+
+    if (max_width <= 0 || max_height <= 0 || max_width > kPreviewMaxSize || max_height > kPreviewMaxSize) {
+      result->Error("INVALID_ARGS", "maxWidth/maxHeight must be between 1 and 1024");
+      return;
+    }
+
+    CapturePreview(max_width, max_height, std::move(result));
+  }
   else {
     result->NotImplemented();
   }
@@ -437,197 +1088,299 @@ HWND HkcwEngine2Plugin::CreateWebViewHostWindow() {
   return hwnd;
 }
 
-void HkcwEngine2Plugin::SetupWebView2(HWND hwnd, const std::string& url) {
-  std::cout << "[HKCW] Setting up WebView2..." << std::endl;
-
-  // Convert URL to wstring
-  std::wstring wurl(url.begin(), url.end());
+// WebView Async: Reuse the shared environment, join a creation already in
+// flight, or start one; the result is kept whichever session asked
+Async<Microsoft::WRL::ComPtr<ICoreWebView2Environment>> HkcwEngine2Plugin::PrepareEnvironment() {
+  using EnvironmentPtr = Microsoft::WRL::ComPtr<ICoreWebView2Environment>;
+  
+  // P1-1: Use shared environment if available
+  if (shared_environment_) {
+    std::cout << "[HKCW] [Performance] Reusing existing WebView2 environment" << std::endl;
+    return Async<EnvironmentPtr>::Resolved(S_OK, shared_environment_);
+  }
+  if (pending_environment_.valid() && !pending_environment_.done()) {
+    return pending_environment_;
+  }
 
   // Get user data folder
   wchar_t user_data_folder[MAX_PATH];
   GetEnvironmentVariableW(L"APPDATA", user_data_folder, MAX_PATH);
   wcscat_s(user_data_folder, L"\\HKCWEngine2");
   
-  // P1-1: Use shared environment if available
-  if (shared_environment_) {
-    std::cout << "[HKCW] [Performance] Reusing existing WebView2 environment" << std::endl;
+  // P1-1: Create environment (will save for reuse)
+  pending_environment_ = CreateEnvironmentAsync(user_data_folder);
+  pending_environment_.Then(CancellationToken(), [](AsyncStatus status, const EnvironmentPtr& env) {
+    if (FAILED(status)) {
+      std::cout << "[HKCW] ERROR: Failed to create WebView2 environment: " << std::hex << status << std::dec << std::endl;
+      return;
+    }
+    std::cout << "[HKCW] WebView2 environment created" << std::endl;
+    shared_environment_ = env;
+  });
+  return pending_environment_;
+}
+
+void HkcwEngine2Plugin::SetupWebView2(HWND hwnd, const std::string& url) {
+  std::cout << "[HKCW] Setting up WebView2..." << std::endl;
+
+  // Crash Recovery: Until the first navigation starts
+  page_url_ = url;
+  
+  // WebView Async: Everything below runs only while this session lasts
+  CancellationToken session = webview_session_.token();
+  
+  PrepareEnvironment().Then(session, [this, hwnd, url, session](AsyncStatus status, const Microsoft::WRL::ComPtr<ICoreWebView2Environment>& env) {
+    if (FAILED(status)) {
+      OnWebViewSetupFailed();
+      return;
+    }
     
-    auto controller_callback = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-        [this, hwnd, wurl](HRESULT result, ICoreWebView2Controller* controller) -> HRESULT {
+    auto controller = CreateControllerAsync(env.Get(), hwnd);
+    controller.Then(
+        session,
+        [this, hwnd, url](AsyncStatus result, const Microsoft::WRL::ComPtr<ICoreWebView2Controller>& created) {
           if (FAILED(result)) {
-            std::cout << "[HKCW] ERROR: Failed to create WebView2 controller: " << std::hex << result << std::endl;
-            return result;
+            std::cout << "[HKCW] ERROR: Failed to create WebView2 controller: " << std::hex << result << std::dec << std::endl;
+            OnWebViewSetupFailed();
+            return;
           }
-
-          std::cout << "[HKCW] WebView2 controller created" << std::endl;
-
-          webview_controller_ = controller;
-          webview_controller_->get_CoreWebView2(&webview_);
-
-          // Set bounds
-          RECT bounds;
-          GetClientRect(hwnd, &bounds);
-          std::cout << "[HKCW] Setting WebView bounds: " << bounds.left << "," << bounds.top 
-                    << " " << (bounds.right - bounds.left) << "x" << (bounds.bottom - bounds.top) << std::endl;
-          
-          webview_controller_->put_Bounds(bounds);
-          webview_controller_->put_IsVisible(TRUE);
-
-              // P1-3: Configure permissions and security
-              ConfigurePermissions();
-              SetupSecurityHandlers();
-              
-              // API Bridge: Setup message bridge only (no SDK injection, user loads it)
-              SetupMessageBridge();
-
-              // Navigate
-              webview_->Navigate(wurl.c_str());
-              
-              // After navigation completes, send interaction mode
-              webview_->add_NavigationCompleted(
-                Microsoft::WRL::Callback<ICoreWebView2NavigationCompletedEventHandler>(
-                  [this](ICoreWebView2* sender, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT {
-                    // Send interaction mode to JavaScript
-                    std::wstringstream script;
-                    script << L"(function() {"
-                           << L"  var event = new CustomEvent('hkcw:interactionMode', {"
-                           << L"    detail: { enabled: " << (enable_interaction_ ? L"true" : L"false") << L" }"
-                           << L"  });"
-                           << L"  window.dispatchEvent(event);"
-                           << L"  console.log('[HKCW] Interaction mode set to: " << (enable_interaction_ ? L"true" : L"false") << L"');"
-                           << L"})();";
-                    
-                    webview_->ExecuteScript(script.str().c_str(), nullptr);
-                    std::cout << "[HKCW] [API] Sent interaction mode to JS: " << enable_interaction_ << std::endl;
-                    return S_OK;
-                  }).Get(), nullptr);
-          std::string url_str;
-          for (wchar_t c : wurl) {
-            if (c < 128) url_str.push_back(static_cast<char>(c));
+          AttachController(created.Get(), hwnd, url);
+        },
+        [](const Microsoft::WRL::ComPtr<ICoreWebView2Controller>& created) {
+          // Stopped while the controller was being created
+          if (created) {
+            std::cout << "[HKCW] Discarding controller of a cancelled setup" << std::endl;
+            created->Close();
           }
-          std::cout << "[HKCW] Navigating to: " << url_str << std::endl;
-
-          is_initialized_ = true;
-          return S_OK;
         });
+  });
+}
 
-    shared_environment_->CreateCoreWebView2Controller(hwnd, controller_callback.Get());
-    return;
+// WebView Async: Configure a new controller and start navigating; handlers
+// are registered before the navigation so none of its events are missed.
+// Everything up to Navigate is a synchronous call on this thread, so
+// there is nothing here to run concurrently; the only independent wait,
+// environment creation, already overlaps the WorkerW search
+void HkcwEngine2Plugin::AttachController(ICoreWebView2Controller* controller, HWND hwnd,
+                                         const std::string& url) {
+  std::cout << "[HKCW] WebView2 controller created" << std::endl;
+
+  webview_controller_ = controller;
+  webview_controller_->get_CoreWebView2(&webview_);
+
+  // Set bounds to match window
+  RECT bounds;
+  GetClientRect(hwnd, &bounds);
+  std::cout << "[HKCW] Setting WebView bounds: " << bounds.left << "," << bounds.top 
+            << " " << (bounds.right - bounds.left) << "x" << (bounds.bottom - bounds.top) << std::endl;
+  
+  HRESULT hr = webview_controller_->put_Bounds(bounds);
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] ERROR: Failed to set bounds: " << std::hex << hr << std::dec << std::endl;
   }
+  
+  // Make sure WebView is visible
+  webview_controller_->put_IsVisible(TRUE);
 
-  // P1-1: Create environment (will save for reuse)
-  auto callback = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
-      [this, hwnd, wurl](HRESULT result, ICoreWebView2Environment* env) -> HRESULT {
-        if (FAILED(result)) {
-          std::cout << "[HKCW] ERROR: Failed to create WebView2 environment: " << std::hex << result << std::endl;
-          return result;
-        }
+  // P1-3: Configure permissions and security
+  ConfigurePermissions();
+  SetupSecurityHandlers();
+  
+  // API Bridge: Setup message bridge only (no SDK injection, user loads it)
+  SetupMessageBridge();
+  SetupProcessFailedHandler();
+  
+  // Crash Recovery: A rebuilt controller gets Dart's feeds back before the
+  // navigation shares them
+  RestoreAppFeeds();
 
-        std::cout << "[HKCW] WebView2 environment created" << std::endl;
+  // After every navigation completes, send interaction mode
+  webview_->add_NavigationCompleted(
+    Microsoft::WRL::Callback<ICoreWebView2NavigationCompletedEventHandler>(
+      [this](ICoreWebView2* sender, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT {
+        // Preview: New document, cached thumbnails are stale
+        frame_generation_++;
+        
+        // Crash Recovery: A recovered page is back
+        BOOL success = FALSE;
+        args->get_IsSuccess(&success);
+        if (success) {
+          crash_recovery_->OnRestored(GetTickCount64());
+        }
+        
+        SendInteractionMode();
+        
+        // Shared Feed: The new document has no buffers yet
+        ShareFeeds();
         
-        // P1-1: Save environment for reuse
-        shared_environment_ = env;
-
-        auto controller_callback = Microsoft::WRL::Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
-            [this, hwnd, wurl](HRESULT result, ICoreWebView2Controller* controller) -> HRESULT {
-              if (FAILED(result)) {
-                std::cout << "[HKCW] ERROR: Failed to create WebView2 controller: " << std::hex << result << std::endl;
-                return result;
-              }
-
-              std::cout << "[HKCW] WebView2 controller created" << std::endl;
-
-              webview_controller_ = controller;
-              webview_controller_->get_CoreWebView2(&webview_);
-
-              // Set bounds to match window
-              RECT bounds;
-              GetClientRect(hwnd, &bounds);
-              std::cout << "[HKCW] Setting WebView bounds: " << bounds.left << "," << bounds.top 
-                        << " " << (bounds.right - bounds.left) << "x" << (bounds.bottom - bounds.top) << std::endl;
-              
-              HRESULT hr = webview_controller_->put_Bounds(bounds);
-              if (FAILED(hr)) {
-                std::cout << "[HKCW] ERROR: Failed to set bounds: " << std::hex << hr << std::endl;
-              }
-              
-              // Make sure WebView is visible
-              webview_controller_->put_IsVisible(TRUE);
-              std::cout << "[HKCW] WebView2 visibility set to TRUE" << std::endl;
-
-              // P1-3: Configure permissions and security
-              ConfigurePermissions();
-              SetupSecurityHandlers();
-              
-              // API Bridge: Setup message bridge only (no SDK injection, user loads it)
-              SetupMessageBridge();
-
-              // Navigate to URL
-              webview_->Navigate(wurl.c_str());
-              
-              // After navigation completes, send interaction mode
-              webview_->add_NavigationCompleted(
-                Microsoft::WRL::Callback<ICoreWebView2NavigationCompletedEventHandler>(
-                  [this](ICoreWebView2* sender, ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT {
-                    // Send interaction mode to JavaScript
-                    std::wstringstream script;
-                    script << L"(function() {"
-                           << L"  var event = new CustomEvent('hkcw:interactionMode', {"
-                           << L"    detail: { enabled: " << (enable_interaction_ ? L"true" : L"false") << L" }"
-                           << L"  });"
-                           << L"  window.dispatchEvent(event);"
-                           << L"  console.log('[HKCW] Interaction mode set to: " << (enable_interaction_ ? L"true" : L"false") << L"');"
-                           << L"})();";
-                    
-                    webview_->ExecuteScript(script.str().c_str(), nullptr);
-                    std::cout << "[HKCW] [API] Sent interaction mode to JS: " << enable_interaction_ << std::endl;
-                    return S_OK;
-                  }).Get(), nullptr);
-              
-              // Convert wstring to string for logging
-              std::string url_str;
-              for (wchar_t c : wurl) {
-                if (c < 128) url_str.push_back(static_cast<char>(c));
-              }
-              std::cout << "[HKCW] Navigating to: " << url_str << std::endl;
-
-              is_initialized_ = true;
-              return S_OK;
-            });
-
-        env->CreateCoreWebView2Controller(hwnd, controller_callback.Get());
+        // Input Listeners: Fall back for pages that never report
+        WatchInputListeners();
         return S_OK;
-      });
-
-  HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(
-      nullptr, user_data_folder, nullptr, callback.Get());
+      }).Get(), nullptr);
 
-  if (FAILED(hr)) {
-    std::cout << "[HKCW] ERROR: CreateCoreWebView2EnvironmentWithOptions failed: " << std::hex << hr << std::endl;
+  // Navigate to URL
+  std::cout << "[HKCW] Navigating to: " << url << std::endl;
+  auto navigation = StartNavigation(url);
+  if (navigation.done() && FAILED(navigation.status())) {
+    std::cout << "[HKCW] ERROR: Navigate failed: " << std::hex << navigation.status() << std::dec << std::endl;
   }
+
+  is_initialized_ = true;
 }
 
-// P0-2: Initialize with retry mechanism
-bool HkcwEngine2Plugin::InitializeWithRetry(const std::string& url, bool enable_mouse_transparent, int max_retries) {
-  std::cout << "[HKCW] [Retry] Attempt " << (init_retry_count_ + 1) << " of " << max_retries << std::endl;
-  
-  bool success = InitializeWallpaper(url, enable_mouse_transparent);
-  
-  if (!success && init_retry_count_ < max_retries - 1) {
-    init_retry_count_++;
-    std::cout << "[HKCW] [Retry] Initialization failed, retrying in 1 second..." << std::endl;
-    Sleep(1000);
-    return InitializeWithRetry(url, enable_mouse_transparent, max_retries);
-  }
-  
-  if (success) {
-    init_retry_count_ = 0;  // Reset on success
-  }
-  
-  return success;
+// WebView Async: Navigations the plugin starts are timed to their own
+// completion; ones the page starts itself are not. Closing the WebView
+// drops the wait.
+Async<bool> HkcwEngine2Plugin::StartNavigation(const std::string& url) {
+  auto started = std::chrono::steady_clock::now();
+  auto navigation = NavigateAsync(webview_.Get(), Utf8ToWide(url), webview_session_.token());
+  navigation.Then(webview_session_.token(), [started](AsyncStatus status, bool success) {
+    if (FAILED(status)) return;  // Navigate itself failed; the caller logs it
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - started).count();
+    std::cout << "[HKCW] [Performance] Navigation " << (success ? "completed" : "failed")
+              << " in " << elapsed << "ms" << std::endl;
+  });
+  return navigation;
 }
 
-// P0-2: Error logging
+// Crash Recovery: Map WebView2's failure kinds onto recovery decisions
+void HkcwEngine2Plugin::SetupProcessFailedHandler() {
+  if (!webview_) return;
+  
+  webview_->add_ProcessFailed(
+    Microsoft::WRL::Callback<ICoreWebView2ProcessFailedEventHandler>(
+      [this](ICoreWebView2* sender, ICoreWebView2ProcessFailedEventArgs* args) -> HRESULT {
+        COREWEBVIEW2_PROCESS_FAILED_KIND kind;
+        if (FAILED(args->get_ProcessFailedKind(&kind))) {
+          return S_OK;
+        }
+        
+        ProcessFailure failure = ProcessFailure::kOther;
+        if (kind == COREWEBVIEW2_PROCESS_FAILED_KIND_BROWSER_PROCESS_EXITED) {
+          failure = ProcessFailure::kBrowserExited;
+        } else if (kind == COREWEBVIEW2_PROCESS_FAILED_KIND_RENDER_PROCESS_EXITED) {
+          failure = ProcessFailure::kRendererExited;
+        } else if (kind == COREWEBVIEW2_PROCESS_FAILED_KIND_RENDER_PROCESS_UNRESPONSIVE) {
+          failure = ProcessFailure::kRendererUnresponsive;
+        }
+        
+        RecoveryAction action = crash_recovery_->OnFailure(failure, GetTickCount64());
+        std::cout << "[HKCW] [Recovery] Process failed (kind " << kind << "), action: "
+                  << RecoveryActionName(action) << std::endl;
+        return S_OK;
+      }).Get(), nullptr);
+}
+
+// Crash Recovery: Setup that was part of a recovery failed; the next
+// attempt starts from a fresh environment
+void HkcwEngine2Plugin::OnWebViewSetupFailed() {
+  if (crash_recovery_->state() != CrashRecovery::State::kRecovering) {
+    return;
+  }
+  shared_environment_ = nullptr;
+  crash_recovery_->OnFailure(ProcessFailure::kBrowserExited, GetTickCount64());
+}
+
+// Crash Recovery: New controller on the existing host; SetupWebView2 reuses
+// shared_environment_, whose browser process WebView2 starts again
+bool HkcwEngine2Plugin::RebuildController() {
+  if (!webview_host_hwnd_ || !IsWindow(webview_host_hwnd_) || page_url_.empty()) {
+    return false;
+  }
+  std::cout << "[HKCW] [Recovery] Rebuilding controller for: " << page_url_ << std::endl;
+  
+  std::string url = page_url_;
+  CloseWebView();
+  SetupWebView2(webview_host_hwnd_, url);
+  return true;
+}
+
+// Crash Recovery: Feeds and the spectrum Dart opened went with the old
+// WebView; open them again on the new one. A feed that cannot be opened
+// is dropped and counted, so getRecoveryStats shows what the page lost
+void HkcwEngine2Plugin::RestoreAppFeeds() {
+  for (auto it = app_feeds_.begin(); it != app_feeds_.end();) {
+    if (OpenFeed(it->first, it->second)) {
+      feeds_restored_++;
+      ++it;
+    } else {
+      std::cout << "[HKCW] [Recovery] ERROR: Feed " << it->first << " lost" << std::endl;
+      feeds_lost_++;
+      it = app_feeds_.erase(it);
+    }
+  }
+  
+  if (app_audio_bands_ == 0) return;
+  if (StartAudioSpectrum(app_audio_bands_)) {
+    feeds_restored_++;
+  } else {
+    std::cout << "[HKCW] [Recovery] ERROR: Audio spectrum lost" << std::endl;
+    feeds_lost_++;
+    app_audio_bands_ = 0;
+  }
+}
+
+// Crash Recovery: Crash loop; a native frame until the next wallpaper
+void HkcwEngine2Plugin::ShowCrashFallback() {
+  std::cout << "[HKCW] [Recovery] Crash loop, showing static frame: " << crash_fallback_url_ << std::endl;
+  LogError("WebView crash loop, static fallback shown");
+  
+  CloseWebView();
+  enable_interaction_ = false;
+  if (!webview_host_hwnd_) {
+    return;
+  }
+  
+  native_renderer_ = std::make_unique<NativeWallpaperRenderer>();
+  native_renderer_->SetCacheDirectory(GetImageCacheDirectory());
+  if (native_renderer_->Attach(webview_host_hwnd_) && native_renderer_->Show(crash_fallback_url_)) {
+    native_url_ = crash_fallback_url_;
+    frame_generation_++;
+  }
+}
+
+// URL Rules: %APPDATA%\HKCWEngine2\url_rules.txt
+std::string HkcwEngine2Plugin::GetDefaultRuleFilePath() {
+  char app_data[MAX_PATH];
+  DWORD length = GetEnvironmentVariableA("APPDATA", app_data, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::string();
+  }
+  return std::string(app_data) + "\\HKCWEngine2\\url_rules.txt";
+}
+
+// Native Renderer: Pre-scaled images are machine-local, keep them out of roaming
+std::string HkcwEngine2Plugin::GetImageCacheDirectory() {
+  char local_app_data[MAX_PATH];
+  DWORD length = GetEnvironmentVariableA("LOCALAPPDATA", local_app_data, MAX_PATH);
+  if (length == 0 || length >= MAX_PATH) {
+    return std::string();
+  }
+  return std::string(local_app_data) + "\\HKCWEngine2\\image_cache";
+}
+
+// P0-2: Initialize with retry mechanism
+bool HkcwEngine2Plugin::InitializeWithRetry(const std::string& url, bool enable_mouse_transparent, int max_retries) {
+  std::cout << "[HKCW] [Retry] Attempt " << (init_retry_count_ + 1) << " of " << max_retries << std::endl;
+  
+  bool success = InitializeWallpaper(url, enable_mouse_transparent);
+  
+  if (!success && init_retry_count_ < max_retries - 1) {
+    init_retry_count_++;
+    std::cout << "[HKCW] [Retry] Initialization failed, retrying in 1 second..." << std::endl;
+    Sleep(1000);
+    return InitializeWithRetry(url, enable_mouse_transparent, max_retries);
+  }
+  
+  if (success) {
+    init_retry_count_ = 0;  // Reset on success
+  }
+  
+  return success;
+}
+
+// P0-2: Error logging
 void HkcwEngine2Plugin::LogError(const std::string& error) {
   std::ofstream log("hkcw_errors.log", std::ios::app);
   if (log.is_open()) {
@@ -709,11 +1462,7 @@ void HkcwEngine2Plugin::SetupSecurityHandlers() {
         LPWSTR uri;
         args->get_Uri(&uri);
         
-        std::wstring wuri(uri);
-        std::string url;
-        for (wchar_t c : wuri) {
-          if (c < 128) url.push_back(static_cast<char>(c));
-        }
+        std::string url = WideToUtf8(uri);
         
         // P0-3: Validate URL
         if (!url_validator_.IsAllowed(url)) {
@@ -722,91 +1471,138 @@ void HkcwEngine2Plugin::SetupSecurityHandlers() {
           LogError("Navigation blocked: " + url);
         } else {
           std::cout << "[HKCW] [Security] Navigation allowed: " << url << std::endl;
+          // Request Filter: Party checks are relative to the top-level page
+          document_host_ = std::string(RequestFilter::ExtractHost(url));
+          
+          // Crash Recovery: What a rebuilt controller navigates to
+          page_url_ = url;
+          
+          // System Telemetry: Subscriptions belong to the old document
+          StopTelemetry();
+          
+          // Input Listeners: Likewise; no input source until the new page asks
+          ResetInputListeners();
+        }
+        
+        CoTaskMemFree(uri);
+        return S_OK;
+      }).Get(), nullptr);
+  
+  // Request Filter: Subresources (scripts, images, ad iframes, XHR...)
+  webview_->add_WebResourceRequested(
+    Microsoft::WRL::Callback<ICoreWebView2WebResourceRequestedEventHandler>(
+      [this](ICoreWebView2* sender, ICoreWebView2WebResourceRequestedEventArgs* args) -> HRESULT {
+        Microsoft::WRL::ComPtr<ICoreWebView2WebResourceRequest> request;
+        COREWEBVIEW2_WEB_RESOURCE_CONTEXT context;
+        if (FAILED(args->get_Request(&request)) || FAILED(args->get_ResourceContext(&context))) {
+          return S_OK;
         }
         
+        LPWSTR uri;
+        if (FAILED(request->get_Uri(&uri))) return S_OK;
+        
+        // Hot path: reuse one buffer for every subresource URL
+        WideToUtf8(uri, resource_url_buffer_);
         CoTaskMemFree(uri);
+        
+        // The wallpaper page's own request carries the URL its navigation
+        // started with, minus the fragment
+        std::string_view page(page_url_);
+        bool main_frame = context == COREWEBVIEW2_WEB_RESOURCE_CONTEXT_DOCUMENT &&
+                          resource_url_buffer_ == page.substr(0, page.find('#'));
+        
+        FilterRequest filter_request;
+        filter_request.url = resource_url_buffer_;
+        filter_request.document_host = document_host_;
+        filter_request.type = ResourceTypeFromContext(context, main_frame);
+        
+        if (request_filter_.ShouldBlock(filter_request) && shared_environment_) {
+          Microsoft::WRL::ComPtr<ICoreWebView2WebResourceResponse> response;
+          if (SUCCEEDED(shared_environment_->CreateWebResourceResponse(
+                  nullptr, 403, L"Blocked", L"", &response))) {
+            args->put_Response(response.Get());
+          }
+        }
         return S_OK;
       }).Get(), nullptr);
   
+  resource_filter_installed_ = false;
+  InstallResourceFilter();
+  
   std::cout << "[HKCW] [Security] Security handlers installed" << std::endl;
 }
 
-// API Bridge: Load SDK JavaScript
-std::string HkcwEngine2Plugin::LoadSDKScript() {
-  std::cout << "[HKCW] [API] Loading HKCW SDK script..." << std::endl;
+// Request Filter: Load an EasyList-style list and rebuild the index
+bool HkcwEngine2Plugin::LoadFilterList(const std::string& path) {
+  size_t added = request_filter_.LoadFile(path);
+  if (added == 0) {
+    LogError("Filter list empty or unreadable: " + path);
+    return false;
+  }
   
-  // Get SDK file path
-  char module_path[MAX_PATH];
-  GetModuleFileNameA(nullptr, module_path, MAX_PATH);
-  std::string exe_dir(module_path);
-  size_t last_slash = exe_dir.find_last_of("\\/");
-  if (last_slash != std::string::npos) {
-    exe_dir = exe_dir.substr(0, last_slash);
+  request_filter_.Compile();
+  InstallResourceFilter();
+  return true;
+}
+
+// Request Filter: WebResourceRequested only fires for registered filters,
+// so interception is enabled lazily once rules exist
+void HkcwEngine2Plugin::InstallResourceFilter() {
+  if (!webview_ || resource_filter_installed_ || request_filter_.rule_count() == 0) {
+    return;
   }
   
-  std::string sdk_path = exe_dir + "\\data\\flutter_assets\\packages\\hkcw_engine2\\hkcw_sdk.js";
+  HRESULT hr = webview_->AddWebResourceRequestedFilter(L"*", COREWEBVIEW2_WEB_RESOURCE_CONTEXT_ALL);
+  if (SUCCEEDED(hr)) {
+    resource_filter_installed_ = true;
+    std::cout << "[HKCW] [Filter] Subresource filtering enabled (" 
+              << request_filter_.rule_count() << " rules)" << std::endl;
+  } else {
+    std::cout << "[HKCW] [Filter] ERROR: AddWebResourceRequestedFilter failed: " << std::hex << hr << std::endl;
+  }
+}
+
+// Request Filter: With no rules left, stop routing every request through
+// the handler
+void HkcwEngine2Plugin::RemoveResourceFilter() {
+  if (!webview_ || !resource_filter_installed_) {
+    resource_filter_installed_ = false;
+    return;
+  }
   
-  std::ifstream file(sdk_path);
-  if (!file.is_open()) {
-    std::cout << "[HKCW] [API] WARNING: SDK file not found at: " << sdk_path << std::endl;
-    std::cout << "[HKCW] [API] Using embedded SDK script" << std::endl;
-    
-    // Return embedded minimal SDK
-    return R"(
-(function() {
-  window.HKCW = {
-    version: '3.1.0',
-    dpiScale: window.devicePixelRatio || 1,
-    screenWidth: screen.width * (window.devicePixelRatio || 1),
-    screenHeight: screen.height * (window.devicePixelRatio || 1),
-    interactionEnabled: true,
-    
-    onClick: function(element, callback, options) {
-      console.log('[HKCW] onClick registered');
-      setTimeout(function() {
-        var el = (typeof element === 'string') ? document.querySelector(element) : element;
-        if (el) el.addEventListener('click', function(e) { callback(e.clientX, e.clientY); });
-      }, 2000);
-    },
-    
-    openURL: function(url) {
-      console.log('[HKCW] Opening URL:', url);
-      if (window.chrome && window.chrome.webview) {
-        window.chrome.webview.postMessage({type: 'openURL', url: url});
-      }
-    },
-    
-    ready: function(name) {
-      console.log('[HKCW] Ready:', name);
-      if (window.chrome && window.chrome.webview) {
-        window.chrome.webview.postMessage({type: 'ready', name: name});
-      }
-    },
-    
-    onMouse: function(callback) {
-      window.addEventListener('hkcw:mouse', function(e) { callback(e.detail); });
-    },
-    
-    onKeyboard: function(callback) {
-      window.addEventListener('hkcw:keyboard', function(e) { callback(e.detail); });
-    },
+  HRESULT hr = webview_->RemoveWebResourceRequestedFilter(L"*", COREWEBVIEW2_WEB_RESOURCE_CONTEXT_ALL);
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] [Filter] ERROR: RemoveWebResourceRequestedFilter failed: " << std::hex << hr << std::dec << std::endl;
+  }
+  resource_filter_installed_ = false;
+  std::cout << "[HKCW] [Filter] Subresource filtering disabled" << std::endl;
+}
+
+// API Bridge: SDK source for injection. The build embeds windows/hkcw_sdk.js;
+// HKCW_SDK_PATH points at a working copy during development and is read once.
+const wchar_t* HkcwEngine2Plugin::GetSDKScript() {
+  static const std::wstring override_script = [] {
+    wchar_t path[MAX_PATH];
+    DWORD length = GetEnvironmentVariableW(L"HKCW_SDK_PATH", path, MAX_PATH);
+    if (length == 0 || length >= MAX_PATH) {
+      return std::wstring();
+    }
     
-    enableDebug: function() {
-      console.log('[HKCW] Debug enabled');
+    std::ifstream file(std::filesystem::path(path), std::ios::binary);
+    if (!file.is_open()) {
+      std::cout << "[HKCW] [API] WARNING: HKCW_SDK_PATH not readable, using embedded SDK" << std::endl;
+      return std::wstring();
     }
-  };
-  console.log('[HKCW SDK] Loaded v' + HKCW.version);
-})();
-)";
-  }
-  
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  std::string script = buffer.str();
-  file.close();
+    
+    std::string script((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::cout << "[HKCW] [API] SDK override loaded (" << script.length() << " bytes)" << std::endl;
+    return Utf8ToWide(script);
+  }();
   
-  std::cout << "[HKCW] [API] SDK script loaded (" << script.length() << " bytes)" << std::endl;
-  return script;
+  if (!override_script.empty()) {
+    return override_script.c_str();
+  }
+  return kEmbeddedSdkScript;
 }
 
 // API Bridge: Inject SDK into page
@@ -815,13 +1611,11 @@ void HkcwEngine2Plugin::InjectHKCWSDK() {
   
   std::cout << "[HKCW] [API] Injecting HKCW SDK..." << std::endl;
   
-  // Load SDK script
-  std::string sdk_script = LoadSDKScript();
-  std::wstring wsdk_script(sdk_script.begin(), sdk_script.end());
+  std::cout << "[HKCW] [API] SDK v" << kEmbeddedSdkVersion << " (" << kEmbeddedSdkHash << ")" << std::endl;
   
   // Inject on every navigation
   webview_->AddScriptToExecuteOnDocumentCreated(
-    wsdk_script.c_str(),
+    GetSDKScript(),
     Microsoft::WRL::Callback<ICoreWebView2AddScriptToExecuteOnDocumentCreatedCompletedHandler>(
       [](HRESULT result, LPCWSTR id) -> HRESULT {
         if (SUCCEEDED(result)) {
@@ -845,29 +1639,209 @@ void HkcwEngine2Plugin::SetupMessageBridge() {
         LPWSTR message;
         args->get_WebMessageAsJson(&message);
         
-        std::wstring wmessage(message);
-        std::string msg;
-        for (wchar_t c : wmessage) {
-          if (c < 128) msg.push_back(static_cast<char>(c));
-        }
-        
-        HandleWebMessage(msg);
-        
+        WideToUtf8(message, message_buffer_);
         CoTaskMemFree(message);
+        
+        // Message Scheduler: Queue now, handle on a later UI-loop turn;
+        // SDK batches are split into their messages without reparsing
+        auto now = std::chrono::steady_clock::now();
+        bool queued = false;
+        if (MessageScheduler::MessageType(message_buffer_) == "BATCH") {
+          queued = message_scheduler_.EnqueueBatch(message_buffer_, now) > 0;
+        } else {
+          MessageScheduler::Result result = message_scheduler_.Enqueue(message_buffer_, now);
+          queued = result == MessageScheduler::Result::kQueued ||
+                   result == MessageScheduler::Result::kCoalesced;
+        }
+        if (queued) {
+          ScheduleMessageDrain();
+        }
         return S_OK;
       }).Get(), nullptr);
   
   std::cout << "[HKCW] [API] Message bridge ready" << std::endl;
 }
 
+// Message Scheduler: Per-type budgets; IFRAME_DATA is a full snapshot,
+// so only the newest one matters
+void HkcwEngine2Plugin::ConfigureMessageScheduler() {
+  message_scheduler_.SetPolicy("IFRAME_DATA", {20.0, 4.0, true});
+  message_scheduler_.SetPolicy("LOG", {50.0, 100.0, false});
+  message_scheduler_.SetPolicy("OPEN_URL", {5.0, 5.0, false});
+  message_scheduler_.SetPolicy("openURL", {5.0, 5.0, false});
+  message_scheduler_.SetPolicy("READY", {2.0, 5.0, false});
+  message_scheduler_.SetPolicy("ready", {2.0, 5.0, false});
+  message_scheduler_.SetPolicy("INPUT_LISTENERS", {5.0, 5.0, true});  // Latest wins
+  message_scheduler_.SetPolicy("KEYBOARD_LISTENERS", {5.0, 5.0, true});
+  message_scheduler_.SetPolicy("HIT_REGIONS", {10.0, 5.0, true});  // The whole set; latest wins
+  message_scheduler_.SetPolicy("HIT_REGION_SET", {30.0, 64.0, false});  // SDK < 3.9.4, one per region
+  message_scheduler_.SetPolicy("HIT_REGION_REMOVE", {30.0, 64.0, false});
+  message_scheduler_.SetPolicy("TELEMETRY_SUBSCRIPTION", {2.0, 5.0, true});  // Latest wins
+  message_scheduler_.SetDefaultPolicy({20.0, 40.0, false});
+}
+
+HWND HkcwEngine2Plugin::CreateDispatchWindow() {
+  static bool class_registered = false;
+  if (!class_registered) {
+    WNDCLASSW wc = {};
+    wc.lpfnWndProc = DispatchWindowProc;
+    wc.hInstance = GetModuleHandle(nullptr);
+    wc.lpszClassName = kDispatchWindowClassName;
+    if (!RegisterClassW(&wc) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+      std::cout << "[HKCW] [Scheduler] ERROR: Failed to register dispatch window class" << std::endl;
+      return nullptr;
+    }
+    class_registered = true;
+  }
+  
+  HWND hwnd = CreateWindowExW(0, kDispatchWindowClassName, L"", 0, 0, 0, 0, 0,
+                              HWND_MESSAGE, nullptr, GetModuleHandle(nullptr), nullptr);
+  if (!hwnd) {
+    std::cout << "[HKCW] [Scheduler] ERROR: Failed to create dispatch window, error: "
+              << GetLastError() << std::endl;
+    return nullptr;
+  }
+  
+  SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+  return hwnd;
+}
+
+// Shell Recovery: Broadcasts only reach top-level windows, so this one is
+// a hidden tool window rather than message-only
+HWND HkcwEngine2Plugin::CreateShellWatchWindow() {
+  if (!dispatch_hwnd_) {
+    return nullptr;  // Class not registered
+  }
+  
+  HWND hwnd = CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, kDispatchWindowClassName,
+                              kShellWatchWindowTitle, WS_POPUP, 0, 0, 0, 0, nullptr, nullptr,
+                              GetModuleHandle(nullptr), nullptr);
+  if (!hwnd) {
+    std::cout << "[HKCW] [Shell] ERROR: Failed to create shell watch window, error: "
+              << GetLastError() << std::endl;
+    return nullptr;
+  }
+  
+  // An elevated app would otherwise never see explorer's broadcast
+  ChangeWindowMessageFilterEx(hwnd, TaskbarCreatedMessage(), MSGFLT_ALLOW, nullptr);
+  SetWindowLongPtrW(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+  return hwnd;
+}
+
+void HkcwEngine2Plugin::ScheduleMessageDrain() {
+  if (!dispatch_hwnd_) {
+    DrainWebMessages();
+    return;
+  }
+  if (drain_posted_) return;
+  
+  // One posted message per batch keeps input and paint messages interleaved
+  KillTimer(dispatch_hwnd_, kDrainTimerId);
+  drain_posted_ = PostMessageW(dispatch_hwnd_, kDrainMessage, 0, 0) != FALSE;
+}
+
+void HkcwEngine2Plugin::DrainWebMessages() {
+  drain_posted_ = false;
+  
+  MessageScheduler::DrainResult drain = message_scheduler_.Drain(
+      kDrainMaxMessages, kDrainBudget, std::chrono::steady_clock::now(),
+      [this](std::string_view message) { HandleWebMessage(message); });
+  
+  uint64_t dropped = message_scheduler_.totals().dropped();
+  if (dropped != messages_dropped_logged_) {
+    std::cout << "[HKCW] [Scheduler] Dropped " << (dropped - messages_dropped_logged_)
+              << " web message(s) (rate limit / queue full / too large)" << std::endl;
+    messages_dropped_logged_ = dropped;
+  }
+  
+  if (!dispatch_hwnd_) return;
+  if (drain.more) {
+    ScheduleMessageDrain();
+  } else if (drain.retry_after > std::chrono::steady_clock::duration::zero()) {
+    // Coalesced snapshots waiting for tokens
+    auto wait_ms = std::chrono::ceil<std::chrono::milliseconds>(drain.retry_after).count();
+    SetTimer(dispatch_hwnd_, kDrainTimerId, static_cast<UINT>(wait_ms), nullptr);
+  }
+}
+
+LRESULT CALLBACK HkcwEngine2Plugin::DispatchWindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                                       LPARAM lparam) {
+  auto* plugin = reinterpret_cast<HkcwEngine2Plugin*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+  if (plugin) {
+    if (message == kDrainMessage) {
+      plugin->DrainWebMessages();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kDrainTimerId) {
+      KillTimer(hwnd, kDrainTimerId);
+      plugin->DrainWebMessages();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kInputLegacyTimerId) {
+      KillTimer(hwnd, kInputLegacyTimerId);
+      if (!plugin->input_reported_) {
+        std::cout << "[HKCW] [Input] Page did not report listeners (SDK < 3.7), forwarding buttons" << std::endl;
+        plugin->SetInputClasses(kInputButtons | kInputGestures);
+      }
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kGestureTimerId) {
+      KillTimer(hwnd, kGestureTimerId);
+      plugin->TickGestures();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kTelemetryTimerId) {
+      plugin->SampleTelemetry();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kKeyboardTimerId) {
+      KillTimer(hwnd, kKeyboardTimerId);
+      plugin->FlushKeyboard();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kOcclusionTimerId) {
+      KillTimer(hwnd, kOcclusionTimerId);
+      plugin->RebuildOcclusion();
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kScriptTimerId) {
+      plugin->script_pipeline_.Tick(std::chrono::steady_clock::now());
+      if (!plugin->script_pipeline_.busy()) {
+        KillTimer(hwnd, kScriptTimerId);
+        plugin->script_timer_running_ = false;
+      }
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kRecoveryTimerId) {
+      KillTimer(hwnd, kRecoveryTimerId);
+      plugin->crash_recovery_->OnTimer(GetTickCount64());
+      return 0;
+    }
+    if (message == WM_TIMER && wparam == kShellWatchTimerId) {
+      plugin->CheckShell();
+      return 0;
+    }
+    if (message == TaskbarCreatedMessage() && hwnd == plugin->shell_watch_hwnd_) {
+      plugin->OnTaskbarCreated();
+      return 0;
+    }
+    if (message == kAudioFrameMessage) {
+      plugin->PublishAudioFrame();
+      return 0;
+    }
+  }
+  return DefWindowProcW(hwnd, message, wparam, lparam);
+}
+
 // API Bridge: Handle messages from web
-void HkcwEngine2Plugin::HandleWebMessage(const std::string& message) {
+void HkcwEngine2Plugin::HandleWebMessage(std::string_view message) {
   std::cout << "[HKCW] [API] Received message: " << message << std::endl;
   
   // Parse JSON message (support both uppercase and lowercase)
   if (message.find("\"type\":\"IFRAME_DATA\"") != std::string::npos) {
     // Handle iframe data synchronization
     HandleIframeDataMessage(message);
+    UpdateAdClicks();
   }
   else if (message.find("\"type\":\"OPEN_URL\"") != std::string::npos || 
       message.find("\"type\":\"openURL\"") != std::string::npos) {
@@ -875,12 +1849,14 @@ void HkcwEngine2Plugin::HandleWebMessage(const std::string& message) {
     size_t url_start = message.find("\"url\":\"") + 7;
     size_t url_end = message.find("\"", url_start);
     if (url_start != std::string::npos && url_end != std::string::npos) {
-      std::string url = message.substr(url_start, url_end - url_start);
+      std::string url(message.substr(url_start, url_end - url_start));
       std::cout << "[HKCW] [API] Opening URL: " << url << std::endl;
       
-      // Open URL using ShellExecute
-      std::wstring wurl(url.begin(), url.end());
-      ShellExecuteW(nullptr, L"open", wurl.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
+      // Validated and launched on the launcher worker
+      UrlLauncher::Result launch = url_launcher_->Open(url);
+      if (launch != UrlLauncher::Result::kQueued) {
+        std::cout << "[HKCW] [API] URL not opened: " << UrlLauncher::ResultName(launch) << std::endl;
+      }
     }
   }
   else if (message.find("\"type\":\"READY\"") != std::string::npos || 
@@ -889,16 +1865,79 @@ void HkcwEngine2Plugin::HandleWebMessage(const std::string& message) {
     size_t name_start = message.find("\"name\":\"") + 8;
     size_t name_end = message.find("\"", name_start);
     if (name_start != std::string::npos && name_end != std::string::npos) {
-      std::string name = message.substr(name_start, name_end - name_start);
+      std::string name(message.substr(name_start, name_end - name_start));
       std::cout << "[HKCW] [API] Wallpaper ready: " << name << std::endl;
     }
   }
+  else if (message.find("\"type\":\"INPUT_LISTENERS\"") != std::string::npos) {
+    uint32_t classes = 0;
+    if (message.find("\"buttons\":true") != std::string::npos) classes |= kInputButtons;
+    if (message.find("\"motion\":true") != std::string::npos) classes |= kInputMotion;
+    if (message.find("\"wheel\":true") != std::string::npos) classes |= kInputWheel;
+    if (message.find("\"regions\":true") != std::string::npos) classes |= kInputRegions;
+    if (message.find("\"gestures\":true") != std::string::npos) classes |= kInputGestures;
+    if (message.find("\"ads\":true") != std::string::npos) classes |= kInputAds;
+    input_reported_ = true;
+    if (dispatch_hwnd_) KillTimer(dispatch_hwnd_, kInputLegacyTimerId);
+    SetInputClasses(classes);
+  }
+  else if (message.find("\"type\":\"HIT_REGIONS\"") != std::string::npos) {
+    std::vector<HitRegion> regions;
+    if (!ParseHitRegions(message, regions)) {
+      std::cout << "[HKCW] [Regions] Malformed region set" << std::endl;
+    } else {
+      size_t accepted = hit_regions_.Replace(regions);
+      if (accepted < regions.size()) {
+        std::cout << "[HKCW] [Regions] " << (regions.size() - accepted) << " of " << regions.size()
+                  << " regions rejected (empty or limit reached)" << std::endl;
+      }
+    }
+  }
+  else if (message.find("\"type\":\"HIT_REGION_SET\"") != std::string::npos) {
+    HitRegion region;
+    if (!ParseHitRegion(message, region)) {
+      std::cout << "[HKCW] [Regions] Malformed region: " << message << std::endl;
+    } else if (!hit_regions_.Set(region)) {
+      std::cout << "[HKCW] [Regions] Region rejected (empty or limit reached): " << region.id << std::endl;
+    }
+  }
+  else if (message.find("\"type\":\"HIT_REGION_REMOVE\"") != std::string::npos) {
+    uint32_t id = 0;
+    if (ParseHitRegionId(message, id)) hit_regions_.Remove(id);
+  }
+  else if (message.find("\"type\":\"KEYBOARD_LISTENERS\"") != std::string::npos) {
+    // Space-separated KeyboardEvent.code names
+    std::string keys;
+    size_t keys_start = message.find("\"keys\":\"");
+    if (keys_start != std::string::npos) {
+      keys_start += 8;
+      size_t keys_end = message.find('"', keys_start);
+      if (keys_end != std::string::npos) keys.assign(message.substr(keys_start, keys_end - keys_start));
+    }
+    SetKeyboardKeys(keys);
+  }
+  else if (message.find("\"type\":\"TELEMETRY_SUBSCRIPTION\"") != std::string::npos) {
+    // The page's whole subscription: shortest interval wanted, 0 = none
+    long interval = kTelemetryDefaultIntervalMs;
+    size_t interval_start = message.find("\"interval\":");
+    if (interval_start != std::string::npos) {
+      // The number ends at ',' or '}' inside the message, even in a batch view
+      interval = std::strtol(message.data() + interval_start + 11, nullptr, 10);
+    }
+    if (interval <= 0) {
+      StopTelemetry();
+    } else {
+      interval = (std::max)(interval, static_cast<long>(kTelemetryMinIntervalMs));
+      interval = (std::min)(interval, static_cast<long>(kTelemetryMaxIntervalMs));
+      StartTelemetry(static_cast<UINT>(interval));
+    }
+  }
   else if (message.find("\"type\":\"LOG\"") != std::string::npos) {
     // Extract log message
     size_t msg_start = message.find("\"message\":\"") + 11;
     size_t msg_end = message.find("\"", msg_start);
     if (msg_start != std::string::npos && msg_end != std::string::npos) {
-      std::string log_msg = message.substr(msg_start, msg_end - msg_start);
+      std::string log_msg(message.substr(msg_start, msg_end - msg_start));
       std::cout << "[HKCW] [WebLog] " << log_msg << std::endl;
     }
   }
@@ -907,98 +1946,120 @@ void HkcwEngine2Plugin::HandleWebMessage(const std::string& message) {
   }
 }
 
-// Mouse Hook: Low-level mouse callback
-LRESULT CALLBACK HkcwEngine2Plugin::LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
-  if (nCode >= 0 && hook_instance_ && hook_instance_->enable_interaction_) {
-    MSLLHOOKSTRUCT* info = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-    POINT pt = info->pt;
-    
-    // Check if click position is occluded by a top-level application window
-    HWND window_at_point = WindowFromPoint(pt);
-    
-    // Get window class name and title for debugging
-    wchar_t className[256] = {0};
-    wchar_t windowTitle[256] = {0};
-    if (window_at_point) {
-      GetClassNameW(window_at_point, className, 256);
-      GetWindowTextW(window_at_point, windowTitle, 256);
+// Input Source: Every backend's events land here, on the UI thread
+void HkcwEngine2Plugin::DispatchInput(const InputEvent& event) {
+  if (!enable_interaction_) {
+    return;
+  }
+  POINT pt = {event.x, event.y};
+  
+  // With the hook backend everything below runs inside the hook: stack
+  // buffers and precomputed strings only, no heap allocation (and no
+  // cross-process WM_GETTEXT)
+  
+  // Gesture Recognizer: Raw button/move events
+  bool is_wheel = event.type == InputEvent::Type::kWheel;
+  bool is_move = event.type == InputEvent::Type::kMove;
+  PointerEvent pointer = {PointerEvent::Type::kMove, event.button, pt.x, pt.y, event.time_ms};
+  if (event.type == InputEvent::Type::kDown) pointer.type = PointerEvent::Type::kDown;
+  if (event.type == InputEvent::Type::kUp) pointer.type = PointerEvent::Type::kUp;
+  bool is_left_up = event.type == InputEvent::Type::kUp && event.button == PointerButton::kLeft;
+  
+  // Input Listeners: Only the event classes the page listens to do any
+  // work past this point; ad iframes count even if the page never said
+  uint32_t classes = input_classes_;
+  if (ad_clicks_) classes |= kInputAds;
+  
+  if (is_move) {
+    // Moves matter mid-gesture, and then like a captured drag: they keep
+    // going over app windows. Idle moves skip the hit test unless the
+    // page wants motion.
+    if (gesture_recognizer_.pressed()) {
+      gesture_recognizer_.Process(pointer, gesture_handler_);
     }
-    
-    // Check if this is a top-level application window (not desktop layer)
-    bool is_app_window = false;
-    if (window_at_point) {
-      // Get the root owner window
-      HWND root_window = GetAncestor(window_at_point, GA_ROOT);
-      
-      // Check if it's a visible top-level window with WS_OVERLAPPEDWINDOW style
-      if (root_window && IsWindowVisible(root_window)) {
-        LONG style = GetWindowLongW(root_window, GWL_STYLE);
-        
-        // If it has title bar or is a popup window, it's likely an app window
-        if ((style & WS_CAPTION) || (style & WS_POPUP)) {
-          // But exclude desktop-related windows
-          wchar_t rootClassName[256] = {0};
-          GetClassNameW(root_window, rootClassName, 256);
-          
-          if (wcscmp(rootClassName, L"Progman") != 0 &&
-              wcscmp(rootClassName, L"WorkerW") != 0 &&
-              wcscmp(rootClassName, L"Shell_TrayWnd") != 0 &&  // Taskbar
-              wcsstr(rootClassName, L"Xaml") == nullptr) {  // System UI
-            is_app_window = true;
-          }
-        }
-      }
+    if (!(classes & kInputMotion)) {
+      return;
     }
-    
-    // If occluded by app window, don't forward
-    if (is_app_window) {
-      // Silently ignore - app window is in front
-      return CallNextHookEx(nullptr, nCode, wParam, lParam);
+  } else if (is_wheel) {
+    if (!(classes & kInputWheel)) {
+      return;
     }
-    
-    // Check if click is on an iframe ad (priority handling)
-    if (wParam == WM_LBUTTONUP) {
-      IframeInfo* iframe = hook_instance_->GetIframeAtPoint(pt.x, pt.y);
-      
-      if (iframe && !iframe->click_url.empty()) {
-        std::cout << "[HKCW] [iframe] Click detected on iframe: " << iframe->id 
-                  << " at (" << pt.x << "," << pt.y << ")" << std::endl;
-        std::cout << "[HKCW] [iframe] Opening ad URL: " << iframe->click_url << std::endl;
-        
-        // Open the ad URL directly (bypass iframe sandbox restrictions)
-        std::wstring url_wide(iframe->click_url.begin(), iframe->click_url.end());
-        ShellExecuteW(nullptr, L"open", url_wide.c_str(), nullptr, nullptr, SW_SHOWNORMAL);
-        
-        // Don't forward to WebView - handled by native layer
-        return CallNextHookEx(nullptr, nCode, wParam, lParam);
-      }
+  } else if (!(classes & (kInputButtons | kInputRegions)) &&
+             !(is_left_up && (classes & kInputAds))) {
+    return;
+  }
+  
+  // Releases of the tracked button end the gesture wherever they land,
+  // except on an ad: that click is handled natively and the page never
+  // sees it
+  if (pointer.type == PointerEvent::Type::kUp && gesture_recognizer_.pressed()) {
+    const IframeInfo* ad = is_left_up ? GetIframeAtPoint(pt.x, pt.y) : nullptr;
+    if (ad && !ad->click_url.empty()) {
+      gesture_recognizer_.Cancel(gesture_handler_);
+    } else {
+      gesture_recognizer_.Process(pointer, gesture_handler_);
     }
+    TickGestures();  // Nothing pending: clears the timer
+  }
+  
+  // Occlusion Cache: Application windows in front of the desktop swallow
+  // the event; usually answered without touching a window
+  uint32_t now_ms = GetTickCount();
+  if (!occlusion_rebuild_scheduled_ && occlusion_cache_.needs_rebuild(now_ms)) {
+    ScheduleOcclusionRebuild();
+  }
+  if (occlusion_cache_.IsOccluded(pt.x, pt.y, now_ms)) {
+    return;
+  }
+  
+  // Check if click is on an iframe ad (priority handling)
+  if (is_left_up) {
+    const IframeInfo* iframe = GetIframeAtPoint(pt.x, pt.y);
     
-    // Send different mouse events to JavaScript (desktop layer clicks)
-    const char* event_type = nullptr;
-    
-    if (wParam == WM_LBUTTONDOWN) {
-      event_type = "mousedown";
-    } else if (wParam == WM_LBUTTONUP) {
-      event_type = "mouseup";
-      std::cout << "[HKCW] [Hook] Desktop click at: " << pt.x << "," << pt.y 
-                << " (Window: " << window_at_point << " Class: ";
-      std::wcout << className;
-      if (wcslen(windowTitle) > 0) {
-        std::wcout << L" Title: " << windowTitle;
+    if (iframe && !iframe->click_url.empty()) {
+      std::cout << "[HKCW] [iframe] Click detected on iframe: " << iframe->id 
+                << " at (" << pt.x << "," << pt.y << ")" << std::endl;
+      std::cout << "[HKCW] [iframe] Opening ad URL: " << iframe->click_url << std::endl;
+      
+      // Open the ad URL natively (bypass iframe sandbox restrictions);
+      // the launcher worker runs the shell, never this callback
+      UrlLauncher::Result launch = url_launcher_->Open(iframe->click_url);
+      if (launch != UrlLauncher::Result::kQueued) {
+        std::cout << "[HKCW] [iframe] Ad URL not opened: " << UrlLauncher::ResultName(launch) << std::endl;
       }
-      std::wcout << L")" << std::endl;
-    } else if (wParam == WM_MOUSEMOVE) {
-      // Optional: send mousemove (but might be too frequent)
-      // event_type = "mousemove";
-    }
-    
-    if (event_type) {
-      hook_instance_->SendClickToWebView(pt.x, pt.y, event_type);
+      
+      // Don't forward to WebView - handled by native layer
+      return;
     }
   }
   
-  return CallNextHookEx(nullptr, nCode, wParam, lParam);
+  // Send different mouse events to JavaScript (desktop layer clicks)
+  const char* event_type = nullptr;
+  bool is_left = event.button == PointerButton::kLeft;
+  
+  bool buttons = (classes & kInputButtons) != 0;
+  
+  if (event.type == InputEvent::Type::kDown && is_left && buttons) {
+    event_type = "mousedown";
+  } else if (is_left_up && buttons) {
+    event_type = "mouseup";
+    std::cout << "[HKCW] [Input] Desktop click at: " << pt.x << "," << pt.y << std::endl;
+  } else if (is_move) {
+    event_type = "mousemove";  // Coalesced to the latest position
+  } else if (is_wheel) {
+    // Wheel: WHEEL_DELTA units, positive = away from the user / right
+    SendWheelToWebView(pt.x, pt.y, event.wheel_x, event.wheel_y);
+  }
+  
+  if (event_type) {
+    SendClickToWebView(pt.x, pt.y, event_type);
+  }
+  
+  // Gesture Recognizer: Presses start on the desktop only
+  if (pointer.type == PointerEvent::Type::kDown) {
+    gesture_recognizer_.Process(pointer, gesture_handler_);
+    TickGestures();  // Arms the long-press timer
+  }
 }
 
 // Mouse Hook: Send mouse event to WebView (compatible with HKCW SDK)
@@ -1008,77 +2069,389 @@ void HkcwEngine2Plugin::SendClickToWebView(int x, int y, const char* event_type)
   }
   
   // Dispatch hkcw:mouse event (SDK expects this format)
-  std::wstringstream script;
-  std::wstring wtype(event_type, event_type + strlen(event_type));
-  
-  script << L"(function() {"
-         << L"  var event = new CustomEvent('hkcw:mouse', {"
-         << L"    detail: {"
-         << L"      type: '" << wtype << L"',"
-         << L"      x: " << x << L","
-         << L"      y: " << y << L","
-         << L"      button: 0"  // 0 = left button
-         << L"    }"
-         << L"  });"
-         << L"  window.dispatchEvent(event);"
-         << L"})();";
-  
-  webview_->ExecuteScript(script.str().c_str(), nullptr);
-}
-
-// Mouse Hook: Setup hook
-void HkcwEngine2Plugin::SetupMouseHook() {
-  if (mouse_hook_) {
-    std::cout << "[HKCW] [Hook] Mouse hook already installed" << std::endl;
+  ScriptBuffer<256> script;
+  if (!kMouseEventScript.Render(script, JsString{event_type}, x, y)) {
     return;
   }
   
-  mouse_hook_ = SetWindowsHookExW(
-    WH_MOUSE_LL,
-    LowLevelMouseProc,
-    GetModuleHandleW(nullptr),
-    0
-  );
+  // Script Pipeline: Moves only matter as the latest position; presses and
+  // releases stay ordered and are dropped only when the queue is full
+  bool is_move = std::strcmp(event_type, "mousemove") == 0;
+  script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                          is_move ? ScriptPipeline::Policy::kCoalesce : ScriptPipeline::Policy::kQueue,
+                          is_move ? kScriptKeyMouseMove : 0, std::chrono::steady_clock::now());
+}
+
+// Input Listeners: Wheel steps are not coalesced (each one scrolls)
+void HkcwEngine2Plugin::SendWheelToWebView(int x, int y, int delta_x, int delta_y) {
+  if (!webview_) {
+    return;
+  }
   
-  if (mouse_hook_) {
-    std::cout << "[HKCW] [Hook] Mouse hook installed successfully" << std::endl;
-  } else {
-    DWORD error = GetLastError();
-    std::cout << "[HKCW] [Hook] ERROR: Failed to install mouse hook, error: " << error << std::endl;
+  ScriptBuffer<256> script;
+  if (kWheelEventScript.Render(script, x, y, delta_x, delta_y)) {
+    script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                            ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
   }
 }
 
-// Mouse Hook: Remove hook
-void HkcwEngine2Plugin::RemoveMouseHook() {
-  if (mouse_hook_) {
-    UnhookWindowsHookEx(mouse_hook_);
-    mouse_hook_ = nullptr;
-    std::cout << "[HKCW] [Hook] Mouse hook removed" << std::endl;
+// Input Listeners: Whatever the backend, the input source exists only
+// while interaction is on and the current page has listeners (a
+// WH_MOUSE_LL hook sees every mouse event on the system and adds to its
+// latency)
+void HkcwEngine2Plugin::UpdateInputSource() {
+  bool wanted = enable_interaction_ && webview_ && (input_classes_ != 0 || ad_clicks_);
+  if (wanted && !input_source_) {
+    StartInputSource();
+  } else if (!wanted && input_source_) {
+    StopInputSource();
   }
 }
 
-// iframe Ad Detection: Handle iframe data from JavaScript
-void HkcwEngine2Plugin::HandleIframeDataMessage(const std::string& json_data) {
-  std::lock_guard<std::mutex> lock(iframes_mutex_);
-  
-  std::cout << "[HKCW] [iframe] Parsing iframe data..." << std::endl;
-  std::cout << "[HKCW] [iframe] Raw JSON: " << json_data << std::endl;
+void HkcwEngine2Plugin::SetInputClasses(uint32_t classes) {
+  if (classes != input_classes_) {
+    std::cout << "[HKCW] [Input] Listening for:" << ((classes & kInputButtons) ? " buttons" : "")
+              << ((classes & kInputMotion) ? " motion" : "") << ((classes & kInputWheel) ? " wheel" : "")
+              << ((classes & kInputRegions) ? " regions" : "")
+              << ((classes & kInputGestures) ? " gestures" : "")
+              << ((classes & kInputAds) ? " ads" : "")
+              << (classes == 0 ? " nothing" : "") << std::endl;
+  }
+  bool gestures_changed = ((classes ^ input_classes_) & kInputGestures) != 0;
+  input_classes_ = classes;
+  if (gestures_changed) ConfigureGestures();
+  UpdateInputSource();
+}
+
+// Input Listeners: New document, nothing registered yet; SDKs older than
+// 3.7 never report, so their pages get buttons after a grace period
+void HkcwEngine2Plugin::ResetInputListeners() {
+  input_reported_ = false;
+  if (dispatch_hwnd_) KillTimer(dispatch_hwnd_, kInputLegacyTimerId);
+  SetInputClasses(0);
   
-  // Clear existing data
-  iframes_.clear();
+  // Hit Regions: Ids belong to the old document
+  hit_regions_.Clear();
   
-  // Simple JSON parsing for iframe array
-  // Format: {"type":"IFRAME_DATA","iframes":[{...},{...}]}
-  size_t iframes_start = json_data.find("\"iframes\":[");
-  if (iframes_start == std::string::npos) {
-    std::cout << "[HKCW] [iframe] No iframes array found" << std::endl;
-    return;
+  // iframe Ad Detection: So do the ads; their hook goes with them
+  {
+    std::lock_guard<std::mutex> lock(iframes_mutex_);
+    iframes_.clear();
   }
+  UpdateAdClicks();
   
-  size_t array_end = json_data.find("]", iframes_start);
-  if (array_end == std::string::npos) {
-    std::cout << "[HKCW] [iframe] No array end found" << std::endl;
-    return;
+  // Keyboard Forwarder: Keys held for the old document die with it
+  keyboard_forwarder_.Reset();
+  if (dispatch_hwnd_) KillTimer(dispatch_hwnd_, kKeyboardTimerId);
+  UpdateKeyboardSource();
+}
+
+void HkcwEngine2Plugin::WatchInputListeners() {
+  if (input_reported_ || !enable_interaction_ || !dispatch_hwnd_) return;
+  SetTimer(dispatch_hwnd_, kInputLegacyTimerId, kInputLegacyGraceMs, nullptr);
+}
+
+// Keyboard Forwarder: Opt-in from the app; the hook also needs a page
+// that lists keys
+void HkcwEngine2Plugin::SetKeyboardForwarding(bool enabled) {
+  keyboard_enabled_ = enabled;
+  std::cout << "[HKCW] [Keyboard] Forwarding " << (enabled ? "enabled" : "disabled") << std::endl;
+  UpdateKeyboardSource();
+}
+
+void HkcwEngine2Plugin::SetKeyboardKeys(const std::string& keys) {
+  size_t accepted = keyboard_forwarder_.SetKeys(keys);
+  std::cout << "[HKCW] [Keyboard] Page listens for " << accepted << " key(s)" << std::endl;
+  ScheduleKeyboardFlush(keyboard_forwarder_.pending_flush());
+  UpdateKeyboardSource();
+}
+
+void HkcwEngine2Plugin::UpdateKeyboardSource() {
+  bool wanted = keyboard_enabled_ && webview_ && !keyboard_forwarder_.empty();
+  if (wanted && !keyboard_source_) {
+    auto source = CreateKeyboardHookSource();
+    if (source->Start([this](uint32_t vk, bool down) { OnKey(vk, down); })) {
+      keyboard_source_ = std::move(source);
+    }
+  } else if (!wanted && keyboard_source_) {
+    keyboard_source_->Stop();
+    keyboard_source_.reset();
+    keyboard_forwarder_.ReleaseAll();
+    ScheduleKeyboardFlush(keyboard_forwarder_.pending_flush());
+  }
+}
+
+// Keyboard Forwarder: Runs inside the keyboard hook; the focus check only
+// happens for keys the page asked for
+void HkcwEngine2Plugin::OnKey(uint32_t vk, bool down) {
+  if (!keyboard_forwarder_.Wants(vk)) {
+    return;
+  }
+  KeyEvent event;
+  event.vk = vk;
+  event.down = down;
+  event.desktop_focused = down && IsDesktopFocused();
+  ScheduleKeyboardFlush(keyboard_forwarder_.Process(event));
+}
+
+// Keyboard Forwarder: Re-arming replaces a slower pending timer
+void HkcwEngine2Plugin::ScheduleKeyboardFlush(KeyForwarder::Flush flush) {
+  if (!dispatch_hwnd_ || flush == KeyForwarder::Flush::kNone) {
+    return;
+  }
+  UINT delay = flush == KeyForwarder::Flush::kNextFrame ? kKeyboardFrameMs : kKeyboardRepeatFlushMs;
+  SetTimer(dispatch_hwnd_, kKeyboardTimerId, delay, nullptr);
+}
+
+// Keyboard Forwarder: Everything batched this frame goes out as one
+// script; the queue policy keeps presses and releases in order
+void HkcwEngine2Plugin::FlushKeyboard() {
+  keyboard_forwarder_.TakeBatch(keyboard_batch_, kKeyboardBatchMax);
+  ScheduleKeyboardFlush(keyboard_forwarder_.pending_flush());
+  if (!webview_ || keyboard_batch_.empty()) {
+    return;
+  }
+  
+  ScriptBuffer<4096> script;
+  script.Append(kKeyboardBatchPrefix, std::size(kKeyboardBatchPrefix) - 1);
+  ScriptBuffer<128> entry;
+  for (const KeyBatchEntry& key : keyboard_batch_) {
+    if (kKeyboardEntryScript.Render(entry, JsString{key.down ? "keydown" : "keyup"},
+                                    JsString{KeyCodeName(key.vk)}, key.repeat,
+                                    (key.modifiers & kKeyModifierCtrl) != 0,
+                                    (key.modifiers & kKeyModifierShift) != 0,
+                                    (key.modifiers & kKeyModifierAlt) != 0,
+                                    (key.modifiers & kKeyModifierMeta) != 0)) {
+      script.Append(entry.c_str(), entry.length());
+    }
+  }
+  script.Append(kKeyboardBatchSuffix, std::size(kKeyboardBatchSuffix) - 1);
+  if (script.overflowed()) {
+    std::cout << "[HKCW] [Keyboard] ERROR: Batch script too long" << std::endl;
+    return;
+  }
+  script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                          ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
+}
+
+// Gesture Recognizer: Left clicks are resolved against the page's regions
+// here; only hits cross into the renderer. Pages with gesture or mouse
+// listeners also get every gesture.
+void HkcwEngine2Plugin::OnGesture(const GestureEvent& gesture) {
+  if (gesture.type == GestureEvent::Type::kClick && gesture.button == PointerButton::kLeft &&
+      (input_classes_ & kInputRegions)) {
+    const HitRegion* region = hit_regions_.HitTest(gesture.x, gesture.y);
+    if (region) {
+      SendRegionClickToWebView(gesture.x, gesture.y, region->id);
+    }
+  }
+  if (input_classes_ & kInputButtons) {
+    SendGestureToWebView(gesture);
+  }
+}
+
+// Hit Regions: Ordered with the gestures around it
+void HkcwEngine2Plugin::SendRegionClickToWebView(int x, int y, uint32_t id) {
+  if (!webview_) {
+    return;
+  }
+  
+  ScriptBuffer<256> script;
+  if (kRegionClickScript.Render(script, x, y, id)) {
+    script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                            ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
+  }
+}
+
+// Gesture Recognizer: Drag moves only matter as the latest position
+void HkcwEngine2Plugin::SendGestureToWebView(const GestureEvent& gesture) {
+  if (!webview_) {
+    return;
+  }
+  
+  ScriptBuffer<320> script;
+  if (!kGestureEventScript.Render(script, JsString{GestureTypeName(gesture.type)},
+                                  JsString{PointerButtonName(gesture.button)}, gesture.x, gesture.y,
+                                  gesture.start_x, gesture.start_y)) {
+    return;
+  }
+  
+  bool is_move = gesture.type == GestureEvent::Type::kDragMove;
+  script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                          is_move ? ScriptPipeline::Policy::kCoalesce : ScriptPipeline::Policy::kQueue,
+                          is_move ? kScriptKeyGestureDrag : 0, std::chrono::steady_clock::now());
+}
+
+// Gesture Recognizer: Fires a due long press, then re-arms the timer for
+// the next deadline (if any)
+void HkcwEngine2Plugin::TickGestures() {
+  DWORD now = GetTickCount();
+  gesture_recognizer_.Tick(now, gesture_handler_);
+  
+  if (!dispatch_hwnd_) return;
+  uint32_t deadline = 0;
+  if (gesture_recognizer_.long_press_deadline(deadline)) {
+    uint32_t wait_ms = deadline - static_cast<uint32_t>(now);
+    SetTimer(dispatch_hwnd_, kGestureTimerId, (std::max)(wait_ms, 1u), nullptr);
+  } else {
+    KillTimer(dispatch_hwnd_, kGestureTimerId);
+  }
+}
+
+// Gesture Recognizer: Thresholds follow the user's mouse settings. A long
+// press swallows the click, so only pages that listen for gestures get
+// them; elsewhere a slow click is still a click (mouseup, onClick regions).
+void HkcwEngine2Plugin::ConfigureGestures() {
+  GestureRecognizer::Options options = gesture_recognizer_.options();
+  options.double_click_ms = GetDoubleClickTime();
+  options.double_click_width = GetSystemMetrics(SM_CXDOUBLECLK);
+  options.double_click_height = GetSystemMetrics(SM_CYDOUBLECLK);
+  options.drag_width = GetSystemMetrics(SM_CXDRAG);
+  options.drag_height = GetSystemMetrics(SM_CYDRAG);
+  options.long_press_ms =
+      (input_classes_ & kInputGestures) ? GestureRecognizer::Options().long_press_ms : 0;
+  gesture_recognizer_.set_options(options);
+}
+
+// Script Templates: Tell the page whether desktop input will be forwarded
+void HkcwEngine2Plugin::SendInteractionMode() {
+  if (!webview_) {
+    return;
+  }
+  
+  ScriptBuffer<256> script;
+  if (kInteractionModeScript.Render(script, enable_interaction_, enable_interaction_)) {
+    script_pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                            ScriptPipeline::Policy::kCoalesce, kScriptKeyInteractionMode,
+                            std::chrono::steady_clock::now());
+  }
+  std::cout << "[HKCW] [API] Sent interaction mode to JS: " << enable_interaction_ << std::endl;
+}
+
+// Input Source: Select the backend; a running source is restarted on it.
+// Replay traces are parsed up front so a bad file leaves the old one.
+bool HkcwEngine2Plugin::SetInputSource(const std::string& kind, const std::string& trace_path, double speed) {
+  if (kind == "replay") {
+    std::ifstream file(std::filesystem::path(Utf8ToWide(trace_path)), std::ios::binary);
+    if (!file.is_open()) {
+      LogError("Input trace not readable: " + trace_path);
+      return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<InputEvent> events;
+    std::string error;
+    if (!ParseInputTrace(text, events, &error)) {
+      LogError(error + ": " + trace_path);
+      return false;
+    }
+    input_replay_events_ = std::move(events);
+    input_replay_speed_ = speed;
+  } else {
+    input_replay_events_.clear();
+  }
+  
+  input_source_kind_ = kind;
+  std::cout << "[HKCW] [Input] Source selected: " << kind << std::endl;
+  if (input_source_) {
+    StopInputSource();
+    UpdateInputSource();
+  }
+  return true;
+}
+
+// Input Source: Start the selected backend
+void HkcwEngine2Plugin::StartInputSource() {
+  if (input_source_) {
+    return;
+  }
+  
+  ConfigureGestures();
+  
+  std::unique_ptr<InputSource> source;
+  if (input_source_kind_ == "rawinput") {
+    source = CreateRawInputSource();
+  } else if (input_source_kind_ == "replay") {
+    source = CreateReplaySource(input_replay_events_, input_replay_speed_);
+  } else {
+    source = CreateLowLevelHookSource();
+  }
+  
+  if (source->Start([this](const InputEvent& event) { DispatchInput(event); })) {
+    input_source_ = std::move(source);
+    std::cout << "[HKCW] [Input] Source started: " << input_source_->name() << std::endl;
+    
+    // Occlusion Cache: Nothing cached survives a stop
+    occlusion_cache_.InvalidateAll();
+    occlusion_watcher_.Start(
+        [this](uint32_t event, WindowHandle window) { OnWindowChanged(event, window); });
+    ScheduleOcclusionRebuild();
+  } else {
+    std::cout << "[HKCW] [Input] ERROR: Failed to start input source: " << source->name() << std::endl;
+  }
+}
+
+// Input Source: Stop the backend; a gesture in progress ends here
+void HkcwEngine2Plugin::StopInputSource() {
+  if (input_source_) {
+    input_source_->Stop();
+    input_source_.reset();
+    gesture_recognizer_.Cancel(gesture_handler_);
+    TickGestures();
+  }
+  occlusion_watcher_.Stop();
+  if (dispatch_hwnd_) {
+    KillTimer(dispatch_hwnd_, kOcclusionTimerId);
+  }
+  occlusion_rebuild_scheduled_ = false;
+}
+
+// Occlusion Cache: A window came to the front, was shown, hidden,
+// destroyed, (un)minimized or cloaked, or a move/size drag started or ended
+void HkcwEngine2Plugin::OnWindowChanged(uint32_t event, WindowHandle window) {
+  occlusion_cache_.OnWinEvent(event, window);
+  ScheduleOcclusionRebuild();
+}
+
+// Occlusion Cache: (Re)arm the settle timer; without the dispatch window
+// only the per-window classifications are used
+void HkcwEngine2Plugin::ScheduleOcclusionRebuild() {
+  if (!dispatch_hwnd_) {
+    return;
+  }
+  SetTimer(dispatch_hwnd_, kOcclusionTimerId, kOcclusionSettleMs, nullptr);
+  occlusion_rebuild_scheduled_ = true;
+}
+
+void HkcwEngine2Plugin::RebuildOcclusion() {
+  occlusion_rebuild_scheduled_ = false;
+  if (!input_source_) {
+    return;
+  }
+  occlusion_cache_.RebuildVisibleRegion(GetTickCount());
+}
+
+// iframe Ad Detection: Handle iframe data from JavaScript
+void HkcwEngine2Plugin::HandleIframeDataMessage(std::string_view json_data) {
+  std::lock_guard<std::mutex> lock(iframes_mutex_);
+  
+  std::cout << "[HKCW] [iframe] Parsing iframe data..." << std::endl;
+  std::cout << "[HKCW] [iframe] Raw JSON: " << json_data << std::endl;
+  
+  // Clear existing data
+  iframes_.clear();
+  
+  // Simple JSON parsing for iframe array
+  // Format: {"type":"IFRAME_DATA","iframes":[{...},{...}]}
+  size_t iframes_start = json_data.find("\"iframes\":[");
+  if (iframes_start == std::string::npos) {
+    std::cout << "[HKCW] [iframe] No iframes array found" << std::endl;
+    return;
+  }
+  
+  size_t array_end = json_data.find("]", iframes_start);
+  if (array_end == std::string::npos) {
+    std::cout << "[HKCW] [iframe] No array end found" << std::endl;
+    return;
   }
   
   // Find each iframe object in the array
@@ -1104,7 +2477,7 @@ void HkcwEngine2Plugin::HandleIframeDataMessage(const std::string& json_data) {
     }
     
     // Extract iframe data within [pos, obj_end)
-    std::string obj_data = json_data.substr(pos, obj_end - pos);
+    std::string obj_data(json_data.substr(pos, obj_end - pos));
     std::cout << "[HKCW] [iframe] Object data: " << obj_data << std::endl;
     
     IframeInfo iframe;
@@ -1189,8 +2562,30 @@ void HkcwEngine2Plugin::HandleIframeDataMessage(const std::string& json_data) {
   std::cout << "[HKCW] [iframe] Total iframes: " << iframes_.size() << std::endl;
 }
 
-// iframe Ad Detection: Check if click is on an iframe
-IframeInfo* HkcwEngine2Plugin::GetIframeAtPoint(int x, int y) {
+// iframe Ad Detection: Ad clicks are opened natively, so an ad needs the
+// input source even on a page that reports no listeners of its own
+void HkcwEngine2Plugin::UpdateAdClicks() {
+  bool ads = false;
+  {
+    std::lock_guard<std::mutex> lock(iframes_mutex_);
+    for (const auto& iframe : iframes_) {
+      if (!iframe.click_url.empty()) {
+        ads = true;
+        break;
+      }
+    }
+  }
+  if (ads != ad_clicks_) {
+    ad_clicks_ = ads;
+    std::cout << "[HKCW] [Input] Ad iframes " << (ads ? "present" : "gone") << std::endl;
+  }
+  UpdateInputSource();
+}
+
+// iframe Ad Detection: Check if click is on an iframe. Input sources and
+// HandleIframeDataMessage both run on the UI thread, so the pointer stays
+// valid for the rest of the input event.
+const IframeInfo* HkcwEngine2Plugin::GetIframeAtPoint(int x, int y) {
   std::lock_guard<std::mutex> lock(iframes_mutex_);
   
   for (auto& iframe : iframes_) {
@@ -1208,60 +2603,43 @@ IframeInfo* HkcwEngine2Plugin::GetIframeAtPoint(int x, int y) {
   return nullptr;
 }
 
-bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_mouse_transparent) {
-  std::cout << "[HKCW] ========== Initializing Wallpaper ==========" << std::endl;
-  std::cout << "[HKCW] URL: " << url << std::endl;
-  std::cout << "[HKCW] Mouse Transparent: " << (enable_mouse_transparent ? "true" : "false") << std::endl;
-
-  // P0-3: Validate URL before initialization
-  if (!url_validator_.IsAllowed(url)) {
-    std::cout << "[HKCW] [Security] URL validation failed: " << url << std::endl;
-    LogError("URL validation failed: " + url);
-    return false;
-  }
-
-  if (is_initialized_) {
-    std::cout << "[HKCW] Already initialized, stopping first..." << std::endl;
-    StopWallpaper();
-  }
+// Find the wallpaper layer: the WorkerW behind the one holding the icons.
+// split_messages 0x052C requests ask Progman to create it first, each
+// abandoned after message_timeout_ms or at once if explorer is hung.
+// Shell recovery retries this at 10 Hz and logs only its first attempt.
+HWND HkcwEngine2Plugin::FindWallpaperParent(int split_messages, DWORD settle_ms, bool allow_progman,
+                                            UINT message_timeout_ms, bool verbose) {
+  std::ostream quiet(nullptr);  // No buffer: output is discarded
+  std::ostream& out = verbose ? std::cout : quiet;
   
-  // Clear any residual iframe data before initialization
-  {
-    std::lock_guard<std::mutex> lock(iframes_mutex_);
-    if (!iframes_.empty()) {
-      std::cout << "[HKCW] [iframe] Clearing " << iframes_.size() << " residual iframe(s)" << std::endl;
-      iframes_.clear();
-    }
-  }
-  
-  // P1-2: Periodic cleanup check
-  PeriodicCleanup();
-
   // Try to find Progman (desktop window)
   HWND progman = FindWindowW(L"Progman", nullptr);
   if (!progman) {
-    std::cout << "[HKCW] ERROR: Progman not found" << std::endl;
-    return false;
+    out << "[HKCW] ERROR: Progman not found" << std::endl;
+    return nullptr;
   }
   
-  std::cout << "[HKCW] Found Progman: " << progman << std::endl;
+  out << "[HKCW] Found Progman: " << progman << std::endl;
   
   // Win11 correct strategy:
   // 1. Send 0x052C multiple times to ensure WorkerW creation
   // 2. SHELLDLL_DefView will be in the FIRST WorkerW (icon layer)
   // 3. The SECOND WorkerW (next sibling) is the wallpaper layer
   
-  std::cout << "[HKCW] Sending 0x052C messages to trigger WorkerW split..." << std::endl;
-  for (int i = 0; i < 3; i++) {
-    SendMessageW(progman, 0x052C, 0, 0);
-    Sleep(100);
+  // A restarting explorer may not answer yet; never block on it
+  out << "[HKCW] Sending 0x052C messages to trigger WorkerW split..." << std::endl;
+  for (int i = 0; i < split_messages; i++) {
+    SendMessageTimeoutW(progman, 0x052C, 0, 0, SMTO_ABORTIFHUNG, message_timeout_ms, nullptr);
+    if (settle_ms > 0) {
+      Sleep(settle_ms);
+    }
   }
   
   HWND wallpaper_workerw = nullptr;
   HWND icon_workerw = nullptr;
   
   // Find the WorkerW that contains SHELLDLL_DefView (this is the icon layer)
-  std::cout << "[HKCW] Searching for SHELLDLL_DefView location..." << std::endl;
+  out << "[HKCW] Searching for SHELLDLL_DefView location..." << std::endl;
   HWND hwnd = nullptr;
   int workerw_count = 0;
   
@@ -1270,15 +2648,15 @@ bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_
     HWND shelldll = FindWindowExW(hwnd, nullptr, L"SHELLDLL_DefView", nullptr);
     if (shelldll) {
       icon_workerw = hwnd;
-      std::cout << "[HKCW] Found SHELLDLL_DefView in WorkerW #" << workerw_count 
-                << " (icon layer): " << icon_workerw << std::endl;
+      out << "[HKCW] Found SHELLDLL_DefView in WorkerW #" << workerw_count 
+          << " (icon layer): " << icon_workerw << std::endl;
       
       // Find the NEXT WorkerW sibling - this is the wallpaper layer!
       wallpaper_workerw = FindWindowExW(nullptr, icon_workerw, L"WorkerW", nullptr);
       if (wallpaper_workerw) {
-        std::cout << "[HKCW] Found NEXT WorkerW (wallpaper layer): " << wallpaper_workerw << std::endl;
+        out << "[HKCW] Found NEXT WorkerW (wallpaper layer): " << wallpaper_workerw << std::endl;
       } else {
-        std::cout << "[HKCW] WARNING: No WorkerW found after icon layer, will use icon WorkerW" << std::endl;
+        out << "[HKCW] WARNING: No WorkerW found after icon layer, will use icon WorkerW" << std::endl;
         wallpaper_workerw = icon_workerw;
       }
       break;
@@ -1289,30 +2667,25 @@ bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_
   if (!icon_workerw) {
     HWND shelldll_in_progman = FindWindowExW(progman, nullptr, L"SHELLDLL_DefView", nullptr);
     if (shelldll_in_progman) {
-      std::cout << "[HKCW] SHELLDLL_DefView still in Progman, 0x052C did not work" << std::endl;
-      std::cout << "[HKCW] Using Progman as parent (this may not work correctly)" << std::endl;
+      out << "[HKCW] SHELLDLL_DefView still in Progman, 0x052C did not work" << std::endl;
+      out << "[HKCW] Using Progman as parent (this may not work correctly)" << std::endl;
       wallpaper_workerw = progman;
     }
   }
   
   // Last resort
   if (!wallpaper_workerw) {
-    std::cout << "[HKCW] ERROR: Could not find suitable parent window" << std::endl;
-    wallpaper_workerw = progman;
+    out << "[HKCW] ERROR: Could not find suitable parent window" << std::endl;
+    if (allow_progman) {
+      wallpaper_workerw = progman;
+    }
   }
   
-  worker_w_hwnd_ = wallpaper_workerw;
-  std::cout << "[HKCW] Final parent window: " << worker_w_hwnd_ << std::endl;
-
-  // Create WebView host window (already parented to WorkerW inside)
-  webview_host_hwnd_ = CreateWebViewHostWindow();
-  if (!webview_host_hwnd_) {
-    std::cout << "[HKCW] ERROR: Failed to create WebView host window" << std::endl;
-    return false;
-  }
+  return wallpaper_workerw;
+}
 
-  std::cout << "[HKCW] WebView host created as child of WorkerW" << std::endl;
-  
+// Host window placement shared by first attach and shell recovery
+void HkcwEngine2Plugin::ConfigureHostWindow() {
   // Always set Z-order behind SHELLDLL_DefView (icons always visible)
   HWND shelldll = FindWindowExW(worker_w_hwnd_, nullptr, L"SHELLDLL_DefView", nullptr);
   if (shelldll) {
@@ -1335,14 +2708,213 @@ bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_
   SetWindowLongPtrW(webview_host_hwnd_, GWL_EXSTYLE, exStyle | WS_EX_LAYERED | WS_EX_TRANSPARENT);
   SetLayeredWindowAttributes(webview_host_hwnd_, 0, 255, LWA_ALPHA);
   std::cout << "[HKCW] Window transparency ENABLED (clicks pass through)" << std::endl;
+}
+
+// Shell Recovery: Watchdog tick; while the shell is gone, a retry
+void HkcwEngine2Plugin::CheckShell() {
+  if (!webview_host_hwnd_) {
+    KillTimer(dispatch_hwnd_, kShellWatchTimerId);
+    return;
+  }
+  if (!shell_lost_) {
+    if (worker_w_hwnd_ && !IsWindow(worker_w_hwnd_)) {
+      OnShellLost();
+    }
+    return;
+  }
+  ReattachWallpaper();
+}
+
+// Shell Recovery: Also sent on DPI and theme changes, when nothing is lost
+void HkcwEngine2Plugin::OnTaskbarCreated() {
+  if (!webview_host_hwnd_) {
+    return;
+  }
+  if (!shell_lost_) {
+    bool attached = IsWindow(worker_w_hwnd_) && IsWindow(webview_host_hwnd_) &&
+                    GetParent(webview_host_hwnd_) == worker_w_hwnd_;
+    if (attached) {
+      return;
+    }
+    OnShellLost();
+  }
+  ReattachWallpaper();
+}
+
+void HkcwEngine2Plugin::OnShellLost() {
+  std::cout << "[HKCW] [Shell] Desktop window " << worker_w_hwnd_
+            << " is gone (explorer.exe restarted?), waiting to re-attach" << std::endl;
+  shell_lost_ = true;
+  shell_lost_at_ = std::chrono::steady_clock::now();
+  shell_attempts_ = 0;
+  SetTimer(dispatch_hwnd_, kShellWatchTimerId, kShellRetryIntervalMs, nullptr);
+}
+
+// Shell Recovery: Move the existing host (or, if it died with its parent, a
+// new host) under the new wallpaper layer and point the controller at it.
+// The environment, browser process and page all survive; only when the
+// controller cannot be re-parented is the wallpaper reloaded.
+bool HkcwEngine2Plugin::ReattachWallpaper() {
+  auto now = std::chrono::steady_clock::now();
+  int64_t lost_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now - shell_lost_at_).count();
+  
+  bool first_attempt = shell_attempts_++ == 0;
+  HWND parent = FindWallpaperParent(1, 0, lost_ms >= kShellSplitTimeoutMs, kShellRetryMessageTimeoutMs,
+                                    first_attempt);
+  if (!parent) {
+    // Desktop not back yet; the watchdog retries
+    if (first_attempt) {
+      std::cout << "[HKCW] [Shell] Desktop not back yet, retrying every " << kShellRetryIntervalMs
+                << " ms" << std::endl;
+    }
+    return false;
+  }
+  worker_w_hwnd_ = parent;
+  
+  bool host_alive = IsWindow(webview_host_hwnd_) != FALSE;
+  if (host_alive) {
+    SetParent(webview_host_hwnd_, worker_w_hwnd_);
+  } else {
+    ResourceTracker::Instance().UntrackWindow(webview_host_hwnd_);
+    webview_host_hwnd_ = CreateWebViewHostWindow();
+    shell_stats_.hosts_recreated++;
+  }
+  
+  bool attached = webview_host_hwnd_ != nullptr;
+  if (attached) {
+    // The new taskbar may have a different work area
+    RECT work_area;
+    SystemParametersInfoW(SPI_GETWORKAREA, 0, &work_area, 0);
+    SetWindowPos(webview_host_hwnd_, nullptr, 0, 0, work_area.right - work_area.left,
+                 work_area.bottom - work_area.top, SWP_NOZORDER | SWP_NOACTIVATE);
+    ConfigureHostWindow();
+    ShowWindow(webview_host_hwnd_, SW_SHOW);
+    
+    if (native_renderer_) {
+      // A new host has no frame yet; the image cache makes this cheap
+      attached = native_renderer_->Attach(webview_host_hwnd_) &&
+                 (host_alive || native_renderer_->Show(native_url_));
+      InvalidateRect(webview_host_hwnd_, nullptr, FALSE);
+    } else if (webview_controller_) {
+      if (!host_alive) {
+        attached = SUCCEEDED(webview_controller_->put_ParentWindow(webview_host_hwnd_));
+      }
+      if (attached) {
+        RECT bounds;
+        GetClientRect(webview_host_hwnd_, &bounds);
+        webview_controller_->put_Bounds(bounds);
+        webview_controller_->put_IsVisible(TRUE);
+        webview_controller_->NotifyParentWindowPositionChanged();
+      }
+    }
+  }
+  
+  shell_lost_ = false;
+  SetTimer(dispatch_hwnd_, kShellWatchTimerId, kShellWatchIntervalMs, nullptr);
+  
+  int64_t recovery_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - shell_lost_at_).count();
+  if (attached) {
+    shell_stats_.recoveries++;
+    shell_stats_.last_recovery_ms = recovery_ms;
+    shell_stats_.max_recovery_ms = (std::max)(shell_stats_.max_recovery_ms, recovery_ms);
+    std::cout << "[HKCW] [Shell] Re-attached to " << worker_w_hwnd_ << " in " << recovery_ms
+              << " ms after " << shell_attempts_ << " attempt(s) (host "
+              << (host_alive ? "kept" : "recreated") << ")" << std::endl;
+    return true;
+  }
+  
+  // Last resort: the same page from scratch
+  std::string url = native_url_;
+  if (url.empty() && webview_) {
+    LPWSTR source = nullptr;
+    if (SUCCEEDED(webview_->get_Source(&source)) && source) {
+      url = WideToUtf8(source);
+      CoTaskMemFree(source);
+    }
+  }
+  shell_stats_.reloads++;
+  std::cout << "[HKCW] [Shell] Re-attach failed after " << recovery_ms << " ms, reloading: " << url
+            << std::endl;
+  StopWallpaper();
+  if (url.empty()) {
+    return false;
+  }
+  return InitializeWallpaper(url, mouse_transparent_);
+}
+
+bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_mouse_transparent) {
+  std::cout << "[HKCW] ========== Initializing Wallpaper ==========" << std::endl;
+  std::cout << "[HKCW] URL: " << url << std::endl;
+  std::cout << "[HKCW] Mouse Transparent: " << (enable_mouse_transparent ? "true" : "false") << std::endl;
+
+  // P0-3: Validate URL before initialization
+  if (!url_validator_.IsAllowed(url)) {
+    std::cout << "[HKCW] [Security] URL validation failed: " << url << std::endl;
+    LogError("URL validation failed: " + url);
+    return false;
+  }
+
+  // A setup still waiting for its controller counts as initialized too
+  if (is_initialized_ || webview_host_hwnd_) {
+    std::cout << "[HKCW] Already initialized, stopping first..." << std::endl;
+    StopWallpaper();
+  }
+  
+  // Clear any residual iframe data before initialization
+  {
+    std::lock_guard<std::mutex> lock(iframes_mutex_);
+    if (!iframes_.empty()) {
+      std::cout << "[HKCW] [iframe] Clearing " << iframes_.size() << " residual iframe(s)" << std::endl;
+      iframes_.clear();
+    }
+  }
+  UpdateAdClicks();
+  
+  // P1-2: Periodic cleanup check
+  PeriodicCleanup();
+
+  // WebView Async: The browser process starts while the desktop is searched
+  if (!NativeWallpaperRenderer::IsNativeDescriptor(url)) {
+    PrepareEnvironment();
+  }
+
+  worker_w_hwnd_ = FindWallpaperParent(3, 100, true, 1000, true);
+  if (!worker_w_hwnd_) {
+    return false;
+  }
+  std::cout << "[HKCW] Final parent window: " << worker_w_hwnd_ << std::endl;
+
+  // Create WebView host window (already parented to WorkerW inside)
+  webview_host_hwnd_ = CreateWebViewHostWindow();
+  if (!webview_host_hwnd_) {
+    std::cout << "[HKCW] ERROR: Failed to create WebView host window" << std::endl;
+    return false;
+  }
+
+  std::cout << "[HKCW] WebView host created as child of WorkerW" << std::endl;
+  ConfigureHostWindow();
+  
+  // Shell Recovery: Survive explorer.exe restarts from here on
+  shell_lost_ = false;
+  if (dispatch_hwnd_) {
+    SetTimer(dispatch_hwnd_, kShellWatchTimerId, kShellWatchIntervalMs, nullptr);
+  }
+  
+  mouse_transparent_ = enable_mouse_transparent;
+  
+  // Native Renderer: Static wallpapers need no browser process at all
+  if (NativeWallpaperRenderer::IsNativeDescriptor(url)) {
+    return InitializeNativeWallpaper(url);
+  }
   
   // Store interaction mode for mouse hook
   enable_interaction_ = !enable_mouse_transparent;
   
   if (enable_interaction_) {
-    // Setup mouse hook to capture desktop clicks
-    std::cout << "[HKCW] Interactive mode: Setting up mouse hook..." << std::endl;
-    SetupMouseHook();
+    // Input Listeners: The input source starts once the page registers one
+    std::cout << "[HKCW] Interactive mode: Mouse hook on demand" << std::endl;
+    ResetInputListeners();
   } else {
     std::cout << "[HKCW] Wallpaper mode: No interaction" << std::endl;
   }
@@ -1358,24 +2930,336 @@ bool HkcwEngine2Plugin::InitializeWallpaper(const std::string& url, bool enable_
   return true;
 }
 
-bool HkcwEngine2Plugin::StopWallpaper() {
-  std::cout << "[HKCW] Stopping wallpaper..." << std::endl;
+// Native Renderer: Draw into the host window instead of creating a controller
+bool HkcwEngine2Plugin::InitializeNativeWallpaper(const std::string& url) {
+  std::cout << "[HKCW] [Native] Using native renderer (no WebView2)" << std::endl;
+  
+  // Nothing in the page to receive desktop input
+  enable_interaction_ = false;
+  
+  ShowWindow(webview_host_hwnd_, SW_SHOW);
+  
+  native_renderer_ = std::make_unique<NativeWallpaperRenderer>();
+  native_renderer_->SetCacheDirectory(GetImageCacheDirectory());
+  native_url_ = url;
+  if (!native_renderer_->Attach(webview_host_hwnd_) || !native_renderer_->Show(url)) {
+    LogError("Native wallpaper failed: " + url);
+    StopWallpaper();
+    return false;
+  }
+  
+  UpdateWindow(webview_host_hwnd_);
+  is_initialized_ = true;
+  frame_generation_++;
+  
+  std::cout << "[HKCW] ========== Initialization Complete (Native) ==========" << std::endl;
+  return true;
+}
+
+// Shared Feed: Names go into JSON and page lookups, so keep them plain
+SharedFeed* HkcwEngine2Plugin::OpenFeed(const std::string& name, SharedFeed::Options options) {
+  bool valid_name = !name.empty() && name.size() <= kFeedMaxNameLength &&
+      std::all_of(name.begin(), name.end(), [](unsigned char c) {
+        return std::isalnum(c) || c == '_' || c == '-';
+      });
+  if (!valid_name) {
+    std::cout << "[HKCW] [Feed] ERROR: Invalid feed name: " << name << std::endl;
+    return nullptr;
+  }
+  if (!webview_ || !shared_environment_) {
+    std::cout << "[HKCW] [Feed] ERROR: No WebView for feed " << name << std::endl;
+    return nullptr;
+  }
+  
+  auto transport = CreateWebViewFeedTransport(shared_environment_.Get(), webview_.Get());
+  if (!transport) return nullptr;
+  
+  auto feed = std::make_unique<SharedFeed>(name, std::move(transport), options);
+  if (!feed->Open()) return nullptr;
+  
+  SharedFeed* opened = feed.get();
+  feeds_[name] = std::move(feed);
+  return opened;
+}
 
+void HkcwEngine2Plugin::CloseFeed(const std::string& name) {
+  feeds_.erase(name);
+}
+
+void HkcwEngine2Plugin::ShareFeeds() {
+  for (auto& entry : feeds_) {
+    if (!entry.second->Share()) {
+      std::cout << "[HKCW] [Feed] ERROR: Failed to share feed " << entry.first << std::endl;
+    }
+  }
+}
+
+// Audio Spectrum: The feed is opened first so a page without shared buffer
+// support never starts a capture thread
+bool HkcwEngine2Plugin::StartAudioSpectrum(size_t band_count) {
+  StopAudioSpectrum();
+  if (!dispatch_hwnd_) return false;
+  
+  SharedFeed::Options feed_options;
+  feed_options.slot_size = static_cast<uint32_t>((band_count + 2) * sizeof(float));
+  if (!OpenFeed(kAudioFeedName, feed_options)) return false;
+  
+  auto capture = CreateLoopbackCapture();
+  SpectrumAnalyzer::Options options;
+  options.band_count = band_count;
+  audio_analyzer_ = std::make_unique<SpectrumAnalyzer>(options);
+  audio_frame_ = SpectrumFrame();
+  audio_frame_posted_ = false;
+  
+  // Capture thread: analyze in place, keep only the latest frame for the UI
+  bool started = capture->Start(
+      [this](const float* interleaved, size_t frames, uint32_t channels, uint32_t sample_rate) {
+        audio_analyzer_->Push(interleaved, frames, channels, sample_rate,
+                              [this](const SpectrumFrame& frame) {
+          {
+            std::lock_guard<std::mutex> lock(audio_mutex_);
+            audio_frame_.bands.assign(frame.bands.begin(), frame.bands.end());
+            audio_frame_.rms = frame.rms;
+            audio_frame_.peak = frame.peak;
+            audio_frame_.index = frame.index;
+          }
+          if (!audio_frame_posted_.exchange(true) &&
+              !PostMessageW(dispatch_hwnd_, kAudioFrameMessage, 0, 0)) {
+            audio_frame_posted_ = false;
+          }
+        });
+      });
+  if (!started) {
+    audio_analyzer_.reset();
+    CloseFeed(kAudioFeedName);
+    return false;
+  }
+  
+  audio_capture_ = std::move(capture);
+  std::cout << "[HKCW] [Audio] Spectrum enabled: " << band_count << " bands" << std::endl;
+  return true;
+}
+
+void HkcwEngine2Plugin::StopAudioSpectrum() {
+  if (!audio_capture_) return;
+  audio_capture_->Stop();
+  audio_capture_.reset();
+  audio_analyzer_.reset();
+  CloseFeed(kAudioFeedName);
+  std::cout << "[HKCW] [Audio] Spectrum disabled" << std::endl;
+}
+
+void HkcwEngine2Plugin::PublishAudioFrame() {
+  audio_frame_posted_ = false;
+  if (!audio_capture_) return;  // Stopped with a frame message in flight
+  
+  auto feed_it = feeds_.find(kAudioFeedName);
+  if (feed_it == feeds_.end()) {
+    // closeFeed from Dart: nowhere to publish, stop capturing
+    StopAudioSpectrum();
+    return;
+  }
+  
+  size_t capacity = 0;
+  uint8_t* payload = feed_it->second->BeginFrame(capacity);
+  // Too small for rms and peak: skip; the next BeginFrame releases the slot
+  if (!payload || capacity < 2 * sizeof(float)) return;
+  
+  size_t length = 0;
+  uint32_t band_count = 0;
+  {
+    std::lock_guard<std::mutex> lock(audio_mutex_);
+    // Clamped to the slot; the tag carries the band count actually written
+    size_t bands = (std::min)(audio_frame_.bands.size(), capacity / sizeof(float) - 2);
+    band_count = static_cast<uint32_t>(bands);
+    length = (bands + 2) * sizeof(float);
+    float* out = reinterpret_cast<float*>(payload);
+    std::copy_n(audio_frame_.bands.begin(), bands, out);
+    out[band_count] = audio_frame_.rms;
+    out[band_count + 1] = audio_frame_.peak;
+  }
+  feed_it->second->CommitFrame(length, band_count);
+}
+
+// System Telemetry: The first sample only primes the rates, so the page
+// gets its keyframe one interval after subscribing
+void HkcwEngine2Plugin::StartTelemetry(UINT interval_ms) {
+  if (!dispatch_hwnd_) return;
+  
+  if (!telemetry_) {
+    telemetry_ = std::make_unique<TelemetrySampler>(CreateWindowsTelemetrySource());
+    telemetry_->Sample(std::chrono::steady_clock::now(), telemetry_message_);
+    std::cout << "[HKCW] [Telemetry] Page subscribed, every " << interval_ms << " ms" << std::endl;
+  }
+  // A second subscriber has no state yet
+  telemetry_->RequestKeyframe();
+  SetTimer(dispatch_hwnd_, kTelemetryTimerId, interval_ms, nullptr);
+}
+
+void HkcwEngine2Plugin::StopTelemetry() {
+  if (!telemetry_) return;
+  if (dispatch_hwnd_) KillTimer(dispatch_hwnd_, kTelemetryTimerId);
+  
+  const TelemetrySampler::Stats& stats = telemetry_->stats();
+  std::cout << "[HKCW] [Telemetry] Stopped after " << stats.samples << " sample(s), "
+            << stats.messages << " message(s), " << stats.bytes << " bytes" << std::endl;
+  telemetry_.reset();
+}
+
+void HkcwEngine2Plugin::SampleTelemetry() {
+  if (!telemetry_ || !webview_) {
+    StopTelemetry();
+    return;
+  }
+  if (telemetry_->Sample(std::chrono::steady_clock::now(), telemetry_message_)) {
+    Utf8ToWide(telemetry_message_, telemetry_wide_);
+    webview_->PostWebMessageAsJson(telemetry_wide_.c_str());
+  }
+}
+
+// Preview: Thumbnail of whatever is on the desktop right now
+void HkcwEngine2Plugin::CapturePreview(
+    int max_width, int max_height,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  // Native frames only change with a new generation; live pages are
+  // re-captured at most once per kPreviewMinIntervalMs
+  bool same_frame = !preview_png_.empty() && preview_generation_ == frame_generation_ &&
+      (native_renderer_ || std::chrono::steady_clock::now() - preview_time_ <
+                               std::chrono::milliseconds(kPreviewMinIntervalMs));
+  if (same_frame && preview_max_width_ == max_width && preview_max_height_ == max_height) {
+    result->Success(flutter::EncodableValue(preview_png_));
+    return;
+  }
+
+  pending_previews_.push_back({max_width, max_height, std::move(result)});
+  if (preview_capture_running_) {
+    return;  // Answered when the running capture completes
+  }
+  preview_capture_generation_ = frame_generation_;
+
+  if (native_renderer_) {
+    const Surface& frame = native_renderer_->frame();
+    ImageView view;
+    view.pixels = frame.pixels.data();
+    view.width = frame.width;
+    view.height = frame.height;
+    view.stride = frame.width;
+    CompletePreviews(frame.pixels.empty() ? nullptr : &view);
+    return;
+  }
+
+  if (!webview_) {
+    CompletePreviews(nullptr);
+    return;
+  }
+
+  Microsoft::WRL::ComPtr<IStream> stream;
+  HRESULT hr = CreateStreamOnHGlobal(nullptr, TRUE, &stream);
+  if (SUCCEEDED(hr)) {
+    preview_capture_running_ = true;
+    auto start = std::chrono::steady_clock::now();
+    CancellationToken session = webview_session_.token();
+    hr = webview_->CapturePreview(
+      COREWEBVIEW2_CAPTURE_PREVIEW_IMAGE_FORMAT_PNG, stream.Get(),
+      Microsoft::WRL::Callback<ICoreWebView2CapturePreviewCompletedHandler>(
+        [this, stream, start, session](HRESULT error_code) -> HRESULT {
+          // CloseWebView already answered this capture's requests
+          if (session.cancelled()) return S_OK;
+          preview_capture_running_ = false;
+
+          std::vector<uint32_t> pixels;
+          ImageView view;
+          if (SUCCEEDED(error_code) &&
+              PreviewEncoder::DecodeStream(stream.Get(), pixels, view.width, view.height)) {
+            view.pixels = pixels.data();
+            view.stride = view.width;
+            CompletePreviews(&view);
+          } else {
+            CompletePreviews(nullptr);
+          }
+
+          auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::steady_clock::now() - start);
+          std::cout << "[HKCW] [Preview] Captured " << view.width << "x" << view.height
+                    << " in " << elapsed.count() << " ms" << std::endl;
+          return S_OK;
+        }).Get());
+    if (FAILED(hr)) {
+      preview_capture_running_ = false;
+    }
+  }
+
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] [Preview] ERROR: CapturePreview failed: " << std::hex << hr << std::dec << std::endl;
+    CompletePreviews(nullptr);
+  }
+}
+
+void HkcwEngine2Plugin::CompletePreviews(const ImageView* frame) {
+  std::vector<PendingPreview> pending;
+  pending.swap(pending_previews_);
+
+  bool encoded_now = false;
+  for (auto& request : pending) {
+    if (!frame) {
+      request.result->Error("CAPTURE_FAILED", "No wallpaper frame to capture");
+      continue;
+    }
+
+    // Requests coalesced onto one capture usually share a size
+    if (!encoded_now || preview_max_width_ != request.max_width ||
+        preview_max_height_ != request.max_height) {
+      std::vector<uint8_t> png;
+      if (!PreviewEncoder::EncodeThumbnail(*frame, request.max_width, request.max_height, png)) {
+        request.result->Error("CAPTURE_FAILED", "Failed to encode thumbnail");
+        continue;
+      }
+      preview_png_ = std::move(png);
+      preview_max_width_ = request.max_width;
+      preview_max_height_ = request.max_height;
+      preview_generation_ = preview_capture_generation_;
+      preview_time_ = std::chrono::steady_clock::now();
+      encoded_now = true;
+    }
+
+    request.result->Success(flutter::EncodableValue(preview_png_));
+  }
+}
+
+// Close the controller and everything bound to its document; the host
+// window stays
+void HkcwEngine2Plugin::CloseWebView() {
+  // WebView Async: Setup and script callbacks still on their way are dropped
+  webview_session_.Cancel();
+  
+  // Preview: A capture in flight will not complete; answer its requests
+  preview_capture_running_ = false;
+  CompletePreviews(nullptr);
+  
   if (webview_controller_) {
     webview_controller_->Close();
     webview_controller_ = nullptr;
   }
 
   webview_ = nullptr;
+  resource_filter_installed_ = false;
 
-  if (webview_host_hwnd_) {
-    // P0-1: Untrack before destroying
-    ResourceTracker::Instance().UntrackWindow(webview_host_hwnd_);
-    
-    DestroyWindow(webview_host_hwnd_);
-    webview_host_hwnd_ = nullptr;
-  }
-
+  // Audio Spectrum: Its feed goes with the WebView
+  StopAudioSpectrum();
+  
+  // System Telemetry: No page left to subscribe
+  StopTelemetry();
+  
+  // Input Listeners: No page, no input source
+  ResetInputListeners();
+  
+  // Shared Feed: Buffers belong to the WebView being closed
+  feeds_.clear();
+  
+  // Message Scheduler: Messages from the old page are stale
+  message_scheduler_.Clear();
+  script_pipeline_.Reset();
+  
   // Clear iframe data when stopping wallpaper
   {
     std::lock_guard<std::mutex> lock(iframes_mutex_);
@@ -1384,6 +3268,40 @@ bool HkcwEngine2Plugin::StopWallpaper() {
       iframes_.clear();
     }
   }
+  UpdateAdClicks();
+}
+
+bool HkcwEngine2Plugin::StopWallpaper() {
+  std::cout << "[HKCW] Stopping wallpaper..." << std::endl;
+
+  // Native Renderer: Restore the host window procedure before destroying it
+  native_renderer_.reset();
+  native_url_.clear();
+  frame_generation_++;
+  
+  // Shell Recovery: Nothing left to re-attach
+  if (dispatch_hwnd_) {
+    KillTimer(dispatch_hwnd_, kShellWatchTimerId);
+  }
+  shell_lost_ = false;
+  
+  // Crash Recovery: Likewise nothing to bring back
+  if (dispatch_hwnd_) {
+    KillTimer(dispatch_hwnd_, kRecoveryTimerId);
+  }
+  crash_recovery_->Reset();
+  app_feeds_.clear();
+  app_audio_bands_ = 0;
+
+  CloseWebView();
+
+  if (webview_host_hwnd_) {
+    // P0-1: Untrack before destroying
+    ResourceTracker::Instance().UntrackWindow(webview_host_hwnd_);
+    
+    DestroyWindow(webview_host_hwnd_);
+    webview_host_hwnd_ = nullptr;
+  }
 
   worker_w_hwnd_ = nullptr;
   is_initialized_ = false;
@@ -1396,6 +3314,26 @@ bool HkcwEngine2Plugin::StopWallpaper() {
 }
 
 bool HkcwEngine2Plugin::NavigateToUrl(const std::string& url) {
+  // Native Renderer: Native-to-native switches crossfade in place; switching
+  // between native and web content needs a different host setup
+  bool wants_native = NativeWallpaperRenderer::IsNativeDescriptor(url);
+  if (native_renderer_ && wants_native) {
+    if (!url_validator_.IsAllowed(url)) {
+      std::cout << "[HKCW] [Security] URL validation failed: " << url << std::endl;
+      LogError("URL validation failed: " + url);
+      return false;
+    }
+    if (!native_renderer_->Show(url)) {
+      return false;
+    }
+    native_url_ = url;
+    frame_generation_++;
+    return true;
+  }
+  if (native_renderer_ || (wants_native && is_initialized_)) {
+    return InitializeWallpaper(url, mouse_transparent_);
+  }
+  
   if (!webview_) {
     std::cout << "[HKCW] ERROR: WebView not initialized" << std::endl;
     LogError("NavigateToUrl: WebView not initialized");
@@ -1417,12 +3355,13 @@ bool HkcwEngine2Plugin::NavigateToUrl(const std::string& url) {
       iframes_.clear();
     }
   }
+  UpdateAdClicks();
 
   // P1-2: Check if cleanup needed
   PeriodicCleanup();
 
-  std::wstring wurl(url.begin(), url.end());
-  HRESULT hr = webview_->Navigate(wurl.c_str());
+  auto navigation = StartNavigation(url);
+  HRESULT hr = navigation.done() ? navigation.status() : S_OK;
   
   if (SUCCEEDED(hr)) {
     std::cout << "[HKCW] Navigated to: " << url << std::endl;
@@ -6,16 +6,38 @@
 #include <windows.h>
 #include <wrl.h>
 #include <WebView2.h>
+#include <map>
 #include <memory>
 #include <set>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <thread>
 #include <atomic>
 #include <fstream>
 #include <psapi.h>
 #include <mutex>
+#include <condition_variable>
+#include <filesystem>
+
+#include "audio_capture.h"
+#include "audio_spectrum.h"
+#include "crash_recovery.h"
+#include "gesture_recognizer.h"
+#include "hit_region_registry.h"
+#include "input_source.h"
+#include "keyboard_forwarder.h"
+#include "message_scheduler.h"
+#include "native_renderer.h"
+#include "occlusion_cache.h"
+#include "request_filter.h"
+#include "script_pipeline.h"
+#include "shared_feed.h"
+#include "system_telemetry.h"
+#include "url_launcher.h"
+#include "url_rule_snapshot.h"
+#include "webview_async.h"
 
 namespace hkcw_engine2 {
 
@@ -49,18 +71,43 @@ private:
 };
 
 // P0-3: URL Validator for security
+// Thread-safe: the URL launcher validates on its worker thread
 class URLValidator {
 public:
+  URLValidator() = default;
+  ~URLValidator();
+  URLValidator(const URLValidator&) = delete;
+  URLValidator& operator=(const URLValidator&) = delete;
+  
   bool IsAllowed(const std::string& url);
   void AddWhitelist(const std::string& pattern);
   void AddBlacklist(const std::string& pattern);
   void ClearWhitelist();
   void ClearBlacklist();
+  
+  // URL Rules: Load a rule file through a cached binary snapshot;
+  // a watcher thread reloads it when it changes on disk
+  bool LoadRuleFile(const std::string& path);
 
 private:
+  void WatchRuleFile();
+  bool ReplaceSnapshot(const std::string& path);  // Caller holds reload_mutex_
+  
+  std::mutex mutex_;
   std::vector<std::string> whitelist_;
   std::vector<std::string> blacklist_;
   bool MatchesPattern(const std::string& url, const std::string& pattern);
+  
+  UrlRuleSnapshot snapshot_;
+  
+  // Builds run under reload_mutex_ alone, so IsAllowed only ever waits
+  // for the swap
+  std::mutex reload_mutex_;
+  std::condition_variable reload_wake_;
+  std::string rule_file_path_;
+  std::filesystem::file_time_type rule_file_time_;
+  bool stop_reload_ = false;
+  std::thread reload_thread_;
 };
 
 class HkcwEngine2Plugin : public flutter::Plugin {
@@ -79,13 +126,39 @@ class HkcwEngine2Plugin : public flutter::Plugin {
       std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
 
   bool InitializeWallpaper(const std::string& url, bool enable_mouse_transparent);
+  bool InitializeNativeWallpaper(const std::string& url);
   bool StopWallpaper();
+  void CloseWebView();
   bool NavigateToUrl(const std::string& url);
 
   HWND FindWorkerW();
   HWND FindWorkerWWindows11();
   HWND CreateWebViewHostWindow();
+  HWND FindWallpaperParent(int split_messages, DWORD settle_ms, bool allow_progman,
+                           UINT message_timeout_ms, bool verbose);
+  void ConfigureHostWindow();
   void SetupWebView2(HWND hwnd, const std::string& url);
+  // WebView Async: Environment creation, started before the host exists
+  // when possible; the result is shared by every plugin instance
+  static Async<Microsoft::WRL::ComPtr<ICoreWebView2Environment>> PrepareEnvironment();
+  void AttachController(ICoreWebView2Controller* controller, HWND hwnd, const std::string& url);
+  Async<bool> StartNavigation(const std::string& url);
+  
+  // Crash Recovery: Bring the page back after a WebView2 process failure
+  // without tearing down the host or the environment
+  void SetupProcessFailedHandler();
+  void OnWebViewSetupFailed();
+  bool RebuildController();
+  void RestoreAppFeeds();
+  void ShowCrashFallback();
+  
+  // Shell Recovery: Re-attach the running wallpaper to the new desktop
+  // after explorer.exe restarts, instead of reloading it
+  HWND CreateShellWatchWindow();
+  void CheckShell();
+  void OnTaskbarCreated();
+  void OnShellLost();
+  bool ReattachWallpaper();
   
   // P0-2: Exception recovery
   bool InitializeWithRetry(const std::string& url, bool enable_mouse_transparent, int max_retries = 3);
@@ -99,27 +172,153 @@ class HkcwEngine2Plugin : public flutter::Plugin {
   void ConfigurePermissions();
   void SetupSecurityHandlers();
   
+  // Request Filter: Subresource blocking via WebResourceRequested
+  bool LoadFilterList(const std::string& path);
+  void InstallResourceFilter();
+  void RemoveResourceFilter();
+  
+  // Preview: Downsampled PNG thumbnails for the settings UI
+  void CapturePreview(int max_width, int max_height,
+                      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+  void CompletePreviews(const ImageView* frame);
+  
+  // Shared Feed: Bulk native-to-page frames through WebView2 shared buffers;
+  // a feed with the same name is replaced
+  SharedFeed* OpenFeed(const std::string& name, SharedFeed::Options options);
+  void CloseFeed(const std::string& name);
+  void ShareFeeds();
+  
+  // Audio Spectrum: System loopback analyzed on the capture thread; the
+  // UI thread publishes the latest frame to the "audio" feed
+  bool StartAudioSpectrum(size_t band_count);
+  void StopAudioSpectrum();
+  void PublishAudioFrame();
+  
+  // System Telemetry: Sampled on a dispatch-window timer only while the
+  // page is subscribed; changes are posted as delta messages
+  void StartTelemetry(UINT interval_ms);
+  void StopTelemetry();
+  void SampleTelemetry();
+  
+  // URL Rules: Default rule file under the user data folder
+  std::string GetDefaultRuleFilePath();
+  std::string GetImageCacheDirectory();
+  
   // API Bridge: JavaScript SDK injection and message handling
   void InjectHKCWSDK();
   void SetupMessageBridge();
-  void HandleWebMessage(const std::string& message);
-  std::string LoadSDKScript();
+  void HandleWebMessage(std::string_view message);
+  static const wchar_t* GetSDKScript();
+  
+  // Message Scheduler: Web messages are queued and drained in budgeted
+  // batches from a message-only window on the UI thread
+  void ConfigureMessageScheduler();
+  HWND CreateDispatchWindow();
+  void ScheduleMessageDrain();
+  void DrainWebMessages();
+  static LRESULT CALLBACK DispatchWindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
   
-  // Mouse Hook: Capture desktop clicks and forward to WebView
-  void SetupMouseHook();
-  void RemoveMouseHook();
-  static LRESULT CALLBACK LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam);
+  // Input Source: Capture desktop mouse events from the selected backend
+  // (hook, Raw Input or trace replay) and forward them to WebView
+  bool SetInputSource(const std::string& kind, const std::string& trace_path, double speed);
+  void StartInputSource();
+  void StopInputSource();
+  void DispatchInput(const InputEvent& event);
   void SendClickToWebView(int x, int y, const char* event_type = "mouseup");
+  void SendInteractionMode();
+  void SendWheelToWebView(int x, int y, int delta_x, int delta_y);
+  
+  // Input Listeners: The SDK reports which event classes the page listens
+  // to; the input source runs only while there are any
+  void UpdateInputSource();
+  void SetInputClasses(uint32_t classes);
+  void ResetInputListeners();
+  void WatchInputListeners();
+  
+  // Keyboard Forwarder: Opt-in desktop hotkeys, filtered to the keys the
+  // page lists and batched per frame
+  void SetKeyboardForwarding(bool enabled);
+  void SetKeyboardKeys(const std::string& keys);
+  void UpdateKeyboardSource();
+  void OnKey(uint32_t vk, bool down);
+  void ScheduleKeyboardFlush(KeyForwarder::Flush flush);
+  void FlushKeyboard();
+  
+  // Gesture Recognizer: Clicks, double clicks, drags, long presses and
+  // context clicks recognized natively from the input source's raw events
+  void ConfigureGestures();
+  void OnGesture(const GestureEvent& gesture);
+  void SendGestureToWebView(const GestureEvent& gesture);
+  void TickGestures();
+  
+  // Hit Regions: onClick elements registered by the SDK and hit-tested
+  // natively, like iframe ads
+  void SendRegionClickToWebView(int x, int y, uint32_t id);
+  
+  // Occlusion Cache: Which points an application window covers, kept
+  // current by window events while the input source runs
+  void OnWindowChanged(uint32_t event, WindowHandle window);
+  void ScheduleOcclusionRebuild();
+  void RebuildOcclusion();
   
   // iframe Ad Detection: Handle iframe click regions
-  void HandleIframeDataMessage(const std::string& json_data);
-  IframeInfo* GetIframeAtPoint(int x, int y);
+  void HandleIframeDataMessage(std::string_view json_data);
+  const IframeInfo* GetIframeAtPoint(int x, int y);
+  void UpdateAdClicks();  // After iframes_ changes
 
   HWND webview_host_hwnd_ = nullptr;
   HWND worker_w_hwnd_ = nullptr;
   Microsoft::WRL::ComPtr<ICoreWebView2Controller> webview_controller_;
   Microsoft::WRL::ComPtr<ICoreWebView2> webview_;
   bool is_initialized_ = false;
+  bool mouse_transparent_ = true;
+  
+  // Native Renderer: Set instead of a WebView for static wallpapers
+  std::unique_ptr<NativeWallpaperRenderer> native_renderer_;
+  std::string native_url_;  // Shown again if the host has to be recreated
+  
+  // Shell Recovery: shell_watch_hwnd_ is a hidden top-level window, the
+  // only kind the TaskbarCreated broadcast reaches
+  struct ShellRecoveryStats {
+    uint64_t recoveries = 0;
+    uint64_t reloads = 0;  // Re-attach failed, wallpaper initialized again
+    uint64_t hosts_recreated = 0;  // Host died with its parent
+    int64_t last_recovery_ms = 0;  // Loss noticed -> attached again
+    int64_t max_recovery_ms = 0;
+  };
+  HWND shell_watch_hwnd_ = nullptr;
+  bool shell_lost_ = false;
+  std::chrono::steady_clock::time_point shell_lost_at_;
+  int shell_attempts_ = 0;  // Discovery attempts this incident
+  ShellRecoveryStats shell_stats_;
+  
+  // Crash Recovery: page_url_ is the last top-level navigation allowed.
+  // app_feeds_ and app_audio_bands_ are what Dart opened; they outlive the
+  // WebView so a rebuilt controller gets them back, until the wallpaper stops
+  std::unique_ptr<CrashRecovery> crash_recovery_;
+  std::string crash_fallback_url_;  // Native descriptor
+  std::string page_url_;
+  std::map<std::string, SharedFeed::Options> app_feeds_;
+  size_t app_audio_bands_ = 0;  // 0: spectrum off
+  uint64_t feeds_restored_ = 0;  // Spectrum included
+  uint64_t feeds_lost_ = 0;
+  
+  // Preview: Last thumbnail and the frame generation it was taken from;
+  // requests arriving during a capture wait for it instead of starting another
+  struct PendingPreview {
+    int max_width;
+    int max_height;
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result;
+  };
+  uint64_t frame_generation_ = 0;
+  uint64_t preview_generation_ = 0;
+  uint64_t preview_capture_generation_ = 0;
+  int preview_max_width_ = 0;
+  int preview_max_height_ = 0;
+  std::vector<uint8_t> preview_png_;
+  std::chrono::steady_clock::time_point preview_time_;
+  bool preview_capture_running_ = false;
+  std::vector<PendingPreview> pending_previews_;
   
   // P0: Retry tracking
   int init_retry_count_ = 0;
@@ -127,16 +326,83 @@ class HkcwEngine2Plugin : public flutter::Plugin {
   // P0-3: URL validation
   URLValidator url_validator_;
   
+  // URL Launcher: Ad clicks and HKCW.openURL, launched off the hook thread
+  std::unique_ptr<UrlLauncher> url_launcher_;
+  
+  // Request Filter: EasyList rules and current top-level host
+  RequestFilter request_filter_;
+  std::string document_host_;
+  bool resource_filter_installed_ = false;
+  
   // P1-2: Cache cleanup timing
   std::chrono::steady_clock::time_point last_cleanup_;
   
   // P1-1: Shared WebView2 environment
   static Microsoft::WRL::ComPtr<ICoreWebView2Environment> shared_environment_;
+  static Async<Microsoft::WRL::ComPtr<ICoreWebView2Environment>> pending_environment_;
   
-  // Mouse Hook
-  HHOOK mouse_hook_ = nullptr;
-  static HkcwEngine2Plugin* hook_instance_;
+  // WebView Async: Cancelled by CloseWebView, so callbacks from a setup
+  // that was stopped (or superseded) never touch the current WebView
+  CancellationSource webview_session_;
+  
+  // Input Source: Running backend and the one setInputSource selected
+  std::unique_ptr<InputSource> input_source_;
+  std::string input_source_kind_ = "hook";
+  std::vector<InputEvent> input_replay_events_;
+  double input_replay_speed_ = 1.0;
   bool enable_interaction_ = false;
+  uint32_t input_classes_ = 0;  // kInput* bits
+  bool input_reported_ = false;  // Current page runs an SDK that reports
+  bool ad_clicks_ = false;  // iframes_ has a clickUrl; UI thread only
+  
+  // Hit Regions: Current document's onClick regions
+  HitRegionRegistry hit_regions_;
+  
+  // Occlusion Cache: The visible region is rebuilt from a timer, never
+  // from inside the hook
+  OcclusionCache occlusion_cache_{CreateWin32WindowSystem(), OcclusionCache::Options()};
+  OcclusionWatcher occlusion_watcher_;
+  bool occlusion_rebuild_scheduled_ = false;
+  
+  // Keyboard Forwarder: Hook runs only while enabled and the page listens
+  std::unique_ptr<KeyboardSource> keyboard_source_;
+  KeyForwarder keyboard_forwarder_;
+  std::vector<KeyBatchEntry> keyboard_batch_;
+  bool keyboard_enabled_ = false;
+  
+  // Gesture Recognizer: Fed by the input source; long presses fire from a timer
+  GestureRecognizer gesture_recognizer_{GestureRecognizer::Options()};
+  GestureRecognizer::Handler gesture_handler_;
+  
+  // Script Pipeline: Every native-to-page ExecuteScript goes through here
+  ScriptPipeline script_pipeline_{ScriptPipeline::Options()};
+  bool script_timer_running_ = false;
+  
+  // Shared Feed: Open feeds by name; closed with the WebView
+  std::map<std::string, std::unique_ptr<SharedFeed>> feeds_;
+  
+  // Audio Spectrum: audio_frame_ is written by the capture thread under
+  // audio_mutex_; one frame message is in flight at a time
+  std::unique_ptr<AudioCaptureSource> audio_capture_;
+  std::unique_ptr<SpectrumAnalyzer> audio_analyzer_;
+  std::mutex audio_mutex_;
+  SpectrumFrame audio_frame_;
+  std::atomic<bool> audio_frame_posted_{false};
+  
+  // System Telemetry: Created on subscribe, destroyed on unsubscribe
+  std::unique_ptr<TelemetrySampler> telemetry_;
+  std::string telemetry_message_;
+  std::wstring telemetry_wide_;
+  
+  // Message Scheduler
+  MessageScheduler message_scheduler_{MessageScheduler::Options()};
+  HWND dispatch_hwnd_ = nullptr;
+  bool drain_posted_ = false;
+  uint64_t messages_dropped_logged_ = 0;
+  
+  // UTF Transcoding: Reused for every web message / subresource URL
+  std::string message_buffer_;
+  std::string resource_url_buffer_;
   
   // iframe Ad Detection
   std::vector<IframeInfo> iframes_;
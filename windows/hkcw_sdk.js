@@ -6,7 +6,7 @@
 
   // HKCW Global Object
   window.HKCW = {
-    version: '3.1.0',
+    version: '3.9.4',
     dpiScale: window.devicePixelRatio || 1,
     screenWidth: screen.width * (window.devicePixelRatio || 1),
     screenHeight: screen.height * (window.devicePixelRatio || 1),
@@ -16,7 +16,25 @@
     _debugMode: false,
     _clickHandlers: [],
     _mouseCallbacks: [],
+    _gestureCallbacks: [],
+    _clickRequests: 0,
+    _regionSeq: 0,
+    
+    // Event classes last reported to native; null until the first report
+    _inputReported: null,
+    _adFrames: false,  // Last IFRAME_DATA had an ad with a click URL
     _keyboardCallbacks: [],
+    _keyboardReported: null,
+    
+    // Outgoing messages, flushed to native once per frame
+    _outbox: [],
+    _flushScheduled: false,
+    
+    // Shared feeds from native: name -> { buffer, words, lastSequence, callbacks }
+    _feeds: {},
+    
+    // System telemetry: key list from the last keyframe and current values
+    _telemetry: { keys: null, values: {}, subscribers: [], interval: 0 },
     
     // Initialize
     _init: function() {
@@ -33,6 +51,9 @@
       
       // Setup event listeners
       this._setupEventListeners();
+      
+      // Native installs its mouse hook only for pages that listen
+      this._reportInput();
     },
     
     // Detect debug mode from URL parameter
@@ -89,6 +110,196 @@
       document.body.appendChild(border);
     },
     
+    // Queue a message for native; everything queued during a frame goes
+    // out as one BATCH post (one IPC instead of one per message)
+    postMessage: function(message) {
+      if (!(window.chrome && window.chrome.webview)) return false;
+      
+      // Ads are clicked natively, which needs button input
+      if (message.type === 'IFRAME_DATA') {
+        this._adFrames = (message.iframes || []).some(function(f) { return !!f.clickUrl; });
+        this._reportInput();
+      }
+      
+      // Snapshots: only the newest one per frame matters
+      if (message.type === 'IFRAME_DATA' || message.type === 'INPUT_LISTENERS' ||
+          message.type === 'KEYBOARD_LISTENERS' || message.type === 'TELEMETRY_SUBSCRIPTION' ||
+          message.type === 'HIT_REGIONS') {
+        for (let i = 0; i < this._outbox.length; i++) {
+          if (this._outbox[i].type === message.type) {
+            this._outbox[i] = message;
+            return true;
+          }
+        }
+      }
+      
+      this._outbox.push(message);
+      this._scheduleFlush();
+      return true;
+    },
+    
+    _scheduleFlush: function() {
+      if (this._flushScheduled) return;
+      this._flushScheduled = true;
+      
+      const self = this;
+      const flush = function() { self._flush(); };
+      // rAF is paused while the page is hidden; the timer covers that
+      if (window.requestAnimationFrame) {
+        window.requestAnimationFrame(flush);
+      }
+      setTimeout(flush, 50);
+    },
+    
+    _flush: function() {
+      if (!this._flushScheduled) return;
+      this._flushScheduled = false;
+      
+      const messages = this._outbox;
+      this._outbox = [];
+      if (messages.length === 0) return;
+      
+      if (messages.length === 1) {
+        window.chrome.webview.postMessage(messages[0]);
+      } else {
+        window.chrome.webview.postMessage({
+          type: 'BATCH',
+          messages: messages
+        });
+      }
+    },
+    
+    // Latest frame of a native shared feed, read in place (no copy, no
+    // parsing). Returns null if there is no new consistent frame. frame.data
+    // views shared memory that native reuses a few frames later: copy it, or
+    // check frame.valid() after reading, if it must outlive the callback.
+    readFeed: function(name) {
+      const feed = this._feeds[name];
+      if (!feed || !feed.words) return null;
+      
+      const words = feed.words;
+      if (words[0] !== 0x46434B48) return null;  // 'HKCF'
+      const sequence = words[5];
+      if (sequence === 0 || sequence === feed.lastSequence) return null;
+      
+      const base = 64 + words[6] * words[4];
+      const slot = base >> 2;
+      const guard = words[slot];
+      if ((guard & 1) !== 0 || words[slot + 1] !== sequence) return null;  // Being rewritten
+      
+      feed.lastSequence = sequence;
+      return {
+        sequence: sequence,
+        tag: words[slot + 3],
+        data: new Uint8Array(feed.buffer, base + 16, words[slot + 2]),
+        valid: function() { return words[slot] === guard; }
+      };
+    },
+    
+    // Called with each new frame of a feed (native sends a small
+    // HKCW_FEED_FRAME message per frame)
+    onFeedFrame: function(name, callback) {
+      this._feed(name).callbacks.push(callback);
+    },
+    
+    // Spectrum of the system audio output, ~60 times per second, once
+    // Dart has called enableAudioSpectrum. bands are 0..1 from low to high
+    // frequency; the Float32Array views the feed, so copy it to keep it.
+    onAudioSpectrum: function(callback) {
+      this.onFeedFrame('audio', function(frame) {
+        const count = frame.tag;
+        const values = new Float32Array(frame.data.buffer, frame.data.byteOffset, count + 2);
+        const rms = values[count];
+        const peak = values[count + 1];
+        if (!frame.valid()) return;  // Overwritten while reading
+        callback({
+          bands: values.subarray(0, count),
+          rms: rms,
+          peak: peak,
+          sequence: frame.sequence
+        });
+      });
+    },
+    
+    // System stats sampled natively and pushed as deltas: cpu / cpuN (%),
+    // memUsed / memTotal (MiB), netRx / netTx / diskRead / diskWrite
+    // (KiB/s), battery (%, -1 without one), charging (0/1). callback gets
+    // the full values object and the keys that changed. Returns a function
+    // that unsubscribes; native stops sampling once nobody listens.
+    onTelemetry: function(callback, options) {
+      const t = this._telemetry;
+      const subscriber = { callback: callback, interval: (options && options.interval) || 1000 };
+      t.subscribers.push(subscriber);
+      if (!this._updateTelemetrySubscription() && t.keys) {
+        callback(t.values, t.keys.slice());
+      }
+      
+      const self = this;
+      return function() {
+        const index = t.subscribers.indexOf(subscriber);
+        if (index < 0) return;
+        t.subscribers.splice(index, 1);
+        self._updateTelemetrySubscription();
+      };
+    },
+    
+    // Native samples at the shortest interval anyone asked for (0 = stop).
+    // The message carries the whole state, so native keeps only the newest.
+    _updateTelemetrySubscription: function() {
+      const t = this._telemetry;
+      let interval = 0;
+      for (let i = 0; i < t.subscribers.length; i++) {
+        if (interval === 0 || t.subscribers[i].interval < interval) {
+          interval = t.subscribers[i].interval;
+        }
+      }
+      if (interval === t.interval) return false;
+      t.interval = interval;
+      this.postMessage({ type: 'TELEMETRY_SUBSCRIPTION', interval: interval });
+      return true;
+    },
+    
+    _onTelemetry: function(data) {
+      const t = this._telemetry;
+      const changed = [];
+      if (data.keys) {
+        t.keys = data.keys;
+        t.values = {};
+        for (let i = 0; i < data.keys.length; i++) {
+          t.values[data.keys[i]] = data.values[i];
+          changed.push(data.keys[i]);
+        }
+      } else if (t.keys && data.d) {
+        for (let i = 0; i + 1 < data.d.length; i += 2) {
+          const key = t.keys[data.d[i]];
+          t.values[key] = data.d[i + 1];
+          changed.push(key);
+        }
+      } else {
+        return;  // Delta before the keyframe
+      }
+      t.subscribers.forEach(function(subscriber) {
+        subscriber.callback(t.values, changed);
+      });
+    },
+    
+    _feed: function(name) {
+      if (!this._feeds[name]) {
+        this._feeds[name] = { buffer: null, words: null, lastSequence: 0, callbacks: [] };
+      }
+      return this._feeds[name];
+    },
+    
+    _onFeedFrame: function(name) {
+      const feed = this._feeds[name];
+      if (!feed || feed.callbacks.length === 0) return;
+      const frame = this.readFeed(name);
+      if (!frame) return;
+      feed.callbacks.forEach(function(cb) {
+        cb(frame);
+      });
+    },
+    
     // Check if point is in bounds
     _isInBounds: function(x, y, bounds) {
       return x >= bounds.left && x <= bounds.right &&
@@ -110,13 +321,119 @@
       }
     },
     
-    // Register click handler
+    // Handle a click native resolved to one of our regions
+    _handleRegionClick: function(id, x, y) {
+      for (let i = 0; i < this._clickHandlers.length; i++) {
+        const handler = this._clickHandlers[i];
+        if (handler.id === id) {
+          this._log('Region click: ' + (handler.element.id || handler.element.className));
+          handler.callback(x, y);
+          return;
+        }
+      }
+    },
+    
+    // Send every onClick region to native in one message (a page with
+    // hundreds of regions would otherwise outrun the per-message budget);
+    // tag goes last in each (native finds fields by key)
+    _sendRegions: function() {
+      this.postMessage({
+        type: 'HIT_REGIONS',
+        regions: this._clickHandlers.map(function(handler) {
+          const b = handler.bounds;
+          return {
+            id: handler.id,
+            left: b.left,
+            top: b.top,
+            right: b.right,
+            bottom: b.bottom,
+            z: handler.z,
+            tag: String(handler.element.id || handler.element.className || '')
+          };
+        })
+      });
+    },
+    
+    // Layout changed: move regions whose elements moved
+    _updateRegions: function() {
+      const self = this;
+      let moved = false;
+      this._clickHandlers.forEach(function(handler) {
+        const bounds = self._calculateElementBounds(handler.element);
+        const old = handler.bounds;
+        if (bounds.left !== old.left || bounds.top !== old.top ||
+            bounds.right !== old.right || bounds.bottom !== old.bottom) {
+          handler.bounds = bounds;
+          moved = true;
+        }
+      });
+      if (moved) this._sendRegions();
+    },
+    
+    // Tell native which event classes have listeners (buttons, motion,
+    // wheel, regions, gestures, ads); it uninstalls its global mouse hook
+    // when there are none. onClick alone only needs regions: native
+    // hit-tests clicks and sends just the hits. Long presses (which replace
+    // the click) are only recognized while onGesture has listeners.
+    _reportInput: function() {
+      const mouse = this._mouseCallbacks;
+      const classes = {
+        buttons: this._gestureCallbacks.length > 0 || mouse.length > 0,
+        motion: mouse.some(function(m) { return m.motion; }),
+        wheel: mouse.some(function(m) { return m.wheel; }),
+        regions: this._clickRequests > 0,
+        gestures: this._gestureCallbacks.length > 0,
+        ads: this._adFrames
+      };
+      const last = this._inputReported;
+      if (last && last.buttons === classes.buttons && last.motion === classes.motion &&
+          last.wheel === classes.wheel && last.regions === classes.regions &&
+          last.gestures === classes.gestures && last.ads === classes.ads) {
+        return;
+      }
+      this._inputReported = classes;
+      this.postMessage({
+        type: 'INPUT_LISTENERS',
+        buttons: classes.buttons,
+        motion: classes.motion,
+        wheel: classes.wheel,
+        regions: classes.regions,
+        gestures: classes.gestures,
+        ads: classes.ads
+      });
+    },
+    
+    // Remove item from list and re-report; returned by the on* registrations
+    _unsubscriber: function(list, item) {
+      const self = this;
+      let removed = false;
+      return function() {
+        if (removed) return;
+        removed = true;
+        const index = list.indexOf(item);
+        if (index >= 0) list.splice(index, 1);
+        self._reportInput();
+      };
+    },
+    
+    // Register click handler; returns a function that removes it. The
+    // element's bounds are registered with native, which hit-tests desktop
+    // clicks itself; options.z puts overlapping regions on top (equal z:
+    // the earlier registration wins).
     onClick: function(element, callback, options) {
       const self = this;
       options = options || {};
       
+      // Regions are needed from now on, not only once the handler is placed
+      this._clickRequests++;
+      this._reportInput();
+      let handler = null;
+      let cancelled = false;
+      
       // Delay registration to ensure DOM is ready
       setTimeout(function() {
+        if (cancelled) return;
+        
         // Get element
         let el = element;
         if (typeof element === 'string') {
@@ -132,11 +449,15 @@
         const bounds = self._calculateElementBounds(el);
         
         // Register handler
-        self._clickHandlers.push({
+        handler = {
+          id: ++self._regionSeq,
           element: el,
           callback: callback,
-          bounds: bounds
-        });
+          bounds: bounds,
+          z: options.z || 0
+        };
+        self._clickHandlers.push(handler);
+        self._sendRegions();
         
         // Debug output
         const showDebug = (options.debug !== undefined) ? options.debug : self._debugMode;
@@ -156,6 +477,18 @@
           self._showDebugBorder(bounds, el);
         }
       }, 2000);
+      
+      return function() {
+        if (cancelled) return;
+        cancelled = true;
+        const index = self._clickHandlers.indexOf(handler);
+        if (index >= 0) {
+          self._clickHandlers.splice(index, 1);
+          self._sendRegions();
+        }
+        self._clickRequests--;
+        self._reportInput();
+      };
     },
     
     // Open URL in default browser
@@ -163,12 +496,7 @@
       this._log('Opening URL: ' + url);
       
       // Call native method via postMessage
-      if (window.chrome && window.chrome.webview) {
-        window.chrome.webview.postMessage({
-          type: 'openURL',
-          url: url
-        });
-      } else {
+      if (!this.postMessage({ type: 'openURL', url: url })) {
         console.warn('[HKCW] Native bridge not available, opening in current window');
         window.open(url, '_blank');
       }
@@ -178,24 +506,79 @@
     ready: function(name) {
       this._log('Wallpaper ready: ' + name, true);
       
-      if (window.chrome && window.chrome.webview) {
-        window.chrome.webview.postMessage({
-          type: 'ready',
-          name: name
-        });
-      }
+      this.postMessage({ type: 'ready', name: name });
     },
     
-    // Register mouse event callback
-    onMouse: function(callback) {
-      this._mouseCallbacks.push(callback);
+    // Register mouse event callback: mousedown / mouseup always, plus
+    // mousemove with { motion: true } and wheel (deltaX, deltaY) with
+    // { wheel: true }. Returns a function that removes it.
+    onMouse: function(callback, options) {
+      const entry = {
+        callback: callback,
+        motion: !!(options && options.motion),
+        wheel: !!(options && options.wheel)
+      };
+      this._mouseCallbacks.push(entry);
       this._log('Mouse callback registered (total: ' + this._mouseCallbacks.length + ')');
+      this._reportInput();
+      return this._unsubscriber(this._mouseCallbacks, entry);
+    },
+    
+    // Register gesture callback: detail is { type, button, x, y, startX,
+    // startY } in physical pixels. type is click, dblclick (after the
+    // second click), contextclick, longpress, dragstart, dragmove or
+    // dragend; button is left, right or middle. Thresholds follow the
+    // user's Windows mouse settings.
+    onGesture: function(callback) {
+      this._gestureCallbacks.push(callback);
+      this._log('Gesture callback registered (total: ' + this._gestureCallbacks.length + ')');
+      this._reportInput();
+      return this._unsubscriber(this._gestureCallbacks, callback);
     },
     
-    // Register keyboard event callback
-    onKeyboard: function(callback) {
-      this._keyboardCallbacks.push(callback);
+    // Keys forwarded when onKeyboard is called without a key list
+    _defaultKeys: [
+      'ArrowLeft', 'ArrowUp', 'ArrowRight', 'ArrowDown', 'Space', 'Enter', 'Escape',
+      'F1', 'F2', 'F3', 'F4', 'F5', 'F6', 'F7', 'F8', 'F9', 'F10', 'F11', 'F12',
+      'MediaPlayPause', 'MediaStop', 'MediaTrackNext', 'MediaTrackPrevious'
+    ],
+    
+    // Tell native the union of keys callbacks listen for; it installs its
+    // keyboard hook only while there are any (and the app enabled it)
+    _reportKeyboard: function() {
+      const keys = [];
+      this._keyboardCallbacks.forEach(function(k) {
+        k.keys.forEach(function(key) {
+          if (keys.indexOf(key) < 0) keys.push(key);
+        });
+      });
+      const joined = keys.sort().join(' ');
+      if (joined === this._keyboardReported) return;
+      this._keyboardReported = joined;
+      this.postMessage({ type: 'KEYBOARD_LISTENERS', keys: joined });
+    },
+    
+    // Register keyboard event callback: detail is { type, code, repeat,
+    // ctrl, shift, alt, meta }. type is keydown or keyup, code a
+    // KeyboardEvent.code name; auto-repeats arrive folded into one keydown
+    // per frame with repeat = their count. Only keys in options.keys
+    // (default: arrows, Space, Enter, Escape, F1-F12, media keys) are
+    // delivered, only while the desktop has focus, and native accepts at
+    // most 10 letter/digit keys per page. Returns a function that removes it.
+    onKeyboard: function(callback, options) {
+      const entry = {
+        callback: callback,
+        keys: (options && options.keys) ? options.keys.slice() : this._defaultKeys
+      };
+      this._keyboardCallbacks.push(entry);
       this._log('Keyboard callback registered (total: ' + this._keyboardCallbacks.length + ')');
+      this._reportKeyboard();
+      const remove = this._unsubscriber(this._keyboardCallbacks, entry);
+      const self = this;
+      return function() {
+        remove();
+        self._reportKeyboard();
+      };
     },
     
     // Setup event listeners
@@ -205,27 +588,91 @@
       // Listen for custom events from native
       window.addEventListener('hkcw:mouse', function(event) {
         const detail = event.detail;
-        self._mouseCallbacks.forEach(function(cb) {
-          cb(detail);
+        const motion = detail.type === 'mousemove';
+        const wheel = detail.type === 'wheel';
+        self._mouseCallbacks.forEach(function(m) {
+          if ((motion && !m.motion) || (wheel && !m.wheel)) return;
+          m.callback(detail);
         });
       });
       
       window.addEventListener('hkcw:keyboard', function(event) {
         const detail = event.detail;
-        self._keyboardCallbacks.forEach(function(cb) {
+        self._keyboardCallbacks.forEach(function(k) {
+          if (k.keys.indexOf(detail.code) >= 0) k.callback(detail);
+        });
+      });
+      
+      window.addEventListener('hkcw:gesture', function(event) {
+        const detail = event.detail;
+        self._gestureCallbacks.forEach(function(cb) {
           cb(detail);
         });
       });
       
+      // Native resolves onClick regions and sends only hits, with the id
       window.addEventListener('hkcw:click', function(event) {
         const detail = event.detail;
-        self._handleClick(detail.x, detail.y);
+        if (detail.id !== undefined) {
+          self._handleRegionClick(detail.id, detail.x, detail.y);
+        } else {
+          self._handleClick(detail.x, detail.y);
+        }
+      });
+      
+      window.addEventListener('resize', function() {
+        self._updateRegions();
       });
       
       window.addEventListener('hkcw:interactionMode', function(event) {
         self.interactionEnabled = event.detail.enabled;
         self._log('Interaction mode: ' + (self.interactionEnabled ? 'ON' : 'OFF'), true);
       });
+      
+      // Shared feeds: buffers arrive once per document, frames as messages
+      if (window.chrome && window.chrome.webview) {
+        window.chrome.webview.addEventListener('sharedbufferreceived', function(event) {
+          const info = event.additionalData;
+          if (!info || info.type !== 'HKCW_FEED') return;
+          const feed = self._feed(info.name);
+          feed.buffer = event.getBuffer();
+          feed.words = new Uint32Array(feed.buffer);
+          feed.lastSequence = 0;
+          self._log('Feed received: ' + info.name + ' (' + feed.buffer.byteLength + ' bytes)');
+        });
+        
+        window.chrome.webview.addEventListener('message', function(event) {
+          const data = event.data;
+          if (data && data.type === 'HKCW_FEED_FRAME') {
+            self._onFeedFrame(data.name);
+          } else if (data && data.type === 'HKCW_TELEMETRY') {
+            self._onTelemetry(data);
+          }
+        });
+      }
+      
+      // Deliver anything still queued before the page goes away; a page
+      // kept in the back/forward cache listens for nothing meanwhile
+      window.addEventListener('pagehide', function() {
+        self._inputReported = null;
+        self._adFrames = false;  // Native forgets the ads with the page
+        self.postMessage({
+          type: 'INPUT_LISTENERS', buttons: false, motion: false, wheel: false, regions: false,
+          gestures: false, ads: false
+        });
+        self._keyboardReported = null;
+        self.postMessage({ type: 'KEYBOARD_LISTENERS', keys: '' });
+        self._flush();
+      });
+      
+      window.addEventListener('pageshow', function(event) {
+        if (event.persisted) {
+          // Native dropped our regions when the page was left
+          if (self._clickHandlers.length > 0) self._sendRegions();
+          self._reportInput();
+          self._reportKeyboard();
+        }
+      });
     }
   };
   
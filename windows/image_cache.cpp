@@ -0,0 +1,155 @@
+#include "image_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char kCacheMagic[8] = {'H', 'K', 'C', 'W', 'I', 'M', 'G', 'C'};
+const uint32_t kCacheVersion = 1;
+const char kEntryExtension[] = ".frame";
+
+struct CacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t width;
+  uint32_t height;
+  uint32_t reserved;
+};
+
+}  // namespace
+
+void ScaledImageCache::SetDirectory(const std::string& directory) {
+  directory_ = directory;
+}
+
+std::string ScaledImageCache::MakeKey(uint64_t content_hash, int width, int height, ImageFit fit,
+                                      ResampleFilter filter) {
+  char key[64];
+  std::snprintf(key, sizeof(key), "%016llx_%dx%d_%d%d",
+                static_cast<unsigned long long>(content_hash), width, height,
+                static_cast<int>(fit), static_cast<int>(filter));
+  return key;
+}
+
+std::string ScaledImageCache::EntryPath(const std::string& key) const {
+  return (fs::u8path(directory_) / fs::u8path(key + kEntryExtension)).u8string();
+}
+
+bool ScaledImageCache::Load(const std::string& key, int width, int height,
+                            Surface& target) const {
+  if (!enabled()) return false;
+
+  fs::path path = fs::u8path(EntryPath(key));
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+
+  CacheHeader header;
+  if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+      !std::equal(kCacheMagic, kCacheMagic + 8, header.magic) ||
+      header.version != kCacheVersion ||
+      header.width != static_cast<uint32_t>(width) ||
+      header.height != static_cast<uint32_t>(height)) {
+    return false;
+  }
+
+  target.Resize(width, height);
+  std::streamsize bytes = static_cast<std::streamsize>(target.pixels.size() * sizeof(uint32_t));
+  if (!in.read(reinterpret_cast<char*>(target.pixels.data()), bytes)) {
+    target.Release();
+    return false;
+  }
+
+  // Hits count as use for Trim's LRU order
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return true;
+}
+
+bool ScaledImageCache::Store(const std::string& key, const Surface& surface) {
+  if (!enabled() || surface.pixels.empty()) return false;
+
+  std::error_code ec;
+  fs::create_directories(fs::u8path(directory_), ec);
+
+  // Write aside and rename so a reader never sees a partial frame
+  fs::path path = fs::u8path(EntryPath(key));
+  fs::path temp = path;
+  temp += ".tmp";
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      std::cout << "[HKCW] [ImageCache] ERROR: Cannot write " << temp.u8string() << std::endl;
+      return false;
+    }
+
+    CacheHeader header = {};
+    std::copy(kCacheMagic, kCacheMagic + 8, header.magic);
+    header.version = kCacheVersion;
+    header.width = static_cast<uint32_t>(surface.width);
+    header.height = static_cast<uint32_t>(surface.height);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(surface.pixels.data()),
+              static_cast<std::streamsize>(surface.pixels.size() * sizeof(uint32_t)));
+    if (!out) {
+      out.close();
+      fs::remove(temp, ec);
+      return false;
+    }
+  }
+
+  fs::rename(temp, path, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    return false;
+  }
+
+  Trim();
+  return true;
+}
+
+void ScaledImageCache::Trim() {
+  if (!enabled()) return;
+
+  struct Entry {
+    fs::path path;
+    fs::file_time_type time;
+    uint64_t size;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+
+  std::error_code ec;
+  for (fs::directory_iterator it(fs::u8path(directory_), ec), end; !ec && it != end;
+       it.increment(ec)) {
+    if (it->path().extension() != kEntryExtension) continue;
+    std::error_code entry_ec;
+    uint64_t size = it->file_size(entry_ec);
+    fs::file_time_type time = it->last_write_time(entry_ec);
+    if (entry_ec) continue;
+    entries.push_back({it->path(), time, size});
+    total += size;
+  }
+
+  if (total <= max_bytes_) return;
+
+  std::sort(entries.begin(), entries.end(),
+            [](const Entry& a, const Entry& b) { return a.time < b.time; });
+  for (const Entry& entry : entries) {
+    if (total <= max_bytes_) break;
+    if (fs::remove(entry.path, ec)) {
+      total -= entry.size;
+    }
+  }
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,46 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_CACHE_H_
+#define FLUTTER_PLUGIN_IMAGE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+
+#include "image_resampler.h"
+#include "software_rasterizer.h"
+
+namespace hkcw_engine2 {
+
+// Image Cache: pre-scaled wallpaper frames on disk.
+//
+// Entries are addressed by the hash of the source file's bytes plus the
+// output size, fit and filter, so a renamed or re-downloaded photo still
+// hits and an edited one misses. Each entry is a small header followed by
+// raw BGRA rows; loading one costs a single read instead of a decode.
+class ScaledImageCache {
+ public:
+  static const uint64_t kDefaultMaxBytes = 256ull * 1024 * 1024;
+
+  // UTF-8 directory, created on first store. Empty disables the cache.
+  void SetDirectory(const std::string& directory);
+  void set_max_bytes(uint64_t max_bytes) { max_bytes_ = max_bytes; }
+  bool enabled() const { return !directory_.empty(); }
+
+  static std::string MakeKey(uint64_t content_hash, int width, int height, ImageFit fit,
+                             ResampleFilter filter);
+
+  // Loads only if the stored frame is exactly width x height
+  bool Load(const std::string& key, int width, int height, Surface& target) const;
+  bool Store(const std::string& key, const Surface& surface);
+
+  // Delete least recently used entries until under max_bytes
+  void Trim();
+
+ private:
+  std::string EntryPath(const std::string& key) const;
+
+  std::string directory_;
+  uint64_t max_bytes_ = kDefaultMaxBytes;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_IMAGE_CACHE_H_
@@ -0,0 +1,234 @@
+#include "image_resampler.h"
+
+#include "simd_config.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const int kPrecisionBits = 14;
+const double kPi = 3.14159265358979323846;
+
+double FilterSupport(ResampleFilter filter) {
+  switch (filter) {
+    case ResampleFilter::kBox: return 0.5;
+    case ResampleFilter::kBilinear: return 1.0;
+    case ResampleFilter::kLanczos3: return 3.0;
+  }
+  return 1.0;
+}
+
+double Sinc(double x) {
+  if (x == 0.0) return 1.0;
+  x *= kPi;
+  return std::sin(x) / x;
+}
+
+double FilterWeight(ResampleFilter filter, double x) {
+  switch (filter) {
+    case ResampleFilter::kBox:
+      return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+    case ResampleFilter::kBilinear:
+      x = std::fabs(x);
+      return x < 1.0 ? 1.0 - x : 0.0;
+    case ResampleFilter::kLanczos3:
+      return (x > -3.0 && x < 3.0) ? Sinc(x) * Sinc(x / 3.0) : 0.0;
+  }
+  return 0.0;
+}
+
+inline uint8_t ClampToByte(int value) {
+  return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// Weighted sum of `count` BGRA pixels spaced `step` apart
+inline uint32_t Convolve(const uint32_t* in, size_t step, const int16_t* weights, int count) {
+#if HKCW_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_set1_epi32(1 << (kPrecisionBits - 1));
+  int i = 0;
+  for (; i + 1 < count; i += 2) {
+    // b0 b1 g0 g1 r0 r1 a0 a1 against w0 w1 w0 w1 ...
+    __m128i pair = _mm_unpacklo_epi32(
+        _mm_cvtsi32_si128(static_cast<int>(in[static_cast<size_t>(i) * step])),
+        _mm_cvtsi32_si128(static_cast<int>(in[static_cast<size_t>(i + 1) * step])));
+    pair = _mm_unpacklo_epi8(pair, zero);
+    pair = _mm_unpacklo_epi16(pair, _mm_srli_si128(pair, 8));
+    uint32_t packed = static_cast<uint16_t>(weights[i]) |
+                      static_cast<uint32_t>(static_cast<uint16_t>(weights[i + 1])) << 16;
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(pair, _mm_set1_epi32(static_cast<int>(packed))));
+  }
+  if (i < count) {
+    __m128i single = _mm_cvtsi32_si128(static_cast<int>(in[static_cast<size_t>(i) * step]));
+    single = _mm_unpacklo_epi16(_mm_unpacklo_epi8(single, zero), zero);
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(
+        single, _mm_set1_epi32(static_cast<int>(static_cast<uint16_t>(weights[i])))));
+  }
+  sum = _mm_srai_epi32(sum, kPrecisionBits);
+  sum = _mm_packs_epi32(sum, sum);
+  return static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+#else
+  int channels[4] = {1 << (kPrecisionBits - 1), 1 << (kPrecisionBits - 1),
+                     1 << (kPrecisionBits - 1), 1 << (kPrecisionBits - 1)};
+  for (int i = 0; i < count; i++) {
+    uint32_t pixel = in[static_cast<size_t>(i) * step];
+    for (int c = 0; c < 4; c++) {
+      channels[c] += static_cast<int>((pixel >> (c * 8)) & 0xFF) * weights[i];
+    }
+  }
+  uint32_t result = 0;
+  for (int c = 0; c < 4; c++) {
+    result |= static_cast<uint32_t>(ClampToByte(channels[c] >> kPrecisionBits)) << (c * 8);
+  }
+  return result;
+#endif
+}
+
+}  // namespace
+
+void ImageResampler::Compute(float start, float extent, int in_size, int out_size,
+                             ResampleFilter filter, Coefficients& coefficients) {
+  double scale = static_cast<double>(extent) / out_size;
+  double filter_scale = (std::max)(scale, 1.0);
+  double support = FilterSupport(filter) * filter_scale;
+  int max_taps = static_cast<int>(std::ceil(support)) * 2 + 1;
+
+  coefficients.max_taps = max_taps;
+  coefficients.bounds.resize(static_cast<size_t>(out_size) * 2);
+  coefficients.weights.assign(static_cast<size_t>(out_size) * static_cast<size_t>(max_taps), 0);
+
+  std::vector<double> kernel(static_cast<size_t>(max_taps));
+  for (int out = 0; out < out_size; out++) {
+    double center = start + (out + 0.5) * scale;
+    int first = (std::max)(static_cast<int>(center - support + 0.5), 0);
+    int last = (std::min)(static_cast<int>(center + support + 0.5), in_size);
+    int taps = (std::min)(last - first, max_taps);
+
+    double total = 0.0;
+    for (int i = 0; i < taps; i++) {
+      double weight = FilterWeight(filter, (first + i - center + 0.5) / filter_scale);
+      kernel[static_cast<size_t>(i)] = weight;
+      total += weight;
+    }
+
+    // Outside the source (or a degenerate kernel): nearest edge pixel
+    if (taps <= 0 || total == 0.0) {
+      first = (std::min)((std::max)(static_cast<int>(center), 0), in_size - 1);
+      taps = 1;
+      kernel[0] = 1.0;
+      total = 1.0;
+    }
+
+    coefficients.bounds[static_cast<size_t>(out) * 2] = first;
+    coefficients.bounds[static_cast<size_t>(out) * 2 + 1] = taps;
+    int16_t* weights = &coefficients.weights[static_cast<size_t>(out) * static_cast<size_t>(max_taps)];
+    int sum = 0;
+    int largest = 0;
+    for (int i = 0; i < taps; i++) {
+      double normalized = kernel[static_cast<size_t>(i)] / total;
+      weights[i] = static_cast<int16_t>(std::lround(normalized * (1 << kPrecisionBits)));
+      sum += weights[i];
+      if (weights[i] > weights[largest]) largest = i;
+    }
+    // Rounding drift adds up over hundreds of taps on big reductions and
+    // would darken flat areas; the largest tap absorbs it
+    weights[largest] = static_cast<int16_t>(weights[largest] + (1 << kPrecisionBits) - sum);
+  }
+}
+
+void ImageResampler::Resample(const ImageView& source, float src_x, float src_y,
+                              float src_width, float src_height, Surface& target,
+                              ResampleFilter filter) {
+  if (source.width <= 0 || source.height <= 0 || target.width <= 0 || target.height <= 0) {
+    return;
+  }
+
+  Compute(src_x, src_width, source.width, target.width, filter, horizontal_);
+  Compute(src_y, src_height, source.height, target.height, filter, vertical_);
+
+  // Only the source rows the vertical pass reads go through the first pass
+  int row_begin = vertical_.bounds[0];
+  int row_end = 0;
+  for (int y = 0; y < target.height; y++) {
+    row_end = (std::max)(row_end, vertical_.bounds[static_cast<size_t>(y) * 2] +
+                                      vertical_.bounds[static_cast<size_t>(y) * 2 + 1]);
+    row_begin = (std::min)(row_begin, vertical_.bounds[static_cast<size_t>(y) * 2]);
+  }
+
+  size_t out_width = static_cast<size_t>(target.width);
+  intermediate_.resize(out_width * static_cast<size_t>(row_end - row_begin));
+
+  // Pass 1: horizontal, source rows -> intermediate
+  for (int y = row_begin; y < row_end; y++) {
+    const uint32_t* in = source.pixels + static_cast<size_t>(y) * static_cast<size_t>(source.stride);
+    uint32_t* out = &intermediate_[static_cast<size_t>(y - row_begin) * out_width];
+    for (size_t x = 0; x < out_width; x++) {
+      int first = horizontal_.bounds[x * 2];
+      int taps = horizontal_.bounds[x * 2 + 1];
+      out[x] = Convolve(in + first, 1,
+                        &horizontal_.weights[x * static_cast<size_t>(horizontal_.max_taps)], taps);
+    }
+  }
+
+  // Pass 2: vertical, intermediate columns -> target
+  for (int y = 0; y < target.height; y++) {
+    int first = vertical_.bounds[static_cast<size_t>(y) * 2];
+    int taps = vertical_.bounds[static_cast<size_t>(y) * 2 + 1];
+    const int16_t* weights = &vertical_.weights[static_cast<size_t>(y) *
+                                                static_cast<size_t>(vertical_.max_taps)];
+    const uint32_t* in = &intermediate_[static_cast<size_t>(first - row_begin) * out_width];
+    uint32_t* out = target.Row(y);
+    for (size_t x = 0; x < out_width; x++) {
+      out[x] = Convolve(in + x, out_width, weights, taps);
+    }
+  }
+}
+
+void ImageResampler::ResampleToFit(const ImageView& source, ImageFit fit, uint32_t background,
+                                   int width, int height, Surface& target,
+                                   ResampleFilter filter) {
+  target.Resize(width, height);
+  if (source.width <= 0 || source.height <= 0 || width <= 0 || height <= 0) return;
+
+  float image_width = static_cast<float>(source.width);
+  float image_height = static_cast<float>(source.height);
+  float target_width = static_cast<float>(width);
+  float target_height = static_cast<float>(height);
+
+  switch (fit) {
+    case ImageFit::kStretch:
+      Resample(source, 0.0f, 0.0f, image_width, image_height, target, filter);
+      break;
+
+    case ImageFit::kCover: {
+      float scale = (std::max)(target_width / image_width, target_height / image_height);
+      float crop_width = target_width / scale;
+      float crop_height = target_height / scale;
+      Resample(source, (image_width - crop_width) * 0.5f, (image_height - crop_height) * 0.5f,
+               crop_width, crop_height, target, filter);
+      break;
+    }
+
+    case ImageFit::kContain: {
+      float scale = (std::min)(target_width / image_width, target_height / image_height);
+      Surface fitted;
+      fitted.Resize((std::max)(static_cast<int>(image_width * scale + 0.5f), 1),
+                    (std::max)(static_cast<int>(image_height * scale + 0.5f), 1));
+      Resample(source, 0.0f, 0.0f, image_width, image_height, fitted, filter);
+
+      FillSolid(target, background);
+      int left = (width - fitted.width) / 2;
+      int top = (height - fitted.height) / 2;
+      for (int y = 0; y < fitted.height && top + y < height; y++) {
+        std::copy(fitted.Row(y), fitted.Row(y) + (std::min)(fitted.width, width - left),
+                  target.Row(top + y) + left);
+      }
+      break;
+    }
+  }
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,49 @@
+#ifndef FLUTTER_PLUGIN_IMAGE_RESAMPLER_H_
+#define FLUTTER_PLUGIN_IMAGE_RESAMPLER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "software_rasterizer.h"
+
+namespace hkcw_engine2 {
+
+enum class ResampleFilter { kBox, kBilinear, kLanczos3 };
+
+// Image Resampler: separable, area-aware resampling of BGRA images.
+//
+// Coefficients are precomputed per output row/column in 14-bit fixed
+// point; the filter support widens with the downscale ratio so large
+// reductions average every source pixel instead of aliasing. The inner
+// loops consume two taps per SSE2 multiply-add.
+class ImageResampler {
+ public:
+  // Resample the source rectangle to exactly target.width x target.height
+  void Resample(const ImageView& source, float src_x, float src_y, float src_width,
+                float src_height, Surface& target, ResampleFilter filter);
+
+  // Resize target to width x height and fit the image: cover crops the
+  // centre, contain letterboxes with background, stretch ignores aspect
+  void ResampleToFit(const ImageView& source, ImageFit fit, uint32_t background, int width,
+                     int height, Surface& target, ResampleFilter filter);
+
+ private:
+  struct Coefficients {
+    std::vector<int> bounds;       // Per output: first source index, tap count
+    std::vector<int16_t> weights;  // Per output: taps, padded to max_taps
+    int max_taps = 0;
+  };
+
+  static void Compute(float start, float extent, int in_size, int out_size,
+                      ResampleFilter filter, Coefficients& coefficients);
+
+  // Reused between calls; a 4K intermediate is ~30 MB, so keep it
+  // only as long as the resampler lives
+  Coefficients horizontal_;
+  Coefficients vertical_;
+  std::vector<uint32_t> intermediate_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_IMAGE_RESAMPLER_H_
@@ -0,0 +1,397 @@
+#include "input_source.h"
+
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <iostream>
+#endif
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// Next whitespace-separated token of line, advancing pos past it
+std::string_view NextToken(std::string_view line, size_t& pos) {
+  while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) pos++;
+  size_t start = pos;
+  while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t') pos++;
+  return line.substr(start, pos - start);
+}
+
+bool ParseInt(std::string_view token, long long& value) {
+  if (token.empty()) return false;
+  auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+  return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+bool ParseButton(std::string_view token, PointerButton& button) {
+  if (token == "left") button = PointerButton::kLeft;
+  else if (token == "right") button = PointerButton::kRight;
+  else if (token == "middle") button = PointerButton::kMiddle;
+  else return false;
+  return true;
+}
+
+}  // namespace
+
+bool ParseInputTrace(std::string_view text, std::vector<InputEvent>& events, std::string* error) {
+  events.clear();
+  size_t line_number = 0;
+  size_t line_start = 0;
+  while (line_start < text.size()) {
+    size_t line_end = text.find('\n', line_start);
+    if (line_end == std::string_view::npos) line_end = text.size();
+    std::string_view line = text.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    line_number++;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    size_t pos = 0;
+    std::string_view time_token = NextToken(line, pos);
+    if (time_token.empty() || time_token[0] == '#') continue;
+
+    InputEvent event;
+    std::string_view type = NextToken(line, pos);
+    long long numbers[5] = {};
+    size_t count = 0;
+    bool ok = ParseInt(time_token, numbers[0]) && numbers[0] >= 0;
+    event.time_ms = static_cast<uint32_t>(numbers[0]);
+
+    if (type == "down" || type == "up") {
+      event.type = type == "down" ? InputEvent::Type::kDown : InputEvent::Type::kUp;
+      ok = ok && ParseButton(NextToken(line, pos), event.button);
+      count = 2;
+    } else if (type == "move") {
+      event.type = InputEvent::Type::kMove;
+      count = 2;
+    } else if (type == "wheel") {
+      event.type = InputEvent::Type::kWheel;
+      count = 4;
+    } else {
+      ok = false;
+    }
+    for (size_t i = 0; ok && i < count; i++) {
+      ok = ParseInt(NextToken(line, pos), numbers[i]);
+    }
+    ok = ok && NextToken(line, pos).empty();
+
+    if (!ok) {
+      if (error) *error = "Invalid input trace line " + std::to_string(line_number);
+      events.clear();
+      return false;
+    }
+    event.x = static_cast<int>(numbers[0]);
+    event.y = static_cast<int>(numbers[1]);
+    if (event.type == InputEvent::Type::kWheel) {
+      event.wheel_x = static_cast<int>(numbers[2]);
+      event.wheel_y = static_cast<int>(numbers[3]);
+    }
+    events.push_back(event);
+  }
+  return true;
+}
+
+InputReplayer::InputReplayer(std::vector<InputEvent> events, double speed)
+    : events_(std::move(events)), speed_(speed) {}
+
+uint32_t InputReplayer::DueMs(size_t index) const {
+  if (speed_ <= 0.0) return 0;
+  uint32_t offset = events_[index].time_ms - events_[0].time_ms;
+  return static_cast<uint32_t>(std::floor(static_cast<double>(offset) / speed_));
+}
+
+uint32_t InputReplayer::next_due_ms() const {
+  return done() ? 0 : DueMs(next_);
+}
+
+size_t InputReplayer::Advance(uint32_t elapsed_ms, uint32_t start_time_ms,
+                              const InputSource::Handler& handler, size_t max_events) {
+  size_t delivered = 0;
+  while (next_ < events_.size() && delivered < max_events) {
+    uint32_t due = DueMs(next_);
+    if (due > elapsed_ms) break;
+    InputEvent event = events_[next_++];
+    event.time_ms = start_time_ms + due;
+    handler(event);
+    delivered++;
+  }
+  return delivered;
+}
+
+#ifdef _WIN32
+
+namespace {
+
+class LowLevelHookSource : public InputSource {
+ public:
+  ~LowLevelHookSource() override { Stop(); }
+
+  bool Start(Handler handler) override {
+    if (hook_) return true;
+    if (instance_) return false;  // One WH_MOUSE_LL hook per process
+
+    handler_ = std::move(handler);
+    instance_ = this;
+    hook_ = SetWindowsHookExW(WH_MOUSE_LL, HookProc, GetModuleHandleW(nullptr), 0);
+    if (!hook_) {
+      std::cout << "[HKCW] [Hook] ERROR: Failed to install mouse hook, error: " << GetLastError()
+                << std::endl;
+      instance_ = nullptr;
+      return false;
+    }
+    std::cout << "[HKCW] [Hook] Mouse hook installed successfully" << std::endl;
+    return true;
+  }
+
+  void Stop() override {
+    if (!hook_) return;
+    UnhookWindowsHookEx(hook_);
+    hook_ = nullptr;
+    instance_ = nullptr;
+    std::cout << "[HKCW] [Hook] Mouse hook removed" << std::endl;
+  }
+
+  const char* name() const override { return "hook"; }
+
+ private:
+  // Runs for every mouse event on the system: decode and hand off only
+  static LRESULT CALLBACK HookProc(int code, WPARAM wparam, LPARAM lparam) {
+    if (code >= 0 && instance_) {
+      const auto* info = reinterpret_cast<const MSLLHOOKSTRUCT*>(lparam);
+      InputEvent event;
+      event.x = info->pt.x;
+      event.y = info->pt.y;
+      event.time_ms = info->time;
+      bool known = true;
+      switch (wparam) {
+        case WM_MOUSEMOVE: event.type = InputEvent::Type::kMove; break;
+        case WM_LBUTTONDOWN: event.type = InputEvent::Type::kDown; event.button = PointerButton::kLeft; break;
+        case WM_LBUTTONUP: event.type = InputEvent::Type::kUp; event.button = PointerButton::kLeft; break;
+        case WM_RBUTTONDOWN: event.type = InputEvent::Type::kDown; event.button = PointerButton::kRight; break;
+        case WM_RBUTTONUP: event.type = InputEvent::Type::kUp; event.button = PointerButton::kRight; break;
+        case WM_MBUTTONDOWN: event.type = InputEvent::Type::kDown; event.button = PointerButton::kMiddle; break;
+        case WM_MBUTTONUP: event.type = InputEvent::Type::kUp; event.button = PointerButton::kMiddle; break;
+        case WM_MOUSEWHEEL:
+          event.type = InputEvent::Type::kWheel;
+          event.wheel_y = static_cast<short>(HIWORD(info->mouseData));
+          break;
+        case WM_MOUSEHWHEEL:
+          event.type = InputEvent::Type::kWheel;
+          event.wheel_x = static_cast<short>(HIWORD(info->mouseData));
+          break;
+        default: known = false; break;
+      }
+      if (known) instance_->handler_(event);
+    }
+    return CallNextHookEx(nullptr, code, wparam, lparam);
+  }
+
+  static LowLevelHookSource* instance_;
+  HHOOK hook_ = nullptr;
+  Handler handler_;
+};
+
+LowLevelHookSource* LowLevelHookSource::instance_ = nullptr;
+
+const wchar_t kRawInputWindowClassName[] = L"HKCWRawInput";
+
+class RawInputSource : public InputSource {
+ public:
+  ~RawInputSource() override { Stop(); }
+
+  bool Start(Handler handler) override {
+    if (hwnd_) return true;
+    handler_ = std::move(handler);
+
+    static bool class_registered = false;
+    if (!class_registered) {
+      WNDCLASSW wc = {};
+      wc.lpfnWndProc = WindowProc;
+      wc.hInstance = GetModuleHandle(nullptr);
+      wc.lpszClassName = kRawInputWindowClassName;
+      if (!RegisterClassW(&wc) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
+        std::cout << "[HKCW] [Input] ERROR: Failed to register raw input window class" << std::endl;
+        return false;
+      }
+      class_registered = true;
+    }
+
+    hwnd_ = CreateWindowExW(0, kRawInputWindowClassName, L"", 0, 0, 0, 0, 0, HWND_MESSAGE, nullptr,
+                            GetModuleHandle(nullptr), nullptr);
+    if (!hwnd_) return false;
+    SetWindowLongPtrW(hwnd_, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(this));
+
+    // Generic desktop / mouse, delivered even while we are in the background
+    RAWINPUTDEVICE device = {0x01, 0x02, RIDEV_INPUTSINK, hwnd_};
+    if (!RegisterRawInputDevices(&device, 1, sizeof(device))) {
+      std::cout << "[HKCW] [Input] ERROR: RegisterRawInputDevices failed, error: " << GetLastError()
+                << std::endl;
+      DestroyWindow(hwnd_);
+      hwnd_ = nullptr;
+      return false;
+    }
+    std::cout << "[HKCW] [Input] Raw input registered" << std::endl;
+    return true;
+  }
+
+  void Stop() override {
+    if (!hwnd_) return;
+    RAWINPUTDEVICE device = {0x01, 0x02, RIDEV_REMOVE, nullptr};
+    RegisterRawInputDevices(&device, 1, sizeof(device));
+    DestroyWindow(hwnd_);
+    hwnd_ = nullptr;
+    std::cout << "[HKCW] [Input] Raw input removed" << std::endl;
+  }
+
+  const char* name() const override { return "rawinput"; }
+
+ private:
+  static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam) {
+    auto* source = reinterpret_cast<RawInputSource*>(GetWindowLongPtrW(hwnd, GWLP_USERDATA));
+    if (message == WM_INPUT && source) {
+      source->OnRawInput(reinterpret_cast<HRAWINPUT>(lparam));
+    }
+    // WM_INPUT also needs DefWindowProc for the system's cleanup
+    return DefWindowProcW(hwnd, message, wparam, lparam);
+  }
+
+  void OnRawInput(HRAWINPUT handle) {
+    RAWINPUT raw;
+    UINT size = sizeof(raw);
+    if (GetRawInputData(handle, RID_INPUT, &raw, &size, sizeof(RAWINPUTHEADER)) == static_cast<UINT>(-1) ||
+        raw.header.dwType != RIM_TYPEMOUSE) {
+      return;
+    }
+
+    const RAWMOUSE& mouse = raw.data.mouse;
+    POINT pt;
+    GetCursorPos(&pt);
+    InputEvent event;
+    event.x = pt.x;
+    event.y = pt.y;
+    event.time_ms = static_cast<uint32_t>(GetMessageTime());
+
+    if (mouse.lLastX != 0 || mouse.lLastY != 0 || (mouse.usFlags & MOUSE_MOVE_ABSOLUTE)) {
+      event.type = InputEvent::Type::kMove;
+      handler_(event);
+    }
+
+    // One report can carry several transitions
+    static const struct {
+      USHORT flag;
+      InputEvent::Type type;
+      PointerButton button;
+    } kTransitions[] = {
+      {RI_MOUSE_LEFT_BUTTON_DOWN, InputEvent::Type::kDown, PointerButton::kLeft},
+      {RI_MOUSE_LEFT_BUTTON_UP, InputEvent::Type::kUp, PointerButton::kLeft},
+      {RI_MOUSE_RIGHT_BUTTON_DOWN, InputEvent::Type::kDown, PointerButton::kRight},
+      {RI_MOUSE_RIGHT_BUTTON_UP, InputEvent::Type::kUp, PointerButton::kRight},
+      {RI_MOUSE_MIDDLE_BUTTON_DOWN, InputEvent::Type::kDown, PointerButton::kMiddle},
+      {RI_MOUSE_MIDDLE_BUTTON_UP, InputEvent::Type::kUp, PointerButton::kMiddle},
+    };
+    for (const auto& transition : kTransitions) {
+      if (mouse.usButtonFlags & transition.flag) {
+        event.type = transition.type;
+        event.button = transition.button;
+        handler_(event);
+      }
+    }
+
+    if (mouse.usButtonFlags & (RI_MOUSE_WHEEL | RI_MOUSE_HWHEEL)) {
+      short delta = static_cast<short>(mouse.usButtonData);
+      bool horizontal = (mouse.usButtonFlags & RI_MOUSE_HWHEEL) != 0;
+      event.type = InputEvent::Type::kWheel;
+      event.wheel_x = horizontal ? delta : 0;
+      event.wheel_y = horizontal ? 0 : delta;
+      handler_(event);
+    }
+  }
+
+  HWND hwnd_ = nullptr;
+  Handler handler_;
+};
+
+// At speed 0 a tick delivers at most this many events
+const size_t kReplayEventsPerTick = 1000;
+
+class ReplaySource : public InputSource {
+ public:
+  ReplaySource(std::vector<InputEvent> events, double speed) : replayer_(std::move(events), speed) {}
+  ~ReplaySource() override { Stop(); }
+
+  bool Start(Handler handler) override {
+    if (timer_) return true;
+    if (instance_) return false;
+    handler_ = std::move(handler);
+    instance_ = this;
+    start_ms_ = GetTickCount();
+    std::cout << "[HKCW] [Input] Replaying " << replayer_.size() << " event(s)" << std::endl;
+    Schedule();
+    return true;
+  }
+
+  void Stop() override {
+    if (instance_ == this) instance_ = nullptr;
+    if (timer_) {
+      KillTimer(nullptr, timer_);
+      timer_ = 0;
+    }
+  }
+
+  const char* name() const override { return "replay"; }
+
+ private:
+  // Thread timer: runs on the UI thread's message loop like the others
+  static void CALLBACK TimerProc(HWND, UINT, UINT_PTR, DWORD) {
+    if (instance_) instance_->Tick();
+  }
+
+  void Tick() {
+    // Speed 0 (or a long stall) makes everything due at once: catch up in
+    // slices so the message loop keeps running
+    replayer_.Advance(GetTickCount() - start_ms_, start_ms_, handler_, kReplayEventsPerTick);
+    if (replayer_.done()) {
+      std::cout << "[HKCW] [Input] Replay finished" << std::endl;
+      KillTimer(nullptr, timer_);
+      timer_ = 0;
+      return;
+    }
+    Schedule();
+  }
+
+  void Schedule() {
+    uint32_t elapsed = GetTickCount() - start_ms_;
+    uint32_t due = replayer_.next_due_ms();
+    UINT delay = due > elapsed ? due - elapsed : USER_TIMER_MINIMUM;
+    timer_ = SetTimer(nullptr, timer_, delay, TimerProc);
+  }
+
+  static ReplaySource* instance_;
+  InputReplayer replayer_;
+  Handler handler_;
+  uint32_t start_ms_ = 0;
+  UINT_PTR timer_ = 0;
+};
+
+ReplaySource* ReplaySource::instance_ = nullptr;
+
+}  // namespace
+
+std::unique_ptr<InputSource> CreateLowLevelHookSource() {
+  return std::make_unique<LowLevelHookSource>();
+}
+
+std::unique_ptr<InputSource> CreateRawInputSource() {
+  return std::make_unique<RawInputSource>();
+}
+
+std::unique_ptr<InputSource> CreateReplaySource(std::vector<InputEvent> events, double speed) {
+  return std::make_unique<ReplaySource>(std::move(events), speed);
+}
+
+#endif  // _WIN32
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,93 @@
+#ifndef FLUTTER_PLUGIN_INPUT_SOURCE_H_
+#define FLUTTER_PLUGIN_INPUT_SOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "gesture_recognizer.h"
+
+namespace hkcw_engine2 {
+
+// Input Source: one desktop mouse event, in screen pixels
+struct InputEvent {
+  enum class Type { kMove, kDown, kUp, kWheel };
+  Type type = Type::kMove;
+  PointerButton button = PointerButton::kLeft;  // kDown / kUp
+  int x = 0;
+  int y = 0;
+  int wheel_x = 0;  // kWheel, WHEEL_DELTA units; positive = right / away
+  int wheel_y = 0;
+  uint32_t time_ms = 0;  // Tick count; wraps
+};
+
+// Input Source: where desktop mouse events come from. Every backend
+// delivers on the thread that started it (the UI thread), so the dispatch
+// logic behind it needs no locking.
+class InputSource {
+ public:
+  using Handler = std::function<void(const InputEvent& event)>;
+
+  virtual ~InputSource() = default;
+
+  virtual bool Start(Handler handler) = 0;
+  virtual void Stop() = 0;
+  virtual const char* name() const = 0;
+};
+
+// Input Trace: recorded events, one per line, times relative to the first:
+//   <ms> move <x> <y>
+//   <ms> down|up left|right|middle <x> <y>
+//   <ms> wheel <x> <y> <dx> <dy>
+// Blank lines and lines starting with '#' are ignored.
+bool ParseInputTrace(std::string_view text, std::vector<InputEvent>& events, std::string* error);
+
+// Input Replay: a trace played against a caller-supplied clock, so tests
+// and benchmarks run in virtual time and live playback on a timer.
+class InputReplayer {
+ public:
+  // speed 1 = original timing, 4 = four times faster, 0 = as fast as possible
+  InputReplayer(std::vector<InputEvent> events, double speed);
+
+  // Delivers every event due at elapsed_ms since playback started; event
+  // times are rebased onto start_time_ms so downstream timing (double
+  // clicks, long presses) sees the replayed pace. At most max_events are
+  // delivered per call.
+  size_t Advance(uint32_t elapsed_ms, uint32_t start_time_ms, const InputSource::Handler& handler,
+                 size_t max_events = SIZE_MAX);
+
+  bool done() const { return next_ >= events_.size(); }
+  // Milliseconds from playback start until the next event is due
+  uint32_t next_due_ms() const;
+  size_t size() const { return events_.size(); }
+
+ private:
+  uint32_t DueMs(size_t index) const;
+
+  std::vector<InputEvent> events_;
+  double speed_;
+  size_t next_ = 0;
+};
+
+#ifdef _WIN32
+// WH_MOUSE_LL: exact positions and timestamps, but every mouse event on
+// the system waits for our callback (and Windows drops hooks that are
+// slower than LowLevelHooksTimeout)
+std::unique_ptr<InputSource> CreateLowLevelHookSource();
+
+// Raw Input (RIDEV_INPUTSINK) on a message-only window: delivered as
+// ordinary window messages, nothing waits for us. Positions come from
+// GetCursorPos, so they include pointer acceleration like the hook's.
+std::unique_ptr<InputSource> CreateRawInputSource();
+
+// A recorded trace replayed on a thread timer
+std::unique_ptr<InputSource> CreateReplaySource(std::vector<InputEvent> events, double speed);
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_INPUT_SOURCE_H_
@@ -0,0 +1,279 @@
+#include "keyboard_forwarder.h"
+
+#include <algorithm>
+#include <array>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <iostream>
+#endif
+
+namespace hkcw_engine2 {
+
+namespace {
+
+struct NamedKey {
+  uint32_t vk;
+  const char* name;
+};
+
+// Everything forwardable that is not a letter, digit or function key
+const NamedKey kNamedKeys[] = {
+  {0x08, "Backspace"}, {0x09, "Tab"}, {0x0D, "Enter"}, {0x1B, "Escape"},
+  {0x20, "Space"}, {0x21, "PageUp"}, {0x22, "PageDown"}, {0x23, "End"},
+  {0x24, "Home"}, {0x25, "ArrowLeft"}, {0x26, "ArrowUp"}, {0x27, "ArrowRight"},
+  {0x28, "ArrowDown"}, {0x2D, "Insert"}, {0x2E, "Delete"},
+  {0xAD, "AudioVolumeMute"}, {0xAE, "AudioVolumeDown"}, {0xAF, "AudioVolumeUp"},
+  {0xB0, "MediaTrackNext"}, {0xB1, "MediaTrackPrevious"}, {0xB2, "MediaStop"},
+  {0xB3, "MediaPlayPause"},
+};
+
+// vk -> name, built once; generated names live in the table's own storage
+struct KeyNameTable {
+  std::array<const char*, 256> names = {};
+  std::array<std::array<char, 8>, 256> storage = {};
+
+  KeyNameTable() {
+    for (const NamedKey& key : kNamedKeys) names[key.vk] = key.name;
+    for (uint32_t vk = 'A'; vk <= 'Z'; vk++) Generate(vk, "Key", static_cast<char>(vk));
+    for (uint32_t vk = '0'; vk <= '9'; vk++) Generate(vk, "Digit", static_cast<char>(vk));
+    for (uint32_t i = 0; i < 10; i++) Generate(0x60 + i, "Numpad", static_cast<char>('0' + i));
+    for (uint32_t i = 0; i < 24; i++) {  // F1..F24 = 0x70..0x87
+      std::string name = "F" + std::to_string(i + 1);
+      name.copy(storage[0x70 + i].data(), name.size());
+      names[0x70 + i] = storage[0x70 + i].data();
+    }
+  }
+
+  void Generate(uint32_t vk, const char* prefix, char suffix) {
+    std::string name = std::string(prefix) + suffix;
+    name.copy(storage[vk].data(), name.size());
+    names[vk] = storage[vk].data();
+  }
+};
+
+const KeyNameTable& KeyNames() {
+  static const KeyNameTable table;
+  return table;
+}
+
+}  // namespace
+
+const char* KeyCodeName(uint32_t vk) {
+  return vk < 256 ? KeyNames().names[vk] : nullptr;
+}
+
+uint32_t KeyCodeFromName(std::string_view name) {
+  const KeyNameTable& table = KeyNames();
+  for (uint32_t vk = 0; vk < 256; vk++) {
+    if (table.names[vk] && name == table.names[vk]) return vk;
+  }
+  return 0;
+}
+
+bool IsTextKey(uint32_t vk) {
+  return (vk >= 'A' && vk <= 'Z') || (vk >= '0' && vk <= '9') || (vk >= 0x60 && vk <= 0x69);
+}
+
+bool KeyForwarder::IsModifier(uint32_t vk) {
+  switch (vk) {
+    case 0x10: case 0x11: case 0x12:  // Shift, Control, Menu
+    case 0xA0: case 0xA1: case 0xA2: case 0xA3: case 0xA4: case 0xA5:  // Left / right variants
+    case 0x5B: case 0x5C:  // Windows keys
+      return true;
+  }
+  return false;
+}
+
+size_t KeyForwarder::SetKeys(std::string_view names) {
+  std::bitset<256> keys;
+  size_t text_keys = 0;
+  size_t pos = 0;
+  while (pos < names.size()) {
+    size_t end = names.find(' ', pos);
+    if (end == std::string_view::npos) end = names.size();
+    uint32_t vk = KeyCodeFromName(names.substr(pos, end - pos));
+    pos = end + 1;
+    if (vk == 0 || keys[vk]) continue;
+    if (IsTextKey(vk) && ++text_keys > kMaxTextKeys) continue;
+    keys[vk] = true;
+  }
+
+  keys_ = keys;
+  for (uint32_t vk = 0; vk < 256; vk++) {
+    if (held_[vk] && !keys_[vk]) Release(vk);
+  }
+  return keys_.count();
+}
+
+bool KeyForwarder::Push(KeyBatchEntry entry) {
+  // Releases always fit (room for every held key is reserved)
+  if (entry.down && pending_.size() >= kMaxPending) {
+    dropped_++;
+    return false;
+  }
+  pending_.push_back(entry);
+  forwarded_++;
+  return true;
+}
+
+void KeyForwarder::Release(uint32_t vk) {
+  held_[vk] = false;
+  Push({vk, false, false, 0, Modifiers()});
+}
+
+uint32_t KeyForwarder::Modifiers() const {
+  uint32_t modifiers = 0;
+  if (modifiers_down_[0x10] || modifiers_down_[0xA0] || modifiers_down_[0xA1]) modifiers |= kKeyModifierShift;
+  if (modifiers_down_[0x11] || modifiers_down_[0xA2] || modifiers_down_[0xA3]) modifiers |= kKeyModifierCtrl;
+  if (modifiers_down_[0x12] || modifiers_down_[0xA4] || modifiers_down_[0xA5]) modifiers |= kKeyModifierAlt;
+  if (modifiers_down_[0x5B] || modifiers_down_[0x5C]) modifiers |= kKeyModifierMeta;
+  return modifiers;
+}
+
+bool KeyForwarder::IsRepeat(const KeyBatchEntry& entry) {
+  return entry.down && !entry.initial;
+}
+
+KeyForwarder::Flush KeyForwarder::pending_flush() const {
+  if (pending_.empty()) return Flush::kNone;
+  for (const KeyBatchEntry& entry : pending_) {
+    if (!IsRepeat(entry)) return Flush::kNextFrame;
+  }
+  return Flush::kRepeat;
+}
+
+KeyForwarder::Flush KeyForwarder::Process(const KeyEvent& event) {
+  if (event.vk >= 256) return Flush::kNone;
+  uint32_t vk = event.vk;
+  Flush before = pending_flush();
+
+  if (IsModifier(vk)) {
+    modifiers_down_[vk] = event.down;
+    return Flush::kNone;
+  }
+
+  if (!event.down) {
+    if (held_[vk]) Release(vk);
+  } else if (!event.desktop_focused) {
+    // Typing went elsewhere: nothing more for the page, and whatever it
+    // thinks is held is let go
+    ReleaseAll();
+  } else if (held_[vk]) {
+    // Auto-repeat: fold into the press still waiting in this batch
+    for (auto it = pending_.rbegin(); it != pending_.rend(); ++it) {
+      if (it->vk != vk) continue;
+      if (it->down) {
+        it->repeat++;
+        coalesced_++;
+        return Flush::kNone;
+      }
+      break;
+    }
+    Push({vk, true, false, 1, Modifiers()});
+  } else if (keys_[vk]) {
+    if (Push({vk, true, true, 0, Modifiers()})) held_[vk] = true;
+  }
+
+  Flush after = pending_flush();
+  return after > before ? after : Flush::kNone;
+}
+
+void KeyForwarder::ReleaseAll() {
+  for (uint32_t vk = 0; vk < 256; vk++) {
+    if (held_[vk]) Release(vk);
+  }
+}
+
+void KeyForwarder::Reset() {
+  keys_.reset();
+  held_.reset();
+  pending_.clear();
+}
+
+void KeyForwarder::TakeBatch(std::vector<KeyBatchEntry>& out, size_t max_entries) {
+  size_t count = (std::min)(max_entries, pending_.size());
+  out.assign(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(count));
+  pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(count));
+}
+
+#ifdef _WIN32
+
+namespace {
+
+class KeyboardHookSource : public KeyboardSource {
+ public:
+  ~KeyboardHookSource() override { Stop(); }
+
+  bool Start(Handler handler) override {
+    if (hook_) return true;
+    if (instance_) return false;  // One WH_KEYBOARD_LL hook per process
+
+    handler_ = std::move(handler);
+    instance_ = this;
+    hook_ = SetWindowsHookExW(WH_KEYBOARD_LL, HookProc, GetModuleHandleW(nullptr), 0);
+    if (!hook_) {
+      std::cout << "[HKCW] [Keyboard] ERROR: Failed to install keyboard hook, error: " << GetLastError()
+                << std::endl;
+      instance_ = nullptr;
+      return false;
+    }
+    std::cout << "[HKCW] [Keyboard] Keyboard hook installed" << std::endl;
+    return true;
+  }
+
+  void Stop() override {
+    if (!hook_) return;
+    UnhookWindowsHookEx(hook_);
+    hook_ = nullptr;
+    instance_ = nullptr;
+    std::cout << "[HKCW] [Keyboard] Keyboard hook removed" << std::endl;
+  }
+
+ private:
+  static LRESULT CALLBACK HookProc(int code, WPARAM wparam, LPARAM lparam) {
+    if (code >= 0 && instance_) {
+      const auto* info = reinterpret_cast<const KBDLLHOOKSTRUCT*>(lparam);
+      bool down = wparam == WM_KEYDOWN || wparam == WM_SYSKEYDOWN;
+      instance_->handler_(info->vkCode, down);
+    }
+    return CallNextHookEx(nullptr, code, wparam, lparam);
+  }
+
+  static KeyboardHookSource* instance_;
+  HHOOK hook_ = nullptr;
+  Handler handler_;
+};
+
+KeyboardHookSource* KeyboardHookSource::instance_ = nullptr;
+
+}  // namespace
+
+std::unique_ptr<KeyboardSource> CreateKeyboardHookSource() {
+  return std::make_unique<KeyboardHookSource>();
+}
+
+bool IsDesktopFocused() {
+  HWND foreground = GetForegroundWindow();
+  if (!foreground) return false;
+
+  wchar_t class_name[32] = {0};
+  GetClassNameW(foreground, class_name, 32);
+  if (wcscmp(class_name, L"Progman") != 0 && wcscmp(class_name, L"WorkerW") != 0) {
+    return false;
+  }
+
+  // Renaming an icon puts an edit box in the desktop list view: that is typing
+  GUITHREADINFO info = {sizeof(info)};
+  if (GetGUIThreadInfo(GetWindowThreadProcessId(foreground, nullptr), &info) && info.hwndFocus) {
+    GetClassNameW(info.hwndFocus, class_name, 32);
+    if (wcscmp(class_name, L"Edit") == 0) return false;
+  }
+  return true;
+}
+
+#endif  // _WIN32
+
+}  // namespace hkcw_engine2
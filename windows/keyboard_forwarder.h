@@ -0,0 +1,135 @@
+#ifndef FLUTTER_PLUGIN_KEYBOARD_FORWARDER_H_
+#define FLUTTER_PLUGIN_KEYBOARD_FORWARDER_H_
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Modifier bits carried on every forwarded key
+const uint32_t kKeyModifierCtrl = 1;
+const uint32_t kKeyModifierShift = 2;
+const uint32_t kKeyModifierAlt = 4;
+const uint32_t kKeyModifierMeta = 8;
+
+// One key transition as seen by the keyboard source
+struct KeyEvent {
+  uint32_t vk = 0;  // Windows virtual-key code
+  bool down = false;
+  bool desktop_focused = false;  // Only needed for presses
+};
+
+// One entry of a per-frame batch
+struct KeyBatchEntry {
+  uint32_t vk;
+  bool down;
+  bool initial;  // The first press, not an auto-repeat
+  uint32_t repeat;  // Presses: auto-repeats folded into this entry
+  uint32_t modifiers;  // kKeyModifier* bits
+};
+
+// KeyboardEvent.code names of the keys that can ever be forwarded, or
+// nullptr. Layout-independent on purpose: pages get physical keys, never
+// typed text. Punctuation and modifiers are not forwardable.
+const char* KeyCodeName(uint32_t vk);
+uint32_t KeyCodeFromName(std::string_view name);  // 0 if not forwardable
+
+// Letters, digits and numpad digits: what a keylogger would want
+bool IsTextKey(uint32_t vk);
+
+// Keyboard Forwarder: Filters desktop key events down to the set the page
+// asked for, folds auto-repeat into counts and batches the rest until the
+// caller flushes. Presses and releases want the next frame; a batch of
+// nothing but repeats can wait longer, which is what lets repeats (30/s
+// by default) fold at all.
+//
+// A key is forwarded only if the page listed it, and a press only while
+// the desktop itself has focus; losing focus mid-hold releases the key.
+// Pages may list at most kMaxTextKeys text keys. Releases of delivered
+// presses are never dropped, so the page never sees a stuck key. Not
+// thread-safe; Process allocates nothing.
+class KeyForwarder {
+ public:
+  static const size_t kMaxTextKeys = 10;
+  static const size_t kMaxPending = 64;  // Presses beyond this are dropped
+
+  KeyForwarder() { pending_.reserve(kMaxPending + 256); }
+
+  // Space-separated KeyboardEvent.code names; unknown names and text keys
+  // past the limit are skipped. Held keys no longer listed are released.
+  // Returns the number of keys accepted.
+  size_t SetKeys(std::string_view names);
+  bool empty() const { return keys_.none(); }
+
+  // Cheap pre-check for the hook: true if Process could do anything with vk
+  bool Wants(uint32_t vk) const {
+    return vk < 256 && (keys_[vk] || held_[vk] || IsModifier(vk));
+  }
+
+  enum class Flush {
+    kNone,       // Already scheduled soon enough
+    kRepeat,     // Only repeats pending: flush within the repeat interval
+    kNextFrame,  // A press or release is pending
+  };
+  Flush Process(const KeyEvent& event);
+
+  // Queue releases for every held key (focus lost, listeners gone)
+  void ReleaseAll();
+  // New document: no keys, nothing held or batched
+  void Reset();
+
+  // Moves up to max_entries of the oldest batched entries into out
+  void TakeBatch(std::vector<KeyBatchEntry>& out, size_t max_entries);
+  bool pending() const { return !pending_.empty(); }
+  // Flush timing the current batch needs
+  Flush pending_flush() const;
+
+  uint64_t forwarded() const { return forwarded_; }
+  uint64_t coalesced() const { return coalesced_; }
+  uint64_t dropped() const { return dropped_; }
+
+ private:
+  static bool IsModifier(uint32_t vk);
+  static bool IsRepeat(const KeyBatchEntry& entry);
+  bool Push(KeyBatchEntry entry);
+  void Release(uint32_t vk);
+  uint32_t Modifiers() const;
+
+  std::bitset<256> keys_;
+  std::bitset<256> held_;  // Presses delivered to the page, release pending
+  std::bitset<256> modifiers_down_;
+  std::vector<KeyBatchEntry> pending_;
+
+  uint64_t forwarded_ = 0;
+  uint64_t coalesced_ = 0;
+  uint64_t dropped_ = 0;
+};
+
+#ifdef _WIN32
+// Keyboard Source: delivers every key transition on the UI thread
+class KeyboardSource {
+ public:
+  using Handler = std::function<void(uint32_t vk, bool down)>;
+
+  virtual ~KeyboardSource() = default;
+
+  virtual bool Start(Handler handler) = 0;
+  virtual void Stop() = 0;
+};
+
+// WH_KEYBOARD_LL; never swallows a key
+std::unique_ptr<KeyboardSource> CreateKeyboardHookSource();
+
+// The foreground window is the desktop (Progman / WorkerW) and no icon
+// label is being edited
+bool IsDesktopFocused();
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_KEYBOARD_FORWARDER_H_
@@ -0,0 +1,130 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <utility>
+
+namespace hkcw_engine2 {
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#ifdef _WIN32
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+  int length = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+  std::wstring wpath(length > 0 ? length : 0, L'\0');
+  MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, &wpath[0], length);
+
+  HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size)) {
+    CloseHandle(file);
+    return false;
+  }
+  if (file_size.QuadPart == 0) {
+    CloseHandle(file);  // Nothing to map
+    open_ = true;
+    return true;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    return false;
+  }
+
+  void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+
+  file_ = file;
+  mapping_ = mapping;
+  data_ = static_cast<const char*>(view);
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  open_ = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) UnmapViewOfFile(data_);
+  if (mapping_) CloseHandle(mapping_);
+  if (file_) CloseHandle(file_);
+  data_ = nullptr;
+  mapping_ = nullptr;
+  file_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+#else
+bool MappedFile::Open(const std::string& path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    close(fd);  // Nothing to map
+    open_ = true;
+    return true;
+  }
+
+  void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED) return false;
+
+  data_ = static_cast<const char*>(view);
+  size_ = static_cast<size_t>(st.st_size);
+  open_ = true;
+  return true;
+}
+
+void MappedFile::Close() {
+  if (data_) munmap(const_cast<char*>(data_), size_);
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+#endif
+
+void MappedFile::swap(MappedFile& other) {
+  std::swap(data_, other.data_);
+  std::swap(size_, other.size_);
+  std::swap(open_, other.open_);
+#ifdef _WIN32
+  std::swap(file_, other.file_);
+  std::swap(mapping_, other.mapping_);
+#endif
+}
+
+uint64_t HashBytes(const char* data, size_t size) {
+  // FNV-1a 64
+  uint64_t hash = 14695981039346656037ull;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,43 @@
+#ifndef FLUTTER_PLUGIN_MAPPED_FILE_H_
+#define FLUTTER_PLUGIN_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hkcw_engine2 {
+
+// Read-only memory mapping of a whole file; an empty file opens with no
+// data
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool Open(const std::string& path);
+  void Close();
+  void swap(MappedFile& other);
+
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+  bool is_open() const { return open_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+#ifdef _WIN32
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#endif
+};
+
+// FNV-1a 64 of a byte range: content keys for snapshots and cached frames
+uint64_t HashBytes(const char* data, size_t size);
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_MAPPED_FILE_H_
@@ -0,0 +1,397 @@
+#include "message_scheduler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+inline bool IsJsonSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Index just past the string starting at json[i] (a quote)
+size_t SkipString(std::string_view json, size_t i) {
+  const char* data = json.data();
+  for (i++; i < json.size();) {
+    // memchr is vectorized; escapes are rare in message payloads
+    const void* quote = std::memchr(data + i, '"', json.size() - i);
+    if (!quote) break;
+    size_t end = static_cast<size_t>(static_cast<const char*>(quote) - data);
+    size_t backslashes = 0;
+    while (end - backslashes > i && data[end - backslashes - 1] == '\\') backslashes++;
+    if (backslashes % 2 == 0) return end + 1;
+    i = end + 1;
+  }
+  return json.size();
+}
+
+// Characters that can change nesting while splitting a batch
+inline bool IsStructural(char c) {
+  return c == '"' || c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+}  // namespace
+
+MessageScheduler::MessageScheduler(Options options) : options_(options) {
+  types_.emplace_back();
+  types_[0].type = "*";
+  types_[0].tokens = types_[0].policy.burst;
+  slots_.resize((std::max)(options_.queue_capacity, size_t{1}));
+  batch_pool_.resize(options_.batch_buffers);
+}
+
+void MessageScheduler::SetPolicy(std::string_view type, Policy policy) {
+  size_t index = FindType(type);
+  if (index == 0) {
+    types_.emplace_back();
+    index = types_.size() - 1;
+    types_[index].type = std::string(type);
+  }
+  // A bucket smaller than one token never admits anything, and with rate 0
+  // (unlimited) Drain's retry wait would divide by zero
+  policy.burst = (std::max)(policy.burst, 1.0);
+  TypeState& state = types_[index];
+  state.policy = policy;
+  state.tokens = policy.burst;
+  state.has_refilled = false;
+}
+
+void MessageScheduler::SetDefaultPolicy(Policy policy) {
+  // Snapshots are keyed by type, so the shared bucket never coalesces
+  policy.coalesce = false;
+  policy.burst = (std::max)(policy.burst, 1.0);
+  types_[0].policy = policy;
+  types_[0].tokens = policy.burst;
+  types_[0].has_refilled = false;
+}
+
+size_t MessageScheduler::FindType(std::string_view type) const {
+  for (size_t i = 1; i < types_.size(); i++) {
+    if (types_[i].type == type) return i;
+  }
+  return 0;
+}
+
+void MessageScheduler::Refill(TypeState& state, Clock::time_point now) {
+  if (state.policy.rate <= 0.0) {
+    state.tokens = state.policy.burst;  // Unlimited
+    return;
+  }
+  if (state.has_refilled && now > state.refilled) {
+    double elapsed = std::chrono::duration<double>(now - state.refilled).count();
+    state.tokens = (std::min)(state.policy.burst, state.tokens + elapsed * state.policy.rate);
+  }
+  state.refilled = now;
+  state.has_refilled = true;
+}
+
+MessageScheduler::Result MessageScheduler::Enqueue(std::string_view message,
+                                                   Clock::time_point now) {
+  return Admit(message, kNoBatch, now);
+}
+
+MessageScheduler::Result MessageScheduler::Admit(std::string_view message, size_t batch,
+                                                 Clock::time_point now) {
+  size_t index = FindType(MessageType(message));
+  TypeState& state = types_[index];
+  state.stats.received++;
+
+  if (message.size() > options_.max_message_bytes) {
+    state.stats.too_large++;
+    return Result::kTooLarge;
+  }
+
+  // Latest wins: the bucket is charged when the snapshot is dispatched
+  if (state.policy.coalesce) {
+    bool replaced = state.snapshot_pending;
+    if (replaced) {
+      state.stats.coalesced++;
+    } else {
+      state.snapshot_pending = true;
+      pending_snapshots_++;
+    }
+    Store(state.snapshot, message, batch);
+    return replaced ? Result::kCoalesced : Result::kQueued;
+  }
+
+  Refill(state, now);
+  if (state.tokens < 1.0) {
+    state.stats.rate_limited++;
+    return Result::kRateLimited;
+  }
+  if (count_ == slots_.size()) {
+    state.stats.queue_full++;
+    return Result::kQueueFull;
+  }
+
+  state.tokens -= 1.0;
+  Slot& slot = slots_[(head_ + count_) % slots_.size()];
+  Store(slot.payload, message, batch);
+  slot.type = index;
+  count_++;
+  return Result::kQueued;
+}
+
+void MessageScheduler::Store(Payload& payload, std::string_view message, size_t batch) {
+  Release(payload.batch);  // An overwritten snapshot
+  payload.batch = batch;
+  if (batch == kNoBatch) {
+    payload.owned.assign(message.data(), message.size());
+    return;
+  }
+  payload.offset = static_cast<size_t>(message.data() - batch_pool_[batch].text.data());
+  payload.length = message.size();
+  batch_pool_[batch].refs++;
+}
+
+void MessageScheduler::Release(size_t batch) {
+  // Clear() may have dropped the reference already
+  if (batch != kNoBatch && batch_pool_[batch].refs > 0) batch_pool_[batch].refs--;
+}
+
+void MessageScheduler::Dispatch(Payload& payload, const Handler& handler) {
+  size_t batch = payload.batch;
+  payload.batch = kNoBatch;
+  if (batch == kNoBatch) {
+    // The handler gets a stable buffer even if it enqueues more messages
+    std::swap(dispatch_buffer_, payload.owned);
+    handler(dispatch_buffer_);
+    return;
+  }
+  handler(std::string_view(batch_pool_[batch].text).substr(payload.offset, payload.length));
+  Release(batch);
+}
+
+size_t MessageScheduler::EnqueueBatch(std::string& text, Clock::time_point now) {
+  batches_++;
+
+  // Keep the text in a free pool buffer; the caller gets that buffer's
+  // old capacity back for its next message
+  size_t retained = kNoBatch;
+  for (size_t b = 0; b < batch_pool_.size(); b++) {
+    if (batch_pool_[b].refs == 0) {
+      retained = b;
+      break;
+    }
+  }
+  if (retained == kNoBatch) {
+    batches_copied_++;
+  } else {
+    batch_pool_[retained].text.swap(text);
+  }
+  std::string_view batch = retained == kNoBatch ? std::string_view(text)
+                                                : std::string_view(batch_pool_[retained].text);
+
+  // Find the top-level "messages" key
+  int depth = 0;
+  size_t i = 0;
+  bool found = false;
+  while (i < batch.size() && !found) {
+    char c = batch[i];
+    if (c == '{' || c == '[') {
+      depth++;
+      i++;
+    } else if (c == '}' || c == ']') {
+      depth--;
+      i++;
+    } else if (c == '"') {
+      size_t end = SkipString(batch, i);
+      bool is_messages_key = depth == 1 && batch.substr(i, end - i) == "\"messages\"";
+      i = end;
+      if (!is_messages_key) continue;
+      while (i < batch.size() && IsJsonSpace(batch[i])) i++;
+      if (i < batch.size() && batch[i] == ':') {
+        i++;
+        while (i < batch.size() && IsJsonSpace(batch[i])) i++;
+        found = i < batch.size() && batch[i] == '[';
+      }
+    } else {
+      i++;
+    }
+  }
+  if (!found) return 0;
+
+  // Split the array: each top-level object is one message
+  size_t queued = 0;
+  size_t element_start = 0;
+  depth = 0;
+  for (i++; i < batch.size(); i++) {
+    char c = batch[i];
+    if (!IsStructural(c)) continue;
+    if (c == '"') {
+      i = SkipString(batch, i) - 1;
+    } else if (c == '{' || c == '[') {
+      if (depth++ == 0) element_start = i;
+    } else if (c == '}' || c == ']') {
+      if (depth == 0) break;  // End of the messages array
+      if (--depth == 0 && c == '}') {
+        Result result =
+            Admit(batch.substr(element_start, i + 1 - element_start), retained, now);
+        if (result == Result::kQueued || result == Result::kCoalesced) queued++;
+      }
+    }
+  }
+  return queued;
+}
+
+bool MessageScheduler::DrainSnapshots(size_t& remaining, Clock::time_point deadline,
+                                      Clock::time_point now, const Handler& handler) {
+  bool waiting = false;
+  for (size_t i = 1; i < types_.size() && remaining > 0; i++) {
+    TypeState& state = types_[i];
+    if (!state.snapshot_pending) continue;
+    if (Clock::now() >= deadline) return true;
+
+    Refill(state, now);
+    if (state.tokens < 1.0) {
+      waiting = true;
+      continue;
+    }
+
+    state.tokens -= 1.0;
+    state.snapshot_pending = false;
+    pending_snapshots_--;
+    state.stats.dispatched++;
+    remaining--;
+    Dispatch(state.snapshot, handler);
+  }
+  return waiting;
+}
+
+MessageScheduler::DrainResult MessageScheduler::Drain(size_t max_messages, Clock::duration budget,
+                                                      Clock::time_point now,
+                                                      const Handler& handler) {
+  DrainResult result;
+  Clock::time_point deadline = Clock::now() + budget;
+  size_t remaining = max_messages;
+
+  // Snapshots first: at most one per type, and they carry the state that
+  // click hit-testing depends on
+  DrainSnapshots(remaining, deadline, now, handler);
+
+  while (count_ > 0 && remaining > 0 && Clock::now() < deadline) {
+    Slot& slot = slots_[head_];
+    head_ = (head_ + 1) % slots_.size();
+    count_--;
+    types_[slot.type].stats.dispatched++;
+    remaining--;
+    Dispatch(slot.payload, handler);
+  }
+
+  result.more = count_ > 0;
+
+  // Snapshots still pending either ran out of budget or wait for tokens
+  for (size_t i = 1; i < types_.size(); i++) {
+    TypeState& state = types_[i];
+    if (!state.snapshot_pending) continue;
+    Refill(state, now);
+    if (state.tokens >= 1.0) {
+      result.more = true;
+      continue;
+    }
+    // Only a limited bucket (rate > 0, burst >= 1) can be short of a token
+    auto wait = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>((1.0 - state.tokens) / state.policy.rate));
+    wait = (std::max)(wait, Clock::duration(1));
+    if (result.retry_after == Clock::duration::zero() || wait < result.retry_after) {
+      result.retry_after = wait;
+    }
+  }
+
+  return result;
+}
+
+void MessageScheduler::Clear() {
+  head_ = 0;
+  count_ = 0;
+  pending_snapshots_ = 0;
+  for (TypeState& state : types_) {
+    state.snapshot_pending = false;
+    state.snapshot.batch = kNoBatch;
+  }
+  for (Slot& slot : slots_) {
+    slot.payload.batch = kNoBatch;
+  }
+  for (Batch& batch : batch_pool_) {
+    batch.refs = 0;
+  }
+}
+
+MessageScheduler::Stats MessageScheduler::totals() const {
+  Stats total;
+  for (const TypeState& state : types_) {
+    total.received += state.stats.received;
+    total.dispatched += state.stats.dispatched;
+    total.coalesced += state.stats.coalesced;
+    total.rate_limited += state.stats.rate_limited;
+    total.queue_full += state.stats.queue_full;
+    total.too_large += state.stats.too_large;
+  }
+  return total;
+}
+
+std::vector<MessageScheduler::TypeStats> MessageScheduler::type_stats() const {
+  std::vector<TypeStats> stats;
+  stats.reserve(types_.size());
+  for (const TypeState& state : types_) {
+    stats.push_back({state.type, state.stats});
+  }
+  return stats;
+}
+
+void MessageScheduler::ResetStats() {
+  for (TypeState& state : types_) {
+    state.stats = Stats();
+  }
+}
+
+std::string_view MessageScheduler::MessageType(std::string_view json) {
+  // Walk the top-level object only; nested objects may have their own "type"
+  int depth = 0;
+  size_t i = 0;
+  while (i < json.size()) {
+    char c = json[i];
+    if (c == '{' || c == '[') {
+      depth++;
+      i++;
+    } else if (c == '}' || c == ']') {
+      depth--;
+      i++;
+    } else if (c == '"') {
+      size_t end = SkipString(json, i);
+      bool is_type_key = depth == 1 && json.substr(i, end - i) == "\"type\"";
+      i = end;
+      if (!is_type_key) continue;
+
+      while (i < json.size() && IsJsonSpace(json[i])) i++;
+      if (i >= json.size() || json[i] != ':') continue;  // A value, not a key
+      i++;
+      while (i < json.size() && IsJsonSpace(json[i])) i++;
+      if (i >= json.size() || json[i] != '"') return {};
+      end = SkipString(json, i);
+      if (end > json.size() || json[end - 1] != '"' || end - i < 2) return {};
+      std::string_view value = json.substr(i + 1, end - i - 2);
+      // Type names are plain identifiers; escapes would need decoding
+      return value.find('\\') == std::string_view::npos ? value : std::string_view();
+    } else {
+      i++;
+    }
+  }
+  return {};
+}
+
+const char* MessageScheduler::ResultName(Result result) {
+  switch (result) {
+    case Result::kQueued: return "queued";
+    case Result::kCoalesced: return "coalesced";
+    case Result::kRateLimited: return "rate limited";
+    case Result::kQueueFull: return "queue full";
+    case Result::kTooLarge: return "too large";
+  }
+  return "unknown";
+}
+
+}  // namespace hkcw_engine2
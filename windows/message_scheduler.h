@@ -0,0 +1,165 @@
+#ifndef FLUTTER_PLUGIN_MESSAGE_SCHEDULER_H_
+#define FLUTTER_PLUGIN_MESSAGE_SCHEDULER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Message Scheduler: backpressure for web messages posted by the page.
+//
+// Each message type has a token bucket. Ordinary types are queued in a
+// bounded ring and dropped when their bucket is empty or the ring is full.
+// Snapshot types (IFRAME_DATA) are latest-wins: each type keeps one pending
+// copy that newer messages overwrite, and an empty bucket only delays it.
+// Drain() runs the handler under a message count and time budget so one
+// UI-loop turn never spends long on page traffic. Types without a policy
+// share the default bucket, so arbitrary type strings cannot grow any table.
+//
+// SDK batches are kept whole: their queued elements are views into the
+// retained batch text, which goes back to a small pool once every element
+// has been dispatched or overwritten.
+//
+// Not thread-safe: WebMessageReceived and the drain both run on the UI
+// thread.
+class MessageScheduler {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Handler = std::function<void(std::string_view message)>;
+
+  struct Policy {
+    double rate = 20.0;   // Tokens per second; 0 is unlimited
+    double burst = 40.0;  // Bucket size, at least 1
+    bool coalesce = false;
+  };
+
+  struct Options {
+    size_t queue_capacity = 64;
+    size_t max_message_bytes = 256 * 1024;
+    size_t batch_buffers = 8;  // Batches retained while their elements wait
+  };
+
+  enum class Result { kQueued, kCoalesced, kRateLimited, kQueueFull, kTooLarge };
+
+  struct Stats {
+    uint64_t received = 0;
+    uint64_t dispatched = 0;
+    uint64_t coalesced = 0;  // Overwritten before dispatch
+    uint64_t rate_limited = 0;
+    uint64_t queue_full = 0;
+    uint64_t too_large = 0;
+    uint64_t dropped() const { return rate_limited + queue_full + too_large; }
+  };
+
+  struct TypeStats {
+    std::string type;  // "*" for the default bucket
+    Stats stats;
+  };
+
+  struct DrainResult {
+    bool more = false;  // Dispatchable now; drain again next turn
+    Clock::duration retry_after = Clock::duration::zero();  // Snapshots awaiting tokens
+  };
+
+  explicit MessageScheduler(Options options);
+
+  MessageScheduler(const MessageScheduler&) = delete;
+  MessageScheduler& operator=(const MessageScheduler&) = delete;
+
+  void SetPolicy(std::string_view type, Policy policy);
+  void SetDefaultPolicy(Policy policy);
+
+  // Copies the message; reuses slot capacity so steady state does not allocate
+  Result Enqueue(std::string_view message, Clock::time_point now);
+
+  // {"type":"BATCH","messages":[{...},...]} from the SDK: the array is split
+  // in one pass and each element is enqueued (and rate limited) on its own.
+  // Takes the batch text, so elements are queued as views into it without
+  // copying; |batch| gets a recycled buffer back. If every retained buffer is
+  // still in use the elements are copied instead (counted in
+  // batches_copied()). Returns the number queued or coalesced.
+  size_t EnqueueBatch(std::string& batch, Clock::time_point now);
+
+  DrainResult Drain(size_t max_messages, Clock::duration budget, Clock::time_point now,
+                    const Handler& handler);
+
+  // Drop everything pending (page navigated away / wallpaper stopped)
+  void Clear();
+  bool empty() const { return count_ == 0 && pending_snapshots_ == 0; }
+
+  uint64_t batches() const { return batches_; }
+  uint64_t batches_copied() const { return batches_copied_; }
+  Stats totals() const;
+  std::vector<TypeStats> type_stats() const;
+  void ResetStats();
+
+  // Value of the top-level "type" field, "" if there is none
+  static std::string_view MessageType(std::string_view json);
+  static const char* ResultName(Result result);
+
+ private:
+  static constexpr size_t kNoBatch = static_cast<size_t>(-1);
+
+  // A message is either an owned copy or a range of a retained batch
+  struct Payload {
+    std::string owned;
+    size_t batch = kNoBatch;
+    size_t offset = 0;
+    size_t length = 0;
+  };
+
+  struct Batch {
+    std::string text;
+    size_t refs = 0;  // Payloads still pointing into text
+  };
+
+  struct TypeState {
+    std::string type;
+    Policy policy;
+    double tokens = 0.0;
+    Clock::time_point refilled;
+    bool has_refilled = false;
+    bool snapshot_pending = false;
+    Payload snapshot;
+    Stats stats;
+  };
+
+  struct Slot {
+    Payload payload;
+    size_t type = 0;
+  };
+
+  Result Admit(std::string_view message, size_t batch, Clock::time_point now);
+  void Store(Payload& payload, std::string_view message, size_t batch);
+  void Release(size_t batch);
+  // Hands the payload to the handler; a batch stays referenced until it returns
+  void Dispatch(Payload& payload, const Handler& handler);
+
+  size_t FindType(std::string_view type) const;
+  void Refill(TypeState& state, Clock::time_point now);
+  bool DrainSnapshots(size_t& remaining, Clock::time_point deadline, Clock::time_point now,
+                      const Handler& handler);
+
+  Options options_;
+
+  // types_[0] is the default bucket
+  std::vector<TypeState> types_;
+
+  std::vector<Slot> slots_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  size_t pending_snapshots_ = 0;
+  std::string dispatch_buffer_;
+  std::vector<Batch> batch_pool_;  // Fixed size, so texts never move
+  uint64_t batches_ = 0;
+  uint64_t batches_copied_ = 0;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_MESSAGE_SCHEDULER_H_
@@ -0,0 +1,338 @@
+#include "native_renderer.h"
+
+#include <wincodec.h>
+#include <wrl.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#include "mapped_file.h"
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const wchar_t kRendererProp[] = L"HKCWNativeRenderer";
+const UINT_PTR kFadeTimerId = 0x484B;  // "HK"
+const UINT kFadeIntervalMs = 16;
+const int kFadeDurationMs = 400;
+
+}  // namespace
+
+NativeWallpaperRenderer::~NativeWallpaperRenderer() {
+  Detach();
+}
+
+bool NativeWallpaperRenderer::IsNativeDescriptor(const std::string& url) {
+  WallpaperDescriptor descriptor;
+  return ParseWallpaperDescriptor(url, descriptor);
+}
+
+bool NativeWallpaperRenderer::Attach(HWND hwnd) {
+  if (!hwnd || hwnd_ == hwnd) return hwnd_ != nullptr;
+  Detach();
+
+  SetPropW(hwnd, kRendererProp, this);
+  original_proc_ = reinterpret_cast<WNDPROC>(
+      SetWindowLongPtrW(hwnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(WindowProc)));
+  if (!original_proc_) {
+    RemovePropW(hwnd, kRendererProp);
+    std::cout << "[HKCW] [Native] ERROR: Failed to subclass host window" << std::endl;
+    return false;
+  }
+
+  hwnd_ = hwnd;
+  std::cout << "[HKCW] [Native] Renderer attached to: " << hwnd_ << std::endl;
+  return true;
+}
+
+void NativeWallpaperRenderer::Detach() {
+  if (!hwnd_) return;
+
+  KillTimer(hwnd_, kFadeTimerId);
+  if (IsWindow(hwnd_)) {
+    SetWindowLongPtrW(hwnd_, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(original_proc_));
+    RemovePropW(hwnd_, kRendererProp);
+  }
+
+  hwnd_ = nullptr;
+  original_proc_ = nullptr;
+  fading_ = false;
+  frame_.Release();
+  fade_from_.Release();
+  fade_to_.Release();
+}
+
+bool NativeWallpaperRenderer::Show(const std::string& url) {
+  if (!hwnd_) return false;
+
+  WallpaperDescriptor descriptor;
+  if (!ParseWallpaperDescriptor(url, descriptor)) {
+    std::cout << "[HKCW] [Native] ERROR: Not a native wallpaper: " << url << std::endl;
+    return false;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  Surface next;
+  if (!Render(descriptor, next)) {
+    return false;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "[HKCW] [Native] Rendered " << next.width << "x" << next.height
+            << " in " << elapsed.count() << " ms: " << url << std::endl;
+
+  Present(std::move(next));
+  return true;
+}
+
+bool NativeWallpaperRenderer::Render(const WallpaperDescriptor& descriptor, Surface& target) {
+  RECT client;
+  GetClientRect(hwnd_, &client);
+  target.Resize(client.right - client.left, client.bottom - client.top);
+  if (target.width == 0 || target.height == 0) {
+    std::cout << "[HKCW] [Native] ERROR: Host window has no area" << std::endl;
+    return false;
+  }
+
+  if (descriptor.kind == WallpaperDescriptor::Kind::kImage) {
+    return RenderImage(descriptor, target);
+  }
+  return FillDescriptor(descriptor, target);
+}
+
+bool NativeWallpaperRenderer::RenderImage(const WallpaperDescriptor& descriptor,
+                                          Surface& target) {
+  int width = target.width;
+  int height = target.height;
+
+  MappedFile source;
+  if (!source.Open(descriptor.image_path)) {
+    std::cout << "[HKCW] [Native] ERROR: Cannot open image " << descriptor.image_path << std::endl;
+    return false;
+  }
+
+  // Same bytes at the same size come straight from the cache
+  std::string key = ScaledImageCache::MakeKey(
+      HashBytes(source.data(), source.size()), width, height,
+      descriptor.fit, ResampleFilter::kLanczos3);
+  if (cache_.Load(key, width, height, target)) {
+    std::cout << "[HKCW] [Native] Image cache hit: " << key << std::endl;
+    return true;
+  }
+
+  // Decoded pixels are dropped as soon as the frame is composed
+  std::vector<uint32_t> pixels;
+  int image_width = 0;
+  int image_height = 0;
+  if (!DecodeImage(source.data(), source.size(), width, height, descriptor.fit, pixels,
+                   image_width, image_height)) {
+    std::cout << "[HKCW] [Native] ERROR: Failed to decode image " << descriptor.image_path
+              << std::endl;
+    return false;
+  }
+  source.Close();
+
+  ImageView view;
+  view.pixels = pixels.data();
+  view.width = image_width;
+  view.height = image_height;
+  view.stride = image_width;
+  ImageResampler().ResampleToFit(view, descriptor.fit, descriptor.color, width, height, target,
+                                 ResampleFilter::kLanczos3);
+
+  cache_.Store(key, target);
+  return true;
+}
+
+bool NativeWallpaperRenderer::DecodeImage(const char* data, size_t size, int target_width,
+                                          int target_height, ImageFit fit,
+                                          std::vector<uint32_t>& pixels, int& width,
+                                          int& height) {
+  Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+  HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                IID_PPV_ARGS(&factory));
+  Microsoft::WRL::ComPtr<IWICStream> stream;
+  if (SUCCEEDED(hr)) hr = factory->CreateStream(&stream);
+  if (SUCCEEDED(hr)) {
+    hr = stream->InitializeFromMemory(reinterpret_cast<BYTE*>(const_cast<char*>(data)),
+                                      static_cast<DWORD>(size));
+  }
+  Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+  if (SUCCEEDED(hr)) {
+    hr = factory->CreateDecoderFromStream(stream.Get(), nullptr, WICDecodeMetadataCacheOnDemand,
+                                          &decoder);
+  }
+  Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+  if (SUCCEEDED(hr)) hr = decoder->GetFrame(0, &frame);
+
+  UINT image_width = 0;
+  UINT image_height = 0;
+  if (SUCCEEDED(hr)) hr = frame->GetSize(&image_width, &image_height);
+  if (FAILED(hr) || image_width == 0 || image_height == 0) {
+    std::cout << "[HKCW] [Native] ERROR: WIC decode failed: " << std::hex << hr << std::dec
+              << std::endl;
+    return false;
+  }
+
+  // Smallest decode that still covers the target after fitting; JPEG
+  // decoders can produce it directly by skipping DCT detail
+  double scale_x = static_cast<double>(target_width) / image_width;
+  double scale_y = static_cast<double>(target_height) / image_height;
+  double scale = fit == ImageFit::kContain ? (std::min)(scale_x, scale_y)
+                                           : (std::max)(scale_x, scale_y);
+  UINT needed_width = fit == ImageFit::kStretch
+      ? static_cast<UINT>(target_width)
+      : static_cast<UINT>(std::ceil(image_width * scale));
+  UINT needed_height = fit == ImageFit::kStretch
+      ? static_cast<UINT>(target_height)
+      : static_cast<UINT>(std::ceil(image_height * scale));
+
+  Microsoft::WRL::ComPtr<IWICBitmapSourceTransform> transform;
+  if (needed_width < image_width && needed_height < image_height &&
+      SUCCEEDED(frame.As(&transform))) {
+    UINT reduced_width = needed_width;
+    UINT reduced_height = needed_height;
+    WICPixelFormatGUID format = GUID_WICPixelFormat32bppPBGRA;
+    BOOL rotation_supported = FALSE;
+    if (SUCCEEDED(transform->GetClosestSize(&reduced_width, &reduced_height)) &&
+        reduced_width >= needed_width && reduced_height >= needed_height &&
+        reduced_width < image_width &&
+        SUCCEEDED(transform->GetClosestPixelFormat(&format)) &&
+        IsEqualGUID(format, GUID_WICPixelFormat32bppPBGRA) &&
+        SUCCEEDED(transform->DoesSupportTransform(WICBitmapTransformRotate0,
+                                                  &rotation_supported)) &&
+        rotation_supported) {
+      pixels.resize(static_cast<size_t>(reduced_width) * reduced_height);
+      hr = transform->CopyPixels(nullptr, reduced_width, reduced_height, &format,
+                                 WICBitmapTransformRotate0, reduced_width * 4,
+                                 static_cast<UINT>(pixels.size() * 4),
+                                 reinterpret_cast<BYTE*>(pixels.data()));
+      if (SUCCEEDED(hr)) {
+        std::cout << "[HKCW] [Native] Reduced decode " << image_width << "x" << image_height
+                  << " -> " << reduced_width << "x" << reduced_height << std::endl;
+        width = static_cast<int>(reduced_width);
+        height = static_cast<int>(reduced_height);
+        return true;
+      }
+    }
+  }
+
+  Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+  hr = factory->CreateFormatConverter(&converter);
+  if (SUCCEEDED(hr)) {
+    hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppPBGRA,
+                               WICBitmapDitherTypeNone, nullptr, 0.0,
+                               WICBitmapPaletteTypeCustom);
+  }
+  if (SUCCEEDED(hr)) {
+    pixels.resize(static_cast<size_t>(image_width) * image_height);
+    hr = converter->CopyPixels(nullptr, image_width * 4,
+                               static_cast<UINT>(pixels.size() * 4),
+                               reinterpret_cast<BYTE*>(pixels.data()));
+  }
+
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] [Native] ERROR: WIC decode failed: " << std::hex << hr << std::dec
+              << std::endl;
+    pixels.clear();
+    return false;
+  }
+
+  width = static_cast<int>(image_width);
+  height = static_cast<int>(image_height);
+  return true;
+}
+
+void NativeWallpaperRenderer::Present(Surface&& next) {
+  bool can_fade = frame_.width == next.width && frame_.height == next.height &&
+                  !frame_.pixels.empty();
+
+  if (!can_fade) {
+    frame_ = std::move(next);
+    fading_ = false;
+    KillTimer(hwnd_, kFadeTimerId);
+  } else {
+    // Restart from whatever is on screen, even mid-fade
+    fade_from_ = frame_;
+    fade_to_ = std::move(next);
+    fading_ = true;
+    fade_start_ = std::chrono::steady_clock::now();
+    SetTimer(hwnd_, kFadeTimerId, kFadeIntervalMs, nullptr);
+  }
+
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void NativeWallpaperRenderer::OnFadeTimer() {
+  if (!fading_) {
+    KillTimer(hwnd_, kFadeTimerId);
+    return;
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - fade_start_).count();
+  if (elapsed >= kFadeDurationMs) {
+    frame_ = std::move(fade_to_);
+    fade_from_.Release();
+    fade_to_.Release();
+    fading_ = false;
+    KillTimer(hwnd_, kFadeTimerId);
+  } else {
+    uint32_t alpha = static_cast<uint32_t>(elapsed * 256 / kFadeDurationMs);
+    Crossfade(fade_from_, fade_to_, alpha, frame_);
+  }
+
+  InvalidateRect(hwnd_, nullptr, FALSE);
+}
+
+void NativeWallpaperRenderer::Paint(HDC hdc) {
+  if (frame_.pixels.empty()) return;
+
+  BITMAPINFO info = {};
+  info.bmiHeader.biSize = sizeof(BITMAPINFOHEADER);
+  info.bmiHeader.biWidth = frame_.width;
+  info.bmiHeader.biHeight = -frame_.height;  // Top-down
+  info.bmiHeader.biPlanes = 1;
+  info.bmiHeader.biBitCount = 32;
+  info.bmiHeader.biCompression = BI_RGB;
+
+  SetDIBitsToDevice(hdc, 0, 0, frame_.width, frame_.height, 0, 0, 0, frame_.height,
+                    frame_.pixels.data(), &info, DIB_RGB_COLORS);
+}
+
+LRESULT CALLBACK NativeWallpaperRenderer::WindowProc(HWND hwnd, UINT message, WPARAM wparam,
+                                                     LPARAM lparam) {
+  auto* renderer = static_cast<NativeWallpaperRenderer*>(GetPropW(hwnd, kRendererProp));
+  if (!renderer) {
+    return DefWindowProcW(hwnd, message, wparam, lparam);
+  }
+
+  switch (message) {
+    case WM_PAINT: {
+      PAINTSTRUCT ps;
+      HDC hdc = BeginPaint(hwnd, &ps);
+      renderer->Paint(hdc);
+      EndPaint(hwnd, &ps);
+      return 0;
+    }
+    case WM_ERASEBKGND:
+      return 1;  // Every pixel is painted in WM_PAINT
+    case WM_TIMER:
+      if (wparam == kFadeTimerId) {
+        renderer->OnFadeTimer();
+        return 0;
+      }
+      break;
+    case WM_NCDESTROY: {
+      WNDPROC original = renderer->original_proc_;
+      renderer->Detach();
+      return CallWindowProcW(original, hwnd, message, wparam, lparam);
+    }
+  }
+
+  return CallWindowProcW(renderer->original_proc_, hwnd, message, wparam, lparam);
+}
+
+}  // namespace hkcw_engine2
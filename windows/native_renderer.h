@@ -0,0 +1,67 @@
+#ifndef FLUTTER_PLUGIN_NATIVE_RENDERER_H_
+#define FLUTTER_PLUGIN_NATIVE_RENDERER_H_
+
+#include <windows.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "image_cache.h"
+#include "image_resampler.h"
+#include "software_rasterizer.h"
+
+namespace hkcw_engine2 {
+
+// Native Renderer: draws static wallpapers (color, gradient, image) into
+// the host window with GDI, without creating a WebView2 controller.
+// Switching between native wallpapers crossfades in software.
+class NativeWallpaperRenderer {
+ public:
+  NativeWallpaperRenderer() = default;
+  ~NativeWallpaperRenderer();
+
+  NativeWallpaperRenderer(const NativeWallpaperRenderer&) = delete;
+  NativeWallpaperRenderer& operator=(const NativeWallpaperRenderer&) = delete;
+
+  static bool IsNativeDescriptor(const std::string& url);
+
+  // Subclass the host window to handle WM_PAINT/WM_TIMER
+  bool Attach(HWND hwnd);
+  void Detach();
+
+  // Render a descriptor; crossfades from the current frame if one is shown
+  bool Show(const std::string& url);
+
+  // Pre-scaled image frames are kept here (UTF-8); empty disables caching
+  void SetCacheDirectory(const std::string& directory) { cache_.SetDirectory(directory); }
+
+  HWND hwnd() const { return hwnd_; }
+  const Surface& frame() const { return frame_; }
+
+ private:
+  static LRESULT CALLBACK WindowProc(HWND hwnd, UINT message, WPARAM wparam, LPARAM lparam);
+
+  bool Render(const WallpaperDescriptor& descriptor, Surface& target);
+  bool RenderImage(const WallpaperDescriptor& descriptor, Surface& target);
+  bool DecodeImage(const char* data, size_t size, int target_width, int target_height,
+                   ImageFit fit, std::vector<uint32_t>& pixels, int& width, int& height);
+  void Present(Surface&& next);
+  void Paint(HDC hdc);
+  void OnFadeTimer();
+
+  HWND hwnd_ = nullptr;
+  WNDPROC original_proc_ = nullptr;
+  ScaledImageCache cache_;
+
+  // frame_ is what WM_PAINT shows; fade_from_/fade_to_ only live during
+  // a crossfade and are released afterwards
+  Surface frame_;
+  Surface fade_from_;
+  Surface fade_to_;
+  bool fading_ = false;
+  std::chrono::steady_clock::time_point fade_start_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_NATIVE_RENDERER_H_
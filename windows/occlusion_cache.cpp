@@ -0,0 +1,214 @@
+#include "occlusion_cache.h"
+
+#include <cwchar>
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <iostream>
+#endif
+
+namespace hkcw_engine2 {
+
+bool IsAppWindow(const WindowDescription& description) {
+  if (!description.visible || !description.caption_or_popup) return false;
+  const wchar_t* name = description.class_name;
+  return wcscmp(name, L"Progman") != 0 &&
+         wcscmp(name, L"WorkerW") != 0 &&
+         wcscmp(name, L"Shell_TrayWnd") != 0 &&  // Taskbar
+         wcsstr(name, L"Xaml") == nullptr;  // System UI
+}
+
+OcclusionCache::OcclusionCache(std::unique_ptr<WindowSystem> system, Options options)
+    : system_(std::move(system)), options_(options) {}
+
+bool OcclusionCache::IsOccluded(int x, int y, uint32_t now_ms) {
+  if (region_fresh(now_ms)) {
+    bool covered = false;
+    for (const WindowRect& r : app_rects_) {
+      if (x >= r.left && x < r.right && y >= r.top && y < r.bottom) {
+        covered = true;
+        break;
+      }
+    }
+    if (!covered) {
+      stats_.fast_path++;
+      return false;
+    }
+  }
+
+  WindowHandle root = system_->RootFromPoint(x, y);
+  return root && Classify(root, now_ms);
+}
+
+bool OcclusionCache::Classify(WindowHandle root, uint32_t now_ms) {
+  for (Entry& entry : table_) {
+    if (entry.root == root) {
+      if (now_ms - entry.time_ms < options_.ttl_ms) {
+        stats_.hits++;
+        return entry.app;
+      }
+      entry.root = 0;  // Expired: reclassify below
+      break;
+    }
+  }
+
+  stats_.misses++;
+  WindowDescription description;
+  bool app = system_->Describe(root, description) && IsAppWindow(description);
+
+  // Round-robin replacement; the table only needs to outlast a burst of
+  // events over the same few windows
+  Entry& slot = table_[next_slot_];
+  next_slot_ = (next_slot_ + 1) % kTableSize;
+  slot.root = root;
+  slot.app = app;
+  slot.time_ms = now_ms;
+  return app;
+}
+
+bool OcclusionCache::Invalidate(WindowHandle window) {
+  for (Entry& entry : table_) {
+    if (entry.root == window) entry.root = 0;
+  }
+  bool was_valid = region_valid_;
+  region_valid_ = false;
+  return was_valid;
+}
+
+void OcclusionCache::InvalidateAll() {
+  for (Entry& entry : table_) entry.root = 0;
+  region_valid_ = false;
+  dragging_ = false;
+}
+
+bool OcclusionCache::OnWinEvent(uint32_t event, WindowHandle window) {
+  if (event == kWinEventMoveSizeStart) dragging_ = true;
+  if (event == kWinEventMoveSizeEnd) dragging_ = false;
+  return Invalidate(window);
+}
+
+void OcclusionCache::RebuildVisibleRegion(uint32_t now_ms) {
+  if (dragging_) return;
+  app_rects_.clear();
+  system_->EnumerateTopLevel([this](WindowHandle root) {
+    WindowDescription description;
+    if (system_->Describe(root, description) && IsAppWindow(description) &&
+        description.rect.right > description.rect.left &&
+        description.rect.bottom > description.rect.top) {
+      app_rects_.push_back(description.rect);
+    }
+  });
+  region_valid_ = true;
+  region_time_ms_ = now_ms;
+}
+
+#ifdef _WIN32
+
+namespace {
+
+class Win32WindowSystem : public WindowSystem {
+ public:
+  WindowHandle RootFromPoint(int x, int y) override {
+    HWND window = WindowFromPoint(POINT{x, y});
+    if (!window) return 0;
+    return reinterpret_cast<WindowHandle>(GetAncestor(window, GA_ROOT));
+  }
+
+  bool Describe(WindowHandle root, WindowDescription& description) override {
+    HWND window = reinterpret_cast<HWND>(root);
+    if (!IsWindow(window)) return false;
+
+    description.visible = IsWindowVisible(window) != FALSE;
+    LONG style = GetWindowLongW(window, GWL_STYLE);
+    description.caption_or_popup = (style & WS_CAPTION) || (style & WS_POPUP);
+    GetClassNameW(window, description.class_name, 256);
+
+    RECT rect = {0};
+    GetWindowRect(window, &rect);
+    description.rect = {rect.left, rect.top, rect.right, rect.bottom};
+    return true;
+  }
+
+  void EnumerateTopLevel(const std::function<void(WindowHandle root)>& callback) override {
+    EnumWindows(
+        [](HWND window, LPARAM param) -> BOOL {
+          (*reinterpret_cast<const std::function<void(WindowHandle)>*>(param))(
+              reinterpret_cast<WindowHandle>(window));
+          return TRUE;
+        },
+        reinterpret_cast<LPARAM>(&callback));
+  }
+};
+
+OcclusionWatcher* g_watcher = nullptr;  // WinEvent callbacks carry no context
+
+void CALLBACK WinEventProc(HWINEVENTHOOK, DWORD event, HWND window, LONG object_id,
+                           LONG child_id, DWORD, DWORD) {
+  // Only whole windows: show / hide also fire for the caret and cursor
+  if (!g_watcher || !window || object_id != OBJID_WINDOW || child_id != CHILDID_SELF) return;
+  // and only top-level ones (a destroyed window has no ancestor left to ask)
+  if (event != EVENT_OBJECT_DESTROY && GetAncestor(window, GA_ROOT) != window) return;
+  g_watcher->Notify(event, reinterpret_cast<WindowHandle>(window));
+}
+
+static_assert(EVENT_SYSTEM_FOREGROUND == 0x0003 && EVENT_SYSTEM_MOVESIZESTART == kWinEventMoveSizeStart &&
+                  EVENT_SYSTEM_MOVESIZEEND == kWinEventMoveSizeEnd && EVENT_SYSTEM_MINIMIZESTART == 0x0016 &&
+                  EVENT_SYSTEM_MINIMIZEEND == 0x0017,
+              "kOcclusionWinEvents system event ids");
+static_assert(EVENT_OBJECT_DESTROY == 0x8001 && EVENT_OBJECT_HIDE == 0x8003 &&
+                  EVENT_OBJECT_CLOAKED == 0x8017 && EVENT_OBJECT_UNCLOAKED == 0x8018,
+              "kOcclusionWinEvents object event ids");
+
+}  // namespace
+
+std::unique_ptr<WindowSystem> CreateWin32WindowSystem() {
+  return std::make_unique<Win32WindowSystem>();
+}
+
+OcclusionWatcher::~OcclusionWatcher() {
+  Stop();
+}
+
+bool OcclusionWatcher::Start(Handler handler) {
+  if (!hooks_.empty()) return true;
+  if (g_watcher) return false;  // One watcher per process
+
+  handler_ = std::move(handler);
+  g_watcher = this;
+  for (const WinEventRange& range : kOcclusionWinEvents) {
+    // Our own windows included: the app's window can cover the desktop too
+    HWINEVENTHOOK hook = SetWinEventHook(range.first, range.last, nullptr, WinEventProc, 0, 0,
+                                         WINEVENT_OUTOFCONTEXT);
+    if (!hook) {
+      std::cout << "[HKCW] [Occlusion] ERROR: Failed to install WinEvent hook, error: "
+                << GetLastError() << std::endl;
+      Stop();
+      return false;
+    }
+    hooks_.push_back(hook);
+  }
+  std::cout << "[HKCW] [Occlusion] Window event hooks installed" << std::endl;
+  return true;
+}
+
+void OcclusionWatcher::Stop() {
+  if (hooks_.empty()) {
+    if (g_watcher == this) g_watcher = nullptr;
+    return;
+  }
+  for (void* hook : hooks_) {
+    UnhookWinEvent(static_cast<HWINEVENTHOOK>(hook));
+  }
+  hooks_.clear();
+  g_watcher = nullptr;
+  std::cout << "[HKCW] [Occlusion] Window event hooks removed" << std::endl;
+}
+
+void OcclusionWatcher::Notify(uint32_t event, WindowHandle window) {
+  if (handler_) handler_(event, window);
+}
+
+#endif
+
+}  // namespace hkcw_engine2
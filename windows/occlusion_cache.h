@@ -0,0 +1,163 @@
+#ifndef FLUTTER_PLUGIN_OCCLUSION_CACHE_H_
+#define FLUTTER_PLUGIN_OCCLUSION_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+using WindowHandle = uintptr_t;  // HWND on Windows
+
+struct WindowRect {
+  int left = 0;
+  int top = 0;
+  int right = 0;  // Exclusive, like RECT
+  int bottom = 0;
+};
+
+// What the occlusion test needs to know about a top-level window
+struct WindowDescription {
+  bool visible = false;
+  bool caption_or_popup = false;  // WS_CAPTION or WS_POPUP
+  wchar_t class_name[256] = {0};
+  WindowRect rect;
+};
+
+// The window manager as the cache sees it; Win32 in production, a model
+// in tests
+class WindowSystem {
+ public:
+  virtual ~WindowSystem() = default;
+
+  // Root (GA_ROOT) of the window under the point, or 0
+  virtual WindowHandle RootFromPoint(int x, int y) = 0;
+  virtual bool Describe(WindowHandle root, WindowDescription& description) = 0;
+  virtual void EnumerateTopLevel(const std::function<void(WindowHandle root)>& callback) = 0;
+};
+
+// True for an application window in front of the wallpaper: visible, with
+// a caption or popup style, and not part of the desktop or shell
+// (Progman, WorkerW, the taskbar, XAML system UI)
+bool IsAppWindow(const WindowDescription& description);
+
+// WinEvent ids (inclusive ranges) that invalidate the cache: foreground
+// changes, the start and end of a move/size drag, minimize / restore,
+// destroy / show / hide and cloaking (UWP windows, virtual desktops).
+// Deliberately not EVENT_OBJECT_LOCATIONCHANGE or STATECHANGE: those fire
+// for the cursor and caret on every move system-wide and would wake the
+// UI thread each time.
+const uint32_t kWinEventMoveSizeStart = 0x000A;  // EVENT_SYSTEM_MOVESIZESTART
+const uint32_t kWinEventMoveSizeEnd = 0x000B;
+
+struct WinEventRange {
+  uint32_t first;
+  uint32_t last;
+};
+constexpr WinEventRange kOcclusionWinEvents[] = {
+  {0x0003, 0x0003},  // EVENT_SYSTEM_FOREGROUND
+  {kWinEventMoveSizeStart, kWinEventMoveSizeEnd},
+  {0x0016, 0x0017},  // EVENT_SYSTEM_MINIMIZESTART, MINIMIZEEND
+  {0x8001, 0x8003},  // EVENT_OBJECT_DESTROY, SHOW, HIDE
+  {0x8017, 0x8018},  // EVENT_OBJECT_CLOAKED, UNCLOAKED
+};
+
+// Occlusion Cache: answers "is the desktop covered at this point" for the
+// mouse hook without walking window styles on every event.
+//
+// Two layers. Root classifications (app window or desktop layer) are
+// cached in a fixed table keyed by root handle. Above that, the rectangles
+// of all app windows are kept so a point outside every one of them is
+// known to show the desktop with no system call at all; inside one, the
+// root under the point is looked up and classified (usually a table hit).
+//
+// The owner passes the events in kOcclusionWinEvents to OnWinEvent and
+// calls RebuildVisibleRegion once they settle or needs_rebuild says so;
+// until then only the classification layer is used. While a window is
+// being dragged there is no region to trust, so none is built until the
+// drag ends. Changes without one of those events (a programmatic move, a
+// maximize) are picked up when entries expire after ttl_ms. IsOccluded
+// allocates nothing. Not thread-safe.
+class OcclusionCache {
+ public:
+  struct Options {
+    uint32_t ttl_ms = 2000;
+  };
+
+  struct Stats {
+    uint64_t fast_path = 0;  // Answered from the visible region
+    uint64_t hits = 0;       // Root found in the table
+    uint64_t misses = 0;     // Root classified from its styles
+  };
+
+  static const size_t kTableSize = 64;
+
+  OcclusionCache(std::unique_ptr<WindowSystem> system, Options options);
+
+  bool IsOccluded(int x, int y, uint32_t now_ms);
+
+  // True if the visible region was valid and must now be rebuilt
+  bool Invalidate(WindowHandle window);
+  void InvalidateAll();
+  // Invalidate, plus move/size drag tracking
+  bool OnWinEvent(uint32_t event, WindowHandle window);
+  // Does nothing mid-drag
+  void RebuildVisibleRegion(uint32_t now_ms);
+
+  // The visible region is missing or expired; rebuild it off the hook
+  bool needs_rebuild(uint32_t now_ms) const { return !dragging_ && !region_fresh(now_ms); }
+  bool dragging() const { return dragging_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  struct Entry {
+    WindowHandle root = 0;
+    bool app = false;
+    uint32_t time_ms = 0;
+  };
+
+  bool Classify(WindowHandle root, uint32_t now_ms);
+  bool region_fresh(uint32_t now_ms) const {
+    return region_valid_ && now_ms - region_time_ms_ < options_.ttl_ms;
+  }
+
+  std::unique_ptr<WindowSystem> system_;
+  Options options_;
+  Entry table_[kTableSize];
+  size_t next_slot_ = 0;
+
+  std::vector<WindowRect> app_rects_;
+  bool region_valid_ = false;
+  uint32_t region_time_ms_ = 0;
+  bool dragging_ = false;
+
+  Stats stats_;
+};
+
+#ifdef _WIN32
+std::unique_ptr<WindowSystem> CreateWin32WindowSystem();
+
+// WinEvent hooks (out of context, delivered on the calling thread's
+// message loop) for the events that change occlusion
+class OcclusionWatcher {
+ public:
+  using Handler = std::function<void(uint32_t event, WindowHandle window)>;
+
+  ~OcclusionWatcher();
+
+  bool Start(Handler handler);
+  void Stop();
+
+  void Notify(uint32_t event, WindowHandle window);  // From the WinEvent callback
+
+ private:
+  std::vector<void*> hooks_;  // HWINEVENTHOOK
+  Handler handler_;
+};
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_OCCLUSION_CACHE_H_
@@ -0,0 +1,111 @@
+#include "preview_encoder.h"
+
+#include <wincodec.h>
+#include <wrl.h>
+#include <iostream>
+
+namespace hkcw_engine2 {
+
+bool PreviewEncoder::DecodeStream(IStream* stream, std::vector<uint32_t>& pixels, int& width,
+                                  int& height) {
+  LARGE_INTEGER zero = {};
+  HRESULT hr = stream->Seek(zero, STREAM_SEEK_SET, nullptr);
+
+  Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+  if (SUCCEEDED(hr)) {
+    hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                          IID_PPV_ARGS(&factory));
+  }
+  Microsoft::WRL::ComPtr<IWICBitmapDecoder> decoder;
+  if (SUCCEEDED(hr)) {
+    hr = factory->CreateDecoderFromStream(stream, nullptr, WICDecodeMetadataCacheOnDemand,
+                                          &decoder);
+  }
+  Microsoft::WRL::ComPtr<IWICBitmapFrameDecode> frame;
+  if (SUCCEEDED(hr)) hr = decoder->GetFrame(0, &frame);
+
+  Microsoft::WRL::ComPtr<IWICFormatConverter> converter;
+  if (SUCCEEDED(hr)) hr = factory->CreateFormatConverter(&converter);
+  if (SUCCEEDED(hr)) {
+    hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppBGRA,
+                               WICBitmapDitherTypeNone, nullptr, 0.0,
+                               WICBitmapPaletteTypeCustom);
+  }
+
+  UINT frame_width = 0;
+  UINT frame_height = 0;
+  if (SUCCEEDED(hr)) hr = converter->GetSize(&frame_width, &frame_height);
+  if (SUCCEEDED(hr)) {
+    pixels.resize(static_cast<size_t>(frame_width) * frame_height);
+    hr = converter->CopyPixels(nullptr, frame_width * 4,
+                               static_cast<UINT>(pixels.size() * 4),
+                               reinterpret_cast<BYTE*>(pixels.data()));
+  }
+
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] [Preview] ERROR: Failed to decode capture: " << std::hex << hr
+              << std::dec << std::endl;
+    pixels.clear();
+    return false;
+  }
+
+  width = static_cast<int>(frame_width);
+  height = static_cast<int>(frame_height);
+  return true;
+}
+
+bool PreviewEncoder::EncodeThumbnail(const ImageView& frame, int max_width, int max_height,
+                                     std::vector<uint8_t>& png) {
+  Surface thumbnail;
+  DownsampleThumbnail(frame, max_width, max_height, thumbnail);
+  int width = thumbnail.width;
+  int height = thumbnail.height;
+
+  Microsoft::WRL::ComPtr<IWICImagingFactory> factory;
+  HRESULT hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER,
+                                IID_PPV_ARGS(&factory));
+  Microsoft::WRL::ComPtr<IStream> stream;
+  if (SUCCEEDED(hr)) hr = CreateStreamOnHGlobal(nullptr, TRUE, &stream);
+  Microsoft::WRL::ComPtr<IWICBitmapEncoder> encoder;
+  if (SUCCEEDED(hr)) hr = factory->CreateEncoder(GUID_ContainerFormatPng, nullptr, &encoder);
+  if (SUCCEEDED(hr)) hr = encoder->Initialize(stream.Get(), WICBitmapEncoderNoCache);
+
+  Microsoft::WRL::ComPtr<IWICBitmapFrameEncode> frame_encode;
+  if (SUCCEEDED(hr)) hr = encoder->CreateNewFrame(&frame_encode, nullptr);
+  if (SUCCEEDED(hr)) hr = frame_encode->Initialize(nullptr);
+  if (SUCCEEDED(hr)) {
+    hr = frame_encode->SetSize(static_cast<UINT>(width), static_cast<UINT>(height));
+  }
+
+  WICPixelFormatGUID format = GUID_WICPixelFormat32bppBGRA;
+  if (SUCCEEDED(hr)) hr = frame_encode->SetPixelFormat(&format);
+  if (SUCCEEDED(hr) && !IsEqualGUID(format, GUID_WICPixelFormat32bppBGRA)) {
+    hr = WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+  }
+  if (SUCCEEDED(hr)) {
+    hr = frame_encode->WritePixels(static_cast<UINT>(height), static_cast<UINT>(width) * 4,
+                                   static_cast<UINT>(thumbnail.pixels.size() * 4),
+                                   reinterpret_cast<BYTE*>(thumbnail.pixels.data()));
+  }
+  if (SUCCEEDED(hr)) hr = frame_encode->Commit();
+  if (SUCCEEDED(hr)) hr = encoder->Commit();
+
+  STATSTG stat = {};
+  if (SUCCEEDED(hr)) hr = stream->Stat(&stat, STATFLAG_NONAME);
+  HGLOBAL memory = nullptr;
+  if (SUCCEEDED(hr)) hr = GetHGlobalFromStream(stream.Get(), &memory);
+
+  if (FAILED(hr)) {
+    std::cout << "[HKCW] [Preview] ERROR: Failed to encode thumbnail: " << std::hex << hr
+              << std::dec << std::endl;
+    return false;
+  }
+
+  const auto* bytes = static_cast<const uint8_t*>(GlobalLock(memory));
+  if (!bytes) return false;
+  png.assign(bytes, bytes + stat.cbSize.QuadPart);
+  GlobalUnlock(memory);
+  return true;
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,29 @@
+#ifndef FLUTTER_PLUGIN_PREVIEW_ENCODER_H_
+#define FLUTTER_PLUGIN_PREVIEW_ENCODER_H_
+
+#include <windows.h>
+#include <objidl.h>
+#include <cstdint>
+#include <vector>
+
+#include "preview_thumbnail.h"
+
+namespace hkcw_engine2 {
+
+// Preview: turns full-size frames into small PNG thumbnails for the
+// settings UI. Downsampling is done natively with the box filter
+// (DownsampleThumbnail) so only a few kilobytes cross the platform channel.
+class PreviewEncoder {
+ public:
+  // Decode a PNG stream (as written by CapturePreview) into BGRA pixels
+  static bool DecodeStream(IStream* stream, std::vector<uint32_t>& pixels, int& width,
+                           int& height);
+
+  // Downsample and PNG-encode one thumbnail
+  static bool EncodeThumbnail(const ImageView& frame, int max_width, int max_height,
+                              std::vector<uint8_t>& png);
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_PREVIEW_ENCODER_H_
@@ -0,0 +1,36 @@
+#include "preview_thumbnail.h"
+
+#include <algorithm>
+#include <cstdint>
+
+#include "image_resampler.h"
+
+namespace hkcw_engine2 {
+
+void FitThumbnailSize(int width, int height, int max_width, int max_height, int& out_width,
+                      int& out_height) {
+  out_width = (std::min)(width, max_width);
+  out_height = (std::min)(height, max_height);
+  if (width <= 0 || height <= 0) return;
+
+  // Never upscale; shrink the longer side relative to the box
+  if (static_cast<int64_t>(width) * out_height > static_cast<int64_t>(height) * out_width) {
+    out_height = static_cast<int>(static_cast<int64_t>(height) * out_width / width);
+  } else {
+    out_width = static_cast<int>(static_cast<int64_t>(width) * out_height / height);
+  }
+  out_width = (std::max)(out_width, 1);
+  out_height = (std::max)(out_height, 1);
+}
+
+void DownsampleThumbnail(const ImageView& frame, int max_width, int max_height,
+                         Surface& thumbnail) {
+  int width = 0;
+  int height = 0;
+  FitThumbnailSize(frame.width, frame.height, max_width, max_height, width, height);
+  thumbnail.Resize(width, height);
+  ImageResampler().Resample(frame, 0.0f, 0.0f, static_cast<float>(frame.width),
+                            static_cast<float>(frame.height), thumbnail, ResampleFilter::kBox);
+}
+
+}  // namespace hkcw_engine2
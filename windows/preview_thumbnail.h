@@ -0,0 +1,22 @@
+#ifndef FLUTTER_PLUGIN_PREVIEW_THUMBNAIL_H_
+#define FLUTTER_PLUGIN_PREVIEW_THUMBNAIL_H_
+
+#include "software_rasterizer.h"
+
+namespace hkcw_engine2 {
+
+// Preview: sizing and downsampling of thumbnails. Platform-neutral; the
+// WIC decode and PNG encode stay in PreviewEncoder.
+
+// Largest size with the frame's aspect ratio inside max_width x
+// max_height; never upscales and never returns less than 1x1
+void FitThumbnailSize(int width, int height, int max_width, int max_height, int& out_width,
+                      int& out_height);
+
+// Box-filtered thumbnail of the whole frame at FitThumbnailSize
+void DownsampleThumbnail(const ImageView& frame, int max_width, int max_height,
+                         Surface& thumbnail);
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_PREVIEW_THUMBNAIL_H_
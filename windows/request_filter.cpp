@@ -0,0 +1,574 @@
+#include "request_filter.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// Tokens that appear in nearly every URL make poor bucket keys
+const char* const kCommonTokens[] = {
+  "http", "https", "www", "com", "net", "org", "html", "js", "css", "cdn",
+};
+
+inline bool IsTokenChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+}
+
+inline char ToLowerAscii(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+// EasyList "^": anything but a letter, digit or one of _ - . %
+inline bool IsSeparator(char c) {
+  if (IsTokenChar(c)) return false;
+  if (c == '_' || c == '-' || c == '.' || c == '%') return false;
+  return static_cast<unsigned char>(c) < 0x80;
+}
+
+std::string_view Trim(std::string_view s) {
+  while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+  while (!s.empty() && (s.back() == ' ' || s.back() == '\t' ||
+                        s.back() == '\r' || s.back() == '\n')) {
+    s.remove_suffix(1);
+  }
+  return s;
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); i++) {
+    if (ToLowerAscii(a[i]) != ToLowerAscii(b[i])) return false;
+  }
+  return true;
+}
+
+// True if host is domain or a subdomain of it
+bool HostMatchesDomain(std::string_view host, std::string_view domain) {
+  if (domain.empty() || host.size() < domain.size()) return false;
+  std::string_view tail = host.substr(host.size() - domain.size());
+  if (!EqualsIgnoreCase(tail, domain)) return false;
+  return host.size() == domain.size() || host[host.size() - domain.size() - 1] == '.';
+}
+
+// Last two labels; good enough for first/third-party decisions
+std::string_view BaseDomain(std::string_view host) {
+  size_t last = host.rfind('.');
+  if (last == std::string_view::npos || last == 0) return host;
+  size_t prev = host.rfind('.', last - 1);
+  return prev == std::string_view::npos ? host : host.substr(prev + 1);
+}
+
+}  // namespace
+
+std::string_view RequestFilter::ExtractHost(std::string_view url) {
+  size_t scheme = url.find("://");
+  if (scheme == std::string_view::npos) return std::string_view();
+  size_t begin = scheme + 3;
+  size_t end = url.find_first_of("/:?#", begin);
+  if (end == std::string_view::npos) end = url.size();
+  return url.substr(begin, end - begin);
+}
+
+namespace {
+
+uint32_t TypeFromOption(std::string_view name) {
+  if (name == "script") return kResourceScript;
+  if (name == "image") return kResourceImage;
+  if (name == "stylesheet") return kResourceStylesheet;
+  if (name == "xmlhttprequest") return kResourceXhr;
+  if (name == "subdocument") return kResourceSubdocument;
+  if (name == "media") return kResourceMedia;
+  if (name == "font") return kResourceFont;
+  if (name == "websocket") return kResourceWebsocket;
+  if (name == "ping") return kResourcePing;
+  if (name == "document") return kResourceDocument;
+  if (name == "other" || name == "object") return kResourceOther;
+  return 0;
+}
+
+inline bool BloomContains(const std::vector<uint64_t>& bloom, uint32_t mask, uint32_t hash) {
+  uint32_t a = hash & mask;
+  uint32_t b = (hash * 0x9E3779B1u >> 7) & mask;
+  return (bloom[a >> 6] >> (a & 63) & 1) && (bloom[b >> 6] >> (b & 63) & 1);
+}
+
+inline void BloomInsert(std::vector<uint64_t>& bloom, uint32_t mask, uint32_t hash) {
+  uint32_t a = hash & mask;
+  uint32_t b = (hash * 0x9E3779B1u >> 7) & mask;
+  bloom[a >> 6] |= uint64_t{1} << (a & 63);
+  bloom[b >> 6] |= uint64_t{1} << (b & 63);
+}
+
+uint32_t NextPowerOfTwo(size_t n) {
+  uint32_t p = 1;
+  while (p < n) p <<= 1;
+  return p;
+}
+
+}  // namespace
+
+uint32_t RequestFilter::HashToken(const char* begin, size_t length) {
+  // FNV-1a over the lowercased token; 0 is reserved for "no token"
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= static_cast<unsigned char>(ToLowerAscii(begin[i]));
+    hash *= 16777619u;
+  }
+  return hash ? hash : 1;
+}
+
+uint32_t RequestFilter::PickToken(std::string_view pattern, uint16_t flags) {
+  bool anchored_start = (flags & (kFlagHostAnchor | kFlagStartAnchor)) != 0;
+  bool anchored_end = (flags & kFlagEndAnchor) != 0;
+
+  size_t best_begin = 0;
+  size_t best_length = 0;
+  int best_score = 0;
+
+  size_t i = 0;
+  while (i < pattern.size()) {
+    if (!IsTokenChar(pattern[i])) {
+      i++;
+      continue;
+    }
+    size_t j = i;
+    while (j < pattern.size() && IsTokenChar(pattern[j])) j++;
+
+    // The run must be a whole token in every URL the rule can match
+    bool left_ok = i > 0 ? pattern[i - 1] != '*' : anchored_start;
+    bool right_ok = j < pattern.size() ? pattern[j] != '*' : anchored_end;
+    size_t length = j - i;
+
+    if (left_ok && right_ok && length >= 2) {
+      int score = static_cast<int>((std::min)(length, size_t{16}));
+      for (const char* common : kCommonTokens) {
+        std::string_view token = pattern.substr(i, length);
+        if (EqualsIgnoreCase(token, common)) {
+          score = 1;
+          break;
+        }
+      }
+      if (score > best_score) {
+        best_score = score;
+        best_begin = i;
+        best_length = length;
+      }
+    }
+    i = j;
+  }
+
+  return best_length ? HashToken(pattern.data() + best_begin, best_length) : 0;
+}
+
+bool RequestFilter::AddRule(std::string_view line) {
+  std::string_view text = Trim(line);
+  if (text.empty() || text[0] == '!' || text[0] == '[') {
+    return false;
+  }
+
+  // Cosmetic (element hiding / scriptlet) rules are page-side only
+  if (text.find("##") != std::string_view::npos || text.find("#@#") != std::string_view::npos ||
+      text.find("#?#") != std::string_view::npos || text.find("#$#") != std::string_view::npos) {
+    return false;
+  }
+
+  std::string_view body = text;
+  uint16_t flags = 0;
+  if (body.compare(0, 2, "@@") == 0) {
+    flags |= kFlagException;
+    body.remove_prefix(2);
+  }
+
+  uint32_t include_types = 0;
+  uint32_t exclude_types = 0;
+  std::string_view domains;
+
+  size_t dollar = body.rfind('$');
+  if (dollar != std::string_view::npos) {
+    std::string_view options = body.substr(dollar + 1);
+    body = body.substr(0, dollar);
+
+    while (!options.empty()) {
+      size_t comma = options.find(',');
+      std::string_view option = options.substr(0, comma);
+      options = comma == std::string_view::npos ? std::string_view() : options.substr(comma + 1);
+
+      bool negated = !option.empty() && option[0] == '~';
+      if (negated) option.remove_prefix(1);
+
+      if (uint32_t type = TypeFromOption(option)) {
+        (negated ? exclude_types : include_types) |= type;
+      } else if (option == "third-party" || option == "3p") {
+        flags |= negated ? kFlagFirstParty : kFlagThirdParty;
+      } else if (option == "first-party" || option == "1p") {
+        flags |= negated ? kFlagThirdParty : kFlagFirstParty;
+      } else if (option == "match-case") {
+        flags |= kFlagMatchCase;
+      } else if (option.compare(0, 7, "domain=") == 0) {
+        domains = option.substr(7);
+      } else if (option == "important" || option.empty()) {
+        // No behaviour change for a single list
+      } else {
+        return false;  // Unsupported option, skip rather than over-block
+      }
+    }
+  }
+
+  // Regex rules are not supported by the token index
+  if (body.size() >= 2 && body.front() == '/' && body.back() == '/') {
+    return false;
+  }
+
+  if (body.compare(0, 2, "||") == 0) {
+    flags |= kFlagHostAnchor;
+    body.remove_prefix(2);
+  } else if (!body.empty() && body.front() == '|') {
+    flags |= kFlagStartAnchor;
+    body.remove_prefix(1);
+  }
+  if (!body.empty() && body.back() == '|') {
+    flags |= kFlagEndAnchor;
+    body.remove_suffix(1);
+  }
+
+  // Leading/trailing wildcards only cancel anchoring
+  if (!body.empty() && body.front() == '*') {
+    flags &= static_cast<uint16_t>(~(kFlagHostAnchor | kFlagStartAnchor));
+    while (!body.empty() && body.front() == '*') body.remove_prefix(1);
+  }
+  if (!body.empty() && body.back() == '*') {
+    flags &= static_cast<uint16_t>(~kFlagEndAnchor);
+    while (!body.empty() && body.back() == '*') body.remove_suffix(1);
+  }
+
+  if (body.empty() && include_types == 0 && domains.empty() &&
+      !(flags & (kFlagThirdParty | kFlagFirstParty))) {
+    return false;  // Would match every request
+  }
+
+  Rule rule;
+  rule.text_offset = static_cast<uint32_t>(pool_.size());
+  rule.text_length = static_cast<uint32_t>(text.size());
+  pool_.append(text);
+
+  rule.pattern_offset = static_cast<uint32_t>(pool_.size());
+  rule.pattern_length = static_cast<uint32_t>(body.size());
+  for (char c : body) {
+    pool_.push_back((flags & kFlagMatchCase) ? c : ToLowerAscii(c));
+  }
+
+  rule.domains_offset = static_cast<uint32_t>(pool_.size());
+  rule.domains_length = static_cast<uint32_t>(domains.size());
+  pool_.append(domains);
+
+  rule.type_mask = (include_types ? include_types : kResourceAll) & ~exclude_types;
+  rule.flags = flags;
+
+  rules_.push_back(rule);
+  hits_.push_back(0);
+  return true;
+}
+
+size_t RequestFilter::LoadRules(std::istream& in) {
+  size_t added = 0;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (AddRule(line)) added++;
+  }
+  return added;
+}
+
+size_t RequestFilter::LoadFile(const std::string& path) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    std::cout << "[HKCW] [Filter] ERROR: Cannot open filter list: " << path << std::endl;
+    return 0;
+  }
+
+  size_t added = LoadRules(file);
+  std::cout << "[HKCW] [Filter] Loaded " << added << " rules from " << path << std::endl;
+  return added;
+}
+
+void RequestFilter::Clear() {
+  rules_.clear();
+  hits_.clear();
+  rule_tokens_.clear();
+  pool_.clear();
+  block_index_ = Index();
+  exception_index_ = Index();
+  checked_ = 0;
+  blocked_ = 0;
+  prefilter_rejected_ = 0;
+  prefilter_passed_ = 0;
+}
+
+void RequestFilter::Compile() {
+  rule_tokens_.resize(rules_.size());
+  for (size_t i = 0; i < rules_.size(); i++) {
+    rule_tokens_[i] = PickToken(Pattern(rules_[i]), rules_[i].flags);
+  }
+
+  BuildIndex(false, block_index_);
+  BuildIndex(true, exception_index_);
+
+  std::cout << "[HKCW] [Filter] Compiled " << rules_.size() << " rules ("
+            << block_index_.untokenized.size() + exception_index_.untokenized.size()
+            << " untokenized)" << std::endl;
+}
+
+void RequestFilter::BuildIndex(bool exceptions, Index& index) {
+  index = Index();
+
+  size_t tokenized = 0;
+  for (size_t i = 0; i < rules_.size(); i++) {
+    if (((rules_[i].flags & kFlagException) != 0) != exceptions) continue;
+    if (rule_tokens_[i]) {
+      tokenized++;
+    } else {
+      index.untokenized.push_back(static_cast<uint32_t>(i));
+    }
+  }
+
+  uint32_t buckets = NextPowerOfTwo((std::max)(tokenized, size_t{1}));
+  index.mask = buckets - 1;
+  index.bucket_starts.assign(buckets + 1, 0);
+
+  // Counting sort into CSR buckets
+  for (size_t i = 0; i < rules_.size(); i++) {
+    if (((rules_[i].flags & kFlagException) != 0) != exceptions || !rule_tokens_[i]) continue;
+    index.bucket_starts[(rule_tokens_[i] & index.mask) + 1]++;
+  }
+  for (uint32_t b = 0; b < buckets; b++) {
+    index.bucket_starts[b + 1] += index.bucket_starts[b];
+  }
+
+  index.bucket_hashes.resize(tokenized);
+  index.bucket_rules.resize(tokenized);
+  std::vector<uint32_t> fill(index.bucket_starts.begin(), index.bucket_starts.end() - 1);
+  for (size_t i = 0; i < rules_.size(); i++) {
+    if (((rules_[i].flags & kFlagException) != 0) != exceptions || !rule_tokens_[i]) continue;
+    uint32_t slot = fill[rule_tokens_[i] & index.mask]++;
+    index.bucket_hashes[slot] = rule_tokens_[i];
+    index.bucket_rules[slot] = static_cast<uint32_t>(i);
+  }
+
+  // ~16 bits per token keeps the false positive rate around 1%
+  uint32_t bloom_bits = NextPowerOfTwo((std::max)(tokenized * 16, size_t{1024}));
+  index.bloom.assign(bloom_bits / 64, 0);
+  for (uint32_t hash : index.bucket_hashes) {
+    BloomInsert(index.bloom, bloom_bits - 1, hash);
+  }
+}
+
+int RequestFilter::Match(const FilterRequest& request) {
+  checked_++;
+  if (rules_.empty()) return kNoMatch;
+
+  lower_url_.assign(request.url.data(), request.url.size());
+  for (char& c : lower_url_) c = ToLowerAscii(c);
+  std::string_view lower_url(lower_url_);
+  std::string_view host = ExtractHost(lower_url);
+
+  url_tokens_.clear();
+  size_t i = 0;
+  while (i < lower_url.size()) {
+    if (!IsTokenChar(lower_url[i])) {
+      i++;
+      continue;
+    }
+    size_t j = i;
+    while (j < lower_url.size() && IsTokenChar(lower_url[j])) j++;
+    if (j - i >= 2) url_tokens_.push_back(HashToken(lower_url.data() + i, j - i));
+    i = j;
+  }
+
+  int block = MatchIndex(block_index_, request, lower_url, host);
+  if (block == kNoMatch) return kNoMatch;
+  hits_[static_cast<size_t>(block)]++;
+
+  int exception = MatchIndex(exception_index_, request, lower_url, host);
+  if (exception != kNoMatch) {
+    hits_[static_cast<size_t>(exception)]++;
+    return kNoMatch;
+  }
+
+  blocked_++;
+  return block;
+}
+
+int RequestFilter::MatchIndex(const Index& index, const FilterRequest& request,
+                              std::string_view lower_url, std::string_view host) {
+  if (!index.bloom.empty()) {
+    uint32_t bloom_mask = static_cast<uint32_t>(index.bloom.size() * 64 - 1);
+    for (uint32_t token : url_tokens_) {
+      if (!BloomContains(index.bloom, bloom_mask, token)) {
+        prefilter_rejected_++;
+        continue;
+      }
+      prefilter_passed_++;
+
+      uint32_t bucket = token & index.mask;
+      for (uint32_t k = index.bucket_starts[bucket]; k < index.bucket_starts[bucket + 1]; k++) {
+        if (index.bucket_hashes[k] != token) continue;
+        uint32_t rule = index.bucket_rules[k];
+        if (RuleMatches(rules_[rule], request, lower_url, host)) {
+          return static_cast<int>(rule);
+        }
+      }
+    }
+  }
+
+  for (uint32_t rule : index.untokenized) {
+    if (RuleMatches(rules_[rule], request, lower_url, host)) {
+      return static_cast<int>(rule);
+    }
+  }
+
+  return kNoMatch;
+}
+
+bool RequestFilter::RuleMatches(const Rule& rule, const FilterRequest& request,
+                                std::string_view lower_url, std::string_view host) const {
+  if (!(rule.type_mask & request.type)) return false;
+
+  if (rule.flags & (kFlagThirdParty | kFlagFirstParty)) {
+    if (request.document_host.empty()) return false;
+    bool third_party = !EqualsIgnoreCase(BaseDomain(host), BaseDomain(request.document_host));
+    if ((rule.flags & kFlagThirdParty) && !third_party) return false;
+    if ((rule.flags & kFlagFirstParty) && third_party) return false;
+  }
+
+  if (rule.domains_length && !DomainOptionMatches(rule, request.document_host)) {
+    return false;
+  }
+
+  std::string_view pattern = Pattern(rule);
+  std::string_view url = (rule.flags & kFlagMatchCase) ? request.url : lower_url;
+  bool end_anchor = (rule.flags & kFlagEndAnchor) != 0;
+
+  if (rule.flags & kFlagHostAnchor) {
+    if (host.empty()) return false;
+    size_t host_begin = static_cast<size_t>(host.data() - lower_url.data());
+    size_t host_end = host_begin + host.size();
+    for (size_t pos = host_begin; pos < host_end; pos++) {
+      if ((pos == host_begin || url[pos - 1] == '.') &&
+          PatternMatchesAt(pattern, url, pos, end_anchor)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (rule.flags & kFlagStartAnchor) {
+    return PatternMatchesAt(pattern, url, 0, end_anchor);
+  }
+
+  // Unanchored: jump between occurrences of the leading literal
+  size_t literal = pattern.find_first_of("*^");
+  std::string_view prefix = pattern.substr(0, literal);
+  if (prefix.empty()) {
+    for (size_t pos = 0; pos <= url.size(); pos++) {
+      if (PatternMatchesAt(pattern, url, pos, end_anchor)) return true;
+    }
+    return false;
+  }
+
+  for (size_t pos = url.find(prefix); pos != std::string_view::npos;
+       pos = url.find(prefix, pos + 1)) {
+    if (PatternMatchesAt(pattern, url, pos, end_anchor)) return true;
+  }
+  return false;
+}
+
+bool RequestFilter::PatternMatchesAt(std::string_view pattern, std::string_view url,
+                                     size_t start, bool end_anchor) const {
+  // Greedy wildcard matching with single-star backtracking
+  size_t p = 0;
+  size_t u = start;
+  size_t star_p = std::string_view::npos;
+  size_t star_u = 0;
+
+  while (true) {
+    if (p < pattern.size()) {
+      char pc = pattern[p];
+      if (pc == '*') {
+        star_p = p++;
+        star_u = u;
+        continue;
+      }
+      if (u < url.size()) {
+        if (pc == '^' ? IsSeparator(url[u]) : pc == url[u]) {
+          p++;
+          u++;
+          continue;
+        }
+      } else if (pc == '^') {
+        p++;  // "^" also matches the end of the address
+        continue;
+      }
+    } else if (!end_anchor || u == url.size()) {
+      return true;
+    }
+
+    if (star_p != std::string_view::npos && star_u < url.size()) {
+      p = star_p + 1;
+      u = ++star_u;
+      continue;
+    }
+    return false;
+  }
+}
+
+bool RequestFilter::DomainOptionMatches(const Rule& rule, std::string_view document_host) const {
+  std::string_view domains = std::string_view(pool_).substr(rule.domains_offset, rule.domains_length);
+
+  bool has_include = false;
+  bool included = false;
+  while (!domains.empty()) {
+    size_t bar = domains.find('|');
+    std::string_view domain = domains.substr(0, bar);
+    domains = bar == std::string_view::npos ? std::string_view() : domains.substr(bar + 1);
+
+    if (!domain.empty() && domain[0] == '~') {
+      if (HostMatchesDomain(document_host, domain.substr(1))) return false;
+    } else if (!domain.empty()) {
+      has_include = true;
+      if (HostMatchesDomain(document_host, domain)) included = true;
+    }
+  }
+
+  return !has_include || included;
+}
+
+std::vector<FilterRuleStat> RequestFilter::GetRuleStats(size_t limit) const {
+  std::vector<uint32_t> order;
+  for (size_t i = 0; i < hits_.size(); i++) {
+    if (hits_[i]) order.push_back(static_cast<uint32_t>(i));
+  }
+  std::sort(order.begin(), order.end(),
+            [this](uint32_t a, uint32_t b) { return hits_[a] > hits_[b]; });
+  if (limit && order.size() > limit) order.resize(limit);
+
+  std::vector<FilterRuleStat> stats;
+  stats.reserve(order.size());
+  for (uint32_t i : order) {
+    const Rule& rule = rules_[i];
+    stats.push_back({pool_.substr(rule.text_offset, rule.text_length), hits_[i],
+                     (rule.flags & kFlagException) != 0});
+  }
+  return stats;
+}
+
+void RequestFilter::ResetStats() {
+  std::fill(hits_.begin(), hits_.end(), 0);
+  checked_ = 0;
+  blocked_ = 0;
+  prefilter_rejected_ = 0;
+  prefilter_passed_ = 0;
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,151 @@
+#ifndef FLUTTER_PLUGIN_REQUEST_FILTER_H_
+#define FLUTTER_PLUGIN_REQUEST_FILTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Request Filter: resource classes understood by EasyList "$type" options
+enum ResourceType : uint32_t {
+  kResourceOther = 1u << 0,
+  kResourceScript = 1u << 1,
+  kResourceImage = 1u << 2,
+  kResourceStylesheet = 1u << 3,
+  kResourceXhr = 1u << 4,
+  kResourceSubdocument = 1u << 5,
+  kResourceMedia = 1u << 6,
+  kResourceFont = 1u << 7,
+  kResourceWebsocket = 1u << 8,
+  kResourcePing = 1u << 9,
+  kResourceAll = (1u << 10) - 1,
+  // The top-level page itself: outside kResourceAll, so only rules that
+  // name "$document" apply to it
+  kResourceDocument = 1u << 10,
+};
+
+// A single subresource request as seen by the filter
+struct FilterRequest {
+  std::string_view url;
+  std::string_view document_host;  // Host of the top-level page
+  uint32_t type = kResourceOther;
+};
+
+struct FilterRuleStat {
+  std::string rule;
+  uint32_t hits;
+  bool exception;
+};
+
+// Request Filter: EasyList-style network rule engine.
+//
+// Rules are compiled into token hash buckets: every rule is indexed under one
+// alphanumeric token that must appear verbatim in any URL it can match. A
+// request is tokenized once, each token is checked against a bloom filter and
+// only surviving tokens touch the buckets, so the common "no match" case
+// costs a handful of hash probes. Cosmetic rules, regex rules and options we
+// cannot honour natively ($popup, $csp, ...) are skipped at load time.
+class RequestFilter {
+ public:
+  static constexpr int kNoMatch = -1;
+
+  // Parse one list line; returns false if the line was skipped
+  bool AddRule(std::string_view line);
+  size_t LoadRules(std::istream& in);
+  size_t LoadFile(const std::string& path);
+  void Clear();
+
+  // Build buckets and bloom filter; must be called after adding rules
+  void Compile();
+
+  // Returns the index of the blocking rule, or kNoMatch if the request
+  // is allowed (no block rule, or an exception rule overrides it)
+  int Match(const FilterRequest& request);
+  bool ShouldBlock(const FilterRequest& request) { return Match(request) != kNoMatch; }
+
+  // Host part of an absolute URL ("" if there is none)
+  static std::string_view ExtractHost(std::string_view url);
+
+  size_t rule_count() const { return rules_.size(); }
+  uint64_t checked_count() const { return checked_; }
+  uint64_t blocked_count() const { return blocked_; }
+  // URL tokens the bloom filter turned away / let through to a bucket
+  uint64_t prefilter_rejected() const { return prefilter_rejected_; }
+  uint64_t prefilter_passed() const { return prefilter_passed_; }
+
+  // Rules with at least one hit, most hit first (limit 0 = all)
+  std::vector<FilterRuleStat> GetRuleStats(size_t limit = 0) const;
+  void ResetStats();
+
+ private:
+  enum RuleFlags : uint16_t {
+    kFlagException = 1u << 0,
+    kFlagHostAnchor = 1u << 1,   // ||
+    kFlagStartAnchor = 1u << 2,  // |
+    kFlagEndAnchor = 1u << 3,    // trailing |
+    kFlagThirdParty = 1u << 4,
+    kFlagFirstParty = 1u << 5,
+    kFlagMatchCase = 1u << 6,
+  };
+
+  struct Rule {
+    uint32_t pattern_offset;
+    uint32_t pattern_length;
+    uint32_t text_offset;     // Original rule text, for stats
+    uint32_t text_length;
+    uint32_t domains_offset;  // "a.com|~b.com" from $domain=
+    uint32_t domains_length;
+    uint32_t type_mask;
+    uint16_t flags;
+  };
+
+  // Compact bucket index over one rule set (block or exception)
+  struct Index {
+    std::vector<uint32_t> bucket_starts;  // CSR offsets, size mask + 2
+    std::vector<uint32_t> bucket_hashes;
+    std::vector<uint32_t> bucket_rules;
+    std::vector<uint32_t> untokenized;
+    std::vector<uint64_t> bloom;
+    uint32_t mask = 0;
+  };
+
+  static uint32_t HashToken(const char* begin, size_t length);
+  static uint32_t PickToken(std::string_view pattern, uint16_t flags);
+
+  void BuildIndex(bool exceptions, Index& index);
+  int MatchIndex(const Index& index, const FilterRequest& request,
+                 std::string_view lower_url, std::string_view host);
+  bool RuleMatches(const Rule& rule, const FilterRequest& request,
+                   std::string_view lower_url, std::string_view host) const;
+  bool PatternMatchesAt(std::string_view pattern, std::string_view url,
+                        size_t start, bool end_anchor) const;
+  bool DomainOptionMatches(const Rule& rule, std::string_view document_host) const;
+
+  std::string_view Pattern(const Rule& rule) const {
+    return std::string_view(pool_).substr(rule.pattern_offset, rule.pattern_length);
+  }
+
+  std::vector<Rule> rules_;
+  std::vector<uint32_t> hits_;
+  std::vector<uint32_t> rule_tokens_;
+  std::string pool_;
+  Index block_index_;
+  Index exception_index_;
+
+  // Per-request scratch buffers, reused to avoid allocation
+  std::string lower_url_;
+  std::vector<uint32_t> url_tokens_;
+
+  uint64_t checked_ = 0;
+  uint64_t blocked_ = 0;
+  uint64_t prefilter_rejected_ = 0;
+  uint64_t prefilter_passed_ = 0;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_REQUEST_FILTER_H_
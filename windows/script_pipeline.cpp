@@ -0,0 +1,173 @@
+#include "script_pipeline.h"
+
+#include <algorithm>
+
+namespace hkcw_engine2 {
+
+ScriptPipeline::ScriptPipeline(Options options) : options_(options) {
+  options_.max_in_flight = (std::max)(options_.max_in_flight, size_t{1});
+  queue_.resize((std::max)(options_.queue_capacity, size_t{1}));
+  in_flight_.reserve(options_.max_in_flight);
+  latency_ms_.resize(kLatencySamples);
+}
+
+ScriptPipeline::Result ScriptPipeline::Submit(std::wstring_view script, Policy policy,
+                                              uint32_t key, Clock::time_point now) {
+  stats_.submitted++;
+  ExpireInFlight(now);
+  Pump(now);
+
+  // Start immediately only if nothing older is waiting
+  if (count_ == 0 && in_flight_.size() < options_.max_in_flight) {
+    start_buffer_.assign(script.data(), script.size());
+    return Start(start_buffer_.c_str(), now, now) ? Result::kStarted : Result::kFailed;
+  }
+
+  if (policy == Policy::kDropIfBusy) {
+    stats_.dropped++;
+    return Result::kDropped;
+  }
+
+  if (policy == Policy::kCoalesce && key != 0) {
+    for (size_t i = 0; i < count_; i++) {
+      Pending& pending = queue_[(head_ + i) % queue_.size()];
+      if (pending.key == key) {
+        pending.script.assign(script.data(), script.size());
+        pending.submitted = now;
+        stats_.coalesced++;
+        return Result::kCoalesced;
+      }
+    }
+  }
+
+  if (count_ == queue_.size()) {
+    stats_.dropped++;
+    return Result::kDropped;
+  }
+
+  Pending& pending = queue_[(head_ + count_) % queue_.size()];
+  pending.script.assign(script.data(), script.size());
+  pending.key = policy == Policy::kCoalesce ? key : 0;
+  pending.submitted = now;
+  count_++;
+  return Result::kQueued;
+}
+
+bool ScriptPipeline::Start(const wchar_t* script, Clock::time_point submitted,
+                           Clock::time_point now) {
+  // Registered first: the executor may complete inline
+  uint64_t ticket = next_ticket_++;
+  in_flight_.push_back({ticket, submitted, now});
+  stats_.started++;
+
+  if (executor_ && executor_(script, ticket)) {
+    return true;
+  }
+
+  auto it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                         [ticket](const InFlight& call) { return call.ticket == ticket; });
+  if (it != in_flight_.end()) {
+    in_flight_.erase(it);
+  }
+  stats_.failed++;
+  return false;
+}
+
+void ScriptPipeline::Complete(uint64_t ticket, bool success, Clock::time_point now) {
+  auto it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                         [ticket](const InFlight& call) { return call.ticket == ticket; });
+  if (it == in_flight_.end()) return;  // Timed out or reset
+
+  RecordLatency(now - it->submitted);
+  in_flight_.erase(it);
+  if (success) {
+    stats_.completed++;
+  } else {
+    stats_.failed++;
+  }
+
+  Pump(now);
+}
+
+void ScriptPipeline::Tick(Clock::time_point now) {
+  ExpireInFlight(now);
+  Pump(now);
+}
+
+void ScriptPipeline::Pump(Clock::time_point now) {
+  if (pumping_) return;
+  pumping_ = true;
+
+  while (count_ > 0) {
+    Pending& pending = queue_[head_];
+    bool stale = now - pending.submitted > options_.max_queue_delay;
+    if (!stale && in_flight_.size() >= options_.max_in_flight) break;
+
+    // Keep the slot's capacity for reuse; start from a stable buffer
+    std::swap(start_buffer_, pending.script);
+    Clock::time_point submitted = pending.submitted;
+    head_ = (head_ + 1) % queue_.size();
+    count_--;
+
+    if (stale) {
+      stats_.expired++;
+      continue;
+    }
+    Start(start_buffer_.c_str(), submitted, now);
+  }
+
+  pumping_ = false;
+}
+
+void ScriptPipeline::ExpireInFlight(Clock::time_point now) {
+  size_t before = in_flight_.size();
+  in_flight_.erase(std::remove_if(in_flight_.begin(), in_flight_.end(),
+                                  [&](const InFlight& call) {
+                                    return now - call.started > options_.in_flight_timeout;
+                                  }),
+                   in_flight_.end());
+  stats_.timed_out += before - in_flight_.size();
+}
+
+void ScriptPipeline::Reset() {
+  head_ = 0;
+  count_ = 0;
+  in_flight_.clear();
+}
+
+void ScriptPipeline::RecordLatency(Clock::duration latency) {
+  latency_ms_[latency_next_] = std::chrono::duration<double, std::milli>(latency).count();
+  latency_next_ = (latency_next_ + 1) % latency_ms_.size();
+  latency_filled_ = (std::min)(latency_filled_ + 1, latency_ms_.size());
+}
+
+ScriptPipeline::Stats ScriptPipeline::stats() const {
+  Stats stats = stats_;
+  stats.in_flight = in_flight_.size();
+  stats.queued = count_;
+
+  if (latency_filled_ > 0) {
+    std::vector<double> samples(latency_ms_.begin(), latency_ms_.begin() + latency_filled_);
+    double total = 0.0;
+    for (double sample : samples) total += sample;
+    stats.latency_avg_ms = total / static_cast<double>(samples.size());
+    stats.latency_max_ms = *std::max_element(samples.begin(), samples.end());
+    size_t p95 = samples.size() * 95 / 100;
+    std::nth_element(samples.begin(), samples.begin() + p95, samples.end());
+    stats.latency_p95_ms = samples[p95];
+  }
+  return stats;
+}
+
+const char* ScriptPipeline::ResultName(Result result) {
+  switch (result) {
+    case Result::kStarted: return "started";
+    case Result::kQueued: return "queued";
+    case Result::kCoalesced: return "coalesced";
+    case Result::kDropped: return "dropped";
+    case Result::kFailed: return "failed";
+  }
+  return "unknown";
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,130 @@
+#ifndef FLUTTER_PLUGIN_SCRIPT_PIPELINE_H_
+#define FLUTTER_PLUGIN_SCRIPT_PIPELINE_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Script Pipeline: bounded ExecuteScript calls with completion tracking.
+//
+// At most max_in_flight scripts are handed to the executor at a time; the
+// rest wait in a bounded queue. When the page is slow, input events are
+// merged (latest-wins per key) or dropped rather than piling up inside
+// WebView2, and anything that waited longer than max_queue_delay is
+// discarded, so the lag between an input and its script stays bounded.
+// Each call gets a ticket; Complete(ticket) records round-trip latency.
+//
+// The executor is injected so the policy runs against a stand-in WebView.
+// Not thread-safe: submissions and completions both arrive on the UI thread.
+class ScriptPipeline {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Start the script; false if it could not be started (no completion
+  // will follow). Otherwise Complete(ticket, ...) must be called later.
+  using Executor = std::function<bool(const wchar_t* script, uint64_t ticket)>;
+
+  enum class Policy {
+    kQueue,       // Ordered; dropped only when the queue is full
+    kCoalesce,    // Replaces a queued script with the same key
+    kDropIfBusy,  // Dropped unless it can start immediately
+  };
+
+  struct Options {
+    size_t max_in_flight = 4;
+    size_t queue_capacity = 32;
+    std::chrono::milliseconds max_queue_delay{250};
+    std::chrono::milliseconds in_flight_timeout{5000};  // Hung renderer
+  };
+
+  enum class Result { kStarted, kQueued, kCoalesced, kDropped, kFailed };
+
+  struct Stats {
+    uint64_t submitted = 0;
+    uint64_t started = 0;
+    uint64_t completed = 0;
+    uint64_t failed = 0;     // Executor refused or the script threw
+    uint64_t coalesced = 0;
+    uint64_t dropped = 0;    // Queue full or busy
+    uint64_t expired = 0;    // Waited longer than max_queue_delay
+    uint64_t timed_out = 0;  // No completion within in_flight_timeout
+    size_t in_flight = 0;
+    size_t queued = 0;
+    // Submission to completion, over the last kLatencySamples calls
+    double latency_avg_ms = 0.0;
+    double latency_p95_ms = 0.0;
+    double latency_max_ms = 0.0;
+  };
+
+  static const size_t kLatencySamples = 128;
+
+  explicit ScriptPipeline(Options options);
+
+  ScriptPipeline(const ScriptPipeline&) = delete;
+  ScriptPipeline& operator=(const ScriptPipeline&) = delete;
+
+  void SetExecutor(Executor executor) { executor_ = std::move(executor); }
+
+  // key only matters for kCoalesce (0 never coalesces)
+  Result Submit(std::wstring_view script, Policy policy, uint32_t key, Clock::time_point now);
+  void Complete(uint64_t ticket, bool success, Clock::time_point now);
+  // Enforce max_queue_delay and in_flight_timeout when no Submit or
+  // Complete comes along; the owner calls it from a timer while busy()
+  void Tick(Clock::time_point now);
+  bool busy() const { return count_ > 0 || !in_flight_.empty(); }
+
+  // Forget queued and in-flight scripts (page gone); late completions
+  // for the old tickets are ignored
+  void Reset();
+
+  Stats stats() const;
+  static const char* ResultName(Result result);
+
+ private:
+  struct Pending {
+    std::wstring script;
+    uint32_t key = 0;
+    Clock::time_point submitted;
+  };
+
+  struct InFlight {
+    uint64_t ticket = 0;
+    Clock::time_point submitted;
+    Clock::time_point started;
+  };
+
+  bool Start(const wchar_t* script, Clock::time_point submitted, Clock::time_point now);
+  void Pump(Clock::time_point now);
+  void ExpireInFlight(Clock::time_point now);
+  void RecordLatency(Clock::duration latency);
+
+  Options options_;
+  Executor executor_;
+
+  // Fixed ring of preallocated script slots
+  std::vector<Pending> queue_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+
+  std::vector<InFlight> in_flight_;
+  uint64_t next_ticket_ = 1;
+  bool pumping_ = false;
+  std::wstring start_buffer_;
+
+  std::vector<double> latency_ms_;
+  size_t latency_next_ = 0;
+  size_t latency_filled_ = 0;
+
+  Stats stats_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_SCRIPT_PIPELINE_H_
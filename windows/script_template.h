@@ -0,0 +1,188 @@
+#ifndef FLUTTER_PLUGIN_SCRIPT_TEMPLATE_H_
+#define FLUTTER_PLUGIN_SCRIPT_TEMPLATE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+
+#include "utf_transcoder.h"
+
+namespace hkcw_engine2 {
+
+// Script Templates: JavaScript snippets for native-to-page calls.
+//
+// A template is a wide literal with `{}` holes, split into segments at
+// compile time. Rendering copies the segments and formats each argument
+// into a fixed buffer, with no allocation and no stream. Text arguments are
+// always emitted as quoted, escaped JS string literals. An empty JS block
+// must be written `{ }` so it is not read as a hole.
+
+// UTF-8 text rendered as a single-quoted JS string literal
+struct JsString {
+  std::string_view text;
+};
+
+template <size_t Capacity>
+class ScriptBuffer {
+ public:
+  ScriptBuffer() { data_[0] = L'\0'; }
+
+  void Clear() {
+    length_ = 0;
+    overflowed_ = false;
+    data_[0] = L'\0';
+  }
+
+  void Append(const wchar_t* text, size_t length) {
+    if (length >= Capacity - length_) {
+      overflowed_ = true;
+      return;
+    }
+    std::copy(text, text + length, data_ + length_);
+    length_ += length;
+    data_[length_] = L'\0';
+  }
+
+  void AppendChar(wchar_t c) {
+    if (length_ + 1 >= Capacity) {
+      overflowed_ = true;
+      return;
+    }
+    data_[length_++] = c;
+    data_[length_] = L'\0';
+  }
+
+  void AppendValue(bool value) {
+    if (value) {
+      Append(L"true", 4);
+    } else {
+      Append(L"false", 5);
+    }
+  }
+
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T> &&
+                                                    !std::is_same_v<T, bool>>>
+  void AppendValue(T value) {
+    wchar_t digits[24];
+    size_t count = 0;
+    bool negative = value < 0;
+    // Negate in unsigned space so the minimum value does not overflow
+    uint64_t magnitude = negative ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    do {
+      digits[sizeof(digits) / sizeof(digits[0]) - 1 - count++] =
+          static_cast<wchar_t>(L'0' + magnitude % 10);
+      magnitude /= 10;
+    } while (magnitude != 0);
+    if (negative) {
+      digits[sizeof(digits) / sizeof(digits[0]) - 1 - count++] = L'-';
+    }
+    Append(digits + sizeof(digits) / sizeof(digits[0]) - count, count);
+  }
+
+  void AppendValue(JsString value) {
+    static const wchar_t kHex[] = L"0123456789ABCDEF";
+    AppendChar(L'\'');
+    for (size_t i = 0; i < value.text.size();) {
+      uint32_t code_point = 0;
+      i += DecodeUtf8CodePoint(value.text, i, code_point);
+      switch (code_point) {
+        case '\\': Append(L"\\\\", 2); continue;
+        case '\'': Append(L"\\'", 2); continue;
+        case '"': Append(L"\\\"", 2); continue;
+        case '\n': Append(L"\\n", 2); continue;
+        case '\r': Append(L"\\r", 2); continue;
+        case '\t': Append(L"\\t", 2); continue;
+        case '<': Append(L"\\x3C", 4); continue;  // Never closes a <script>
+      }
+      if (code_point >= 0x20 && code_point < 0x7F) {
+        AppendChar(static_cast<wchar_t>(code_point));
+        continue;
+      }
+      // Everything else as \uXXXX keeps the output ASCII and covers
+      // control characters and U+2028/U+2029 line separators
+      if (code_point >= 0x10000) {
+        code_point -= 0x10000;
+        AppendEscapedUnit(0xD800 + (code_point >> 10), kHex);
+        AppendEscapedUnit(0xDC00 + (code_point & 0x3FF), kHex);
+      } else {
+        AppendEscapedUnit(code_point, kHex);
+      }
+    }
+    AppendChar(L'\'');
+  }
+
+  const wchar_t* c_str() const { return data_; }
+  size_t length() const { return length_; }
+  bool overflowed() const { return overflowed_; }
+
+ private:
+  void AppendEscapedUnit(uint32_t unit, const wchar_t* hex) {
+    wchar_t escape[6] = {L'\\', L'u', hex[(unit >> 12) & 0xF], hex[(unit >> 8) & 0xF],
+                         hex[(unit >> 4) & 0xF], hex[unit & 0xF]};
+    Append(escape, 6);
+  }
+
+  wchar_t data_[Capacity];
+  size_t length_ = 0;
+  bool overflowed_ = false;
+};
+
+class ScriptTemplate {
+ public:
+  static const size_t kMaxHoles = 8;
+
+  template <size_t N>
+  constexpr ScriptTemplate(const wchar_t (&text)[N]) : text_(text) {
+    size_t start = 0;
+    for (size_t i = 0; i + 1 < N - 1; i++) {
+      if (text[i] == L'{' && text[i + 1] == L'}') {
+        // More than kMaxHoles holes fails constant evaluation here
+        begin_[holes_] = start;
+        end_[holes_] = i;
+        holes_++;
+        start = i + 2;
+        i++;
+      }
+    }
+    begin_[holes_] = start;
+    end_[holes_] = N - 1;
+  }
+
+  constexpr size_t holes() const { return holes_; }
+
+  // False if the argument count is wrong or the buffer is too small; the
+  // buffer must not be sent to the page in that case
+  template <size_t Capacity, typename... Args>
+  bool Render(ScriptBuffer<Capacity>& buffer, const Args&... args) const {
+    buffer.Clear();
+    if (sizeof...(Args) != holes_) return false;
+
+    size_t index = 0;
+    (RenderPiece(buffer, index++, args), ...);
+    AppendSegment(buffer, index);
+    return !buffer.overflowed();
+  }
+
+ private:
+  template <size_t Capacity, typename T>
+  void RenderPiece(ScriptBuffer<Capacity>& buffer, size_t index, const T& value) const {
+    AppendSegment(buffer, index);
+    buffer.AppendValue(value);
+  }
+
+  template <size_t Capacity>
+  void AppendSegment(ScriptBuffer<Capacity>& buffer, size_t index) const {
+    buffer.Append(text_ + begin_[index], end_[index] - begin_[index]);
+  }
+
+  const wchar_t* text_;
+  size_t begin_[kMaxHoles + 1] = {};
+  size_t end_[kMaxHoles + 1] = {};
+  size_t holes_ = 0;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_SCRIPT_TEMPLATE_H_
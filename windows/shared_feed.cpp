@@ -0,0 +1,233 @@
+#include "shared_feed.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#include <wrl.h>
+#include "utf_transcoder.h"
+#endif
+
+namespace hkcw_engine2 {
+
+namespace {
+
+// The page reads concurrently from another process: every store to a
+// header word is a single aligned 32-bit write
+inline void StoreWord(uint32_t* word, uint32_t value) {
+  *static_cast<volatile uint32_t*>(word) = value;
+}
+
+inline uint32_t LoadWord(const uint32_t* word) {
+  return *static_cast<const volatile uint32_t*>(word);
+}
+
+}  // namespace
+
+SharedFeed::SharedFeed(std::string name, std::unique_ptr<SharedFeedTransport> transport,
+                       Options options)
+    : name_(std::move(name)), transport_(std::move(transport)), options_(options) {
+  if (options_.slot_count < 2) options_.slot_count = 2;
+  // Keep every payload 16-byte aligned for Float32Array / Uint8Array views
+  options_.slot_size = (options_.slot_size + 15u) & ~15u;
+  stride_ = kSlotHeaderSize + options_.slot_size;
+}
+
+SharedFeed::~SharedFeed() {
+  Close();
+}
+
+uint32_t* SharedFeed::Word(size_t byte_offset) const {
+  return reinterpret_cast<uint32_t*>(base_ + byte_offset);
+}
+
+uint32_t* SharedFeed::SlotHeader(uint32_t slot) const {
+  return Word(kHeaderSize + slot * stride_);
+}
+
+bool SharedFeed::Open() {
+  if (base_) return true;
+  if (!transport_) return false;
+
+  buffer_size_ = kHeaderSize + options_.slot_count * stride_;
+  base_ = transport_->Create(buffer_size_);
+  if (!base_) {
+    std::cout << "[HKCW] [Feed] ERROR: Failed to create shared buffer for " << name_
+              << " (" << buffer_size_ << " bytes)" << std::endl;
+    buffer_size_ = 0;
+    return false;
+  }
+
+  std::memset(base_, 0, buffer_size_);
+  StoreWord(Word(4), kLayoutVersion);
+  StoreWord(Word(8), options_.slot_count);
+  StoreWord(Word(12), options_.slot_size);
+  StoreWord(Word(16), static_cast<uint32_t>(stride_));
+  std::atomic_thread_fence(std::memory_order_release);
+  StoreWord(Word(0), kMagic);  // Last: a page never sees a half-built header
+
+  std::cout << "[HKCW] [Feed] Opened " << name_ << ": " << options_.slot_count << " x "
+            << options_.slot_size << " bytes" << std::endl;
+  return Share();
+}
+
+bool SharedFeed::Share() {
+  if (!base_) return false;
+  return transport_->Share(InfoJson());
+}
+
+void SharedFeed::Close() {
+  if (!base_) return;
+  base_ = nullptr;
+  buffer_size_ = 0;
+  writing_ = false;
+  transport_->Close();
+}
+
+std::string SharedFeed::InfoJson() const {
+  // Feed names are plain identifiers (checked by the caller)
+  return "{\"type\":\"HKCW_FEED\",\"name\":\"" + name_ + "\",\"version\":" +
+         std::to_string(kLayoutVersion) + "}";
+}
+
+uint8_t* SharedFeed::BeginFrame(size_t& capacity) {
+  capacity = 0;
+  if (!base_) return nullptr;
+  if (writing_) AbortFrame();
+
+  // Next slot after the latest; the reader of the latest frame is untouched
+  writing_slot_ = sequence_ == 0 ? 0 : (LoadWord(Word(24)) + 1) % options_.slot_count;
+  uint32_t* slot = SlotHeader(writing_slot_);
+  StoreWord(&slot[0], LoadWord(&slot[0]) | 1u);  // Odd: being written
+  std::atomic_thread_fence(std::memory_order_release);
+
+  writing_ = true;
+  capacity = options_.slot_size;
+  return reinterpret_cast<uint8_t*>(slot) + kSlotHeaderSize;
+}
+
+void SharedFeed::AbortFrame() {
+  // Guard back to even with length 0: the slot holds no valid frame
+  uint32_t* slot = SlotHeader(writing_slot_);
+  StoreWord(&slot[2], 0);
+  std::atomic_thread_fence(std::memory_order_release);
+  StoreWord(&slot[0], LoadWord(&slot[0]) + 1u);
+  writing_ = false;
+}
+
+bool SharedFeed::CommitFrame(size_t length, uint32_t tag) {
+  if (!base_ || !writing_) return false;
+  if (length > options_.slot_size) {
+    dropped_++;
+    AbortFrame();
+    return false;
+  }
+
+  uint32_t* slot = SlotHeader(writing_slot_);
+  uint32_t sequence = sequence_ + 1 == 0 ? 1 : sequence_ + 1;  // 0 means "none"
+  StoreWord(&slot[1], sequence);
+  StoreWord(&slot[2], static_cast<uint32_t>(length));
+  StoreWord(&slot[3], tag);
+  std::atomic_thread_fence(std::memory_order_release);
+  StoreWord(&slot[0], LoadWord(&slot[0]) + 1u);  // Even: stable
+
+  StoreWord(Word(24), writing_slot_);
+  std::atomic_thread_fence(std::memory_order_release);
+  StoreWord(Word(20), sequence);
+  sequence_ = sequence;
+  writing_ = false;
+
+  if (options_.notify) {
+    notify_buffer_.assign("{\"type\":\"HKCW_FEED_FRAME\",\"name\":\"");
+    notify_buffer_.append(name_);
+    notify_buffer_.append("\",\"sequence\":");
+    notify_buffer_.append(std::to_string(sequence));
+    notify_buffer_.push_back('}');
+    transport_->NotifyFrame(notify_buffer_);
+  }
+  return true;
+}
+
+bool SharedFeed::Publish(const void* data, size_t length, uint32_t tag) {
+  size_t capacity = 0;
+  uint8_t* payload = BeginFrame(capacity);
+  if (!payload) return false;
+  if (length <= capacity && length > 0) {
+    std::memcpy(payload, data, length);
+  }
+  return CommitFrame(length, tag);
+}
+
+#ifdef _WIN32
+
+namespace {
+
+class WebViewFeedTransport : public SharedFeedTransport {
+ public:
+  WebViewFeedTransport(Microsoft::WRL::ComPtr<ICoreWebView2Environment12> environment,
+                       Microsoft::WRL::ComPtr<ICoreWebView2_17> webview)
+      : environment_(std::move(environment)), webview_(std::move(webview)) {}
+
+  ~WebViewFeedTransport() override { Close(); }
+
+  uint8_t* Create(size_t size) override {
+    Close();
+    HRESULT hr = environment_->CreateSharedBuffer(size, &buffer_);
+    if (FAILED(hr) || !buffer_) {
+      std::cout << "[HKCW] [Feed] CreateSharedBuffer failed: " << std::hex << hr << std::dec
+                << std::endl;
+      return nullptr;
+    }
+    BYTE* data = nullptr;
+    buffer_->get_Buffer(&data);
+    return data;
+  }
+
+  bool Share(const std::string& info_json) override {
+    if (!buffer_) return false;
+    std::wstring info = Utf8ToWide(info_json);
+    HRESULT hr = webview_->PostSharedBufferToScript(
+        buffer_.Get(), COREWEBVIEW2_SHARED_BUFFER_ACCESS_READ_ONLY, info.c_str());
+    return SUCCEEDED(hr);
+  }
+
+  void NotifyFrame(const std::string& message_json) override {
+    Utf8ToWide(message_json, notify_buffer_);
+    webview_->PostWebMessageAsJson(notify_buffer_.c_str());
+  }
+
+  void Close() override {
+    if (buffer_) {
+      buffer_->Close();  // Pages holding the ArrayBuffer see it detached
+      buffer_ = nullptr;
+    }
+  }
+
+ private:
+  Microsoft::WRL::ComPtr<ICoreWebView2Environment12> environment_;
+  Microsoft::WRL::ComPtr<ICoreWebView2_17> webview_;
+  Microsoft::WRL::ComPtr<ICoreWebView2SharedBuffer> buffer_;
+  std::wstring notify_buffer_;
+};
+
+}  // namespace
+
+std::unique_ptr<SharedFeedTransport> CreateWebViewFeedTransport(ICoreWebView2Environment* environment,
+                                                                ICoreWebView2* webview) {
+  if (!environment || !webview) return nullptr;
+
+  Microsoft::WRL::ComPtr<ICoreWebView2Environment12> environment12;
+  Microsoft::WRL::ComPtr<ICoreWebView2_17> webview17;
+  if (FAILED(environment->QueryInterface(IID_PPV_ARGS(&environment12))) ||
+      FAILED(webview->QueryInterface(IID_PPV_ARGS(&webview17)))) {
+    std::cout << "[HKCW] [Feed] Shared buffers need a newer WebView2 runtime" << std::endl;
+    return nullptr;
+  }
+  return std::make_unique<WebViewFeedTransport>(std::move(environment12), std::move(webview17));
+}
+
+#endif
+
+}  // namespace hkcw_engine2
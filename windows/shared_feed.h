@@ -0,0 +1,115 @@
+#ifndef FLUTTER_PLUGIN_SHARED_FEED_H_
+#define FLUTTER_PLUGIN_SHARED_FEED_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <WebView2.h>
+#endif
+
+namespace hkcw_engine2 {
+
+// Shared Feed: bulk native-to-page data (spectra, stats, tiles) without
+// serialization.
+//
+// A feed is one shared buffer holding a ring of fixed-size slots. The page
+// maps it as an ArrayBuffer and reads frames in place; native only posts a
+// tiny "frame ready" message carrying the sequence number. All fields are
+// little-endian uint32 so the page can read them through a Uint32Array:
+//
+//   header (64 bytes)
+//     [0] magic 'HKCF'  [1] layout version  [2] slot count  [3] slot capacity
+//     [4] slot stride   [5] latest sequence (0 = none yet)  [6] latest slot
+//   slot i at 64 + i * stride
+//     [0] guard (odd while being written)  [1] sequence  [2] length  [3] tag
+//     payload at +16, 16-byte aligned
+//
+// The guard is a per-slot seqlock: a reader that sees the same even guard
+// before and after copying got a consistent frame.
+class SharedFeedTransport {
+ public:
+  virtual ~SharedFeedTransport() = default;
+
+  // Allocate the shared region (zeroed); nullptr on failure
+  virtual uint8_t* Create(size_t size) = 0;
+  // Hand the region to the current page; info_json reaches the page as
+  // additionalData. Called again after every navigation.
+  virtual bool Share(const std::string& info_json) = 0;
+  virtual void NotifyFrame(const std::string& message_json) = 0;
+  virtual void Close() = 0;
+};
+
+class SharedFeed {
+ public:
+  static const uint32_t kMagic = 0x46434B48;  // "HKCF"
+  static const uint32_t kLayoutVersion = 1;
+  static const size_t kHeaderSize = 64;
+  static const size_t kSlotHeaderSize = 16;
+
+  struct Options {
+    uint32_t slot_count = 3;  // Reader lag tolerance, in frames
+    uint32_t slot_size = 64 * 1024;
+    bool notify = true;  // Post a message per frame (else the page polls)
+  };
+
+  SharedFeed(std::string name, std::unique_ptr<SharedFeedTransport> transport, Options options);
+  ~SharedFeed();
+
+  SharedFeed(const SharedFeed&) = delete;
+  SharedFeed& operator=(const SharedFeed&) = delete;
+
+  bool Open();
+  bool Share();  // Re-share after navigation
+  void Close();
+  bool is_open() const { return base_ != nullptr; }
+
+  // Zero-copy producer: write up to capacity bytes, then Commit. The slot
+  // is marked busy until Commit (or the next BeginFrame) so readers never
+  // trust a half-written frame.
+  uint8_t* BeginFrame(size_t& capacity);
+  bool CommitFrame(size_t length, uint32_t tag);
+
+  // Copying producer
+  bool Publish(const void* data, size_t length, uint32_t tag);
+
+  const std::string& name() const { return name_; }
+  uint32_t sequence() const { return sequence_; }
+  uint32_t slot_size() const { return options_.slot_size; }
+  size_t buffer_size() const { return buffer_size_; }
+  uint64_t dropped() const { return dropped_; }  // Frames larger than a slot
+
+ private:
+  uint32_t* Word(size_t byte_offset) const;
+  uint32_t* SlotHeader(uint32_t slot) const;
+  void AbortFrame();
+  std::string InfoJson() const;
+
+  std::string name_;
+  std::unique_ptr<SharedFeedTransport> transport_;
+  Options options_;
+
+  uint8_t* base_ = nullptr;
+  size_t buffer_size_ = 0;
+  size_t stride_ = 0;
+  uint32_t sequence_ = 0;
+  uint32_t writing_slot_ = 0;
+  bool writing_ = false;
+  uint64_t dropped_ = 0;
+  std::string notify_buffer_;
+};
+
+#ifdef _WIN32
+// WebView2 shared buffer (CreateSharedBuffer / PostSharedBufferToScript),
+// read-only for the page; frame messages via PostWebMessageAsJson.
+// nullptr if the runtime is too old for shared buffers.
+std::unique_ptr<SharedFeedTransport> CreateWebViewFeedTransport(ICoreWebView2Environment* environment,
+                                                                ICoreWebView2* webview);
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_SHARED_FEED_H_
@@ -0,0 +1,15 @@
+#ifndef FLUTTER_PLUGIN_SIMD_CONFIG_H_
+#define FLUTTER_PLUGIN_SIMD_CONFIG_H_
+
+// SSE2 is baseline on every x64 target (MSVC and GCC/Clang); 32-bit builds
+// only get it with /arch:SSE2 or -msse2. Other architectures use the scalar
+// paths.
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HKCW_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define HKCW_HAS_SSE2 0
+#endif
+
+#endif  // FLUTTER_PLUGIN_SIMD_CONFIG_H_
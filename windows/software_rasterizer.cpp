@@ -0,0 +1,237 @@
+#include "software_rasterizer.h"
+
+#include "simd_config.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const float kPi = 3.14159265358979f;
+const int kGradientSteps = 1024;
+
+bool StartsWith(std::string_view text, std::string_view prefix) {
+  return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool EndsWithIgnoreCase(std::string_view text, std::string_view suffix) {
+  if (text.size() < suffix.size()) return false;
+  for (size_t i = 0; i < suffix.size(); i++) {
+    char c = text[text.size() - suffix.size() + i];
+    if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    if (c != suffix[i]) return false;
+  }
+  return true;
+}
+
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+std::string PercentDecode(std::string_view text) {
+  std::string out;
+  out.reserve(text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    if (text[i] == '%' && i + 2 < text.size() && HexValue(text[i + 1]) >= 0 &&
+        HexValue(text[i + 2]) >= 0) {
+      out.push_back(static_cast<char>(HexValue(text[i + 1]) * 16 + HexValue(text[i + 2])));
+      i += 2;
+    } else {
+      out.push_back(text[i]);
+    }
+  }
+  return out;
+}
+
+inline uint32_t LerpColor(uint32_t a, uint32_t b, uint32_t weight) {
+  // weight in [0, 256]
+  uint32_t inverse = 256 - weight;
+  uint32_t rb = (((a & 0x00FF00FFu) * inverse + (b & 0x00FF00FFu) * weight) >> 8) & 0x00FF00FFu;
+  uint32_t ag = ((((a >> 8) & 0x00FF00FFu) * inverse + ((b >> 8) & 0x00FF00FFu) * weight) >> 8) & 0x00FF00FFu;
+  return rb | (ag << 8);
+}
+
+}  // namespace
+
+void Surface::Resize(int new_width, int new_height) {
+  width = (std::max)(new_width, 0);
+  height = (std::max)(new_height, 0);
+  pixels.resize(static_cast<size_t>(width) * static_cast<size_t>(height));
+}
+
+void Surface::Release() {
+  width = 0;
+  height = 0;
+  std::vector<uint32_t>().swap(pixels);
+}
+
+bool ParseColor(std::string_view text, uint32_t& color) {
+  if (!text.empty() && text[0] == '#') text.remove_prefix(1);
+  if (text.size() != 3 && text.size() != 6) return false;
+
+  uint32_t rgb = 0;
+  for (char c : text) {
+    int value = HexValue(c);
+    if (value < 0) return false;
+    rgb = rgb << 4 | static_cast<uint32_t>(value);
+    if (text.size() == 3) rgb = rgb << 4 | static_cast<uint32_t>(value);
+  }
+  color = 0xFF000000u | rgb;
+  return true;
+}
+
+bool ParseWallpaperDescriptor(std::string_view url, WallpaperDescriptor& descriptor) {
+  descriptor = WallpaperDescriptor();
+
+  if (StartsWith(url, "hkcw-color:")) {
+    if (!ParseColor(url.substr(11), descriptor.color)) return false;
+    descriptor.kind = WallpaperDescriptor::Kind::kColor;
+    return true;
+  }
+
+  if (StartsWith(url, "hkcw-gradient:")) {
+    std::string_view args = url.substr(14);
+    size_t first = args.find(',');
+    if (first == std::string_view::npos) return false;
+    size_t second = args.find(',', first + 1);
+
+    if (!ParseColor(args.substr(0, first), descriptor.color) ||
+        !ParseColor(args.substr(first + 1, second == std::string_view::npos
+                                               ? std::string_view::npos
+                                               : second - first - 1),
+                    descriptor.gradient_to)) {
+      return false;
+    }
+    if (second != std::string_view::npos) {
+      std::string angle(args.substr(second + 1));
+      descriptor.angle = std::strtof(angle.c_str(), nullptr);
+    }
+    descriptor.kind = WallpaperDescriptor::Kind::kGradient;
+    return true;
+  }
+
+  std::string_view path;
+  if (StartsWith(url, "hkcw-image:")) {
+    path = url.substr(11);
+  } else if (StartsWith(url, "file:///")) {
+    std::string_view file = url.substr(8);
+    std::string_view bare = file.substr(0, file.find_first_of("?#"));
+    if (!EndsWithIgnoreCase(bare, ".jpg") && !EndsWithIgnoreCase(bare, ".jpeg") &&
+        !EndsWithIgnoreCase(bare, ".png") && !EndsWithIgnoreCase(bare, ".bmp")) {
+      return false;
+    }
+    path = file;
+  } else {
+    return false;
+  }
+
+  size_t query = path.find('?');
+  if (query != std::string_view::npos) {
+    std::string_view options = path.substr(query + 1);
+    path = path.substr(0, query);
+    if (options.find("fit=contain") != std::string_view::npos) {
+      descriptor.fit = ImageFit::kContain;
+    } else if (options.find("fit=stretch") != std::string_view::npos) {
+      descriptor.fit = ImageFit::kStretch;
+    }
+  }
+  if (path.empty()) return false;
+
+  descriptor.image_path = PercentDecode(path);
+  descriptor.kind = WallpaperDescriptor::Kind::kImage;
+  return true;
+}
+
+void FillSolid(Surface& surface, uint32_t color) {
+  std::fill(surface.pixels.begin(), surface.pixels.end(), color);
+}
+
+void FillLinearGradient(Surface& surface, uint32_t from, uint32_t to, float angle_degrees) {
+  if (surface.width == 0 || surface.height == 0) return;
+
+  uint32_t lut[kGradientSteps];
+  for (int i = 0; i < kGradientSteps; i++) {
+    lut[i] = LerpColor(from, to, static_cast<uint32_t>(i * 256 / (kGradientSteps - 1)));
+  }
+
+  // CSS semantics: 0deg points up, 90deg right; the gradient line spans
+  // the box projected onto that direction
+  float radians = angle_degrees * kPi / 180.0f;
+  float dir_x = std::sin(radians);
+  float dir_y = -std::cos(radians);
+  float width = static_cast<float>(surface.width);
+  float height = static_cast<float>(surface.height);
+  float length = std::fabs(width * dir_x) + std::fabs(height * dir_y);
+  if (length <= 0.0f) length = 1.0f;
+
+  float scale = static_cast<float>(kGradientSteps - 1) / length;
+  float step = dir_x * scale;
+  for (int y = 0; y < surface.height; y++) {
+    float row = (static_cast<float>(y) + 0.5f - height * 0.5f) * dir_y;
+    float t = ((0.5f - width * 0.5f) * dir_x + row) * scale + static_cast<float>(kGradientSteps - 1) * 0.5f;
+    uint32_t* out = surface.Row(y);
+    for (int x = 0; x < surface.width; x++, t += step) {
+      int index = static_cast<int>(t + 0.5f);
+      index = index < 0 ? 0 : (index >= kGradientSteps ? kGradientSteps - 1 : index);
+      out[x] = lut[index];
+    }
+  }
+}
+
+bool FillDescriptor(const WallpaperDescriptor& descriptor, Surface& surface) {
+  switch (descriptor.kind) {
+    case WallpaperDescriptor::Kind::kColor:
+      FillSolid(surface, descriptor.color);
+      return true;
+
+    case WallpaperDescriptor::Kind::kGradient:
+      FillLinearGradient(surface, descriptor.color, descriptor.gradient_to, descriptor.angle);
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+void Crossfade(const Surface& from, const Surface& to, uint32_t alpha, Surface& out) {
+  if (from.width != to.width || from.height != to.height) {
+    out = to;
+    return;
+  }
+  out.Resize(to.width, to.height);
+  alpha = (std::min)(alpha, 256u);
+
+  size_t count = to.pixels.size();
+  const uint32_t* a = from.pixels.data();
+  const uint32_t* b = to.pixels.data();
+  uint32_t* dst = out.pixels.data();
+  size_t i = 0;
+
+#if HKCW_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i wb = _mm_set1_epi16(static_cast<short>(alpha));
+  const __m128i wa = _mm_set1_epi16(static_cast<short>(256 - alpha));
+  for (; i + 4 <= count; i += 4) {
+    __m128i pa = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i pb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(pa, zero), wa),
+                               _mm_mullo_epi16(_mm_unpacklo_epi8(pb, zero), wb));
+    __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(pa, zero), wa),
+                               _mm_mullo_epi16(_mm_unpackhi_epi8(pb, zero), wb));
+    __m128i result = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+#endif
+
+  for (; i < count; i++) {
+    dst[i] = LerpColor(a[i], b[i], alpha);
+  }
+}
+
+}  // namespace hkcw_engine2
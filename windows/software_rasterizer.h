@@ -0,0 +1,64 @@
+#ifndef FLUTTER_PLUGIN_SOFTWARE_RASTERIZER_H_
+#define FLUTTER_PLUGIN_SOFTWARE_RASTERIZER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// Native Renderer: 32-bit BGRA pixels, top-down rows (DIB layout)
+struct Surface {
+  int width = 0;
+  int height = 0;
+  std::vector<uint32_t> pixels;
+
+  void Resize(int new_width, int new_height);
+  void Release();
+  uint32_t* Row(int y) { return pixels.data() + static_cast<size_t>(y) * width; }
+  const uint32_t* Row(int y) const { return pixels.data() + static_cast<size_t>(y) * width; }
+};
+
+// Non-owning view of decoded BGRA pixels; stride is in pixels
+struct ImageView {
+  const uint32_t* pixels = nullptr;
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+};
+
+enum class ImageFit { kCover, kContain, kStretch };
+
+// Native Renderer: wallpapers that need no browser.
+//   hkcw-color:#1e90ff
+//   hkcw-gradient:#000000,#1e90ff[,angle]   (CSS angle, default 180 = top->bottom)
+//   hkcw-image:C:/path/photo.jpg[?fit=cover|contain|stretch]
+//   file:///C:/path/photo.jpg               (by image extension)
+struct WallpaperDescriptor {
+  enum class Kind { kNone, kColor, kGradient, kImage };
+
+  Kind kind = Kind::kNone;
+  uint32_t color = 0xFF000000;
+  uint32_t gradient_to = 0xFF000000;
+  float angle = 180.0f;
+  std::string image_path;
+  ImageFit fit = ImageFit::kCover;
+};
+
+bool ParseWallpaperDescriptor(std::string_view url, WallpaperDescriptor& descriptor);
+bool ParseColor(std::string_view text, uint32_t& color);
+
+void FillSolid(Surface& surface, uint32_t color);
+void FillLinearGradient(Surface& surface, uint32_t from, uint32_t to, float angle_degrees);
+
+// Color and gradient descriptors need no decoding; false for images
+bool FillDescriptor(const WallpaperDescriptor& descriptor, Surface& surface);
+
+// out = from * (256 - alpha) / 256 + to * alpha / 256, alpha in [0, 256]
+void Crossfade(const Surface& from, const Surface& to, uint32_t alpha, Surface& out);
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_SOFTWARE_RASTERIZER_H_
@@ -0,0 +1,540 @@
+#include "system_telemetry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#include <winternl.h>
+#include <winioctl.h>
+#include <ws2ipdef.h>
+#include <iphlpapi.h>
+#include <iostream>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const int64_t kMiB = 1024 * 1024;
+const double kKiB = 1024.0;
+
+// Counter delta that tolerates wrap/reset (reads as no activity)
+inline uint64_t Delta(uint64_t current, uint64_t previous) {
+  return current >= previous ? current - previous : 0;
+}
+
+inline int64_t Rate(uint64_t current, uint64_t previous, double seconds) {
+  return static_cast<int64_t>(std::llround(static_cast<double>(Delta(current, previous)) / kKiB / seconds));
+}
+
+inline int64_t Percent(uint64_t busy, uint64_t total) {
+  if (total == 0) return 0;
+  return static_cast<int64_t>(std::llround(100.0 * static_cast<double>(busy) / static_cast<double>(total)));
+}
+
+}  // namespace
+
+#ifndef _WIN32
+
+namespace {
+
+// Next unsigned number at or after p, advancing p past it
+uint64_t ParseNumber(const char*& p, const char* end) {
+  while (p < end && (*p < '0' || *p > '9')) {
+    if (*p == '\n') return 0;  // Never read into the next line
+    p++;
+  }
+  uint64_t value = 0;
+  while (p < end && *p >= '0' && *p <= '9') {
+    value = value * 10 + static_cast<uint64_t>(*p - '0');
+    p++;
+  }
+  return value;
+}
+
+inline const char* NextLine(const char* p, const char* end) {
+  const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+  return newline ? static_cast<const char*>(newline) + 1 : end;
+}
+
+class ProcTelemetrySource : public TelemetrySource {
+ public:
+  explicit ProcTelemetrySource(std::string root) : root_(std::move(root)) {
+    FindBatteries();
+  }
+
+  bool Read(TelemetryCounters& counters) override {
+    bool ok = ReadCpu(counters);
+    ReadMemory(counters);
+    ReadNetwork(counters);
+    ReadDisks(counters);
+    ReadBattery(counters);
+    return ok;
+  }
+
+ private:
+  // Whole file into buffer_ (procfs sizes are not known in advance)
+  bool Load(const std::string& path) {
+    buffer_.clear();
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    char chunk[4096];
+    ssize_t n;
+    while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+      buffer_.append(chunk, static_cast<size_t>(n));
+    }
+    close(fd);
+    return !buffer_.empty();
+  }
+
+  bool ReadCpu(TelemetryCounters& counters) {
+    if (!Load(root_ + "/proc/stat")) return false;
+    counters.cpu_busy.clear();
+    counters.cpu_total.clear();
+
+    // "cpuN user nice system idle iowait irq softirq steal ..." per core;
+    // the aggregate "cpu " line is recomputed from the cores
+    const char* p = buffer_.data();
+    const char* end = p + buffer_.size();
+    while (p < end) {
+      const char* line_end = NextLine(p, end);
+      if (line_end - p > 4 && std::memcmp(p, "cpu", 3) == 0 && p[3] >= '0' && p[3] <= '9') {
+        const char* q = p + 3;
+        ParseNumber(q, line_end);  // Core index
+        uint64_t fields[8] = {};
+        for (uint64_t& field : fields) field = ParseNumber(q, line_end);
+        uint64_t total = 0;
+        for (uint64_t field : fields) total += field;
+        uint64_t idle = fields[3] + fields[4];
+        counters.cpu_total.push_back(total);
+        counters.cpu_busy.push_back(total - idle);
+      }
+      p = line_end;
+    }
+    return !counters.cpu_total.empty();
+  }
+
+  void ReadMemory(TelemetryCounters& counters) {
+    if (!Load(root_ + "/proc/meminfo")) return;
+    const char* p = buffer_.data();
+    const char* end = p + buffer_.size();
+    int found = 0;
+    while (p < end && found < 2) {
+      const char* line_end = NextLine(p, end);
+      std::string_view line(p, static_cast<size_t>(line_end - p));
+      const char* q = p;
+      if (line.substr(0, 9) == "MemTotal:") {
+        counters.memory_total = ParseNumber(q, line_end) * 1024;
+        found++;
+      } else if (line.substr(0, 13) == "MemAvailable:") {
+        counters.memory_available = ParseNumber(q, line_end) * 1024;
+        found++;
+      }
+      p = line_end;
+    }
+  }
+
+  void ReadNetwork(TelemetryCounters& counters) {
+    counters.net_rx = 0;
+    counters.net_tx = 0;
+    if (!Load(root_ + "/proc/net/dev")) return;
+
+    // "  name: rx_bytes packets errs drop fifo frame compressed multicast tx_bytes ..."
+    const char* p = buffer_.data();
+    const char* end = p + buffer_.size();
+    while (p < end) {
+      const char* line_end = NextLine(p, end);
+      const void* colon = std::memchr(p, ':', static_cast<size_t>(line_end - p));
+      if (colon) {
+        const char* name = p;
+        while (name < line_end && *name == ' ') name++;
+        std::string_view interface_name(name, static_cast<size_t>(static_cast<const char*>(colon) - name));
+        if (interface_name != "lo") {
+          const char* q = static_cast<const char*>(colon) + 1;
+          uint64_t fields[9] = {};
+          for (uint64_t& field : fields) field = ParseNumber(q, line_end);
+          counters.net_rx += fields[0];
+          counters.net_tx += fields[8];
+        }
+      }
+      p = line_end;
+    }
+  }
+
+  void ReadDisks(TelemetryCounters& counters) {
+    counters.disk_read = 0;
+    counters.disk_write = 0;
+    if (!Load(root_ + "/proc/diskstats")) return;
+
+    // "major minor name reads merged sectors_read ms writes merged sectors_written ..."
+    // Sectors are always 512 bytes here. Partitions would count twice.
+    const char* p = buffer_.data();
+    const char* end = p + buffer_.size();
+    while (p < end) {
+      const char* line_end = NextLine(p, end);
+      const char* q = p;
+      ParseNumber(q, line_end);
+      ParseNumber(q, line_end);
+      while (q < line_end && *q == ' ') q++;
+      const char* name_end = q;
+      while (name_end < line_end && *name_end != ' ') name_end++;
+      std::string_view name(q, static_cast<size_t>(name_end - q));
+      if (!name.empty() && IsWholeDisk(name)) {
+        q = name_end;
+        uint64_t fields[7] = {};
+        for (uint64_t& field : fields) field = ParseNumber(q, line_end);
+        counters.disk_read += fields[2] * 512;
+        counters.disk_write += fields[6] * 512;
+      }
+      p = line_end;
+    }
+  }
+
+  // /sys/block lists whole disks only; virtual ones (loop, ram, zram, dm)
+  // repeat I/O already counted on a real disk
+  bool IsWholeDisk(std::string_view name) {
+    auto it = whole_disks_.find(std::string(name));
+    if (it != whole_disks_.end()) return it->second;
+
+    bool whole = false;
+    struct stat info;
+    std::string path = root_ + "/sys/block/" + std::string(name);
+    if (stat(path.c_str(), &info) == 0) {
+      whole = name.substr(0, 4) != "loop" && name.substr(0, 3) != "ram" &&
+              name.substr(0, 4) != "zram" && name.substr(0, 3) != "dm-";
+    }
+    whole_disks_.emplace(std::string(name), whole);
+    return whole;
+  }
+
+  void FindBatteries() {
+    std::string directory = root_ + "/sys/class/power_supply";
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return;
+    while (dirent* entry = readdir(dir)) {
+      if (entry->d_name[0] == '.') continue;
+      std::string supply = directory + "/" + entry->d_name;
+      if (Load(supply + "/type") && buffer_.compare(0, 7, "Battery") == 0) {
+        batteries_.push_back(supply);
+      }
+    }
+    closedir(dir);
+    std::sort(batteries_.begin(), batteries_.end());
+  }
+
+  void ReadBattery(TelemetryCounters& counters) {
+    counters.battery_percent = -1;
+    counters.charging = false;
+    if (batteries_.empty()) return;
+
+    // First battery; laptops with two report them separately
+    const std::string& battery = batteries_[0];
+    if (Load(battery + "/capacity")) {
+      const char* p = buffer_.data();
+      counters.battery_percent =
+          static_cast<int>((std::min)(ParseNumber(p, p + buffer_.size()), uint64_t{100}));
+    }
+    if (Load(battery + "/status")) {
+      counters.charging = buffer_.compare(0, 8, "Charging") == 0;
+    }
+  }
+
+  std::string root_;
+  std::string buffer_;
+  std::unordered_map<std::string, bool> whole_disks_;
+  std::vector<std::string> batteries_;
+};
+
+}  // namespace
+
+std::unique_ptr<TelemetrySource> CreateProcTelemetrySource(std::string root) {
+  return std::make_unique<ProcTelemetrySource>(std::move(root));
+}
+
+#else  // _WIN32
+
+namespace {
+
+typedef NTSTATUS(NTAPI* NtQuerySystemInformationFn)(SYSTEM_INFORMATION_CLASS, PVOID, ULONG, PULONG);
+
+// Interface rows are re-enumerated this often; in between only the cached
+// interfaces are queried
+const auto kInterfaceRefreshInterval = std::chrono::seconds(30);
+const int kMaxPhysicalDrives = 16;
+
+class WindowsTelemetrySource : public TelemetrySource {
+ public:
+  WindowsTelemetrySource() {
+    HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+    if (ntdll) {
+      query_ = reinterpret_cast<NtQuerySystemInformationFn>(
+          GetProcAddress(ntdll, "NtQuerySystemInformation"));
+    }
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    processors_.resize(info.dwNumberOfProcessors);
+    OpenDisks();
+  }
+
+  ~WindowsTelemetrySource() override {
+    for (HANDLE disk : disks_) CloseHandle(disk);
+  }
+
+  bool Read(TelemetryCounters& counters) override {
+    bool ok = ReadCpu(counters);
+    ReadMemory(counters);
+    ReadNetwork(counters);
+    ReadDisks(counters);
+    ReadBattery(counters);
+    return ok;
+  }
+
+ private:
+  bool ReadCpu(TelemetryCounters& counters) {
+    counters.cpu_busy.clear();
+    counters.cpu_total.clear();
+    if (!query_ || processors_.empty()) return false;
+
+    ULONG size = static_cast<ULONG>(processors_.size() * sizeof(processors_[0]));
+    ULONG returned = 0;
+    if (query_(SystemProcessorPerformanceInformation, processors_.data(), size, &returned) != 0) {
+      return false;
+    }
+
+    // Kernel time includes idle time; 100 ns ticks
+    size_t count = returned / sizeof(processors_[0]);
+    for (size_t i = 0; i < count; i++) {
+      uint64_t idle = static_cast<uint64_t>(processors_[i].IdleTime.QuadPart);
+      uint64_t total = static_cast<uint64_t>(processors_[i].KernelTime.QuadPart) +
+                       static_cast<uint64_t>(processors_[i].UserTime.QuadPart);
+      counters.cpu_total.push_back(total);
+      counters.cpu_busy.push_back(total >= idle ? total - idle : 0);
+    }
+    return count > 0;
+  }
+
+  void ReadMemory(TelemetryCounters& counters) {
+    MEMORYSTATUSEX status = {};
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) {
+      counters.memory_total = status.ullTotalPhys;
+      counters.memory_available = status.ullAvailPhys;
+    }
+  }
+
+  void ReadNetwork(TelemetryCounters& counters) {
+    auto now = std::chrono::steady_clock::now();
+    if (interfaces_.empty() || now - interfaces_refreshed_ >= kInterfaceRefreshInterval) {
+      RefreshInterfaces();
+      interfaces_refreshed_ = now;
+    }
+
+    counters.net_rx = 0;
+    counters.net_tx = 0;
+    for (const NET_LUID& luid : interfaces_) {
+      MIB_IF_ROW2 row = {};
+      row.InterfaceLuid = luid;
+      if (GetIfEntry2(&row) != NO_ERROR) continue;
+      counters.net_rx += row.InOctets;
+      counters.net_tx += row.OutOctets;
+    }
+  }
+
+  // Physical adapters only: filter and virtual interfaces repeat their traffic
+  void RefreshInterfaces() {
+    interfaces_.clear();
+    MIB_IF_TABLE2* table = nullptr;
+    if (GetIfTable2(&table) != NO_ERROR) return;
+    for (ULONG i = 0; i < table->NumEntries; i++) {
+      const MIB_IF_ROW2& row = table->Table[i];
+      if (row.Type == IF_TYPE_SOFTWARE_LOOPBACK || !row.InterfaceAndOperStatusFlags.HardwareInterface ||
+          row.InterfaceAndOperStatusFlags.FilterInterface) {
+        continue;
+      }
+      interfaces_.push_back(row.InterfaceLuid);
+    }
+    FreeMibTable(table);
+  }
+
+  // No access rights are needed for IOCTL_DISK_PERFORMANCE
+  void OpenDisks() {
+    for (int i = 0; i < kMaxPhysicalDrives; i++) {
+      std::wstring path = L"\\\\.\\PhysicalDrive" + std::to_wstring(i);
+      HANDLE disk = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                OPEN_EXISTING, 0, nullptr);
+      if (disk != INVALID_HANDLE_VALUE) disks_.push_back(disk);
+    }
+    std::cout << "[HKCW] [Telemetry] " << processors_.size() << " core(s), " << disks_.size()
+              << " disk(s)" << std::endl;
+  }
+
+  void ReadDisks(TelemetryCounters& counters) {
+    counters.disk_read = 0;
+    counters.disk_write = 0;
+    for (HANDLE disk : disks_) {
+      DISK_PERFORMANCE performance = {};
+      DWORD returned = 0;
+      if (DeviceIoControl(disk, IOCTL_DISK_PERFORMANCE, nullptr, 0, &performance,
+                          sizeof(performance), &returned, nullptr)) {
+        counters.disk_read += static_cast<uint64_t>(performance.BytesRead.QuadPart);
+        counters.disk_write += static_cast<uint64_t>(performance.BytesWritten.QuadPart);
+      }
+    }
+  }
+
+  void ReadBattery(TelemetryCounters& counters) {
+    counters.battery_percent = -1;
+    counters.charging = false;
+    SYSTEM_POWER_STATUS status;
+    if (!GetSystemPowerStatus(&status)) return;
+    // 128: no system battery, 255: unknown
+    if (status.BatteryFlag == 128 || status.BatteryFlag == 255 || status.BatteryLifePercent > 100) {
+      return;
+    }
+    counters.battery_percent = status.BatteryLifePercent;
+    counters.charging = (status.BatteryFlag & 8) != 0;
+  }
+
+  NtQuerySystemInformationFn query_ = nullptr;
+  std::vector<SYSTEM_PROCESSOR_PERFORMANCE_INFORMATION> processors_;
+  std::vector<NET_LUID> interfaces_;
+  std::chrono::steady_clock::time_point interfaces_refreshed_;
+  std::vector<HANDLE> disks_;
+};
+
+}  // namespace
+
+std::unique_ptr<TelemetrySource> CreateWindowsTelemetrySource() {
+  return std::make_unique<WindowsTelemetrySource>();
+}
+
+#endif  // _WIN32
+
+TelemetrySampler::TelemetrySampler(std::unique_ptr<TelemetrySource> source)
+    : source_(std::move(source)) {}
+
+void TelemetrySampler::Reset() {
+  primed_ = false;
+  keyframe_ = true;
+}
+
+bool TelemetrySampler::Sample(Clock::time_point now, std::string& message) {
+  message.clear();
+  if (!source_ || !source_->Read(current_)) return false;
+  stats_.samples++;
+
+  // Cores came or went: no rates this time, new keys next time
+  bool primed = primed_ && current_.cpu_total.size() == previous_.cpu_total.size();
+  double seconds = std::chrono::duration<double>(now - previous_time_).count();
+  if (primed && seconds > 0.0) Compute(seconds);
+
+  std::swap(current_, previous_);
+  previous_time_ = now;
+  primed_ = true;
+  if (!primed || seconds <= 0.0) return false;
+
+  Encode(message);
+  if (message.empty()) return false;
+  stats_.messages++;
+  stats_.bytes += message.size();
+  return true;
+}
+
+void TelemetrySampler::Compute(double seconds) {
+  const TelemetryCounters& now = current_;
+  const TelemetryCounters& before = previous_;
+  size_t cores = now.cpu_total.size();
+  if (keys_.size() != cores + 9) BuildKeys();
+  values_.resize(keys_.size());
+
+  uint64_t busy = 0;
+  uint64_t total = 0;
+  for (size_t i = 0; i < cores; i++) {
+    uint64_t core_busy = Delta(now.cpu_busy[i], before.cpu_busy[i]);
+    uint64_t core_total = Delta(now.cpu_total[i], before.cpu_total[i]);
+    values_[1 + i] = Percent(core_busy, core_total);
+    busy += core_busy;
+    total += core_total;
+  }
+  values_[0] = Percent(busy, total);
+
+  size_t i = 1 + cores;
+  uint64_t used = now.memory_total - (std::min)(now.memory_available, now.memory_total);
+  values_[i++] = static_cast<int64_t>(used) / kMiB;
+  values_[i++] = static_cast<int64_t>(now.memory_total) / kMiB;
+  values_[i++] = Rate(now.net_rx, before.net_rx, seconds);
+  values_[i++] = Rate(now.net_tx, before.net_tx, seconds);
+  values_[i++] = Rate(now.disk_read, before.disk_read, seconds);
+  values_[i++] = Rate(now.disk_write, before.disk_write, seconds);
+  values_[i++] = now.battery_percent;
+  values_[i++] = now.charging ? 1 : 0;
+}
+
+void TelemetrySampler::BuildKeys() {
+  keys_.clear();
+  keys_.push_back("cpu");
+  for (size_t i = 0; i < current_.cpu_total.size(); i++) {
+    keys_.push_back("cpu" + std::to_string(i));
+  }
+  for (const char* key : {"memUsed", "memTotal", "netRx", "netTx", "diskRead", "diskWrite",
+                          "battery", "charging"}) {
+    keys_.push_back(key);
+  }
+  keyframe_ = true;
+}
+
+void TelemetrySampler::Encode(std::string& message) {
+  bool keyframe = keyframe_ || sent_.size() != values_.size();
+  message.assign("{\"type\":\"HKCW_TELEMETRY\",\"seq\":");
+  message.append(std::to_string(sequence_ + 1));
+
+  if (keyframe) {
+    message.append(",\"keys\":[");
+    for (size_t i = 0; i < keys_.size(); i++) {
+      if (i > 0) message.push_back(',');
+      message.push_back('"');
+      message.append(keys_[i]);  // Plain identifiers, nothing to escape
+      message.push_back('"');
+    }
+    message.append("],\"values\":[");
+    for (size_t i = 0; i < values_.size(); i++) {
+      if (i > 0) message.push_back(',');
+      message.append(std::to_string(values_[i]));
+    }
+    message.append("]}");
+  } else {
+    message.append(",\"d\":[");
+    bool any = false;
+    for (size_t i = 0; i < values_.size(); i++) {
+      if (values_[i] == sent_[i]) continue;
+      if (any) message.push_back(',');
+      message.append(std::to_string(i));
+      message.push_back(',');
+      message.append(std::to_string(values_[i]));
+      any = true;
+    }
+    if (!any) {
+      message.clear();
+      return;
+    }
+    message.append("]}");
+  }
+
+  sent_ = values_;
+  keyframe_ = false;
+  sequence_++;
+}
+
+}  // namespace hkcw_engine2
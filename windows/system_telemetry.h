@@ -0,0 +1,103 @@
+#ifndef FLUTTER_PLUGIN_SYSTEM_TELEMETRY_H_
+#define FLUTTER_PLUGIN_SYSTEM_TELEMETRY_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// System Telemetry: raw counters as the OS reports them. Cumulative
+// counters only ever grow (a reset reads as a zero rate); vectors are
+// reused between reads.
+struct TelemetryCounters {
+  std::vector<uint64_t> cpu_busy;   // Per core, cumulative ticks
+  std::vector<uint64_t> cpu_total;  // Per core, cumulative ticks
+  uint64_t memory_total = 0;        // Bytes
+  uint64_t memory_available = 0;    // Bytes
+  uint64_t net_rx = 0;              // Cumulative bytes, loopback excluded
+  uint64_t net_tx = 0;
+  uint64_t disk_read = 0;           // Cumulative bytes, whole disks only
+  uint64_t disk_write = 0;
+  int battery_percent = -1;         // -1 = no battery
+  bool charging = false;
+};
+
+class TelemetrySource {
+ public:
+  virtual ~TelemetrySource() = default;
+
+  // Fields a platform cannot read are left at their defaults
+  virtual bool Read(TelemetryCounters& counters) = 0;
+};
+
+#ifndef _WIN32
+// /proc and /sys under root ("" = the live system); lets the sampler be
+// tested and benchmarked on Linux, including against fixture trees
+std::unique_ptr<TelemetrySource> CreateProcTelemetrySource(std::string root = "");
+#else
+// NtQuerySystemInformation, GlobalMemoryStatusEx, GetIfEntry2,
+// IOCTL_DISK_PERFORMANCE and GetSystemPowerStatus
+std::unique_ptr<TelemetrySource> CreateWindowsTelemetrySource();
+#endif
+
+// System Telemetry: counters to page-ready values, sent as deltas.
+//
+// Every field is an integer so unchanged values compare exactly:
+//   cpu, cpu0..cpuN-1   busy %        memUsed, memTotal   MiB
+//   netRx, netTx        KiB/s         diskRead, diskWrite KiB/s
+//   battery             % (-1: none)  charging            0/1
+// A keyframe carries the key list and every value:
+//   {"type":"HKCW_TELEMETRY","seq":1,"keys":["cpu",...],"values":[12,...]}
+// later messages only the fields that changed, as index/value pairs:
+//   {"type":"HKCW_TELEMETRY","seq":2,"d":[0,15,9,2048]}
+// and nothing at all when no field changed.
+class TelemetrySampler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Stats {
+    uint64_t samples = 0;
+    uint64_t messages = 0;
+    uint64_t bytes = 0;  // Message JSON
+  };
+
+  explicit TelemetrySampler(std::unique_ptr<TelemetrySource> source);
+
+  // Reads the source; true with a message when there is something to send.
+  // The first sample after construction or Reset only primes the rates.
+  bool Sample(Clock::time_point now, std::string& message);
+
+  void RequestKeyframe() { keyframe_ = true; }
+  // Forget previous counters (sampling paused): rates restart from scratch
+  void Reset();
+
+  const std::vector<std::string>& keys() const { return keys_; }
+  const std::vector<int64_t>& values() const { return values_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  void Compute(double seconds);
+  void BuildKeys();
+  void Encode(std::string& message);
+
+  std::unique_ptr<TelemetrySource> source_;
+  TelemetryCounters current_;
+  TelemetryCounters previous_;
+  Clock::time_point previous_time_;
+  bool primed_ = false;
+  bool keyframe_ = true;
+  uint64_t sequence_ = 0;
+
+  std::vector<std::string> keys_;
+  std::vector<int64_t> values_;  // Latest computed
+  std::vector<int64_t> sent_;    // As the page has them
+  Stats stats_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_SYSTEM_TELEMETRY_H_
@@ -0,0 +1,65 @@
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace hkcw_test {
+
+namespace {
+
+thread_local size_t t_allocations = 0;
+
+void* Allocate(size_t size) {
+  t_allocations++;
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* AllocateAligned(size_t size, std::align_val_t alignment) {
+  t_allocations++;
+  size_t align = static_cast<size_t>(alignment);
+  void* memory = std::aligned_alloc(align, (size + align - 1) / align * align);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+}  // namespace
+
+size_t AllocationCount() {
+  return t_allocations;
+}
+
+}  // namespace hkcw_test
+
+void* operator new(size_t size) { return hkcw_test::Allocate(size); }
+void* operator new[](size_t size) { return hkcw_test::Allocate(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return hkcw_test::Allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+  try {
+    return hkcw_test::Allocate(size);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void* operator new(size_t size, std::align_val_t alignment) {
+  return hkcw_test::AllocateAligned(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+  return hkcw_test::AllocateAligned(size, alignment);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept { std::free(memory); }
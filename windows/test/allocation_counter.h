@@ -0,0 +1,15 @@
+#ifndef HKCW_TEST_ALLOCATION_COUNTER_H_
+#define HKCW_TEST_ALLOCATION_COUNTER_H_
+
+#include <cstddef>
+
+namespace hkcw_test {
+
+// Global operator new is replaced in this binary; this counts the calls
+// made on the current thread (worker threads under test do not leak into
+// the count)
+size_t AllocationCount();
+
+}  // namespace hkcw_test
+
+#endif  // HKCW_TEST_ALLOCATION_COUNTER_H_
@@ -0,0 +1,188 @@
+// Audio Spectrum on synthetic PCM: FFT accuracy, band placement, pacing
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <vector>
+
+#include "audio_spectrum.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const uint32_t kRate = 48000;
+
+// Interleaved stereo, the same tone on both channels
+std::vector<float> Sine(double hz, float amplitude, double seconds, uint32_t channels = 2) {
+  size_t frames = static_cast<size_t>(seconds * kRate);
+  std::vector<float> pcm(frames * channels);
+  for (size_t f = 0; f < frames; f++) {
+    float value = amplitude * static_cast<float>(std::sin(2.0 * kPi * hz * static_cast<double>(f) / kRate));
+    for (uint32_t c = 0; c < channels; c++) pcm[f * channels + c] = value;
+  }
+  return pcm;
+}
+
+// Band the analyzer assigns to hz with the default options
+size_t BandOf(double hz, const SpectrumAnalyzer::Options& options) {
+  double position = std::log(hz / options.min_frequency) /
+                    std::log(static_cast<double>(options.max_frequency) / options.min_frequency);
+  return static_cast<size_t>(position * static_cast<double>(options.band_count));
+}
+
+size_t Loudest(const std::vector<float>& bands) {
+  size_t best = 0;
+  for (size_t b = 1; b < bands.size(); b++) {
+    if (bands[b] > bands[best]) best = b;
+  }
+  return best;
+}
+
+}  // namespace
+
+HKCW_TEST(audio_spectrum_fft_matches_dft) {
+  for (size_t n : {4, 8, 64, 1024}) {
+    Fft fft(n);
+    std::vector<float> re(n), im(n);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < n; i++) {
+      seed = seed * 1664525u + 1013904223u;
+      re[i] = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+      seed = seed * 1664525u + 1013904223u;
+      im[i] = static_cast<float>(seed >> 8) / 16777216.0f - 0.5f;
+    }
+    std::vector<std::complex<double>> expected(n);
+    for (size_t k = 0; k < n; k++) {
+      for (size_t t = 0; t < n; t++) {
+        double angle = -2.0 * kPi * static_cast<double>(k * t % n) / static_cast<double>(n);
+        expected[k] += std::complex<double>(re[t], im[t]) * std::polar(1.0, angle);
+      }
+    }
+
+    fft.Forward(re.data(), im.data());
+    double worst = 0.0;
+    for (size_t k = 0; k < n; k++) {
+      worst = (std::max)(worst, std::abs(expected[k] - std::complex<double>(re[k], im[k])));
+    }
+    EXPECT(worst < 1e-3 * std::sqrt(static_cast<double>(n)));
+  }
+}
+
+HKCW_TEST(audio_spectrum_places_tones_in_their_band) {
+  SpectrumAnalyzer::Options options;
+  options.release = 0.0f;
+  // Bin-centred tones (48000 / 1024 = 46.875 Hz per bin); below ~300 Hz
+  // a bin spans several bands, so those are not asserted
+  for (double hz : {375.0, 1031.25, 4968.75}) {
+    SpectrumAnalyzer analyzer(options);
+    std::vector<float> pcm = Sine(hz, 1.0f, 0.5);
+    analyzer.Push(pcm.data(), pcm.size() / 2, 2, kRate, nullptr);
+
+    const std::vector<float>& bands = analyzer.frame().bands;
+    size_t loudest = Loudest(bands);
+    size_t expected = BandOf(hz, options);
+    EXPECT(loudest + 1 >= expected && loudest <= expected + 1);
+    EXPECT(bands[loudest] > 0.85f);  // Wide bands average in quieter bins
+    // Two octaves away is below the floor
+    EXPECT_EQ(bands[BandOf(hz / 4, options)], 0.0f);
+    EXPECT_EQ(bands[BandOf(hz * 3, options)], 0.0f);
+  }
+}
+
+HKCW_TEST(audio_spectrum_level_follows_amplitude) {
+  SpectrumAnalyzer::Options options;
+  options.release = 0.0f;
+
+  float previous = 2.0f;
+  for (float amplitude : {1.0f, 0.1f, 0.01f}) {
+    SpectrumAnalyzer analyzer(options);
+    std::vector<float> pcm = Sine(1000.0, amplitude, 0.25);
+    analyzer.Push(pcm.data(), pcm.size() / 2, 2, kRate, nullptr);
+    float level = analyzer.frame().bands[Loudest(analyzer.frame().bands)];
+    // 20 dB less is 20/70 of the range lower
+    if (previous <= 1.0f) EXPECT(std::fabs((previous - level) - 20.0f / 70.0f) < 0.05f);
+    previous = level;
+
+    EXPECT(std::fabs(analyzer.frame().rms - amplitude / std::sqrt(2.0f)) < amplitude * 0.02f);
+    EXPECT(analyzer.frame().peak <= amplitude && analyzer.frame().peak > amplitude * 0.99f);
+  }
+}
+
+HKCW_TEST(audio_spectrum_silence_is_zero) {
+  SpectrumAnalyzer analyzer{SpectrumAnalyzer::Options()};
+  std::vector<float> pcm(kRate * 2, 0.0f);
+  size_t frames = 0;
+  analyzer.Push(pcm.data(), kRate, 2, kRate, [&frames](const SpectrumFrame&) { frames++; });
+  EXPECT_EQ(frames, size_t{60});
+  for (float level : analyzer.frame().bands) EXPECT_EQ(level, 0.0f);
+  EXPECT_EQ(analyzer.frame().rms, 0.0f);
+}
+
+HKCW_TEST(audio_spectrum_paces_by_sample_count) {
+  std::vector<float> pcm = Sine(440.0, 0.5f, 1.0);
+  size_t total = pcm.size() / 2;
+
+  // One push, 10 ms capture packets, and odd-sized chunks give the same frames
+  std::vector<std::vector<float>> runs;
+  for (size_t chunk : {total, size_t{480}, size_t{37}}) {
+    SpectrumAnalyzer analyzer{SpectrumAnalyzer::Options()};
+    std::vector<float> last_bands;
+    size_t frames = 0;
+    for (size_t offset = 0; offset < total; offset += chunk) {
+      size_t count = (std::min)(chunk, total - offset);
+      analyzer.Push(pcm.data() + offset * 2, count, 2, kRate, [&](const SpectrumFrame& frame) {
+        frames++;
+        EXPECT_EQ(frame.index, uint64_t{frames});
+        last_bands = frame.bands;
+      });
+    }
+    EXPECT_EQ(frames, size_t{60});
+    runs.push_back(last_bands);
+  }
+  EXPECT(runs[0] == runs[1]);
+  EXPECT(runs[0] == runs[2]);
+}
+
+HKCW_TEST(audio_spectrum_releases_exponentially) {
+  SpectrumAnalyzer::Options options;
+  SpectrumAnalyzer analyzer(options);
+  std::vector<float> tone = Sine(1000.0, 1.0f, 0.5);
+  analyzer.Push(tone.data(), tone.size() / 2, 2, kRate, nullptr);
+  size_t band = Loudest(analyzer.frame().bands);
+  float level = analyzer.frame().bands[band];
+
+  // The window still holds the tone for the first frames; after that the
+  // band falls by the release factor each frame
+  std::vector<float> silence(kRate / 60 * 2 * 4, 0.0f);
+  analyzer.Push(silence.data(), silence.size() / 2, 2, kRate, nullptr);
+  std::vector<float> levels;
+  std::vector<float> frame(kRate / 60 * 2, 0.0f);
+  for (int i = 0; i < 5; i++) {
+    analyzer.Push(frame.data(), frame.size() / 2, 2, kRate, nullptr);
+    levels.push_back(analyzer.frame().bands[band]);
+  }
+  EXPECT(level > 0.9f);
+  for (size_t i = 1; i < levels.size(); i++) {
+    EXPECT(std::fabs(levels[i] - levels[i - 1] * options.release) < 1e-5f);
+  }
+
+  analyzer.Reset();
+  EXPECT_EQ(analyzer.frame().bands[band], 0.0f);
+}
+
+HKCW_TEST(audio_spectrum_mixes_channels_to_mono) {
+  SpectrumAnalyzer::Options options;
+  options.release = 0.0f;
+  SpectrumAnalyzer analyzer(options);
+
+  // Opposite phase on left and right cancels
+  std::vector<float> pcm = Sine(1000.0, 1.0f, 0.25);
+  for (size_t f = 0; f < pcm.size() / 2; f++) pcm[f * 2 + 1] = -pcm[f * 2];
+  analyzer.Push(pcm.data(), pcm.size() / 2, 2, kRate, nullptr);
+  EXPECT_EQ(analyzer.frame().peak, 0.0f);
+  EXPECT_EQ(analyzer.frame().bands[BandOf(1000.0, options)], 0.0f);
+}
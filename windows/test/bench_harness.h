@@ -0,0 +1,68 @@
+#ifndef HKCW_BENCH_HARNESS_H_
+#define HKCW_BENCH_HARNESS_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+
+namespace hkcw_bench {
+
+using BenchFunction = void (*)();
+
+// Registers a benchmark during static initialization
+struct Registration {
+  Registration(const char* name, BenchFunction function);
+};
+
+// --quick (what ctest runs): each body runs once, so benchmarks keep
+// building and running without costing test time
+bool Quick();
+
+// Prints one result line
+void Report(const char* label, double ns_per_op);
+
+// Keeps a result observable so the work producing it is not optimized out
+void Consume(uint64_t value);
+
+// Silences the modules' std::cout logging inside a timed body
+class MuteLog {
+ public:
+  MuteLog() { std::cout.setstate(std::ios::failbit); }
+  ~MuteLog() { std::cout.clear(); }
+};
+
+// Runs body, which performs ops operations, until enough time has passed
+// for a stable figure; reports and returns nanoseconds per operation
+template <typename Body>
+double Measure(const char* label, size_t ops, Body&& body) {
+  using Clock = std::chrono::steady_clock;
+  body();  // Warm caches and buffers
+
+  const auto min_time = std::chrono::milliseconds(Quick() ? 0 : 300);
+  size_t iterations = 0;
+  size_t batch = 1;
+  auto start = Clock::now();
+  Clock::duration elapsed{};
+  do {
+    for (size_t i = 0; i < batch; i++) body();
+    iterations += batch;
+    batch *= 2;
+    elapsed = Clock::now() - start;
+  } while (elapsed < min_time);
+
+  double ns = std::chrono::duration<double, std::nano>(elapsed).count() /
+              static_cast<double>(iterations * (ops ? ops : 1));
+  Report(label, ns);
+  return ns;
+}
+
+}  // namespace hkcw_bench
+
+// Benchmark names are suite_case, like tests
+#define HKCW_BENCH(name)                                                  \
+  static void name();                                                     \
+  static const hkcw_bench::Registration name##_registration(#name, name); \
+  static void name()
+
+#endif  // HKCW_BENCH_HARNESS_H_
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "bench_harness.h"
+
+namespace hkcw_bench {
+
+namespace {
+
+struct Bench {
+  const char* name;
+  BenchFunction function;
+};
+
+std::vector<Bench>& Benches() {
+  static std::vector<Bench> benches;
+  return benches;
+}
+
+bool g_quick = false;
+volatile uint64_t g_sink = 0;
+
+}  // namespace
+
+Registration::Registration(const char* name, BenchFunction function) {
+  Benches().push_back({name, function});
+}
+
+bool Quick() { return g_quick; }
+
+void Report(const char* label, double ns_per_op) {
+  char line[160];
+  if (ns_per_op >= 1e6) {
+    std::snprintf(line, sizeof(line), "  %-48s %10.2f ms/op", label, ns_per_op / 1e6);
+  } else if (ns_per_op >= 1e3) {
+    std::snprintf(line, sizeof(line), "  %-48s %10.2f us/op", label, ns_per_op / 1e3);
+  } else {
+    std::snprintf(line, sizeof(line), "  %-48s %10.1f ns/op", label, ns_per_op);
+  }
+  std::cout << line << std::endl;
+}
+
+void Consume(uint64_t value) { g_sink = g_sink + value; }
+
+}  // namespace hkcw_bench
+
+// Usage: hkcw_engine2_bench [--quick] [name prefix]
+// Build optimized (the default build type here is Release) for real figures
+int main(int argc, char** argv) {
+  const char* prefix = "";
+  for (int i = 1; i < argc; i++) {
+    if (std::strcmp(argv[i], "--quick") == 0) {
+      hkcw_bench::g_quick = true;
+    } else {
+      prefix = argv[i];
+    }
+  }
+
+  size_t run = 0;
+  for (const auto& bench : hkcw_bench::Benches()) {
+    if (std::strncmp(bench.name, prefix, std::strlen(prefix)) != 0) continue;
+    std::cout << bench.name << std::endl;
+    bench.function();
+    run++;
+  }
+  std::cout << run << " benchmark(s)" << std::endl;
+  return run == 0 ? 1 : 0;
+}
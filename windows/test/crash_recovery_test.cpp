@@ -0,0 +1,191 @@
+// Crash Recovery: escalation, backoff and the crash-loop fallback, with
+// the plugin's hooks replaced by recorders
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "crash_recovery.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using State = CrashRecovery::State;
+
+namespace {
+
+// What the plugin would have done, in order: "reload", "rebuild",
+// "static" and "wait <ms>"
+struct Recorder {
+  std::vector<std::string> calls;
+  bool reload_starts = true;
+  bool rebuild_starts = true;
+
+  CrashRecovery::Hooks Hooks() {
+    CrashRecovery::Hooks hooks;
+    hooks.reload = [this] {
+      calls.push_back("reload");
+      return reload_starts;
+    };
+    hooks.rebuild_controller = [this] {
+      calls.push_back("rebuild");
+      return rebuild_starts;
+    };
+    hooks.show_static_frame = [this] { calls.push_back("static"); };
+    hooks.schedule = [this](uint32_t delay_ms) { calls.push_back("wait " + std::to_string(delay_ms)); };
+    return hooks;
+  }
+
+  std::string Take() {
+    std::string joined;
+    for (const std::string& call : calls) {
+      if (!joined.empty()) joined += ", ";
+      joined += call;
+    }
+    calls.clear();
+    return joined;
+  }
+};
+
+}  // namespace
+
+HKCW_TEST(crash_recovery_reloads_renderer_at_once) {
+  Recorder recorder;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+
+  EXPECT(recovery.OnFailure(ProcessFailure::kRendererExited, 1000) == RecoveryAction::kReload);
+  EXPECT(recovery.state() == State::kWaiting);
+  EXPECT(recorder.Take() == "wait 0");
+
+  recovery.OnTimer(1000);
+  EXPECT(recovery.state() == State::kRecovering);
+  EXPECT(recorder.Take() == "reload, wait 10000");
+
+  recovery.OnRestored(1400);
+  EXPECT(recovery.state() == State::kHealthy);
+  EXPECT(recovery.pending() == RecoveryAction::kNone);
+  EXPECT_EQ(recovery.stats().restored, uint64_t{1});
+  EXPECT_EQ(recovery.stats().last_restore_ms, uint64_t{400});
+
+  // Only the first load after a failure counts as restored
+  recovery.OnRestored(2000);
+  EXPECT_EQ(recovery.stats().restored, uint64_t{1});
+  recovery.OnTimer(11000);  // The restore timeout, now stale
+  EXPECT(recovery.state() == State::kHealthy);
+}
+
+HKCW_TEST(crash_recovery_rebuilds_for_browser) {
+  Recorder recorder;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+  EXPECT(recovery.OnFailure(ProcessFailure::kBrowserExited, 0) == RecoveryAction::kRebuildController);
+  recovery.OnTimer(0);
+  EXPECT(recorder.Take() == "wait 0, rebuild, wait 10000");
+  EXPECT_EQ(recovery.stats().reloads, uint64_t{0});
+  EXPECT_EQ(recovery.stats().rebuilds, uint64_t{1});
+
+  // A reload that cannot start falls through to a rebuild
+  recovery.OnRestored(100);
+  recorder.reload_starts = false;
+  recovery.OnFailure(ProcessFailure::kRendererUnresponsive, 100000);
+  recovery.OnTimer(100000);
+  EXPECT(recorder.Take() == "wait 0, reload, rebuild, wait 10000");
+  EXPECT(recovery.state() == State::kRecovering);
+}
+
+HKCW_TEST(crash_recovery_ignores_other_processes) {
+  Recorder recorder;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+  EXPECT(recovery.OnFailure(ProcessFailure::kOther, 0) == RecoveryAction::kNone);
+  EXPECT(recovery.state() == State::kHealthy);
+  EXPECT(recorder.Take().empty());
+  EXPECT_EQ(recovery.stats().ignored, uint64_t{1});
+  EXPECT_EQ(recovery.stats().failures, uint64_t{0});
+}
+
+HKCW_TEST(crash_recovery_escalates_and_backs_off) {
+  Recorder recorder;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+  recovery.OnFailure(ProcessFailure::kRendererExited, 1000);
+  recovery.OnTimer(1000);
+  recorder.Take();
+
+  // The renderer dies again while the reload brings it back: rebuild,
+  // after the backoff
+  EXPECT(recovery.OnFailure(ProcessFailure::kRendererExited, 1500) == RecoveryAction::kRebuildController);
+  EXPECT(recorder.Take() == "wait 250");
+  recovery.OnTimer(1600);  // Early timer: waits out the rest
+  EXPECT(recorder.Take() == "wait 150");
+  recovery.OnTimer(1750);
+  EXPECT(recorder.Take() == "rebuild, wait 10000");
+
+  // The incident started at the first failure
+  recovery.OnRestored(2000);
+  EXPECT_EQ(recovery.stats().last_restore_ms, uint64_t{1000});
+
+  // A failure during a wait keeps the stronger action
+  recovery.OnFailure(ProcessFailure::kBrowserExited, 3000);
+  EXPECT(recovery.OnFailure(ProcessFailure::kRendererExited, 3001) == RecoveryAction::kRebuildController);
+  EXPECT(recorder.Take() == "wait 500, wait 1000");
+}
+
+HKCW_TEST(crash_recovery_restore_timeout_rebuilds) {
+  Recorder recorder;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+  recovery.OnFailure(ProcessFailure::kRendererExited, 1000);
+  recovery.OnTimer(1000);
+  recorder.Take();
+
+  // The reloaded page never finished loading
+  recovery.OnTimer(11000);
+  EXPECT(recovery.state() == State::kWaiting);
+  EXPECT(recovery.pending() == RecoveryAction::kRebuildController);
+  EXPECT(recorder.Take() == "wait 250");
+  EXPECT_EQ(recovery.stats().failures, uint64_t{2});
+}
+
+HKCW_TEST(crash_recovery_crash_loop_shows_static_frame) {
+  Recorder recorder;
+  recorder.reload_starts = false;
+  recorder.rebuild_starts = false;
+  CrashRecovery recovery(recorder.Hooks(), CrashRecovery::Options());
+
+  // Nothing starts: every attempt is another failure, until the limit
+  recovery.OnFailure(ProcessFailure::kRendererExited, 0);
+  uint64_t now = 0;
+  for (int i = 0; i < 10 && recovery.state() == State::kWaiting; i++) {
+    recovery.OnTimer(now);
+    now += 1000;
+  }
+  EXPECT(recovery.state() == State::kStaticFrame);
+  EXPECT(recovery.pending() == RecoveryAction::kStaticFrame);
+  EXPECT(recorder.Take() ==
+         "wait 0, reload, rebuild, wait 250, rebuild, wait 500, rebuild, wait 1000, rebuild, static");
+  EXPECT_EQ(recovery.stats().failures, uint64_t{5});
+  EXPECT_EQ(recovery.stats().static_frames, uint64_t{1});
+
+  // Left alone until the next wallpaper
+  EXPECT(recovery.OnFailure(ProcessFailure::kBrowserExited, now) == RecoveryAction::kNone);
+  EXPECT_EQ(recovery.stats().ignored, uint64_t{1});
+  recovery.Reset();
+  recorder.reload_starts = true;
+  EXPECT(recovery.OnFailure(ProcessFailure::kRendererExited, now) == RecoveryAction::kReload);
+  EXPECT(recorder.Take() == "wait 0");
+}
+
+HKCW_TEST(crash_recovery_forgets_old_failures) {
+  Recorder recorder;
+  CrashRecovery::Options options;
+  CrashRecovery recovery(recorder.Hooks(), options);
+
+  // Failures further apart than the window never back off or loop
+  uint64_t now = 0;
+  for (int i = 0; i < 8; i++) {
+    EXPECT(recovery.OnFailure(ProcessFailure::kRendererExited, now) == RecoveryAction::kReload);
+    recovery.OnTimer(now);
+    recovery.OnRestored(now + 100);
+    now += options.loop_window_ms;
+  }
+  EXPECT(recovery.state() == State::kHealthy);
+  EXPECT_EQ(recovery.stats().reloads, uint64_t{8});
+  EXPECT_EQ(recovery.stats().static_frames, uint64_t{0});
+  EXPECT(recorder.Take().find("wait 250") == std::string::npos);
+}
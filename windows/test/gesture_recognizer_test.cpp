@@ -0,0 +1,211 @@
+// Gesture Recognizer scenarios: raw pointer sequences in, gestures out
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gesture_recognizer.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Type = PointerEvent::Type;
+
+namespace {
+
+// Feeds a recognizer and records "type@x,y" for every gesture
+class Scenario {
+ public:
+  explicit Scenario(GestureRecognizer::Options options = GestureRecognizer::Options())
+      : recognizer_(options),
+        handler_([this](const GestureEvent& gesture) {
+          std::string entry = GestureTypeName(gesture.type);
+          if (gesture.button != PointerButton::kLeft) {
+            entry += std::string(":") + PointerButtonName(gesture.button);
+          }
+          entry += "@" + std::to_string(gesture.x) + "," + std::to_string(gesture.y);
+          events_.push_back(entry);
+        }) {}
+
+  Scenario& Down(int x, int y, uint32_t t, PointerButton button = PointerButton::kLeft) {
+    recognizer_.Process({Type::kDown, button, x, y, t}, handler_);
+    return *this;
+  }
+  Scenario& Up(int x, int y, uint32_t t, PointerButton button = PointerButton::kLeft) {
+    recognizer_.Process({Type::kUp, button, x, y, t}, handler_);
+    return *this;
+  }
+  Scenario& Move(int x, int y, uint32_t t) {
+    recognizer_.Process({Type::kMove, PointerButton::kLeft, x, y, t}, handler_);
+    return *this;
+  }
+  Scenario& Tick(uint32_t t) {
+    recognizer_.Tick(t, handler_);
+    return *this;
+  }
+  Scenario& Cancel() {
+    recognizer_.Cancel(handler_);
+    return *this;
+  }
+
+  std::string Take() {
+    std::string joined;
+    for (const std::string& event : events_) {
+      if (!joined.empty()) joined += " ";
+      joined += event;
+    }
+    events_.clear();
+    return joined;
+  }
+
+  GestureRecognizer& recognizer() { return recognizer_; }
+
+ private:
+  GestureRecognizer recognizer_;
+  GestureRecognizer::Handler handler_;
+  std::vector<std::string> events_;
+};
+
+GestureRecognizer::Options NoLongPress() {
+  GestureRecognizer::Options options;
+  options.long_press_ms = 0;
+  return options;
+}
+
+}  // namespace
+
+HKCW_TEST(gesture_recognizer_click_and_double_click) {
+  Scenario s;
+  s.Down(100, 100, 1000).Up(101, 100, 1080);
+  EXPECT(s.Take() == "click@101,100");
+  s.Down(101, 101, 1300).Up(101, 101, 1350);
+  EXPECT(s.Take() == "click@101,101 dblclick@101,101");
+
+  // A third click starts a new pair
+  s.Down(101, 101, 1500).Up(101, 101, 1550);
+  EXPECT(s.Take() == "click@101,101");
+}
+
+HKCW_TEST(gesture_recognizer_double_click_needs_time_and_place) {
+  Scenario s;
+  s.Down(100, 100, 1000).Up(100, 100, 1050);
+  s.Down(100, 100, 1501).Up(100, 100, 1550);  // Press 501 ms after the first press
+  EXPECT(s.Take() == "click@100,100 click@100,100");
+
+  s.Down(200, 200, 3000).Up(200, 200, 3050);
+  s.Down(203, 200, 3100).Up(203, 200, 3150);  // Outside the 4x4 rectangle
+  EXPECT(s.Take() == "click@200,200 click@203,200");
+
+  s.Down(300, 300, 5000, PointerButton::kMiddle).Up(300, 300, 5050, PointerButton::kMiddle);
+  s.Down(300, 300, 5100).Up(300, 300, 5150);  // Different button
+  EXPECT(s.Take() == "click:middle@300,300 click@300,300");
+}
+
+HKCW_TEST(gesture_recognizer_drag) {
+  Scenario s;
+  s.Down(100, 100, 1000).Move(101, 102, 1010);  // Inside the drag rectangle
+  EXPECT(s.Take().empty());
+  s.Move(110, 100, 1020).Move(150, 120, 1030).Up(160, 125, 1040);
+  EXPECT(s.Take() == "dragstart@100,100 dragmove@110,100 dragmove@150,120 dragend@160,125");
+
+  // A drag never pairs into a double click
+  s.Down(160, 125, 1100).Up(160, 125, 1120);
+  EXPECT(s.Take() == "click@160,125");
+}
+
+HKCW_TEST(gesture_recognizer_context_click) {
+  Scenario s;
+  s.Down(50, 60, 1000, PointerButton::kRight).Up(50, 60, 1100, PointerButton::kRight);
+  EXPECT(s.Take() == "contextclick:right@50,60");
+  s.Down(50, 60, 1200, PointerButton::kRight).Up(50, 60, 1300, PointerButton::kRight);
+  EXPECT(s.Take() == "contextclick:right@50,60");  // Right clicks never pair
+}
+
+HKCW_TEST(gesture_recognizer_long_press_from_timer) {
+  Scenario s;
+  s.Down(100, 100, 1000);
+  uint32_t deadline = 0;
+  EXPECT(s.recognizer().long_press_deadline(deadline));
+  EXPECT_EQ(deadline, uint32_t{1500});
+
+  s.Tick(1499);
+  EXPECT(s.Take().empty());
+  s.Tick(1500);
+  EXPECT(s.Take() == "longpress@100,100");
+  EXPECT(!s.recognizer().long_press_deadline(deadline));
+
+  // No click on release, and the next click does not pair with anything
+  s.Up(100, 100, 1700);
+  EXPECT(s.Take().empty());
+  s.Down(100, 100, 1800).Up(100, 100, 1850);
+  EXPECT(s.Take() == "click@100,100");
+}
+
+HKCW_TEST(gesture_recognizer_long_press_without_tick) {
+  // The timer was late: the release still reports the long press
+  Scenario s;
+  s.Down(100, 100, 1000).Up(100, 100, 1600);
+  EXPECT(s.Take() == "longpress@100,100");
+}
+
+HKCW_TEST(gesture_recognizer_slow_click_without_long_press) {
+  // Pages without gesture listeners: holding the button is still a click
+  Scenario s(NoLongPress());
+  uint32_t deadline = 0;
+  s.Down(100, 100, 1000);
+  EXPECT(!s.recognizer().long_press_deadline(deadline));
+  s.Tick(5000).Up(100, 100, 5000);
+  EXPECT(s.Take() == "click@100,100");
+}
+
+HKCW_TEST(gesture_recognizer_long_press_disabled_mid_press) {
+  // The page dropped its gesture listeners while the button was down
+  Scenario s;
+  s.Down(100, 100, 1000);
+  s.recognizer().set_options(NoLongPress());
+  s.Tick(2000).Up(100, 100, 2000);
+  EXPECT(s.Take() == "click@100,100");
+}
+
+HKCW_TEST(gesture_recognizer_drag_cancels_long_press) {
+  Scenario s;
+  s.Down(100, 100, 1000).Move(120, 100, 1100);
+  uint32_t deadline = 0;
+  EXPECT(!s.recognizer().long_press_deadline(deadline));
+  s.Tick(2000).Up(130, 100, 2000);
+  EXPECT(s.Take() == "dragstart@100,100 dragmove@120,100 dragend@130,100");
+}
+
+HKCW_TEST(gesture_recognizer_ignores_chorded_buttons) {
+  Scenario s;
+  s.Down(100, 100, 1000).Down(100, 100, 1010, PointerButton::kRight);
+  s.Up(100, 100, 1020, PointerButton::kRight);
+  EXPECT(s.Take().empty());
+  EXPECT(s.recognizer().pressed());
+  s.Up(100, 100, 1030);
+  EXPECT(s.Take() == "click@100,100");
+}
+
+HKCW_TEST(gesture_recognizer_cancel) {
+  Scenario s;
+  s.Down(100, 100, 1000).Move(140, 100, 1010).Cancel();
+  EXPECT(s.Take() == "dragstart@100,100 dragmove@140,100 dragend@140,100");
+  s.Up(150, 100, 1020);  // The release that was swallowed elsewhere
+  EXPECT(s.Take().empty());
+
+  // A press cancelled before release forgets the pending double click
+  s.Down(10, 10, 2000).Up(10, 10, 2050);
+  s.Down(10, 10, 2100).Cancel();
+  s.Down(10, 10, 2200).Up(10, 10, 2250);
+  EXPECT(s.Take() == "click@10,10 click@10,10");
+}
+
+HKCW_TEST(gesture_recognizer_survives_tick_count_wrap) {
+  Scenario s;
+  uint32_t before_wrap = 0xFFFFFF00u;
+  s.Down(100, 100, before_wrap).Up(100, 100, before_wrap + 50);
+  s.Down(100, 100, before_wrap + 300).Up(100, 100, before_wrap + 350);  // Wraps past 0
+  EXPECT(s.Take() == "click@100,100 click@100,100 dblclick@100,100");
+
+  s.Down(100, 100, 0xFFFFFFF0u).Tick(0x000001F0u);  // 512 ms later, wrapped
+  EXPECT(s.Take() == "longpress@100,100");
+}
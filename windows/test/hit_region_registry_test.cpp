@@ -0,0 +1,81 @@
+// Hit Region Registry: whole-set messages from the SDK
+
+#include <string>
+#include <vector>
+
+#include "hit_region_registry.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+std::string Region(int id, int left, int z, const std::string& tag) {
+  return R"({"id":)" + std::to_string(id) + R"(,"left":)" + std::to_string(left) +
+         R"(,"top":0,"right":)" + std::to_string(left + 14) + R"(,"bottom":9,"z":)" +
+         std::to_string(z) + R"(,"tag":")" + tag + R"("})";
+}
+
+std::string Regions(const std::vector<std::string>& regions) {
+  std::string message = R"({"type":"HIT_REGIONS","regions":[)";
+  for (size_t i = 0; i < regions.size(); i++) {
+    if (i > 0) message += ",";
+    message += regions[i];
+  }
+  return message + "]}";
+}
+
+}  // namespace
+
+HKCW_TEST(hit_region_registry_parses_whole_set) {
+  std::vector<HitRegion> regions;
+  EXPECT(ParseHitRegions(Regions({Region(1, 0, 0, "play"), Region(2, 20, 1, R"(a}{\"id\":9,[)"),
+                                  R"({"id":3})", Region(4, 40, 0, "")}),
+                         regions));
+  EXPECT_EQ(regions.size(), size_t{3});  // The malformed element is skipped
+  if (regions.size() != 3) return;
+  EXPECT_EQ(regions[0].id, uint32_t{1});
+  EXPECT(regions[0].tag == "play");
+  EXPECT_EQ(regions[1].id, uint32_t{2});
+  EXPECT_EQ(regions[1].left, 20);
+  EXPECT_EQ(regions[1].z, 1);
+  EXPECT(regions[1].tag == R"(a}{\"id\":9,[)");
+  EXPECT_EQ(regions[2].id, uint32_t{4});
+
+  EXPECT(ParseHitRegions(Regions({}), regions));
+  EXPECT(regions.empty());
+  EXPECT(!ParseHitRegions(R"({"type":"HIT_REGIONS"})", regions));
+  EXPECT(!ParseHitRegions(R"({"type":"HIT_REGIONS","regions":[{"id":1)", regions));
+}
+
+HKCW_TEST(hit_region_registry_replaces_the_set) {
+  HitRegionRegistry registry;
+  HitRegion old_region{7, 500, 500, 600, 600, 0, "old"};
+  registry.Set(old_region);
+
+  // More regions than one burst of per-region messages ever delivered
+  std::vector<std::string> elements;
+  for (int i = 1; i <= 300; i++) elements.push_back(Region(i, i * 10, i == 151 ? 5 : 0, "r"));
+  std::vector<HitRegion> regions;
+  EXPECT(ParseHitRegions(Regions(elements), regions));
+  EXPECT_EQ(regions.size(), size_t{300});
+  EXPECT_EQ(registry.Replace(regions), HitRegionRegistry::kMaxRegions);
+
+  EXPECT(registry.HitTest(550, 550) == nullptr);  // Not in the new set
+  const HitRegion* hit = registry.HitTest(1512, 5);  // 150 and 151 (raised) overlap
+  EXPECT(hit && hit->id == 151);
+  hit = registry.HitTest(1505, 5);
+  EXPECT(hit && hit->id == 150);
+  EXPECT(registry.HitTest(2575, 5) == nullptr);  // Past the limit
+
+  // Empty rectangles are skipped; a repeated id keeps the later entry
+  regions = {{1, 0, 0, 9, 9, 0, "a"}, {2, 5, 5, 4, 4, 0, "empty"}, {1, 20, 0, 29, 9, 0, "b"}};
+  EXPECT_EQ(registry.Replace(regions), size_t{1});
+  hit = registry.HitTest(25, 5);
+  EXPECT(hit && hit->tag == "b");
+  EXPECT(registry.HitTest(5, 5) == nullptr);
+
+  EXPECT_EQ(registry.Replace({}), size_t{0});
+  EXPECT(registry.empty());
+  EXPECT(registry.HitTest(25, 5) == nullptr);
+}
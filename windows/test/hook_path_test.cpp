@@ -0,0 +1,347 @@
+// Hook path: everything DispatchInput does between the hook callback and
+// ExecuteScript / the launcher worker must not allocate (the plugin's
+// part that needs Win32 is mirrored here with the same modules)
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "gesture_recognizer.h"
+#include "hit_region_registry.h"
+#include "occlusion_cache.h"
+#include "script_pipeline.h"
+#include "script_template.h"
+#include "test_harness.h"
+#include "url_launcher.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+// Same shapes as the plugin's templates
+constexpr ScriptTemplate kMouseEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:mouse',"
+    L"{detail:{type:{},x:{},y:{},button:0}}));})();");
+constexpr ScriptTemplate kGestureEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:gesture',"
+    L"{detail:{type:{},button:{},x:{},y:{},startX:{},startY:{}}}));})();");
+constexpr ScriptTemplate kWheelEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:mouse',"
+    L"{detail:{type:'wheel',x:{},y:{},deltaX:{},deltaY:{}}}));})();");
+constexpr ScriptTemplate kRegionClickScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:click',"
+    L"{detail:{x:{},y:{},id:{}}}));})();");
+
+const uint32_t kScriptKeyMouseMove = 1;
+
+// A desktop with a few application windows over the wallpaper
+class ModelWindows : public WindowSystem {
+ public:
+  struct Window {
+    WindowHandle handle;
+    WindowDescription description;
+  };
+
+  ModelWindows() {
+    Add(1, L"Notepad", {100, 100, 700, 500});
+    Add(2, L"Chrome_WidgetWin_1", {1200, 0, 1920, 800});
+    Add(3, L"Shell_TrayWnd", {0, 1040, 1920, 1080});
+    Add(4, L"WorkerW", {0, 0, 1920, 1080});
+  }
+
+  WindowHandle RootFromPoint(int x, int y) override {
+    for (const Window& window : windows_) {  // Topmost first
+      const WindowRect& r = window.description.rect;
+      if (x >= r.left && x < r.right && y >= r.top && y < r.bottom) return window.handle;
+    }
+    return 0;
+  }
+
+  bool Describe(WindowHandle root, WindowDescription& description) override {
+    for (const Window& window : windows_) {
+      if (window.handle == root) {
+        description = window.description;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void EnumerateTopLevel(const std::function<void(WindowHandle root)>& callback) override {
+    for (const Window& window : windows_) callback(window.handle);
+  }
+
+ private:
+  void Add(WindowHandle handle, const wchar_t* class_name, WindowRect rect) {
+    Window window;
+    window.handle = handle;
+    window.description.visible = true;
+    window.description.caption_or_popup = true;
+    std::wcsncpy(window.description.class_name, class_name, 255);
+    window.description.rect = rect;
+    windows_.push_back(window);
+  }
+
+  std::vector<Window> windows_;
+};
+
+struct Ad {
+  int left, top, width, height;
+  std::string click_url;
+};
+
+// DispatchInput, OnGesture and the Send*ToWebView helpers, minus Win32
+class HookPath {
+ public:
+  HookPath()
+      : occlusion_(std::make_unique<ModelWindows>(), OcclusionCache::Options()),
+        gestures_(GestureRecognizer::Options()),
+        pipeline_(ScriptPipeline::Options()),
+        launcher_(LauncherHooks(), UrlLauncher::Options()) {
+    pipeline_.SetExecutor([this](const wchar_t* script, uint64_t ticket) {
+      scripts_++;
+      script_bytes_ += std::wcslen(script);
+      if (in_flight_count_ == kMaxInFlight) return false;
+      in_flight_[in_flight_count_++] = ticket;
+      return true;
+    });
+    gesture_handler_ = [this](const GestureEvent& gesture) { OnGesture(gesture); };
+
+    for (int i = 0; i < 20; i++) {
+      ads_.push_back({800 + (i % 5) * 80, 560 + (i / 5) * 90, 70, 80,
+                      "https://ads.example.com/click?id=" + std::to_string(i)});
+    }
+    for (uint32_t i = 1; i <= 40; i++) {
+      HitRegion region;
+      region.id = i;
+      region.left = 40 + static_cast<int>(i % 8) * 110;
+      region.top = 560 + static_cast<int>(i / 8) * 90;
+      region.right = region.left + 100;
+      region.bottom = region.top + 60;
+      region.tag = "button";
+      regions_.Set(region);
+    }
+  }
+
+  void Dispatch(const PointerEvent& event) {
+    bool is_move = event.type == PointerEvent::Type::kMove;
+    bool is_left_up = event.type == PointerEvent::Type::kUp && event.button == PointerButton::kLeft;
+
+    if (is_move) {
+      if (gestures_.pressed()) gestures_.Process(event, gesture_handler_);
+    }
+    if (event.type == PointerEvent::Type::kUp && gestures_.pressed()) {
+      const Ad* ad = is_left_up ? AdAt(event.x, event.y) : nullptr;
+      if (ad) {
+        gestures_.Cancel(gesture_handler_);
+      } else {
+        gestures_.Process(event, gesture_handler_);
+      }
+    }
+
+    if (occlusion_.IsOccluded(event.x, event.y, event.time_ms)) return;
+
+    if (is_left_up) {
+      const Ad* ad = AdAt(event.x, event.y);
+      if (ad) {
+        if (launcher_.Open(ad->click_url) == UrlLauncher::Result::kQueued) ad_opens_++;
+        return;
+      }
+    }
+
+    const char* event_type = nullptr;
+    if (event.type == PointerEvent::Type::kDown && event.button == PointerButton::kLeft) {
+      event_type = "mousedown";
+    } else if (is_left_up) {
+      event_type = "mouseup";
+    } else if (is_move) {
+      event_type = "mousemove";
+    }
+    if (event_type) SendMouse(event.x, event.y, event_type);
+
+    if (event.type == PointerEvent::Type::kDown) gestures_.Process(event, gesture_handler_);
+  }
+
+  void Wheel(int x, int y, int delta) {
+    if (occlusion_.IsOccluded(x, y, 0)) return;
+    ScriptBuffer<256> script;
+    if (kWheelEventScript.Render(script, x, y, 0, delta)) {
+      pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                       ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
+    }
+  }
+
+  void Tick(uint32_t now_ms) { gestures_.Tick(now_ms, gesture_handler_); }
+
+  // The renderer finishing scripts; UI thread, like the hook
+  void CompleteScripts() {
+    auto now = std::chrono::steady_clock::now();
+    while (in_flight_count_ > 0) pipeline_.Complete(in_flight_[--in_flight_count_], true, now);
+  }
+
+  OcclusionCache& occlusion() { return occlusion_; }
+  uint64_t scripts() const { return scripts_; }
+  uint64_t region_clicks() const { return region_clicks_; }
+  uint64_t gestures() const { return gestures_sent_; }
+  uint64_t ad_opens() const { return ad_opens_; }
+  UrlLauncher& launcher() { return launcher_; }
+
+ private:
+  static const size_t kMaxInFlight = 8;
+
+  static UrlLauncher::Hooks LauncherHooks() {
+    UrlLauncher::Hooks hooks;
+    hooks.launch = [](const std::string&) { return true; };
+    return hooks;
+  }
+
+  const Ad* AdAt(int x, int y) const {
+    for (const Ad& ad : ads_) {
+      if (x >= ad.left && x < ad.left + ad.width && y >= ad.top && y < ad.top + ad.height) {
+        return &ad;
+      }
+    }
+    return nullptr;
+  }
+
+  void OnGesture(const GestureEvent& gesture) {
+    if (gesture.type == GestureEvent::Type::kClick && gesture.button == PointerButton::kLeft) {
+      const HitRegion* region = regions_.HitTest(gesture.x, gesture.y);
+      if (region) {
+        ScriptBuffer<256> script;
+        if (kRegionClickScript.Render(script, gesture.x, gesture.y, region->id)) {
+          pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                           ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
+          region_clicks_++;
+        }
+      }
+    }
+    ScriptBuffer<320> script;
+    if (kGestureEventScript.Render(script, JsString{GestureTypeName(gesture.type)},
+                                   JsString{PointerButtonName(gesture.button)}, gesture.x,
+                                   gesture.y, gesture.start_x, gesture.start_y)) {
+      pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                       ScriptPipeline::Policy::kQueue, 0, std::chrono::steady_clock::now());
+      gestures_sent_++;
+    }
+  }
+
+  void SendMouse(int x, int y, const char* event_type) {
+    ScriptBuffer<256> script;
+    if (!kMouseEventScript.Render(script, JsString{event_type}, x, y)) return;
+    bool is_move = std::strcmp(event_type, "mousemove") == 0;
+    pipeline_.Submit(std::wstring_view(script.c_str(), script.length()),
+                     is_move ? ScriptPipeline::Policy::kCoalesce : ScriptPipeline::Policy::kQueue,
+                     is_move ? kScriptKeyMouseMove : 0, std::chrono::steady_clock::now());
+  }
+
+  OcclusionCache occlusion_;
+  GestureRecognizer gestures_;
+  GestureRecognizer::Handler gesture_handler_;
+  HitRegionRegistry regions_;
+  std::vector<Ad> ads_;
+  ScriptPipeline pipeline_;
+  UrlLauncher launcher_;
+
+  uint64_t in_flight_[kMaxInFlight] = {};
+  size_t in_flight_count_ = 0;
+  uint64_t scripts_ = 0;
+  uint64_t script_bytes_ = 0;
+  uint64_t region_clicks_ = 0;
+  uint64_t gestures_sent_ = 0;
+  uint64_t ad_opens_ = 0;
+};
+
+// Deterministic stream: wandering moves, clicks, drags, right clicks,
+// wheel steps and long presses over desktop, app windows and ads
+class EventStream {
+ public:
+  explicit EventStream(uint32_t seed) : state_(seed) {}
+
+  // Allocations inside hook-path calls only (region rebuilds run from a
+  // timer in the plugin and are not counted)
+  size_t Run(HookPath& path, int steps) {
+    size_t allocations = 0;
+    for (int i = 0; i < steps; i++) {
+      time_ms_ += 1 + Next() % 16;
+      if (path.occlusion().needs_rebuild(time_ms_)) path.occlusion().RebuildVisibleRegion(time_ms_);
+
+      size_t before = hkcw_test::AllocationCount();
+      Step(path);
+      allocations += hkcw_test::AllocationCount() - before;
+    }
+    return allocations;
+  }
+
+ private:
+  uint32_t Next() {
+    state_ = state_ * 1664525u + 1013904223u;
+    return state_ >> 8;
+  }
+
+  void Step(HookPath& path) {
+    uint32_t roll = Next() % 100;
+    if (roll < 70) {
+      x_ = Clamp(x_ + static_cast<int>(Next() % 41) - 20, 1919);
+      y_ = Clamp(y_ + static_cast<int>(Next() % 41) - 20, 1079);
+      path.Dispatch({PointerEvent::Type::kMove, PointerButton::kLeft, x_, y_, time_ms_});
+    } else if (roll < 90) {
+      if (Next() % 3 == 0) {  // Jump onto an ad or a region row
+        x_ = 40 + static_cast<int>(Next() % 1200);
+        y_ = 560 + static_cast<int>(Next() % 360);
+      }
+      PointerButton button = Next() % 5 == 0 ? PointerButton::kRight : PointerButton::kLeft;
+      path.Dispatch({PointerEvent::Type::kDown, button, x_, y_, time_ms_});
+      time_ms_ += Next() % 4 == 0 ? 700 : 60;  // Some become long presses
+      path.Tick(time_ms_);
+      path.Dispatch({PointerEvent::Type::kUp, button, x_, y_, time_ms_});
+    } else if (roll < 97) {
+      path.Wheel(x_, y_, Next() % 2 ? 120 : -120);
+    } else {
+      path.CompleteScripts();
+    }
+    if (Next() % 4 == 0) path.CompleteScripts();
+  }
+
+  static int Clamp(int value, int max) { return value < 0 ? 0 : (value > max ? max : value); }
+
+  uint32_t state_;
+  uint32_t time_ms_ = 1000;
+  int x_ = 960;
+  int y_ = 700;
+};
+
+}  // namespace
+
+HKCW_TEST(hook_path_does_not_allocate) {
+  HookPath path;
+
+  // Warm-up: preallocated buffers reach their working size
+  EventStream warmup(1);
+  warmup.Run(path, 20000);
+  uint64_t scripts_before = path.scripts();
+
+  EventStream stream(2);
+  size_t allocations = stream.Run(path, 200000);
+  EXPECT_EQ(allocations, size_t{0});
+
+  // The stream reached every branch
+  EXPECT(path.scripts() - scripts_before > 100000);
+  EXPECT(path.region_clicks() > 0);
+  EXPECT(path.gestures() > 0);
+  EXPECT(path.ad_opens() > 0);
+  EXPECT(path.occlusion().stats().fast_path > 0);
+  EXPECT(path.occlusion().stats().hits > 0);
+  path.launcher().WaitIdle(std::chrono::milliseconds(1000));
+}
+
+HKCW_TEST(hook_path_counter_sees_allocations) {
+  size_t before = hkcw_test::AllocationCount();
+  auto text = std::make_unique<std::string>(64, 'x');
+  EXPECT(hkcw_test::AllocationCount() - before >= 1);
+  EXPECT_EQ(text->size(), size_t{64});
+}
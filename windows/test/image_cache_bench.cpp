@@ -0,0 +1,39 @@
+// Image Cache: storing and loading a pre-scaled 1080p frame
+
+#include <filesystem>
+#include <string>
+
+#include "bench_harness.h"
+#include "image_cache.h"
+
+using namespace hkcw_engine2;
+namespace fs = std::filesystem;
+
+HKCW_BENCH(image_cache_frame) {
+  fs::path dir = fs::temp_directory_path() / "hkcw_image_cache_bench";
+  fs::remove_all(dir);
+
+  ScaledImageCache cache;
+  cache.SetDirectory(dir.string());
+  Surface frame;
+  frame.Resize(1920, 1080);
+  for (size_t i = 0; i < frame.pixels.size(); i++) frame.pixels[i] = static_cast<uint32_t>(i * 2654435761u);
+
+  std::string key = ScaledImageCache::MakeKey(0x5EED, 1920, 1080, ImageFit::kCover,
+                                              ResampleFilter::kLanczos3);
+  hkcw_bench::Measure("store 1080p frame", 1, [&] {
+    hkcw_bench::Consume(cache.Store(key, frame));
+  });
+
+  // The hit that replaces decode + resample on the next start
+  Surface loaded;
+  hkcw_bench::Measure("load 1080p frame (hit)", 1, [&] {
+    hkcw_bench::Consume(cache.Load(key, 1920, 1080, loaded));
+  });
+  hkcw_bench::Measure("miss", 1, [&] {
+    hkcw_bench::Consume(cache.Load("absent", 1920, 1080, loaded));
+  });
+
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+}
@@ -0,0 +1,124 @@
+// Image Cache: keys, round trips, size checks and LRU eviction
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "image_cache.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Fresh directory per test, removed afterwards
+struct ScratchDir {
+  fs::path path;
+
+  explicit ScratchDir(const char* name) {
+    path = fs::temp_directory_path() / ("hkcw_image_cache_" + std::string(name));
+    fs::remove_all(path);
+  }
+  ~ScratchDir() {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+
+  bool Has(const std::string& key) const { return fs::exists(path / (key + ".frame")); }
+  void Age(const std::string& key, int seconds) const {
+    fs::last_write_time(path / (key + ".frame"),
+                        fs::file_time_type::clock::now() - std::chrono::seconds(seconds));
+  }
+};
+
+Surface Frame(int width, int height, uint32_t seed) {
+  Surface surface;
+  surface.Resize(width, height);
+  for (size_t i = 0; i < surface.pixels.size(); i++) {
+    surface.pixels[i] = 0xFF000000u | static_cast<uint32_t>(i * 2654435761u + seed) >> 8;
+  }
+  return surface;
+}
+
+uint64_t EntryBytes(int width, int height) {
+  return 24 + static_cast<uint64_t>(width) * static_cast<uint64_t>(height) * 4;  // Header + rows
+}
+
+}  // namespace
+
+HKCW_TEST(image_cache_keys_separate_variants) {
+  std::string key = ScaledImageCache::MakeKey(0x1234, 1920, 1080, ImageFit::kCover,
+                                              ResampleFilter::kLanczos3);
+  EXPECT(key == "0000000000001234_1920x1080_02");
+  EXPECT(key != ScaledImageCache::MakeKey(0x1234, 1920, 1080, ImageFit::kContain,
+                                          ResampleFilter::kLanczos3));
+  EXPECT(key != ScaledImageCache::MakeKey(0x1234, 1080, 1920, ImageFit::kCover,
+                                          ResampleFilter::kLanczos3));
+  EXPECT(key != ScaledImageCache::MakeKey(0x1235, 1920, 1080, ImageFit::kCover,
+                                          ResampleFilter::kLanczos3));
+}
+
+HKCW_TEST(image_cache_round_trips_frames) {
+  ScratchDir dir("round_trip");
+  ScaledImageCache cache;
+  Surface frame = Frame(37, 19, 7);
+  Surface loaded;
+
+  // Disabled until a directory is set
+  EXPECT(!cache.enabled());
+  EXPECT(!cache.Store("a", frame));
+  EXPECT(!cache.Load("a", 37, 19, loaded));
+
+  cache.SetDirectory(dir.path.string());
+  EXPECT(!cache.Load("a", 37, 19, loaded));  // Miss before the directory exists
+  EXPECT(cache.Store("a", frame));
+  EXPECT(cache.Load("a", 37, 19, loaded));
+  EXPECT_EQ(loaded.width, 37);
+  EXPECT(loaded.pixels == frame.pixels);
+  EXPECT(!fs::exists(dir.path / "a.frame.tmp"));
+
+  // A frame of another size is a miss, not a misread
+  EXPECT(!cache.Load("a", 19, 37, loaded));
+  EXPECT(!cache.Load("b", 37, 19, loaded));
+  EXPECT(!cache.Store("empty", Surface()));
+
+  // Truncated entries are misses
+  fs::resize_file(dir.path / "a.frame", EntryBytes(37, 19) - 4);
+  EXPECT(!cache.Load("a", 37, 19, loaded));
+  EXPECT(loaded.pixels.empty());
+  std::ofstream(dir.path / "bad.frame", std::ios::binary) << "not a frame at all, not at all";
+  EXPECT(!cache.Load("bad", 1, 1, loaded));
+}
+
+HKCW_TEST(image_cache_evicts_least_recently_used) {
+  ScratchDir dir("evict");
+  ScaledImageCache cache;
+  cache.SetDirectory(dir.path.string());
+  cache.set_max_bytes(EntryBytes(16, 16) * 3);
+
+  EXPECT(cache.Store("a", Frame(16, 16, 1)));
+  EXPECT(cache.Store("b", Frame(16, 16, 2)));
+  EXPECT(cache.Store("c", Frame(16, 16, 3)));
+  dir.Age("a", 30);
+  dir.Age("b", 20);
+  dir.Age("c", 10);
+
+  // A hit makes "a" the most recent, so "b" is the one to go
+  Surface loaded;
+  EXPECT(cache.Load("a", 16, 16, loaded));
+  EXPECT(cache.Store("d", Frame(16, 16, 4)));
+  EXPECT(dir.Has("a"));
+  EXPECT(!dir.Has("b"));
+  EXPECT(dir.Has("c"));
+  EXPECT(dir.Has("d"));
+
+  // Over budget on its own: everything goes, the new frame included,
+  // but files other than frames are never touched
+  std::ofstream(dir.path / "notes.txt") << "keep";
+  EXPECT(cache.Store("big", Frame(32, 32, 5)));
+  EXPECT(!dir.Has("a") && !dir.Has("c") && !dir.Has("d") && !dir.Has("big"));
+  EXPECT(fs::exists(dir.path / "notes.txt"));
+}
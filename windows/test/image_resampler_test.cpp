@@ -0,0 +1,177 @@
+// Image Resampler: fit modes, filter normalization and edge sizes
+
+#include <cstdint>
+#include <vector>
+
+#include "image_resampler.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+const uint32_t kRed = 0xFFFF0000u;
+const uint32_t kBlue = 0xFF0000FFu;
+const uint32_t kBackground = 0xFF101010u;
+
+struct Image {
+  std::vector<uint32_t> pixels;
+  int width = 0;
+  int height = 0;
+
+  Image(int w, int h, uint32_t color) : pixels(static_cast<size_t>(w) * h, color), width(w), height(h) {}
+  uint32_t& At(int x, int y) { return pixels[static_cast<size_t>(y) * width + x]; }
+  ImageView View() const { return {pixels.data(), width, height, width}; }
+};
+
+bool AllEqual(const Surface& surface, uint32_t color) {
+  for (uint32_t pixel : surface.pixels) {
+    if (pixel != color) return false;
+  }
+  return !surface.pixels.empty();
+}
+
+int Channel(uint32_t pixel, int shift) {
+  return static_cast<int>((pixel >> shift) & 0xFF);
+}
+
+bool Near(uint32_t a, uint32_t b, int tolerance) {
+  for (int shift = 0; shift < 32; shift += 8) {
+    int difference = Channel(a, shift) - Channel(b, shift);
+    if (difference < -tolerance || difference > tolerance) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+HKCW_TEST(image_resampler_keeps_flat_color) {
+  // Weights sum to one after fixed-point rounding, for every ratio
+  Image image(97, 61, 0xFF336699u);
+  ImageResampler resampler;
+  for (ResampleFilter filter : {ResampleFilter::kBox, ResampleFilter::kBilinear, ResampleFilter::kLanczos3}) {
+    for (int size : {1, 7, 61, 250}) {
+      Surface target;
+      target.Resize(size, size * 2);
+      resampler.Resample(image.View(), 0.0f, 0.0f, 97.0f, 61.0f, target, filter);
+      if (!AllEqual(target, 0xFF336699u)) {
+        hkcw_test::Fail(__FILE__, __LINE__, "flat color changed");
+        std::cerr << "    filter " << static_cast<int>(filter) << ", size " << size << std::endl;
+      }
+    }
+  }
+}
+
+HKCW_TEST(image_resampler_identity_and_averaging) {
+  Image checker(16, 16, 0);
+  for (int y = 0; y < 16; y++) {
+    for (int x = 0; x < 16; x++) checker.At(x, y) = ((x + y) & 1) ? 0xFFFFFFFFu : 0xFF000000u;
+  }
+
+  // Same size: every filter reproduces the source exactly
+  ImageResampler resampler;
+  for (ResampleFilter filter : {ResampleFilter::kBox, ResampleFilter::kLanczos3}) {
+    Surface target;
+    target.Resize(16, 16);
+    resampler.Resample(checker.View(), 0.0f, 0.0f, 16.0f, 16.0f, target, filter);
+    EXPECT(target.pixels == checker.pixels);
+  }
+
+  // Halving averages instead of picking every other pixel (aliasing to
+  // solid black or white)
+  Surface half;
+  half.Resize(8, 8);
+  resampler.Resample(checker.View(), 0.0f, 0.0f, 16.0f, 16.0f, half, ResampleFilter::kBox);
+  EXPECT(Near(half.pixels[0], 0xFF808080u, 1));
+  EXPECT(Near(half.pixels[63], 0xFF808080u, 1));
+  Surface tiny;
+  tiny.Resize(2, 2);
+  resampler.Resample(checker.View(), 0.0f, 0.0f, 16.0f, 16.0f, tiny, ResampleFilter::kLanczos3);
+  EXPECT(Near(tiny.pixels[3], 0xFF808080u, 2));
+}
+
+HKCW_TEST(image_resampler_cover_crops_center) {
+  // Left half red, right half blue; cover into a square keeps the middle
+  Image image(200, 100, kRed);
+  for (int y = 0; y < 100; y++) {
+    for (int x = 100; x < 200; x++) image.At(x, y) = kBlue;
+  }
+
+  Surface target;
+  ImageResampler().ResampleToFit(image.View(), ImageFit::kCover, kBackground, 50, 50, target,
+                                 ResampleFilter::kLanczos3);
+  EXPECT_EQ(target.width, 50);
+  EXPECT_EQ(target.height, 50);
+  EXPECT(target.Row(25)[2] == kRed);
+  EXPECT(target.Row(25)[47] == kBlue);
+  EXPECT(target.Row(0)[10] == kRed);
+
+  // Stretch keeps the whole width: the split stays in the middle
+  ImageResampler().ResampleToFit(image.View(), ImageFit::kStretch, kBackground, 40, 40, target,
+                                 ResampleFilter::kBilinear);
+  EXPECT(target.Row(20)[5] == kRed);
+  EXPECT(target.Row(20)[34] == kBlue);
+}
+
+HKCW_TEST(image_resampler_contain_letterboxes) {
+  Image image(200, 100, kRed);
+  Surface target;
+  ImageResampler resampler;
+
+  // 2:1 into a square: 100x50 centered, background above and below
+  resampler.ResampleToFit(image.View(), ImageFit::kContain, kBackground, 100, 100, target,
+                          ResampleFilter::kLanczos3);
+  EXPECT(target.Row(0)[50] == kBackground);
+  EXPECT(target.Row(24)[50] == kBackground);
+  EXPECT(target.Row(25)[0] == kRed);
+  EXPECT(target.Row(74)[99] == kRed);
+  EXPECT(target.Row(75)[50] == kBackground);
+
+  // Tall image into a wide target: pillarbox
+  Image tall(30, 90, kBlue);
+  resampler.ResampleToFit(tall.View(), ImageFit::kContain, kBackground, 90, 30, target,
+                          ResampleFilter::kBox);
+  EXPECT(target.Row(15)[0] == kBackground);
+  EXPECT(target.Row(15)[44] == kBlue);
+  EXPECT(target.Row(15)[89] == kBackground);
+}
+
+HKCW_TEST(image_resampler_edge_sizes) {
+  ImageResampler resampler;
+  Surface target;
+
+  // A single pixel fills any target
+  Image dot(1, 1, kBlue);
+  resampler.ResampleToFit(dot.View(), ImageFit::kCover, kBackground, 33, 17, target,
+                          ResampleFilter::kLanczos3);
+  EXPECT(AllEqual(target, kBlue));
+
+  // One-row and one-column sources
+  Image row(1000, 1, kRed);
+  resampler.ResampleToFit(row.View(), ImageFit::kStretch, kBackground, 3, 3, target,
+                          ResampleFilter::kBox);
+  EXPECT(AllEqual(target, kRed));
+  Image column(1, 500, kRed);
+  resampler.ResampleToFit(column.View(), ImageFit::kContain, kBackground, 10, 10, target,
+                          ResampleFilter::kBilinear);
+  EXPECT(target.Row(5)[4] == kRed);  // At least one column survives
+  EXPECT(target.Row(5)[0] == kBackground);
+
+  // Down to a single pixel: the average of the whole image
+  Image halves(64, 64, 0xFF000000u);
+  for (int y = 32; y < 64; y++) {
+    for (int x = 0; x < 64; x++) halves.At(x, y) = 0xFFFFFFFFu;
+  }
+  resampler.ResampleToFit(halves.View(), ImageFit::kStretch, kBackground, 1, 1, target,
+                          ResampleFilter::kBox);
+  EXPECT(Near(target.pixels[0], 0xFF808080u, 1));
+
+  // Nothing to draw from, or nowhere to draw: sized, left alone
+  Image empty(0, 0, 0);
+  resampler.ResampleToFit(empty.View(), ImageFit::kCover, kBackground, 4, 4, target,
+                          ResampleFilter::kBox);
+  EXPECT_EQ(target.width, 4);
+  resampler.ResampleToFit(dot.View(), ImageFit::kCover, kBackground, 0, 5, target,
+                          ResampleFilter::kBox);
+  EXPECT(target.pixels.empty());
+}
@@ -0,0 +1,173 @@
+// Input Source: trace parsing and replay in virtual time
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gesture_recognizer.h"
+#include "input_source.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Type = InputEvent::Type;
+
+namespace {
+
+const char kClickTrace[] =
+    "# double click, context click, wheel\n"
+    "1000 move 100 100\n"
+    "1010 down left 100 100\n"
+    "1080 up left 101 100\n"
+    "1300 down left 101 101\r\n"
+    "1350 up left 101 101\n"
+    "\n"
+    "2000 down right 500 400\n"
+    "2100 up right 500 400\n"
+    "3000 wheel 640 360 0 -120\n";
+
+std::vector<InputEvent> Parse(const std::string& text) {
+  std::vector<InputEvent> events;
+  std::string error;
+  EXPECT(ParseInputTrace(text, events, &error));
+  EXPECT(error.empty());
+  return events;
+}
+
+// Collects what the replayer delivers
+struct Recorder {
+  std::vector<InputEvent> events;
+  InputSource::Handler handler = [this](const InputEvent& event) { events.push_back(event); };
+
+  std::vector<uint32_t> Times() const {
+    std::vector<uint32_t> times;
+    for (const InputEvent& event : events) times.push_back(event.time_ms);
+    return times;
+  }
+};
+
+}  // namespace
+
+HKCW_TEST(input_source_parses_trace) {
+  std::vector<InputEvent> events = Parse(kClickTrace);
+  EXPECT_EQ(events.size(), size_t{8});
+  if (events.size() != 8) return;
+
+  EXPECT(events[0].type == Type::kMove);
+  EXPECT_EQ(events[0].x, 100);
+  EXPECT_EQ(events[0].time_ms, uint32_t{1000});
+  EXPECT(events[1].type == Type::kDown && events[1].button == PointerButton::kLeft);
+  EXPECT(events[3].type == Type::kDown && events[3].y == 101);  // CRLF line
+  EXPECT(events[6].type == Type::kUp && events[6].button == PointerButton::kRight);
+  EXPECT(events[7].type == Type::kWheel);
+  EXPECT_EQ(events[7].x, 640);
+  EXPECT_EQ(events[7].wheel_x, 0);
+  EXPECT_EQ(events[7].wheel_y, -120);
+}
+
+HKCW_TEST(input_source_rejects_bad_lines) {
+  const char* bad[] = {
+      "10 move 1\n",               // Missing coordinate
+      "10 move 1 2 3\n",           // Trailing token
+      "10 down thumb 1 2\n",       // Unknown button
+      "10 hover 1 2\n",            // Unknown type
+      "-5 move 1 2\n",             // Negative time
+      "10 wheel 1 2 3\n",          // Wheel without dy
+      "1 move 1 2\nx move 1 2\n",  // Second line
+  };
+  for (const char* text : bad) {
+    std::vector<InputEvent> events(1);
+    std::string error;
+    EXPECT(!ParseInputTrace(text, events, &error));
+    EXPECT(events.empty());
+    EXPECT(!error.empty());
+  }
+
+  std::vector<InputEvent> events;
+  std::string error;
+  ParseInputTrace("1 move 1 2\nx move 1 2\n", events, &error);
+  EXPECT(error == "Invalid input trace line 2");
+  EXPECT(ParseInputTrace("# only comments\n\n", events, nullptr));
+  EXPECT(events.empty());
+}
+
+HKCW_TEST(input_source_replays_at_original_speed) {
+  InputReplayer replayer(Parse(kClickTrace), 1.0);
+  Recorder recorder;
+
+  // Times are rebased onto the start time, relative to the first event
+  EXPECT_EQ(replayer.Advance(0, 50000, recorder.handler), size_t{1});
+  EXPECT_EQ(replayer.next_due_ms(), uint32_t{10});
+  EXPECT_EQ(replayer.Advance(9, 50000, recorder.handler), size_t{0});
+  EXPECT_EQ(replayer.Advance(80, 50000, recorder.handler), size_t{2});
+  EXPECT_EQ(replayer.Advance(1999, 50000, recorder.handler), size_t{4});
+  EXPECT(!replayer.done());
+  EXPECT_EQ(replayer.next_due_ms(), uint32_t{2000});
+  EXPECT_EQ(replayer.Advance(2000, 50000, recorder.handler), size_t{1});
+  EXPECT(replayer.done());
+  EXPECT_EQ(replayer.next_due_ms(), uint32_t{0});
+
+  std::vector<uint32_t> expected = {50000, 50010, 50080, 50300, 50350, 51000, 51100, 52000};
+  EXPECT(recorder.Times() == expected);
+  EXPECT_EQ(recorder.events[7].wheel_y, -120);  // Everything but the time is kept
+}
+
+HKCW_TEST(input_source_replays_accelerated) {
+  InputReplayer fast(Parse(kClickTrace), 4.0);
+  Recorder recorder;
+  fast.Advance(500, 0, recorder.handler);
+  EXPECT(fast.done());
+  std::vector<uint32_t> expected = {0, 2, 20, 75, 87, 250, 275, 500};
+  EXPECT(recorder.Times() == expected);
+
+  // Speed 0 delivers everything at once
+  InputReplayer flat(Parse(kClickTrace), 0.0);
+  Recorder all;
+  EXPECT_EQ(flat.Advance(0, 7, all.handler), size_t{8});
+  EXPECT(all.Times() == std::vector<uint32_t>(8, 7));
+}
+
+HKCW_TEST(input_source_caps_events_per_advance) {
+  InputReplayer replayer(Parse(kClickTrace), 0.0);
+  Recorder recorder;
+  EXPECT_EQ(replayer.Advance(0, 0, recorder.handler, 3), size_t{3});
+  EXPECT_EQ(replayer.Advance(0, 0, recorder.handler, 3), size_t{3});
+  EXPECT_EQ(replayer.Advance(0, 0, recorder.handler, 3), size_t{2});
+  EXPECT(replayer.done());
+  EXPECT_EQ(replayer.Advance(0, 0, recorder.handler, 3), size_t{0});
+  EXPECT(recorder.events.size() == 8 && recorder.events[7].type == Type::kWheel);
+}
+
+HKCW_TEST(input_source_replays_across_tick_count_wrap) {
+  std::vector<InputEvent> events = Parse("0 down left 5 5\n60 up left 5 5\n");
+  events[0].time_ms = 0xFFFFFFE0u;  // Recorded just before the wrap
+  events[1].time_ms = 0x0000001Cu;
+  InputReplayer replayer(events, 1.0);
+  Recorder recorder;
+  replayer.Advance(59, 0xFFFFFFF0u, recorder.handler);
+  EXPECT_EQ(recorder.events.size(), size_t{1});
+  replayer.Advance(60, 0xFFFFFFF0u, recorder.handler);
+  std::vector<uint32_t> expected = {0xFFFFFFF0u, 0x0000002Cu};
+  EXPECT(recorder.Times() == expected);
+}
+
+HKCW_TEST(input_source_replay_drives_gestures) {
+  // Downstream timing sees the replayed pace: at 4x the double click's
+  // presses are 73 ms apart, and the right click stays a context click
+  GestureRecognizer recognizer{GestureRecognizer::Options()};
+  std::vector<std::string> gestures;
+  GestureRecognizer::Handler on_gesture = [&gestures](const GestureEvent& gesture) {
+    gestures.push_back(GestureTypeName(gesture.type));
+  };
+
+  InputReplayer replayer(Parse(kClickTrace), 4.0);
+  for (uint32_t elapsed = 0; !replayer.done(); elapsed += 16) {  // A 60 Hz timer
+    replayer.Advance(elapsed, 1000, [&](const InputEvent& event) {
+      if (event.type != Type::kDown && event.type != Type::kUp) return;
+      PointerEvent pointer{event.type == Type::kDown ? PointerEvent::Type::kDown : PointerEvent::Type::kUp,
+                           event.button, event.x, event.y, event.time_ms};
+      recognizer.Process(pointer, on_gesture);
+    });
+  }
+  std::vector<std::string> expected = {"click", "click", "dblclick", "contextclick"};
+  EXPECT(gestures == expected);
+}
@@ -0,0 +1,212 @@
+// Keyboard Forwarder: key filtering, repeat folding and batch limits
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "keyboard_forwarder.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Flush = KeyForwarder::Flush;
+
+namespace {
+
+const uint32_t kSpace = 0x20;
+const uint32_t kArrowLeft = 0x25;
+const uint32_t kLeftControl = 0xA2;
+
+KeyEvent Down(uint32_t vk, bool focused = true) { return {vk, true, focused}; }
+KeyEvent Up(uint32_t vk) { return {vk, false, true}; }
+
+// "+Space" press, "+Space*3" press with folded repeats, "~Space*1" a
+// repeat entry, "-Space" release; "^" prefix when Ctrl was down
+std::string Take(KeyForwarder& forwarder, size_t max_entries = 1000) {
+  std::vector<KeyBatchEntry> batch;
+  forwarder.TakeBatch(batch, max_entries);
+  std::string joined;
+  for (const KeyBatchEntry& entry : batch) {
+    if (!joined.empty()) joined += " ";
+    if (entry.modifiers & kKeyModifierCtrl) joined += "^";
+    joined += !entry.down ? "-" : entry.initial ? "+" : "~";
+    joined += KeyCodeName(entry.vk);
+    if (entry.repeat > 0) joined += "*" + std::to_string(entry.repeat);
+  }
+  return joined;
+}
+
+}  // namespace
+
+HKCW_TEST(keyboard_forwarder_key_names) {
+  EXPECT(std::string(KeyCodeName('A')) == "KeyA");
+  EXPECT(std::string(KeyCodeName('7')) == "Digit7");
+  EXPECT(std::string(KeyCodeName(0x63)) == "Numpad3");
+  EXPECT(std::string(KeyCodeName(0x7B)) == "F12");
+  EXPECT(std::string(KeyCodeName(0x87)) == "F24");
+  EXPECT(std::string(KeyCodeName(kSpace)) == "Space");
+  EXPECT(std::string(KeyCodeName(0xB3)) == "MediaPlayPause");
+  EXPECT(KeyCodeName(0xBA) == nullptr);  // Punctuation (";" on US layouts)
+  EXPECT(KeyCodeName(kLeftControl) == nullptr);
+  EXPECT(KeyCodeName(300) == nullptr);
+
+  for (uint32_t vk = 0; vk < 256; vk++) {
+    if (KeyCodeName(vk)) EXPECT_EQ(KeyCodeFromName(KeyCodeName(vk)), vk);
+  }
+  EXPECT_EQ(KeyCodeFromName("Semicolon"), uint32_t{0});
+  EXPECT_EQ(KeyCodeFromName("keya"), uint32_t{0});
+
+  EXPECT(IsTextKey('Q') && IsTextKey('0') && IsTextKey(0x69));
+  EXPECT(!IsTextKey(kSpace) && !IsTextKey(0x70));
+}
+
+HKCW_TEST(keyboard_forwarder_limits_text_keys) {
+  KeyForwarder forwarder;
+  EXPECT(forwarder.empty());
+  EXPECT_EQ(forwarder.SetKeys("Space Bogus Space  ArrowLeft"), size_t{2});
+
+  // Ten letters at most; non-text keys are not counted against it
+  std::string names = "F5";
+  for (char c = 'A'; c <= 'Z'; c++) names += std::string(" Key") + c;
+  names += " Escape";
+  EXPECT_EQ(forwarder.SetKeys(names), size_t{12});
+  EXPECT(forwarder.Wants('J'));
+  EXPECT(!forwarder.Wants('K'));
+  EXPECT(forwarder.Wants(0x1B));
+  EXPECT(forwarder.Wants(kLeftControl));  // Modifiers are always tracked
+
+  EXPECT_EQ(forwarder.SetKeys(""), size_t{0});
+  EXPECT(forwarder.empty());
+}
+
+HKCW_TEST(keyboard_forwarder_forwards_listed_keys) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft");
+
+  EXPECT(forwarder.Process(Down('A')) == Flush::kNone);
+  EXPECT(!forwarder.pending());
+  EXPECT(forwarder.Process(Down(kSpace)) == Flush::kNextFrame);
+  EXPECT(forwarder.Process(Down(kSpace)) == Flush::kNone);  // Folded
+  EXPECT(forwarder.Process(Down(kSpace)) == Flush::kNone);
+  EXPECT(forwarder.Process(Up(kSpace)) == Flush::kNone);  // Already due next frame
+  EXPECT(forwarder.pending_flush() == Flush::kNextFrame);
+  EXPECT(Take(forwarder) == "+Space*2 -Space");
+  EXPECT_EQ(forwarder.coalesced(), uint64_t{2});
+  EXPECT_EQ(forwarder.forwarded(), uint64_t{2});
+
+  // A release without a delivered press is not forwarded
+  EXPECT(forwarder.Process(Up(kArrowLeft)) == Flush::kNone);
+  EXPECT(!forwarder.pending());
+}
+
+HKCW_TEST(keyboard_forwarder_repeats_can_wait) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft");
+  forwarder.Process(Down(kSpace));
+  EXPECT(Take(forwarder) == "+Space");
+
+  // Held past the flush: repeats start a new entry that only needs the
+  // repeat interval, until a press joins it
+  EXPECT(forwarder.Process(Down(kSpace)) == Flush::kRepeat);
+  EXPECT(forwarder.Process(Down(kSpace)) == Flush::kNone);
+  EXPECT(forwarder.pending_flush() == Flush::kRepeat);
+  EXPECT(forwarder.Process(Down(kArrowLeft)) == Flush::kNextFrame);
+  EXPECT(Take(forwarder) == "~Space*2 +ArrowLeft");
+}
+
+HKCW_TEST(keyboard_forwarder_needs_desktop_focus) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft");
+
+  EXPECT(forwarder.Process(Down(kSpace, false)) == Flush::kNone);
+  EXPECT(!forwarder.pending());
+
+  // Typing into another window releases what the page holds
+  forwarder.Process(Down(kSpace));
+  Take(forwarder);
+  EXPECT(forwarder.Process(Down(kArrowLeft, false)) == Flush::kNextFrame);
+  EXPECT(Take(forwarder) == "-Space");
+  forwarder.Process(Up(kSpace));
+  forwarder.Process(Up(kArrowLeft));
+  EXPECT(!forwarder.pending());
+}
+
+HKCW_TEST(keyboard_forwarder_releases_unlisted_keys) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft");
+  forwarder.Process(Down(kSpace));
+  forwarder.Process(Down(kArrowLeft));
+  Take(forwarder);
+
+  forwarder.SetKeys("ArrowLeft");
+  EXPECT(Take(forwarder) == "-Space");
+  forwarder.ReleaseAll();
+  EXPECT(Take(forwarder) == "-ArrowLeft");
+
+  // A new document forgets everything, including what was batched
+  forwarder.Process(Down(kArrowLeft));
+  forwarder.Reset();
+  EXPECT(!forwarder.pending());
+  EXPECT(forwarder.empty());
+  EXPECT(forwarder.Process(Up(kArrowLeft)) == Flush::kNone);
+  EXPECT(!forwarder.pending());
+}
+
+HKCW_TEST(keyboard_forwarder_carries_modifiers) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space");
+  EXPECT(forwarder.Process(Down(kLeftControl)) == Flush::kNone);
+  forwarder.Process(Down(kSpace));
+  forwarder.Process(Up(kLeftControl));
+  forwarder.Process(Up(kSpace));
+  EXPECT(Take(forwarder) == "^+Space -Space");
+}
+
+HKCW_TEST(keyboard_forwarder_drops_presses_never_releases) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft");
+
+  // Fill the batch to the limit, with Space and ArrowLeft held at the end
+  for (size_t i = 0; i < (KeyForwarder::kMaxPending - 2) / 2; i++) {
+    forwarder.Process(Down(kSpace));
+    forwarder.Process(Up(kSpace));
+  }
+  forwarder.Process(Down(kSpace));
+  forwarder.Process(Down(kArrowLeft));  // The last slot
+  EXPECT_EQ(forwarder.dropped(), uint64_t{0});
+
+  forwarder.Process(Up(kSpace));
+  forwarder.Process(Up(kArrowLeft));
+  forwarder.Process(Down(kSpace));  // No room: dropped, and so is its release
+  forwarder.Process(Up(kSpace));
+  EXPECT_EQ(forwarder.dropped(), uint64_t{1});
+
+  std::vector<KeyBatchEntry> batch;
+  forwarder.TakeBatch(batch, 10);
+  EXPECT_EQ(batch.size(), size_t{10});
+  forwarder.TakeBatch(batch, 1000);
+  EXPECT_EQ(batch.size(), KeyForwarder::kMaxPending + 2 - 10);
+  EXPECT(batch.size() > 2 && !batch.back().down && batch.back().vk == kArrowLeft);
+  EXPECT(!forwarder.pending());
+}
+
+HKCW_TEST(keyboard_forwarder_does_not_allocate) {
+  KeyForwarder forwarder;
+  forwarder.SetKeys("Space ArrowLeft KeyW KeyA KeyS KeyD");
+  std::vector<KeyBatchEntry> batch;
+  batch.reserve(KeyForwarder::kMaxPending + 256);
+
+  auto frame = [&](uint32_t vk) {
+    forwarder.Process(Down(kLeftControl));
+    forwarder.Process(Down(vk));
+    forwarder.Process(Down(vk));
+    forwarder.Process(Up(vk));
+    forwarder.Process(Up(kLeftControl));
+    forwarder.TakeBatch(batch, 64);
+  };
+  frame(kSpace);
+  size_t before = hkcw_test::AllocationCount();
+  for (int i = 0; i < 1000; i++) frame(i % 2 ? 'W' : kArrowLeft);
+  EXPECT_EQ(hkcw_test::AllocationCount() - before, size_t{0});
+  EXPECT_EQ(forwarder.coalesced(), uint64_t{1001});
+}
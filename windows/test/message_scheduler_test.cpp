@@ -0,0 +1,210 @@
+// Message Scheduler: batch slicing, buffer reuse and per-type policies
+
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "message_scheduler.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Clock = MessageScheduler::Clock;
+
+namespace {
+
+const auto kBudget = std::chrono::seconds(1);
+
+std::string Batch(const std::vector<std::string>& messages) {
+  std::string batch = R"({"type":"BATCH","messages":[)";
+  for (size_t i = 0; i < messages.size(); i++) {
+    if (i > 0) batch += ",";
+    batch += messages[i];
+  }
+  return batch + "]}";
+}
+
+// Unlimited rates so only the buffer handling is under test
+void Configure(MessageScheduler& scheduler) {
+  scheduler.SetPolicy("IFRAME_DATA", {0.0, 1.0, true});
+  scheduler.SetDefaultPolicy({0.0, 1.0, false});
+}
+
+std::vector<std::string> DrainAll(MessageScheduler& scheduler, Clock::time_point now) {
+  std::vector<std::string> seen;
+  scheduler.Drain(1000, kBudget, now,
+                  [&seen](std::string_view message) { seen.emplace_back(message); });
+  return seen;
+}
+
+}  // namespace
+
+HKCW_TEST(message_scheduler_batch_elements_are_views) {
+  MessageScheduler scheduler{MessageScheduler::Options()};
+  Configure(scheduler);
+  auto now = Clock::now();
+
+  std::string text = Batch({R"({"type":"LOG","message":"a]}{\"x"})",
+                            R"({"type":"IFRAME_DATA","iframes":[{"id":"a"}]})",
+                            R"({"type":"openURL","url":"https://x/?a=[1]"})"});
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  EXPECT_EQ(scheduler.EnqueueBatch(text, now), size_t{3});
+  EXPECT(text.data() != begin);  // Handed a recycled buffer
+
+  std::vector<std::string> seen;
+  bool in_place = true;
+  scheduler.Drain(10, kBudget, now, [&](std::string_view message) {
+    in_place = in_place && message.data() >= begin && message.data() + message.size() <= end;
+    seen.emplace_back(message);
+  });
+  EXPECT(in_place);
+  EXPECT_EQ(scheduler.batches_copied(), uint64_t{0});
+  EXPECT_EQ(seen.size(), size_t{3});
+  // Snapshots first, then the queue in order
+  EXPECT(seen.size() == 3 && seen[0] == R"({"type":"IFRAME_DATA","iframes":[{"id":"a"}]})");
+  EXPECT(seen.size() == 3 && seen[1] == R"({"type":"LOG","message":"a]}{\"x"})");
+  EXPECT(seen.size() == 3 && seen[2] == R"({"type":"openURL","url":"https://x/?a=[1]"})");
+}
+
+HKCW_TEST(message_scheduler_batch_copies_when_pool_is_busy) {
+  MessageScheduler::Options options;
+  options.batch_buffers = 1;
+  MessageScheduler scheduler(options);
+  Configure(scheduler);
+  auto now = Clock::now();
+
+  std::string first = Batch({R"({"type":"LOG","n":1})", R"({"type":"LOG","n":2})"});
+  std::string second = Batch({R"({"type":"LOG","n":3})", R"({"type":"LOG","n":4})"});
+  EXPECT_EQ(scheduler.EnqueueBatch(first, now), size_t{2});
+  EXPECT_EQ(scheduler.EnqueueBatch(second, now), size_t{2});
+  EXPECT_EQ(scheduler.batches_copied(), uint64_t{1});
+
+  std::vector<std::string> seen = DrainAll(scheduler, now);
+  EXPECT_EQ(seen.size(), size_t{4});
+  EXPECT(seen.size() == 4 && seen[3] == R"({"type":"LOG","n":4})");
+
+  // Everything dispatched: the buffer is free again
+  std::string third = Batch({R"({"type":"LOG","n":5})"});
+  scheduler.EnqueueBatch(third, now);
+  EXPECT_EQ(scheduler.batches_copied(), uint64_t{1});
+}
+
+HKCW_TEST(message_scheduler_overwritten_snapshot_frees_its_batch) {
+  MessageScheduler::Options options;
+  options.batch_buffers = 2;
+  MessageScheduler scheduler(options);
+  Configure(scheduler);
+  auto now = Clock::now();
+
+  // Each batch's only pending element is the snapshot the next one replaces
+  for (int i = 0; i < 10; i++) {
+    std::string text = Batch({R"({"type":"IFRAME_DATA","frame":)" + std::to_string(i) + "}"});
+    scheduler.EnqueueBatch(text, now);
+  }
+  EXPECT_EQ(scheduler.batches_copied(), uint64_t{0});
+
+  std::vector<std::string> seen = DrainAll(scheduler, now);
+  EXPECT_EQ(seen.size(), size_t{1});
+  EXPECT(seen.size() == 1 && seen[0] == R"({"type":"IFRAME_DATA","frame":9})");
+}
+
+HKCW_TEST(message_scheduler_clear_frees_batches) {
+  MessageScheduler::Options options;
+  options.batch_buffers = 1;
+  MessageScheduler scheduler(options);
+  Configure(scheduler);
+  auto now = Clock::now();
+
+  std::string text = Batch({R"({"type":"LOG"})", R"({"type":"IFRAME_DATA"})"});
+  scheduler.EnqueueBatch(text, now);
+  scheduler.Clear();
+  EXPECT(scheduler.empty());
+
+  text = Batch({R"({"type":"LOG","after":true})"});
+  scheduler.EnqueueBatch(text, now);
+  EXPECT_EQ(scheduler.batches_copied(), uint64_t{0});
+  std::vector<std::string> seen = DrainAll(scheduler, now);
+  EXPECT(seen.size() == 1 && seen[0] == R"({"type":"LOG","after":true})");
+}
+
+HKCW_TEST(message_scheduler_rate_limits_batch_elements) {
+  MessageScheduler scheduler{MessageScheduler::Options()};
+  scheduler.SetPolicy("OPEN_URL", {5.0, 2.0, false});
+  auto now = Clock::now();
+
+  std::string text = Batch({R"({"type":"OPEN_URL","url":"a"})", R"({"type":"OPEN_URL","url":"b"})",
+                            R"({"type":"OPEN_URL","url":"c"})", R"({"type":"LOG"})"});
+  EXPECT_EQ(scheduler.EnqueueBatch(text, now), size_t{3});
+  EXPECT_EQ(scheduler.totals().rate_limited, uint64_t{1});
+  EXPECT_EQ(DrainAll(scheduler, now).size(), size_t{3});
+}
+
+HKCW_TEST(message_scheduler_buckets_hold_at_least_one_token) {
+  MessageScheduler scheduler{MessageScheduler::Options()};
+  auto now = Clock::now();
+
+  // Unlimited but under one token: still dispatches, no retry wait
+  scheduler.SetPolicy("IFRAME_DATA", {0.0, 0.5, true});
+  scheduler.SetDefaultPolicy({0.0, 0.0, false});
+  EXPECT(scheduler.Enqueue(R"({"type":"IFRAME_DATA"})", now) == MessageScheduler::Result::kQueued);
+  EXPECT(scheduler.Enqueue(R"({"type":"LOG"})", now) == MessageScheduler::Result::kQueued);
+  EXPECT_EQ(DrainAll(scheduler, now).size(), size_t{2});
+  EXPECT(scheduler.empty());
+
+  // Limited and under one token: one snapshot now, then a finite wait
+  scheduler.SetPolicy("IFRAME_DATA", {4.0, 0.25, true});
+  scheduler.Enqueue(R"({"type":"IFRAME_DATA","n":1})", now);
+  EXPECT_EQ(DrainAll(scheduler, now).size(), size_t{1});
+  scheduler.Enqueue(R"({"type":"IFRAME_DATA","n":2})", now);
+  auto result = scheduler.Drain(10, kBudget, now, [](std::string_view) {});
+  EXPECT(!result.more);
+  EXPECT(result.retry_after > Clock::duration::zero());
+  EXPECT(result.retry_after <= std::chrono::milliseconds(250));
+  EXPECT_EQ(DrainAll(scheduler, now + result.retry_after).size(), size_t{1});
+}
+
+HKCW_TEST(message_scheduler_ignores_malformed_batches) {
+  MessageScheduler scheduler{MessageScheduler::Options()};
+  auto now = Clock::now();
+
+  std::string text = R"({"type":"BATCH"})";
+  EXPECT_EQ(scheduler.EnqueueBatch(text, now), size_t{0});
+  text = R"({"type":"BATCH","messages":[{"type":"LOG")";
+  EXPECT_EQ(scheduler.EnqueueBatch(text, now), size_t{0});
+  text = R"({"type":"BATCH","tail":{"messages":[{"type":"no"}]}})";
+  EXPECT_EQ(scheduler.EnqueueBatch(text, now), size_t{0});
+  EXPECT(scheduler.empty());
+}
+
+HKCW_TEST(message_scheduler_steady_state_does_not_allocate) {
+  MessageScheduler scheduler{MessageScheduler::Options()};
+  Configure(scheduler);
+  auto now = Clock::now();
+
+  std::string iframe = R"({"type":"IFRAME_DATA","iframes":[)";
+  for (int i = 0; i < 8; i++) {
+    if (i > 0) iframe += ",";
+    iframe += R"({"id":"ad-)" + std::to_string(i) + R"(","clickUrl":"https://ads.example.com/"})";
+  }
+  iframe += "]}";
+  const std::string frame =
+      Batch({iframe, R"({"type":"TELEMETRY","fps":60})", R"({"type":"LOG","message":"tick"})"});
+
+  // The page's message buffer, refilled for every post
+  std::string buffer;
+  size_t handled = 0;
+  MessageScheduler::Handler handler = [&handled](std::string_view) { handled++; };
+  auto frame_step = [&] {
+    buffer.assign(frame);
+    scheduler.EnqueueBatch(buffer, now);
+    scheduler.Drain(64, kBudget, now, handler);
+  };
+
+  for (int i = 0; i < 16; i++) frame_step();
+  size_t before = hkcw_test::AllocationCount();
+  for (int i = 0; i < 1000; i++) frame_step();
+  EXPECT_EQ(hkcw_test::AllocationCount() - before, size_t{0});
+  EXPECT_EQ(handled, size_t{3 * 1016});
+}
@@ -0,0 +1,270 @@
+// Occlusion Cache against a simulated desktop that emits the WinEvent
+// stream Windows would, filtered to the events the watcher hooks
+
+#include <cstdint>
+#include <cwchar>
+#include <memory>
+#include <vector>
+
+#include "occlusion_cache.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+// WinEvent ids the simulation emits
+const uint32_t kForeground = 0x0003;
+const uint32_t kMinimizeStart = 0x0016;
+const uint32_t kMinimizeEnd = 0x0017;
+const uint32_t kDestroy = 0x8001;
+const uint32_t kShow = 0x8002;
+const uint32_t kHide = 0x8003;
+const uint32_t kReorder = 0x8004;
+const uint32_t kLocationChange = 0x800B;
+const uint32_t kNameChange = 0x800C;
+
+const WindowHandle kNotepad = 1;
+const WindowHandle kBrowser = 2;
+const WindowHandle kDesktop = 9;
+
+// Top-level windows, topmost first
+struct Desktop {
+  struct Window {
+    WindowHandle handle;
+    const wchar_t* class_name;
+    WindowRect rect;
+    bool visible;
+  };
+  std::vector<Window> windows = {
+      {kNotepad, L"Notepad", {100, 100, 700, 500}, true},
+      {kBrowser, L"Chrome_WidgetWin_1", {1200, 0, 1920, 800}, true},
+      {kDesktop, L"WorkerW", {0, 0, 1920, 1080}, true},
+  };
+
+  Window* Find(WindowHandle handle) {
+    for (Window& window : windows) {
+      if (window.handle == handle) return &window;
+    }
+    return nullptr;
+  }
+};
+
+class ModelWindows : public WindowSystem {
+ public:
+  explicit ModelWindows(Desktop& desktop) : desktop_(desktop) {}
+
+  WindowHandle RootFromPoint(int x, int y) override {
+    for (const Desktop::Window& window : desktop_.windows) {
+      const WindowRect& r = window.rect;
+      if (window.visible && x >= r.left && x < r.right && y >= r.top && y < r.bottom) {
+        return window.handle;
+      }
+    }
+    return 0;
+  }
+
+  bool Describe(WindowHandle root, WindowDescription& description) override {
+    const Desktop::Window* window = desktop_.Find(root);
+    if (!window) return false;
+    description.visible = window->visible;
+    description.caption_or_popup = true;
+    std::wcsncpy(description.class_name, window->class_name, 255);
+    description.rect = window->rect;
+    return true;
+  }
+
+  void EnumerateTopLevel(const std::function<void(WindowHandle root)>& callback) override {
+    for (const Desktop::Window& window : desktop_.windows) callback(window.handle);
+  }
+
+ private:
+  Desktop& desktop_;
+};
+
+// The window manager's side: every change emits what Windows would, and
+// only the hooked ranges reach the cache (each one a UI-thread wake)
+class Simulation {
+ public:
+  Simulation() : cache_(std::make_unique<ModelWindows>(desktop_), OcclusionCache::Options()) {
+    cache_.RebuildVisibleRegion(now_);
+  }
+
+  void Emit(uint32_t event, WindowHandle window) {
+    for (const WinEventRange& range : kOcclusionWinEvents) {
+      if (event >= range.first && event <= range.last) {
+        wakes_++;
+        cache_.OnWinEvent(event, window);
+        return;
+      }
+    }
+  }
+
+  // The pointer is an object of the window under it; moving it reports
+  // its location, and crossing into another window its new shape
+  void MoveCursor(int steps) {
+    for (int i = 0; i < steps; i++) {
+      Emit(kLocationChange, kDesktop);
+      if (i % 50 == 0) Emit(kNameChange, kDesktop);
+    }
+  }
+
+  void Drag(WindowHandle handle, int dx, int steps) {
+    Emit(kWinEventMoveSizeStart, handle);
+    for (int i = 0; i < steps; i++) {
+      Move(handle, dx / steps);
+      Emit(kLocationChange, handle);
+      Advance(16);
+      Settle();  // The rebuild timer may fire mid-drag
+    }
+    Emit(kWinEventMoveSizeEnd, handle);
+  }
+
+  void Move(WindowHandle handle, int dx) {
+    WindowRect& r = desktop_.Find(handle)->rect;
+    r.left += dx;
+    r.right += dx;
+  }
+
+  void Minimize(WindowHandle handle) {
+    Emit(kMinimizeStart, handle);
+    desktop_.Find(handle)->rect = {-32000, -32000, -31840, -31972};
+    Emit(kLocationChange, handle);
+  }
+
+  void SetVisible(WindowHandle handle, bool visible) {
+    desktop_.Find(handle)->visible = visible;
+    Emit(visible ? kShow : kHide, handle);
+  }
+
+  void BringToFront(WindowHandle handle) {
+    for (size_t i = 0; i < desktop_.windows.size(); i++) {
+      if (desktop_.windows[i].handle == handle) {
+        Desktop::Window window = desktop_.windows[i];
+        desktop_.windows.erase(desktop_.windows.begin() + static_cast<std::ptrdiff_t>(i));
+        desktop_.windows.insert(desktop_.windows.begin(), window);
+        break;
+      }
+    }
+    Emit(kReorder, handle);
+    Emit(kForeground, handle);
+  }
+
+  // What the plugin's settle timer does
+  void Settle() {
+    if (cache_.needs_rebuild(now_)) cache_.RebuildVisibleRegion(now_);
+  }
+
+  void Advance(uint32_t ms) { now_ += ms; }
+  bool Occluded(int x, int y) { return cache_.IsOccluded(x, y, now_); }
+
+  Desktop& desktop() { return desktop_; }
+  OcclusionCache& cache() { return cache_; }
+  uint64_t wakes() const { return wakes_; }
+
+ private:
+  Desktop desktop_;
+  OcclusionCache cache_;
+  uint32_t now_ = 100000;
+  uint64_t wakes_ = 0;
+};
+
+}  // namespace
+
+HKCW_TEST(occlusion_cache_cursor_moves_do_not_wake) {
+  Simulation sim;
+  sim.MoveCursor(1000);
+  EXPECT_EQ(sim.wakes(), uint64_t{0});
+
+  EXPECT(sim.Occluded(300, 300));
+  EXPECT(!sim.Occluded(900, 900));
+  EXPECT(sim.cache().stats().fast_path > 0);
+}
+
+HKCW_TEST(occlusion_cache_drag_waits_for_the_end) {
+  Simulation sim;
+  sim.Drag(kNotepad, 800, 50);  // To {900, 100, 1500, 500}, under the browser at 1200+
+  EXPECT_EQ(sim.wakes(), uint64_t{2});  // Start and end, not one per frame
+
+  // Mid-drag answers came from live lookups; after the end the region is
+  // rebuilt where the window landed
+  EXPECT(!sim.cache().dragging());
+  EXPECT(sim.cache().needs_rebuild(0));
+  sim.Settle();
+  uint64_t fast = sim.cache().stats().fast_path;
+  EXPECT(!sim.Occluded(300, 300));
+  EXPECT_EQ(sim.cache().stats().fast_path, fast + 1);
+  EXPECT(sim.Occluded(1000, 300));
+}
+
+HKCW_TEST(occlusion_cache_correct_during_drag) {
+  Simulation sim;
+  sim.Emit(kWinEventMoveSizeStart, kNotepad);
+  sim.Move(kNotepad, 800);
+  sim.Emit(kLocationChange, kNotepad);
+  sim.Settle();  // No region while dragging
+  EXPECT(sim.cache().dragging());
+  EXPECT(!sim.cache().needs_rebuild(0));
+  EXPECT(!sim.Occluded(300, 300));
+  EXPECT(sim.Occluded(1000, 300));
+  sim.Emit(kWinEventMoveSizeEnd, kNotepad);
+  EXPECT(sim.cache().needs_rebuild(0));
+}
+
+HKCW_TEST(occlusion_cache_follows_window_events) {
+  Simulation sim;
+  EXPECT(sim.Occluded(300, 300));
+
+  sim.Minimize(kNotepad);
+  EXPECT(!sim.Occluded(300, 300));
+  sim.Settle();
+  EXPECT(!sim.Occluded(300, 300));
+
+  sim.Emit(kMinimizeEnd, kNotepad);
+  sim.desktop().Find(kNotepad)->rect = {100, 100, 700, 500};
+  sim.Settle();
+  EXPECT(sim.Occluded(300, 300));
+
+  sim.SetVisible(kBrowser, false);
+  EXPECT(!sim.Occluded(1500, 300));
+  sim.Settle();
+  EXPECT(!sim.Occluded(1500, 300));
+  sim.SetVisible(kBrowser, true);
+  sim.Settle();
+  EXPECT(sim.Occluded(1500, 300));
+
+  // Closing: the destroyed handle is gone from the table and the region
+  sim.desktop().windows.erase(sim.desktop().windows.begin());
+  sim.Emit(kDestroy, kNotepad);
+  EXPECT(!sim.Occluded(300, 300));
+  sim.Settle();
+  EXPECT(!sim.Occluded(300, 300));
+}
+
+HKCW_TEST(occlusion_cache_foreground_change) {
+  Simulation sim;
+  // A window moved without a hooked event is picked up once it comes to
+  // the front
+  sim.Move(kBrowser, -1000);
+  sim.Emit(kLocationChange, kBrowser);  // Not hooked: the region is stale
+  sim.BringToFront(kBrowser);
+  sim.Settle();
+  EXPECT(sim.Occluded(300, 300));
+  EXPECT(sim.Occluded(800, 300));  // Only the browser covers this
+}
+
+HKCW_TEST(occlusion_cache_unhooked_moves_expire) {
+  // A programmatic move sends only EVENT_OBJECT_LOCATIONCHANGE: the region
+  // is stale until the TTL runs out
+  Simulation sim;
+  sim.Move(kNotepad, 800);
+  sim.Emit(kLocationChange, kNotepad);
+  EXPECT_EQ(sim.wakes(), uint64_t{0});
+  sim.Settle();
+  EXPECT(!sim.Occluded(1000, 300));  // Stale: still the old rectangle
+
+  sim.Advance(OcclusionCache::Options().ttl_ms);
+  sim.Settle();
+  EXPECT(sim.Occluded(1000, 300));
+  EXPECT(!sim.Occluded(300, 300));
+}
@@ -0,0 +1,35 @@
+// Preview: thumbnail downsample of a captured frame
+
+#include <cstdint>
+#include <vector>
+
+#include "bench_harness.h"
+#include "preview_thumbnail.h"
+
+using namespace hkcw_engine2;
+
+HKCW_BENCH(preview_thumbnail_downsample) {
+  struct Case {
+    const char* label;
+    int width;
+    int height;
+    int max_size;
+  };
+  const Case kCases[] = {
+      {"1920x1080 -> 320x180", 1920, 1080, 320},
+      {"3840x2160 -> 320x180", 3840, 2160, 320},
+      {"3840x2160 -> 640x360", 3840, 2160, 640},
+  };
+
+  Surface thumbnail;
+  for (const Case& c : kCases) {
+    std::vector<uint32_t> pixels(static_cast<size_t>(c.width) * c.height);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = static_cast<uint32_t>(i * 2654435761u);
+    ImageView frame{pixels.data(), c.width, c.height, c.width};
+
+    hkcw_bench::Measure(c.label, 1, [&] {
+      DownsampleThumbnail(frame, c.max_size, c.max_size, thumbnail);
+      hkcw_bench::Consume(thumbnail.pixels[0]);
+    });
+  }
+}
@@ -0,0 +1,58 @@
+// Preview: thumbnail sizing and the box downsample
+
+#include <cstdint>
+#include <vector>
+
+#include "preview_thumbnail.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+HKCW_TEST(preview_thumbnail_fits_aspect_ratio) {
+  int width = 0;
+  int height = 0;
+  FitThumbnailSize(1920, 1080, 320, 320, width, height);
+  EXPECT(width == 320 && height == 180);
+  FitThumbnailSize(1080, 1920, 320, 320, width, height);
+  EXPECT(width == 180 && height == 320);
+  FitThumbnailSize(3440, 1440, 400, 300, width, height);  // Width-limited
+  EXPECT(width == 400 && height == 167);
+  FitThumbnailSize(1920, 1080, 1000, 200, width, height);  // Height-limited
+  EXPECT(width == 355 && height == 200);
+
+  // Never upscales
+  FitThumbnailSize(200, 100, 640, 480, width, height);
+  EXPECT(width == 200 && height == 100);
+
+  // Extreme ratios keep a pixel on the short side
+  FitThumbnailSize(10000, 1, 100, 100, width, height);
+  EXPECT(width == 100 && height == 1);
+  FitThumbnailSize(0, 1080, 320, 320, width, height);
+  EXPECT(width == 0);
+}
+
+HKCW_TEST(preview_thumbnail_averages_frame) {
+  // Vertical stripes one pixel wide: a thumbnail sees their average, not
+  // whichever stripe a point sample lands on
+  const int kWidth = 1920;
+  const int kHeight = 1080;
+  std::vector<uint32_t> pixels(static_cast<size_t>(kWidth) * kHeight);
+  for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (i & 1) ? 0xFFFFFFFFu : 0xFF000000u;
+  ImageView frame{pixels.data(), kWidth, kHeight, kWidth};
+
+  Surface thumbnail;
+  DownsampleThumbnail(frame, 320, 320, thumbnail);
+  EXPECT_EQ(thumbnail.width, 320);
+  EXPECT_EQ(thumbnail.height, 180);
+  bool grey = true;
+  for (uint32_t pixel : thumbnail.pixels) {
+    uint32_t green = (pixel >> 8) & 0xFF;
+    grey &= green >= 0x7E && green <= 0x81 && (pixel >> 24) == 0xFF;
+  }
+  EXPECT(grey);
+
+  // Smaller than the box: copied as is
+  std::vector<uint32_t> small = {0xFF010203u, 0xFF040506u, 0xFF070809u, 0xFF0A0B0Cu};
+  DownsampleThumbnail({small.data(), 2, 2, 2}, 320, 320, thumbnail);
+  EXPECT(thumbnail.pixels == small);
+}
@@ -0,0 +1,123 @@
+// Request Filter: match cost per request against an EasyList-sized list
+
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "request_filter.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+// About the network-rule count of EasyList plus EasyPrivacy, in the same
+// proportions: host anchors, path fragments, typed and third-party rules,
+// a few hundred exceptions
+std::vector<std::string> SyntheticRules(size_t count) {
+  static const char* const kTlds[] = {"com", "net", "io", "org", "co"};
+  std::vector<std::string> rules;
+  rules.reserve(count);
+  for (size_t i = 0; rules.size() < count; i++) {
+    std::string n = std::to_string(i);
+    switch (i % 10) {
+      case 0: case 1: case 2: case 3: case 4:
+        rules.push_back("||adhost" + n + "." + kTlds[i % 5] + "^");
+        break;
+      case 5:
+        rules.push_back("||metrics" + n + "." + kTlds[i % 5] + "^$third-party");
+        break;
+      case 6:
+        rules.push_back("/banner" + n + "/*");
+        break;
+      case 7:
+        rules.push_back("-sponsor" + n + "-$image,script");
+        break;
+      case 8:
+        rules.push_back("/track" + n + ".gif|");
+        break;
+      default:
+        rules.push_back(i % 100 == 9 ? "@@||adhost" + std::to_string(i - 9) + ".com/consent^"
+                                     : "&adslot" + n + "=");
+        break;
+    }
+  }
+  return rules;
+}
+
+struct Request {
+  std::string url;
+  uint32_t type;
+};
+
+// Mostly ordinary page traffic, as a wallpaper with an ad iframe loads it;
+// one request in eight goes to an ad host
+std::vector<Request> SyntheticRequests(size_t count) {
+  std::vector<Request> requests;
+  requests.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    std::string n = std::to_string(i * 7919 % 100000);
+    switch (i % 8) {
+      case 0:
+        requests.push_back({"https://adhost" + n + ".com/serve/ad.js?slot=top", kResourceScript});
+        break;
+      case 1:
+        requests.push_back({"https://cdn.wallpaper.example/assets/app." + n + ".js", kResourceScript});
+        break;
+      case 2:
+        requests.push_back({"https://images.wallpaper.example/bg/4k/" + n + ".webp?w=3840&q=80",
+                            kResourceImage});
+        break;
+      case 3:
+        requests.push_back({"https://fonts.gstatic.example/s/inter/v12/" + n + ".woff2", kResourceFont});
+        break;
+      case 4:
+        requests.push_back({"https://api.weather.example/v1/forecast?lat=52.52&lon=13.40&id=" + n,
+                            kResourceXhr});
+        break;
+      case 5:
+        requests.push_back({"https://www.youtube-nocookie.example/embed/" + n + "?autoplay=1",
+                            kResourceSubdocument});
+        break;
+      case 6:
+        requests.push_back({"https://static.widget.example/css/theme-" + n + ".css", kResourceStylesheet});
+        break;
+      default:
+        requests.push_back({"https://stats.partner.example/collect?v=1&tid=UA-" + n + "&cid=555",
+                            kResourcePing});
+        break;
+    }
+  }
+  return requests;
+}
+
+RequestFilter CompiledFilter(size_t rules) {
+  RequestFilter filter;
+  for (const std::string& rule : SyntheticRules(rules)) filter.AddRule(rule);
+  filter.Compile();
+  return filter;
+}
+
+}  // namespace
+
+HKCW_BENCH(request_filter_compile) {
+  std::vector<std::string> rules = SyntheticRules(55000);
+  hkcw_bench::Measure("load + compile 55k rules", 1, [&] {
+    RequestFilter filter;
+    for (const std::string& rule : rules) filter.AddRule(rule);
+    filter.Compile();
+    hkcw_bench::Consume(filter.rule_count());
+  });
+}
+
+HKCW_BENCH(request_filter_match) {
+  std::vector<Request> requests = SyntheticRequests(4096);
+  for (size_t rules : {size_t{1000}, size_t{55000}}) {
+    RequestFilter filter = CompiledFilter(rules);
+    std::string label = "match, " + std::to_string(rules) + " rules";
+    hkcw_bench::Measure(label.c_str(), requests.size(), [&] {
+      for (const Request& request : requests) {
+        hkcw_bench::Consume(filter.ShouldBlock({request.url, "wallpaper.example", request.type}));
+      }
+    });
+  }
+}
@@ -0,0 +1,144 @@
+// Request Filter against a recorded request corpus (test/data)
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "request_filter.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+const std::string kDataDir = HKCW_TEST_DATA_DIR;
+
+uint32_t TypeFromName(const std::string& name) {
+  if (name == "script") return kResourceScript;
+  if (name == "image") return kResourceImage;
+  if (name == "stylesheet") return kResourceStylesheet;
+  if (name == "xhr") return kResourceXhr;
+  if (name == "subdocument") return kResourceSubdocument;
+  if (name == "media") return kResourceMedia;
+  if (name == "font") return kResourceFont;
+  if (name == "websocket") return kResourceWebsocket;
+  if (name == "ping") return kResourcePing;
+  if (name == "document") return kResourceDocument;
+  return kResourceOther;
+}
+
+// "block|allow <type> <document host> <url>"
+struct CorpusEntry {
+  bool block;
+  uint32_t type;
+  std::string document_host;
+  std::string url;
+  std::string line;
+};
+
+std::vector<CorpusEntry> LoadCorpus() {
+  std::vector<CorpusEntry> corpus;
+  std::ifstream file(kDataDir + "/request_corpus.txt");
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    std::istringstream fields(line);
+    std::string expected, type;
+    CorpusEntry entry;
+    fields >> expected >> type >> entry.document_host >> entry.url;
+    entry.block = expected == "block";
+    entry.type = TypeFromName(type);
+    entry.line = line;
+    corpus.push_back(entry);
+  }
+  return corpus;
+}
+
+RequestFilter LoadFixtureFilter() {
+  RequestFilter filter;
+  filter.LoadFile(kDataDir + "/filter_rules.txt");
+  filter.Compile();
+  return filter;
+}
+
+}  // namespace
+
+HKCW_TEST(request_filter_loads_list) {
+  RequestFilter filter;
+  // Header, comments, cosmetic, regex and $popup lines are skipped
+  EXPECT_EQ(filter.LoadFile(kDataDir + "/filter_rules.txt"), size_t{13});
+  EXPECT_EQ(filter.rule_count(), size_t{13});
+  EXPECT_EQ(filter.LoadFile(kDataDir + "/missing.txt"), size_t{0});
+}
+
+HKCW_TEST(request_filter_matches_corpus) {
+  RequestFilter filter = LoadFixtureFilter();
+  std::vector<CorpusEntry> corpus = LoadCorpus();
+  EXPECT(corpus.size() > 30);
+
+  size_t blocked = 0;
+  for (const CorpusEntry& entry : corpus) {
+    FilterRequest request{entry.url, entry.document_host, entry.type};
+    bool block = filter.ShouldBlock(request);
+    if (block != entry.block) {
+      hkcw_test::Fail(__FILE__, __LINE__, "corpus entry");
+      std::cerr << "    " << entry.line << std::endl;
+    }
+    if (entry.block) blocked++;
+  }
+  EXPECT_EQ(filter.checked_count(), uint64_t{corpus.size()});
+  EXPECT_EQ(filter.blocked_count(), uint64_t{blocked});
+
+  // Exceptions count the requests they let through
+  size_t exceptions = 0;
+  for (const FilterRuleStat& stat : filter.GetRuleStats()) {
+    if (stat.exception) {
+      exceptions++;
+      EXPECT_EQ(stat.hits, uint32_t{1});
+    }
+  }
+  EXPECT_EQ(exceptions, size_t{3});
+  std::vector<FilterRuleStat> top = filter.GetRuleStats(1);
+  EXPECT(top.size() == 1 && top[0].rule == "||doubleclick.net^");
+}
+
+HKCW_TEST(request_filter_main_frame_needs_document_option) {
+  RequestFilter filter;
+  filter.AddRule("/ads/*");
+  filter.AddRule("||landing.example^$document");
+  filter.Compile();
+
+  const char* page = "https://wallpaper.example/ads/index.html";
+  EXPECT(!filter.ShouldBlock({page, "wallpaper.example", kResourceDocument}));
+  EXPECT(filter.ShouldBlock({page, "wallpaper.example", kResourceSubdocument}));
+  EXPECT(filter.ShouldBlock({"https://landing.example/", "landing.example", kResourceDocument}));
+  EXPECT(!filter.ShouldBlock({"https://landing.example/", "x.example", kResourceScript}));
+}
+
+HKCW_TEST(request_filter_prefilter_turns_away_unknown_tokens) {
+  RequestFilter filter = LoadFixtureFilter();
+
+  // No token of this URL indexes a rule: every one stops at the bloom filter
+  FilterRequest clean{"https://cdn.wallpaper.test/static/app.3f9a1c.js", "wallpaper.test",
+                      kResourceScript};
+  EXPECT(!filter.ShouldBlock(clean));
+  EXPECT_EQ(filter.prefilter_passed(), uint64_t{0});
+  EXPECT_EQ(filter.prefilter_rejected(), uint64_t{8});  // https, cdn ... js
+
+  // A listed host's token gets through to its bucket
+  uint64_t rejected = filter.prefilter_rejected();
+  EXPECT(filter.ShouldBlock({"https://doubleclick.net/gpt.js", "wallpaper.example", kResourceScript}));
+  EXPECT(filter.prefilter_passed() >= 1);
+  EXPECT(filter.prefilter_rejected() > rejected);
+
+  filter.ResetStats();
+  EXPECT_EQ(filter.prefilter_passed(), uint64_t{0});
+  EXPECT_EQ(filter.prefilter_rejected(), uint64_t{0});
+
+  // Empty filter: nothing to probe
+  RequestFilter empty;
+  empty.Compile();
+  EXPECT(!empty.ShouldBlock(clean));
+  EXPECT_EQ(empty.prefilter_rejected(), uint64_t{0});
+}
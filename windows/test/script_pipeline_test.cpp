@@ -0,0 +1,183 @@
+// Script Pipeline against a stand-in WebView that completes on request
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "script_pipeline.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Clock = ScriptPipeline::Clock;
+using std::chrono::milliseconds;
+
+namespace {
+
+class StandInWebView {
+ public:
+  struct Call {
+    std::wstring script;
+    uint64_t ticket;
+  };
+
+  explicit StandInWebView(ScriptPipeline& pipeline) : pipeline_(pipeline) {
+    pipeline_.SetExecutor([this](const wchar_t* script, uint64_t ticket) {
+      if (refuse_) return false;
+      running_.push_back({script, ticket});
+      started_.push_back(script);
+      return true;
+    });
+  }
+
+  // Oldest running script finishes
+  void CompleteOne(Clock::time_point now, bool success = true) {
+    if (running_.empty()) return;
+    Call call = running_.front();
+    running_.erase(running_.begin());
+    pipeline_.Complete(call.ticket, success, now);
+  }
+
+  void set_refuse(bool refuse) { refuse_ = refuse; }
+  const std::vector<std::wstring>& started() const { return started_; }
+  const std::vector<Call>& running() const { return running_; }
+
+ private:
+  ScriptPipeline& pipeline_;
+  bool refuse_ = false;
+  std::vector<Call> running_;
+  std::vector<std::wstring> started_;
+};
+
+ScriptPipeline::Options SmallPipeline() {
+  ScriptPipeline::Options options;
+  options.max_in_flight = 2;
+  options.queue_capacity = 4;
+  return options;
+}
+
+}  // namespace
+
+HKCW_TEST(script_pipeline_bounds_in_flight) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  EXPECT(pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, now) == ScriptPipeline::Result::kStarted);
+  EXPECT(pipeline.Submit(L"b", ScriptPipeline::Policy::kQueue, 0, now) == ScriptPipeline::Result::kStarted);
+  EXPECT(pipeline.Submit(L"c", ScriptPipeline::Policy::kQueue, 0, now) == ScriptPipeline::Result::kQueued);
+  EXPECT_EQ(webview.running().size(), size_t{2});
+
+  // A completion starts the next one, in order
+  webview.CompleteOne(now + milliseconds(5));
+  EXPECT_EQ(webview.started().size(), size_t{3});
+  EXPECT(webview.started().back() == L"c");
+  EXPECT_EQ(pipeline.stats().completed, uint64_t{1});
+}
+
+HKCW_TEST(script_pipeline_coalesces_by_key) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"b", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"move 1", ScriptPipeline::Policy::kCoalesce, 1, now);
+  EXPECT(pipeline.Submit(L"move 2", ScriptPipeline::Policy::kCoalesce, 1, now) ==
+         ScriptPipeline::Result::kCoalesced);
+  EXPECT(pipeline.Submit(L"x", ScriptPipeline::Policy::kDropIfBusy, 0, now) ==
+         ScriptPipeline::Result::kDropped);
+
+  webview.CompleteOne(now);
+  EXPECT(webview.started().back() == L"move 2");
+  EXPECT_EQ(pipeline.stats().queued, size_t{0});
+}
+
+HKCW_TEST(script_pipeline_drops_when_queue_full) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  for (int i = 0; i < 6; i++) pipeline.Submit(L"s", ScriptPipeline::Policy::kQueue, 0, now);
+  EXPECT(pipeline.Submit(L"s", ScriptPipeline::Policy::kQueue, 0, now) ==
+         ScriptPipeline::Result::kDropped);
+  EXPECT_EQ(pipeline.stats().dropped, uint64_t{1});
+}
+
+HKCW_TEST(script_pipeline_tick_expires_queued_scripts) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"b", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"stale", ScriptPipeline::Policy::kQueue, 0, now);
+
+  // No further Submit or Complete: only the timer sees the deadline pass
+  pipeline.Tick(now + milliseconds(100));
+  EXPECT_EQ(pipeline.stats().expired, uint64_t{0});
+  pipeline.Tick(now + milliseconds(300));
+  EXPECT_EQ(pipeline.stats().expired, uint64_t{1});
+  EXPECT_EQ(pipeline.stats().queued, size_t{0});
+  EXPECT(pipeline.busy());  // a and b still running
+}
+
+HKCW_TEST(script_pipeline_tick_times_out_hung_renderer) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"b", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Submit(L"c", ScriptPipeline::Policy::kQueue, 0, now + milliseconds(4900));
+
+  // The renderer never answers; the tick frees both slots and starts c
+  pipeline.Tick(now + milliseconds(5001));
+  EXPECT_EQ(pipeline.stats().timed_out, uint64_t{2});
+  EXPECT(webview.started().back() == L"c");
+
+  // A late completion for a timed-out ticket is ignored
+  webview.CompleteOne(now + milliseconds(5002));
+  EXPECT_EQ(pipeline.stats().completed, uint64_t{0});
+
+  pipeline.Tick(now + milliseconds(20000));
+  EXPECT(!pipeline.busy());
+}
+
+HKCW_TEST(script_pipeline_reset_ignores_old_tickets) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, now);
+  pipeline.Reset();
+  EXPECT(!pipeline.busy());
+  webview.CompleteOne(now);
+  EXPECT_EQ(pipeline.stats().completed, uint64_t{0});
+}
+
+HKCW_TEST(script_pipeline_counts_refused_scripts) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  webview.set_refuse(true);
+
+  EXPECT(pipeline.Submit(L"a", ScriptPipeline::Policy::kQueue, 0, Clock::now()) ==
+         ScriptPipeline::Result::kFailed);
+  EXPECT_EQ(pipeline.stats().failed, uint64_t{1});
+  EXPECT(!pipeline.busy());
+}
+
+HKCW_TEST(script_pipeline_records_latency) {
+  ScriptPipeline pipeline(SmallPipeline());
+  StandInWebView webview(pipeline);
+  auto now = Clock::now();
+
+  for (int i = 1; i <= 20; i++) {
+    pipeline.Submit(L"s", ScriptPipeline::Policy::kQueue, 0, now);
+    webview.CompleteOne(now + milliseconds(i));
+  }
+  ScriptPipeline::Stats stats = pipeline.stats();
+  EXPECT(stats.latency_max_ms > 19.9 && stats.latency_max_ms < 20.1);
+  EXPECT(stats.latency_avg_ms > 10.4 && stats.latency_avg_ms < 10.6);
+  EXPECT(stats.latency_p95_ms >= 19.0);
+}
@@ -0,0 +1,66 @@
+// Script Templates: render cost per native-to-page event, against the
+// std::wstringstream builder the templates replaced
+
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#include "bench_harness.h"
+#include "script_template.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+constexpr ScriptTemplate kMouseEventScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:mouse',"
+    L"{detail:{type:{},x:{},y:{},button:0}}));})();");
+
+constexpr ScriptTemplate kTitleScript(
+    L"(function(){window.dispatchEvent(new CustomEvent('hkcw:title',{detail:{}}));})();");
+
+// The previous SendClickToWebView, as it was
+std::wstring StreamMouseEvent(const char* event_type, int x, int y) {
+  std::wstringstream script;
+  std::wstring wtype(event_type, event_type + strlen(event_type));
+  script << L"(function() {"
+         << L"  var event = new CustomEvent('hkcw:mouse', {"
+         << L"    detail: {"
+         << L"      type: '" << wtype << L"',"
+         << L"      x: " << x << L","
+         << L"      y: " << y << L","
+         << L"      button: 0"
+         << L"    }"
+         << L"  });"
+         << L"  window.dispatchEvent(event);"
+         << L"})();";
+  return script.str();
+}
+
+}  // namespace
+
+HKCW_BENCH(script_template_mouse_event) {
+  const int kEvents = 1000;
+  hkcw_bench::Measure("wstringstream builder", kEvents, [&] {
+    for (int i = 0; i < kEvents; i++) {
+      hkcw_bench::Consume(StreamMouseEvent("mousemove", i, 1080 - i).size());
+    }
+  });
+  hkcw_bench::Measure("template, stack buffer", kEvents, [&] {
+    ScriptBuffer<256> script;
+    for (int i = 0; i < kEvents; i++) {
+      kMouseEventScript.Render(script, JsString{"mousemove"}, i, 1080 - i);
+      hkcw_bench::Consume(script.length());
+    }
+  });
+}
+
+HKCW_BENCH(script_template_escape_text) {
+  // A page title mixing ASCII, markup, CJK and an emoji
+  const JsString title{"Night City </script> \xE5\xA3\x81\xE7\xBA\xB8 \xF0\x9F\x8C\x83 \"live\""};
+  hkcw_bench::Measure("JsString title (40 B)", 1, [&] {
+    ScriptBuffer<512> script;
+    kTitleScript.Render(script, title);
+    hkcw_bench::Consume(script.length());
+  });
+}
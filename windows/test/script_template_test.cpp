@@ -0,0 +1,120 @@
+// Script Templates: JsString escaping, value formatting and the
+// argument/capacity checks that keep a bad script from reaching the page
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+#include "script_template.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+constexpr ScriptTemplate kValueScript(L"f({});");
+static_assert(kValueScript.holes() == 1, "value");
+
+template <typename T>
+std::wstring Rendered(const T& value) {
+  ScriptBuffer<256> buffer;
+  if (!kValueScript.Render(buffer, value)) return L"<failed>";
+  std::wstring script = buffer.c_str();
+  return script.substr(2, script.size() - 4);  // Without f( and );
+}
+
+std::wstring Escaped(std::string_view text) {
+  return Rendered(JsString{text});
+}
+
+bool IsAscii(const std::wstring& text) {
+  for (wchar_t c : text) {
+    if (c < 0x20 || c > 0x7E) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+HKCW_TEST(script_template_escapes_markup_and_quotes) {
+  EXPECT(Escaped("") == L"''");
+  EXPECT(Escaped("plain text 123") == L"'plain text 123'");
+
+  // A literal can never end the <script> element it is embedded in
+  EXPECT(Escaped("</script>") == L"'\\x3C/script>'");
+  EXPECT(Escaped("<!--") == L"'\\x3C!--'");
+
+  EXPECT(Escaped("it's") == L"'it\\'s'");
+  EXPECT(Escaped("say \"hi\"") == L"'say \\\"hi\\\"'");
+  EXPECT(Escaped("C:\\wall\\paper") == L"'C:\\\\wall\\\\paper'");
+  EXPECT(Escaped("\\'") == L"'\\\\\\''");  // Escaped backslash, then quote
+  EXPECT(Escaped("a\nb\r\tc") == L"'a\\nb\\r\\tc'");
+}
+
+HKCW_TEST(script_template_escapes_non_ascii) {
+  // U+2028/U+2029 end a line inside older JS string literals
+  EXPECT(Escaped("a\xE2\x80\xA8" "b\xE2\x80\xA9") == L"'a\\u2028b\\u2029'");
+
+  EXPECT(Escaped("caf\xC3\xA9") == L"'caf\\u00E9'");
+  EXPECT(Escaped("\xE5\xA3\x81\xE7\xBA\xB8") == L"'\\u58C1\\u7EB8'");
+  EXPECT(Escaped("\xF0\x9F\x98\x80") == L"'\\uD83D\\uDE00'");  // Surrogate pair
+  EXPECT(Escaped("\x01\x1F\x7F") == L"'\\u0001\\u001F\\u007F'");
+  EXPECT(Escaped(std::string_view("a\0b", 3)) == L"'a\\u0000b'");
+
+  // Malformed UTF-8 decodes to U+FFFD rather than passing raw bytes through
+  EXPECT(Escaped("\xC3") == L"'\\uFFFD'");
+  EXPECT(Escaped("\xC0\xAF") == L"'\\uFFFD\\uFFFD'");
+
+  std::wstring mixed = Escaped("<b>\xE2\x80\xA8\"\xF0\x9F\x8C\x84\"</b>\n");
+  EXPECT(IsAscii(mixed));
+}
+
+HKCW_TEST(script_template_formats_values) {
+  EXPECT(Rendered(0) == L"0");
+  EXPECT(Rendered(-42) == L"-42");
+  EXPECT(Rendered(true) == L"true");
+  EXPECT(Rendered(false) == L"false");
+  EXPECT(Rendered(uint64_t{18446744073709551615u}) == L"18446744073709551615");
+  EXPECT(Rendered((std::numeric_limits<int64_t>::min)()) == L"-9223372036854775808");
+
+  constexpr ScriptTemplate kEvent(L"e({type:{},x:{},y:{},on:{}});");
+  static_assert(kEvent.holes() == 4, "type, x, y, on");
+  ScriptBuffer<128> buffer;
+  EXPECT(kEvent.Render(buffer, JsString{"click"}, 10, -3, true));
+  EXPECT(std::wstring(buffer.c_str()) == L"e({type:'click',x:10,y:-3,on:true});");
+  EXPECT_EQ(buffer.length(), std::wstring(buffer.c_str()).size());
+
+  // An empty JS block is written { } so it is not a hole
+  constexpr ScriptTemplate kBlock(L"try{{}}catch(e){ }");
+  static_assert(kBlock.holes() == 1, "one hole inside the braces");
+  EXPECT(kBlock.Render(buffer, 7));
+  EXPECT(std::wstring(buffer.c_str()) == L"try{7}catch(e){ }");
+}
+
+HKCW_TEST(script_template_rejects_bad_renders) {
+  constexpr ScriptTemplate kPair(L"p({},{});");
+  ScriptBuffer<64> buffer;
+
+  // Wrong argument count: nothing rendered
+  EXPECT(!kPair.Render(buffer, 1));
+  EXPECT(!kPair.Render(buffer, 1, 2, 3));
+  EXPECT_EQ(buffer.length(), size_t{0});
+  EXPECT(kPair.Render(buffer, 1, 2));
+
+  // Overflow: Render fails, the buffer stays terminated and within bounds
+  ScriptBuffer<16> small;
+  EXPECT(!kPair.Render(small, JsString{"a long string that cannot fit"}, 2));
+  EXPECT(small.overflowed());
+  EXPECT(small.length() < 16);
+  EXPECT_EQ(std::wstring(small.c_str()).size(), small.length());
+
+  // Escapes count against the capacity too: 4 quotes need 8 characters
+  ScriptBuffer<12> exact;
+  EXPECT(kValueScript.Render(exact, JsString{"\"\""}));  // f('\"\"'); is 11
+  EXPECT(!kValueScript.Render(exact, JsString{"\"\"\""}));
+
+  // Reusable after a failure
+  EXPECT(kPair.Render(small, 1, 2));
+  EXPECT(std::wstring(small.c_str()) == L"p(1,2);");
+}
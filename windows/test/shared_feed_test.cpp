@@ -0,0 +1,245 @@
+// Shared Feed ring against an in-memory transport and a page-side reader
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "shared_feed.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+struct TransportLog {
+  std::vector<std::string> shares;
+  std::vector<std::string> frames;
+  const uint8_t* base = nullptr;
+  bool closed = false;
+};
+
+class MemoryTransport : public SharedFeedTransport {
+ public:
+  explicit MemoryTransport(TransportLog& log) : log_(log) {}
+
+  uint8_t* Create(size_t size) override {
+    // uint32_t storage keeps the header words aligned
+    memory_.assign((size + 3) / 4, 0xFFFFFFFFu);
+    log_.base = reinterpret_cast<uint8_t*>(memory_.data());
+    return reinterpret_cast<uint8_t*>(memory_.data());
+  }
+  bool Share(const std::string& info_json) override {
+    log_.shares.push_back(info_json);
+    return true;
+  }
+  void NotifyFrame(const std::string& message_json) override {
+    log_.frames.push_back(message_json);
+  }
+  void Close() override { log_.closed = true; }
+
+ private:
+  TransportLog& log_;
+  std::vector<uint32_t> memory_;
+};
+
+std::unique_ptr<SharedFeedTransport> Transport(TransportLog& log) {
+  return std::make_unique<MemoryTransport>(log);
+}
+
+uint32_t WordAt(const uint8_t* base, size_t index) {
+  uint32_t value;
+  std::memcpy(&value, base + index * 4, 4);
+  return value;
+}
+
+// What the SDK does: latest slot, seqlock copy, retry on a torn read
+struct PageReader {
+  const uint8_t* base;
+
+  bool Read(uint32_t& sequence, uint32_t& tag, std::vector<uint8_t>& payload) const {
+    auto word = [this](size_t offset) {
+      return static_cast<const std::atomic<uint32_t>*>(
+                 static_cast<const void*>(base + offset))->load(std::memory_order_acquire);
+    };
+    uint32_t latest = word(20);
+    if (latest == 0) return false;
+    size_t stride = word(16);
+    size_t slot = SharedFeed::kHeaderSize + word(24) * stride;
+
+    uint32_t guard = word(slot);
+    if (guard & 1u) return false;
+    sequence = word(slot + 4);
+    uint32_t length = word(slot + 8);
+    tag = word(slot + 12);
+    if (length > stride - SharedFeed::kSlotHeaderSize) return false;
+    payload.resize(length);
+    for (uint32_t i = 0; i < length; i++) {
+      payload[i] = static_cast<const std::atomic<uint8_t>*>(static_cast<const void*>(
+                       base + slot + SharedFeed::kSlotHeaderSize + i))
+                       ->load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return word(slot) == guard;
+  }
+};
+
+SharedFeed::Options Small() {
+  SharedFeed::Options options;
+  options.slot_count = 3;
+  options.slot_size = 100;  // Rounded up to 112
+  return options;
+}
+
+}  // namespace
+
+HKCW_TEST(shared_feed_writes_header_and_shares) {
+  TransportLog log;
+  SharedFeed feed("spectrum", Transport(log), Small());
+  EXPECT(feed.Open());
+  EXPECT_EQ(feed.slot_size(), uint32_t{112});
+  EXPECT_EQ(feed.buffer_size(), SharedFeed::kHeaderSize + 3 * (16 + 112));
+
+  EXPECT_EQ(WordAt(log.base, 0), SharedFeed::kMagic);
+  EXPECT_EQ(WordAt(log.base, 1), SharedFeed::kLayoutVersion);
+  EXPECT_EQ(WordAt(log.base, 2), uint32_t{3});
+  EXPECT_EQ(WordAt(log.base, 3), uint32_t{112});
+  EXPECT_EQ(WordAt(log.base, 4), uint32_t{128});
+  EXPECT_EQ(WordAt(log.base, 5), uint32_t{0});  // No frame yet
+
+  EXPECT_EQ(log.shares.size(), size_t{1});
+  EXPECT(log.shares[0] == R"({"type":"HKCW_FEED","name":"spectrum","version":1})");
+  EXPECT(feed.Share());  // After a navigation
+  EXPECT_EQ(log.shares.size(), size_t{2});
+
+  feed.Close();
+  EXPECT(log.closed);
+  EXPECT(!feed.is_open());
+}
+
+HKCW_TEST(shared_feed_rotates_slots) {
+  TransportLog log;
+  SharedFeed feed("stats", Transport(log), Small());
+  feed.Open();
+  PageReader reader{log.base};
+
+  for (uint32_t i = 1; i <= 7; i++) {
+    std::vector<uint8_t> frame(i * 10, static_cast<uint8_t>(i));
+    EXPECT(feed.Publish(frame.data(), frame.size(), 100 + i));
+    EXPECT_EQ(WordAt(log.base, 5), i);
+    EXPECT_EQ(WordAt(log.base, 6), (i - 1) % 3);
+
+    uint32_t sequence = 0, tag = 0;
+    std::vector<uint8_t> payload;
+    EXPECT(reader.Read(sequence, tag, payload));
+    EXPECT_EQ(sequence, i);
+    EXPECT_EQ(tag, 100 + i);
+    EXPECT(payload == frame);
+  }
+  EXPECT_EQ(feed.sequence(), uint32_t{7});
+  EXPECT_EQ(log.frames.size(), size_t{7});
+  EXPECT(log.frames.back() == R"({"type":"HKCW_FEED_FRAME","name":"stats","sequence":7})");
+}
+
+HKCW_TEST(shared_feed_drops_oversized_frames) {
+  TransportLog log;
+  SharedFeed feed("tiles", Transport(log), Small());
+  feed.Open();
+  uint8_t small[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  EXPECT(feed.Publish(small, sizeof(small), 1));
+
+  std::vector<uint8_t> big(113, 9);
+  EXPECT(!feed.Publish(big.data(), big.size(), 2));
+  EXPECT_EQ(feed.dropped(), uint64_t{1});
+  EXPECT_EQ(feed.sequence(), uint32_t{1});
+  EXPECT_EQ(log.frames.size(), size_t{1});
+
+  // The latest frame is still the small one, and the dropped slot is empty
+  EXPECT_EQ(WordAt(log.base, 6), uint32_t{0});
+  const uint8_t* dropped_slot = log.base + SharedFeed::kHeaderSize + 128;
+  EXPECT_EQ(WordAt(dropped_slot, 0), uint32_t{2});
+  EXPECT_EQ(WordAt(dropped_slot, 2), uint32_t{0});
+  PageReader reader{log.base};
+  uint32_t sequence = 0, tag = 0;
+  std::vector<uint8_t> payload;
+  EXPECT(reader.Read(sequence, tag, payload));
+  EXPECT(payload == std::vector<uint8_t>(small, small + sizeof(small)));
+}
+
+HKCW_TEST(shared_feed_marks_slot_busy_until_commit) {
+  TransportLog log;
+  SharedFeed feed("busy", Transport(log), Small());
+  feed.Open();
+
+  size_t capacity = 0;
+  uint8_t* payload = feed.BeginFrame(capacity);
+  EXPECT_EQ(capacity, size_t{112});
+  const uint8_t* slot = payload - 16;
+  EXPECT_EQ(WordAt(slot, 0) & 1u, uint32_t{1});
+
+  // A second BeginFrame abandons the first and reopens the same slot
+  feed.BeginFrame(capacity);
+  EXPECT_EQ(WordAt(slot, 0) & 1u, uint32_t{1});
+  EXPECT(feed.CommitFrame(4, 0));
+  EXPECT_EQ(WordAt(slot, 0), uint32_t{4});  // Two write cycles
+  EXPECT_EQ(WordAt(slot, 2), uint32_t{4});
+  EXPECT(!feed.CommitFrame(4, 0));  // Nothing open
+}
+
+HKCW_TEST(shared_feed_without_notify_posts_nothing) {
+  TransportLog log;
+  SharedFeed::Options options = Small();
+  options.notify = false;
+  SharedFeed feed("polled", Transport(log), options);
+  feed.Open();
+  uint8_t data[4] = {};
+  EXPECT(feed.Publish(data, sizeof(data), 0));
+  EXPECT(log.frames.empty());
+  EXPECT_EQ(feed.sequence(), uint32_t{1});
+}
+
+HKCW_TEST(shared_feed_reader_never_sees_torn_frames) {
+  TransportLog log;
+  SharedFeed::Options options = Small();
+  options.notify = false;
+  SharedFeed feed("race", Transport(log), options);
+  feed.Open();
+
+  // Every frame is filled with one byte value that the tag repeats
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (uint32_t i = 0; i < 20000; i++) {
+      size_t room = 0;
+      uint8_t* payload = feed.BeginFrame(room);
+      uint8_t value = static_cast<uint8_t>(i);
+      for (size_t b = 0; b < room; b++) {
+        reinterpret_cast<std::atomic<uint8_t>*>(payload + b)->store(value, std::memory_order_relaxed);
+      }
+      feed.CommitFrame(room, value);
+    }
+    done = true;
+  });
+
+  PageReader reader{log.base};
+  uint64_t torn = 0;
+  std::vector<uint8_t> payload;
+  auto read = [&] {
+    uint32_t sequence = 0, tag = 0;
+    if (!reader.Read(sequence, tag, payload)) return false;
+    for (uint8_t byte : payload) {
+      if (byte != static_cast<uint8_t>(tag)) {
+        torn++;
+        break;
+      }
+    }
+    return true;
+  };
+  while (!done) read();
+  writer.join();
+  EXPECT(read());  // The writer is idle: the latest frame reads cleanly
+  EXPECT_EQ(payload.size(), size_t{112});
+  EXPECT_EQ(torn, uint64_t{0});
+}
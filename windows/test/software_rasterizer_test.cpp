@@ -0,0 +1,143 @@
+// Native Renderer: descriptor parsing and the software fills, rendered
+// into an offscreen surface (the GDI presentation stays Windows-only)
+
+#include <cstdint>
+#include <string>
+
+#include "software_rasterizer.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+using Kind = WallpaperDescriptor::Kind;
+
+namespace {
+
+uint32_t Channel(uint32_t pixel, int shift) {
+  return (pixel >> shift) & 0xFF;
+}
+
+}  // namespace
+
+HKCW_TEST(software_rasterizer_parses_descriptors) {
+  WallpaperDescriptor descriptor;
+  EXPECT(ParseWallpaperDescriptor("hkcw-color:#1e90ff", descriptor));
+  EXPECT(descriptor.kind == Kind::kColor);
+  EXPECT_EQ(descriptor.color, 0xFF1E90FFu);
+  EXPECT(ParseWallpaperDescriptor("hkcw-color:f0a", descriptor));
+  EXPECT_EQ(descriptor.color, 0xFFFF00AAu);
+  EXPECT(!ParseWallpaperDescriptor("hkcw-color:#12345", descriptor));
+  EXPECT(!ParseWallpaperDescriptor("hkcw-color:#gg0000", descriptor));
+
+  EXPECT(ParseWallpaperDescriptor("hkcw-gradient:#000000,#ffffff", descriptor));
+  EXPECT(descriptor.kind == Kind::kGradient);
+  EXPECT(descriptor.angle == 180.0f);
+  EXPECT(ParseWallpaperDescriptor("hkcw-gradient:#000,#fff,90", descriptor));
+  EXPECT_EQ(descriptor.gradient_to, 0xFFFFFFFFu);
+  EXPECT(descriptor.angle == 90.0f);
+  EXPECT(!ParseWallpaperDescriptor("hkcw-gradient:#000000", descriptor));
+
+  EXPECT(ParseWallpaperDescriptor("hkcw-image:C:/photos/a.jpg?fit=contain", descriptor));
+  EXPECT(descriptor.kind == Kind::kImage);
+  EXPECT(descriptor.fit == ImageFit::kContain);
+  EXPECT(descriptor.image_path == "C:/photos/a.jpg");
+  EXPECT(ParseWallpaperDescriptor("file:///C:/My%20Photos/b.PNG", descriptor));
+  EXPECT(descriptor.image_path == "C:/My Photos/b.PNG");
+  EXPECT(descriptor.fit == ImageFit::kCover);
+  EXPECT(!ParseWallpaperDescriptor("file:///C:/site/index.html", descriptor));
+  EXPECT(!ParseWallpaperDescriptor("https://example.com/a.jpg", descriptor));
+  EXPECT(!ParseWallpaperDescriptor("hkcw-image:", descriptor));
+}
+
+HKCW_TEST(software_rasterizer_fills_offscreen_surface) {
+  Surface surface;
+  surface.Resize(37, 21);  // Odd sizes: no row is a whole number of vectors
+  EXPECT_EQ(surface.pixels.size(), size_t{37 * 21});
+
+  WallpaperDescriptor descriptor;
+  EXPECT(ParseWallpaperDescriptor("hkcw-color:#1e90ff", descriptor));
+  EXPECT(FillDescriptor(descriptor, surface));
+  for (uint32_t pixel : surface.pixels) {
+    if (pixel != 0xFF1E90FFu) {
+      hkcw_test::Fail(__FILE__, __LINE__, "solid fill");
+      break;
+    }
+  }
+
+  EXPECT(ParseWallpaperDescriptor("hkcw-image:C:/a.jpg", descriptor));
+  EXPECT(!FillDescriptor(descriptor, surface));
+
+  Surface empty;
+  EXPECT(ParseWallpaperDescriptor("hkcw-gradient:#000,#fff", descriptor));
+  EXPECT(FillDescriptor(descriptor, empty));  // Nothing to draw, nothing touched
+  EXPECT(empty.pixels.empty());
+}
+
+HKCW_TEST(software_rasterizer_gradient_follows_css_angle) {
+  Surface surface;
+  surface.Resize(64, 48);
+
+  // 180deg: top to bottom, rows uniform
+  FillLinearGradient(surface, 0xFF000000u, 0xFFFFFFFFu, 180.0f);
+  EXPECT(Channel(surface.Row(0)[0], 0) < 0x10);
+  EXPECT(Channel(surface.Row(47)[0], 0) > 0xF0);
+  bool uniform_rows = true;
+  bool monotonic = true;
+  for (int y = 0; y < surface.height; y++) {
+    for (int x = 1; x < surface.width; x++) uniform_rows &= surface.Row(y)[x] == surface.Row(y)[0];
+    if (y > 0) monotonic &= Channel(surface.Row(y)[0], 8) >= Channel(surface.Row(y - 1)[0], 8);
+    monotonic &= Channel(surface.Row(y)[0], 24) == 0xFF;
+  }
+  EXPECT(uniform_rows);
+  EXPECT(monotonic);
+
+  // 90deg: left to right, columns uniform
+  FillLinearGradient(surface, 0xFFFF0000u, 0xFF0000FFu, 90.0f);
+  EXPECT(Channel(surface.Row(10)[0], 16) > 0xF0);
+  EXPECT(Channel(surface.Row(10)[63], 0) > 0xF0);
+  EXPECT(surface.Row(0)[20] == surface.Row(47)[20]);
+
+  // 0deg with the stops swapped draws 180deg again, within LUT rounding
+  Surface up;
+  up.Resize(64, 48);
+  FillLinearGradient(up, 0xFFFFFFFFu, 0xFF000000u, 0.0f);
+  FillLinearGradient(surface, 0xFF000000u, 0xFFFFFFFFu, 180.0f);
+  bool mirrored = true;
+  for (int y = 0; y < surface.height; y++) {
+    int difference = static_cast<int>(Channel(up.Row(y)[3], 0)) -
+                     static_cast<int>(Channel(surface.Row(y)[3], 0));
+    mirrored &= difference >= -2 && difference <= 2;
+  }
+  EXPECT(mirrored);
+}
+
+HKCW_TEST(software_rasterizer_crossfades) {
+  Surface from;
+  Surface to;
+  Surface out;
+  from.Resize(7, 3);  // 21 pixels: vector body plus a scalar tail
+  to.Resize(7, 3);
+  FillSolid(from, 0xFF000000u);
+  FillSolid(to, 0xFFC864FFu);
+
+  Crossfade(from, to, 0, out);
+  EXPECT(out.pixels == from.pixels);
+  Crossfade(from, to, 256, out);
+  EXPECT(out.pixels == to.pixels);
+  Crossfade(from, to, 1000, out);  // Clamped
+  EXPECT(out.pixels == to.pixels);
+
+  Crossfade(from, to, 128, out);
+  EXPECT_EQ(out.pixels[0], 0xFF64327Fu);
+  EXPECT_EQ(out.pixels[20], 0xFF64327Fu);
+
+  // A resize mid-fade just shows the new frame
+  Surface wide;
+  wide.Resize(9, 3);
+  FillSolid(wide, 0xFF123456u);
+  Crossfade(from, wide, 128, out);
+  EXPECT_EQ(out.width, 9);
+  EXPECT(out.pixels == wide.pixels);
+
+  out.Release();
+  EXPECT(out.pixels.capacity() == 0);
+}
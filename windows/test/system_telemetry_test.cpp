@@ -0,0 +1,314 @@
+// System Telemetry: recorded /proc and /sys text through the Linux source
+// and the sampler, decoded the way the SDK decodes it
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "system_telemetry.h"
+#include "test_harness.h"
+
+using namespace hkcw_engine2;
+namespace fs = std::filesystem;
+using Clock = TelemetrySampler::Clock;
+
+namespace {
+
+// Fixture root per test, removed afterwards
+struct ScratchDir {
+  fs::path path;
+
+  explicit ScratchDir(const char* name) {
+    path = fs::temp_directory_path() / ("hkcw_system_telemetry_" + std::string(name));
+    fs::remove_all(path);
+  }
+  ~ScratchDir() {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+
+  void Write(const std::string& relative, const std::string& text) const {
+    fs::path file = path / relative;
+    fs::create_directories(file.parent_path());
+    std::ofstream(file, std::ios::binary | std::ios::trunc) << text;
+  }
+};
+
+// The counters that move between recordings; everything else is fixed text
+struct Recording {
+  uint64_t cpu0_user, cpu0_system, cpu0_idle, cpu0_iowait;
+  uint64_t cpu1_user, cpu1_idle;
+  uint64_t mem_available_kb;
+  uint64_t lo_bytes, eth0_rx, eth0_tx;
+  uint64_t sda_read, sda_written, sda1_read, loop0_read;  // Sectors
+  int battery;
+  bool charging;
+};
+
+void WriteRecording(const ScratchDir& dir, const Recording& r) {
+  std::string u = std::to_string(r.cpu0_user + r.cpu1_user);
+  dir.Write("proc/stat",
+            "cpu  " + u + " 34 " + std::to_string(r.cpu0_system + 849) + " " +
+            std::to_string(r.cpu0_idle + r.cpu1_idle) + " 6290 127 456 0 0 0\n"
+            "cpu0 " + std::to_string(r.cpu0_user) + " 34 " + std::to_string(r.cpu0_system) + " " +
+            std::to_string(r.cpu0_idle) + " " + std::to_string(r.cpu0_iowait) + " 127 438 0 0 0\n"
+            "cpu1 " + std::to_string(r.cpu1_user) + " 0 849 " + std::to_string(r.cpu1_idle) +
+            " 2614 0 18 0 0 0\n"
+            "intr 114930548 113199788 3 0 5 263 0 4 0 0 0 0 0 0\n"
+            "ctxt 1990473\n"
+            "btime 1062191376\n"
+            "processes 2915\n"
+            "procs_running 1\n"
+            "procs_blocked 0\n"
+            "softirq 183433 0 21755 12 39 0 0 0 0 0\n");
+
+  dir.Write("proc/meminfo",
+            "MemTotal:       16318852 kB\n"
+            "MemFree:         1245084 kB\n"
+            "MemAvailable:    " + std::to_string(r.mem_available_kb) + " kB\n"
+            "Buffers:          379956 kB\n"
+            "Cached:          6604748 kB\n"
+            "SwapTotal:       2097148 kB\n");
+
+  dir.Write("proc/net/dev",
+            "Inter-|   Receive                                                |  Transmit\n"
+            " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets "
+            "errs drop fifo colls carrier compressed\n"
+            "    lo: " + std::to_string(r.lo_bytes) + "    5000    0    0    0     0          0"
+            "         0 " + std::to_string(r.lo_bytes) + "    5000    0    0    0     0       0"
+            "          0\n"
+            "  eth0: " + std::to_string(r.eth0_rx) + "   40000    0    0    0     0          0"
+            "         0 " + std::to_string(r.eth0_tx) + "   20000    0    0    0     0       0"
+            "          0\n");
+
+  dir.Write("proc/diskstats",
+            "   8       0 sda 1000 0 " + std::to_string(r.sda_read) + " 0 500 0 " +
+            std::to_string(r.sda_written) + " 0 0 0 0\n"
+            "   8       1 sda1 900 0 " + std::to_string(r.sda1_read) + " 0 400 0 30000 0 0 0 0\n"
+            "   7       0 loop0 10 0 " + std::to_string(r.loop0_read) + " 0 0 0 0 0 0 0 0\n");
+
+  dir.Write("sys/class/power_supply/BAT0/capacity", std::to_string(r.battery) + "\n");
+  dir.Write("sys/class/power_supply/BAT0/status", r.charging ? "Charging\n" : "Discharging\n");
+}
+
+// hkcw_sdk.js _onTelemetry: a keyframe replaces keys and values, a delta
+// patches index/value pairs, a delta before any keyframe is ignored
+struct PageMirror {
+  std::vector<std::string> keys;
+  std::vector<int64_t> values;
+  uint64_t last_seq = 0;
+
+  static std::vector<std::string> Array(const std::string& message, const std::string& field) {
+    std::vector<std::string> items;
+    size_t start = message.find("\"" + field + "\":[");
+    if (start == std::string::npos) return items;
+    start += field.size() + 4;
+    size_t end = message.find(']', start);
+    for (size_t i = start; i < end;) {
+      size_t comma = message.find(',', i);
+      if (comma == std::string::npos || comma > end) comma = end;
+      std::string item = message.substr(i, comma - i);
+      if (item.size() >= 2 && item.front() == '"') item = item.substr(1, item.size() - 2);
+      items.push_back(item);
+      i = comma + 1;
+    }
+    return items;
+  }
+
+  bool Apply(const std::string& message) {
+    if (message.find("{\"type\":\"HKCW_TELEMETRY\",\"seq\":") != 0) return false;
+    last_seq = std::strtoull(message.c_str() + 31, nullptr, 10);
+    std::vector<std::string> new_keys = Array(message, "keys");
+    if (!new_keys.empty()) {
+      keys = new_keys;
+      values.clear();
+      for (const std::string& value : Array(message, "values")) {
+        values.push_back(std::strtoll(value.c_str(), nullptr, 10));
+      }
+      return values.size() == keys.size();
+    }
+    if (keys.empty()) return false;
+    std::vector<std::string> pairs = Array(message, "d");
+    if (pairs.empty() || pairs.size() % 2 != 0) return false;
+    for (size_t i = 0; i < pairs.size(); i += 2) {
+      size_t index = std::strtoull(pairs[i].c_str(), nullptr, 10);
+      if (index >= values.size()) return false;
+      values[index] = std::strtoll(pairs[i + 1].c_str(), nullptr, 10);
+    }
+    return true;
+  }
+};
+
+const Recording kFirst = {1132, 1441, 11311718, 3675, 1123, 11313845, 8159426,
+                          1000000, 50000000, 8000000, 80000, 40000, 70000, 100, 80, false};
+
+Recording Advance(Recording r, uint64_t cpu1_user) {
+  // cpu0: 50 of 100 ticks busy; cpu1: cpu1_user of 100
+  r.cpu0_user += 30;
+  r.cpu0_system += 20;
+  r.cpu0_idle += 45;
+  r.cpu0_iowait += 5;
+  r.cpu1_user += cpu1_user;
+  r.cpu1_idle += 100 - cpu1_user;
+  // 1 MiB/s in, 100 KiB/s out, 2 MiB/s read, 512 KiB/s written; loopback,
+  // partitions and loop devices would double count and must not show
+  r.lo_bytes += 900000000;
+  r.eth0_rx += 1048576;
+  r.eth0_tx += 102400;
+  r.sda_read += 4096;
+  r.sda_written += 1024;
+  r.sda1_read += 4096;
+  r.loop0_read += 99999;
+  return r;
+}
+
+}  // namespace
+
+HKCW_TEST(system_telemetry_parses_recorded_proc) {
+  ScratchDir dir("parse");
+  WriteRecording(dir, kFirst);
+  dir.Write("sys/block/sda/size", "1000215216\n");
+  dir.Write("sys/block/loop0/size", "0\n");
+  dir.Write("sys/class/power_supply/BAT0/type", "Battery\n");
+  dir.Write("sys/class/power_supply/AC/type", "Mains\n");
+
+  TelemetryCounters counters;
+  EXPECT(CreateProcTelemetrySource(dir.path.string())->Read(counters));
+  EXPECT_EQ(counters.cpu_total.size(), size_t{2});  // The aggregate line is not a core
+  EXPECT_EQ(counters.cpu_total[0], uint64_t{1132 + 34 + 1441 + 11311718 + 3675 + 127 + 438});
+  EXPECT_EQ(counters.cpu_busy[0], uint64_t{1132 + 34 + 1441 + 127 + 438});
+  EXPECT_EQ(counters.cpu_busy[1], uint64_t{1123 + 849 + 18});
+  EXPECT_EQ(counters.memory_total, uint64_t{16318852} * 1024);
+  EXPECT_EQ(counters.memory_available, uint64_t{8159426} * 1024);
+  EXPECT_EQ(counters.net_rx, uint64_t{50000000});
+  EXPECT_EQ(counters.net_tx, uint64_t{8000000});
+  EXPECT_EQ(counters.disk_read, uint64_t{80000} * 512);
+  EXPECT_EQ(counters.disk_write, uint64_t{40000} * 512);
+  EXPECT_EQ(counters.battery_percent, 80);
+  EXPECT(!counters.charging);
+
+  // A tree without /proc/stat fails the read; the rest keeps defaults
+  ScratchDir empty("parse_empty");
+  fs::create_directories(empty.path);
+  TelemetryCounters missing;
+  EXPECT(!CreateProcTelemetrySource(empty.path.string())->Read(missing));
+  EXPECT_EQ(missing.battery_percent, -1);
+}
+
+HKCW_TEST(system_telemetry_deltas_round_trip) {
+  ScratchDir dir("round_trip");
+  WriteRecording(dir, kFirst);
+  dir.Write("sys/block/sda/size", "1000215216\n");
+  dir.Write("sys/block/loop0/size", "0\n");
+  dir.Write("sys/class/power_supply/BAT0/type", "Battery\n");
+
+  TelemetrySampler sampler(CreateProcTelemetrySource(dir.path.string()));
+  PageMirror page;
+  std::string message;
+  Clock::time_point start = Clock::now();
+  auto at = [start](int seconds) { return start + std::chrono::seconds(seconds); };
+
+  // First recording only primes the rates
+  EXPECT(!sampler.Sample(at(0), message));
+  EXPECT(message.empty());
+
+  // Keyframe: every value, as computed from the recorded deltas
+  Recording second = Advance(kFirst, 10);
+  WriteRecording(dir, second);
+  EXPECT(sampler.Sample(at(1), message));
+  EXPECT(message.find("\"keys\":[\"cpu\",\"cpu0\",\"cpu1\",\"memUsed\"") != std::string::npos);
+  EXPECT(page.Apply(message));
+  std::vector<int64_t> expected = {30, 50, 10, 7968, 15936, 1024, 100, 2048, 512, 80, 0};
+  EXPECT(page.values == expected);
+  EXPECT(page.values == sampler.values());
+
+  // Delta: cpu1 busier, 512 MiB less available, battery down a percent
+  Recording third = Advance(second, 40);
+  third.mem_available_kb -= 512 * 1024;
+  third.battery = 79;
+  WriteRecording(dir, third);
+  EXPECT(sampler.Sample(at(2), message));
+  EXPECT(message == "{\"type\":\"HKCW_TELEMETRY\",\"seq\":2,\"d\":[0,45,2,40,3,8480,9,79]}");
+  EXPECT(page.Apply(message));
+  expected = {45, 50, 40, 8480, 15936, 1024, 100, 2048, 512, 79, 0};
+  EXPECT(page.values == expected);
+  EXPECT(page.values == sampler.values());
+
+  // Same rates again: nothing to send
+  Recording fourth = Advance(third, 40);
+  WriteRecording(dir, fourth);
+  EXPECT(!sampler.Sample(at(3), message));
+  EXPECT(message.empty());
+
+  // Plugged in and twice the download: two fields change
+  Recording fifth = Advance(fourth, 40);
+  fifth.eth0_rx += 1048576;
+  fifth.charging = true;
+  WriteRecording(dir, fifth);
+  EXPECT(sampler.Sample(at(4), message));
+  EXPECT(message == "{\"type\":\"HKCW_TELEMETRY\",\"seq\":3,\"d\":[5,2048,10,1]}");
+  EXPECT(page.Apply(message));
+  EXPECT(page.values == sampler.values());
+  EXPECT_EQ(page.last_seq, uint64_t{3});
+
+  // A new subscriber joins: the next message is a keyframe it can start from
+  sampler.RequestKeyframe();
+  WriteRecording(dir, Advance(fifth, 40));
+  EXPECT(sampler.Sample(at(5), message));
+  PageMirror late;
+  EXPECT(late.Apply(message));
+  EXPECT(page.Apply(message));
+  EXPECT(late.values == sampler.values());
+  EXPECT(late.keys == page.keys);
+  EXPECT_EQ(sampler.stats().messages, uint64_t{4});
+}
+
+HKCW_TEST(system_telemetry_counter_resets_and_core_changes) {
+  ScratchDir dir("resets");
+  WriteRecording(dir, kFirst);
+  dir.Write("sys/block/sda/size", "1000215216\n");
+
+  TelemetrySampler sampler(CreateProcTelemetrySource(dir.path.string()));
+  PageMirror page;
+  std::string message;
+  Clock::time_point start = Clock::now();
+  EXPECT(!sampler.Sample(start, message));
+
+  Recording second = Advance(kFirst, 10);
+  WriteRecording(dir, second);
+  EXPECT(sampler.Sample(start + std::chrono::seconds(1), message));
+  EXPECT(page.Apply(message));
+
+  // Interface counters reset (driver reload): reads as no traffic, not as
+  // a huge rate from unsigned wraparound
+  Recording third = Advance(second, 10);
+  third.eth0_rx = 1000;
+  third.eth0_tx = 1000;
+  WriteRecording(dir, third);
+  EXPECT(sampler.Sample(start + std::chrono::seconds(2), message));
+  EXPECT(page.Apply(message));
+  EXPECT_EQ(page.values[5], int64_t{0});
+  EXPECT_EQ(page.values[6], int64_t{0});
+  EXPECT(page.values == sampler.values());
+
+  // A core goes offline: no rates for that sample, then a fresh keyframe
+  std::string stat;
+  {
+    std::ifstream in(dir.path / "proc/stat");
+    for (std::string line; std::getline(in, line);) {
+      if (line.compare(0, 5, "cpu1 ") != 0) stat += line + "\n";
+    }
+  }
+  dir.Write("proc/stat", stat);
+  EXPECT(!sampler.Sample(start + std::chrono::seconds(3), message));
+  dir.Write("proc/stat", stat);
+  EXPECT(sampler.Sample(start + std::chrono::seconds(4), message));
+  EXPECT(message.find("\"keys\":[\"cpu\",\"cpu0\",\"memUsed\"") != std::string::npos);
+  EXPECT(page.Apply(message));
+  EXPECT_EQ(page.keys.size(), size_t{10});
+  EXPECT(page.values == sampler.values());
+}
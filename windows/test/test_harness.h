@@ -0,0 +1,42 @@
+#ifndef HKCW_TEST_HARNESS_H_
+#define HKCW_TEST_HARNESS_H_
+
+#include <iostream>
+
+namespace hkcw_test {
+
+using TestFunction = void (*)();
+
+// Registers a test during static initialization
+struct Registration {
+  Registration(const char* name, TestFunction function);
+};
+
+// Marks the running test failed; it keeps running
+void Fail(const char* file, int line, const char* expression);
+
+}  // namespace hkcw_test
+
+// Test names are suite_case; ctest runs each suite by name prefix
+#define HKCW_TEST(name)                                                  \
+  static void name();                                                    \
+  static const hkcw_test::Registration name##_registration(#name, name); \
+  static void name()
+
+#define EXPECT(condition)                                  \
+  do {                                                     \
+    if (!(condition)) {                                    \
+      hkcw_test::Fail(__FILE__, __LINE__, #condition);     \
+    }                                                      \
+  } while (0)
+
+#define EXPECT_EQ(actual, expected)                                            \
+  do {                                                                         \
+    if (!((actual) == (expected))) {                                           \
+      hkcw_test::Fail(__FILE__, __LINE__, #actual " == " #expected);          \
+      std::cerr << "    actual: " << (actual) << ", expected: " << (expected) \
+                << std::endl;                                                  \
+    }                                                                          \
+  } while (0)
+
+#endif  // HKCW_TEST_HARNESS_H_
@@ -0,0 +1,51 @@
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "test_harness.h"
+
+namespace hkcw_test {
+
+namespace {
+
+struct Test {
+  const char* name;
+  TestFunction function;
+};
+
+std::vector<Test>& Tests() {
+  static std::vector<Test> tests;
+  return tests;
+}
+
+bool g_failed = false;
+
+}  // namespace
+
+Registration::Registration(const char* name, TestFunction function) {
+  Tests().push_back({name, function});
+}
+
+void Fail(const char* file, int line, const char* expression) {
+  g_failed = true;
+  std::cerr << file << ":" << line << ": EXPECT failed: " << expression << std::endl;
+}
+
+}  // namespace hkcw_test
+
+// Usage: hkcw_engine2_tests [name prefix]
+int main(int argc, char** argv) {
+  const char* prefix = argc > 1 ? argv[1] : "";
+  size_t run = 0;
+  size_t failed = 0;
+  for (const auto& test : hkcw_test::Tests()) {
+    if (std::strncmp(test.name, prefix, std::strlen(prefix)) != 0) continue;
+    hkcw_test::g_failed = false;
+    test.function();
+    std::cout << (hkcw_test::g_failed ? "[FAIL] " : "[ OK ] ") << test.name << std::endl;
+    run++;
+    if (hkcw_test::g_failed) failed++;
+  }
+  std::cout << run << " test(s), " << failed << " failed" << std::endl;
+  return run == 0 || failed > 0 ? 1 : 0;
+}
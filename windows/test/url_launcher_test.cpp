@@ -0,0 +1,164 @@
+// URL Launcher policy against a stub validator, launcher and clock
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "test_harness.h"
+#include "url_launcher.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+const auto kIdle = std::chrono::milliseconds(2000);
+
+// Everything under blocked.example is refused; launches are recorded
+class StubShell {
+ public:
+  UrlLauncher::Hooks Hooks() {
+    UrlLauncher::Hooks hooks;
+    hooks.validate = [](const std::string& url) {
+      return url.find("blocked.example") == std::string::npos;
+    };
+    hooks.launch = [this](const std::string& url) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      launched_.push_back(url);
+      return true;
+    };
+    hooks.now = [this] {
+      return UrlLauncher::Clock::time_point(std::chrono::milliseconds(now_ms_.load()));
+    };
+    return hooks;
+  }
+
+  void Advance(int64_t ms) { now_ms_ += ms; }
+
+  std::vector<std::string> launched() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return launched_;
+  }
+
+ private:
+  std::atomic<int64_t> now_ms_{1000000};
+  std::mutex mutex_;
+  std::vector<std::string> launched_;
+};
+
+}  // namespace
+
+HKCW_TEST(url_launcher_opens_valid_urls) {
+  StubShell shell;
+  UrlLauncher launcher(shell.Hooks(), UrlLauncher::Options());
+
+  EXPECT(launcher.Open("https://ads.example.com/a") == UrlLauncher::Result::kQueued);
+  EXPECT(launcher.WaitIdle(kIdle));
+  EXPECT_EQ(shell.launched().size(), size_t{1});
+  EXPECT_EQ(launcher.stats().launched, uint64_t{1});
+}
+
+HKCW_TEST(url_launcher_debounces_repeats) {
+  StubShell shell;
+  UrlLauncher launcher(shell.Hooks(), UrlLauncher::Options());
+
+  EXPECT(launcher.Open("https://ads.example.com/a") == UrlLauncher::Result::kQueued);
+  EXPECT(launcher.Open("https://ads.example.com/a") == UrlLauncher::Result::kDuplicate);
+  shell.Advance(1001);
+  EXPECT(launcher.Open("https://ads.example.com/a") == UrlLauncher::Result::kQueued);
+  EXPECT(launcher.WaitIdle(kIdle));
+  EXPECT_EQ(shell.launched().size(), size_t{2});
+}
+
+HKCW_TEST(url_launcher_rate_limits_launches) {
+  StubShell shell;
+  UrlLauncher launcher(shell.Hooks(), UrlLauncher::Options());
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT(launcher.Open("https://ads.example.com/" + std::to_string(i)) ==
+           UrlLauncher::Result::kQueued);
+    EXPECT(launcher.WaitIdle(kIdle));
+  }
+  EXPECT(launcher.Open("https://ads.example.com/3") == UrlLauncher::Result::kRateLimited);
+
+  shell.Advance(10000);
+  EXPECT(launcher.Open("https://ads.example.com/4") == UrlLauncher::Result::kQueued);
+  EXPECT(launcher.WaitIdle(kIdle));
+  EXPECT_EQ(shell.launched().size(), size_t{4});
+}
+
+HKCW_TEST(url_launcher_blocked_urls_do_not_use_quota) {
+  StubShell shell;
+  UrlLauncher launcher(shell.Hooks(), UrlLauncher::Options());
+
+  // A page spamming blocked URLs
+  for (int i = 0; i < 20; i++) {
+    launcher.Open("https://blocked.example/" + std::to_string(i));
+    EXPECT(launcher.WaitIdle(kIdle));
+  }
+  EXPECT_EQ(launcher.stats().rejected, uint64_t{20});
+
+  for (int i = 0; i < 3; i++) {
+    EXPECT(launcher.Open("https://ads.example.com/" + std::to_string(i)) ==
+           UrlLauncher::Result::kQueued);
+  }
+  EXPECT(launcher.WaitIdle(kIdle));
+  EXPECT_EQ(shell.launched().size(), size_t{3});
+  EXPECT_EQ(launcher.stats().rate_limited, uint64_t{0});
+}
+
+HKCW_TEST(url_launcher_charges_quota_after_validation) {
+  StubShell shell;
+  UrlLauncher launcher(shell.Hooks(), UrlLauncher::Options());
+
+  // Queued faster than the worker charges them: the fourth valid URL is
+  // refused after validation, not launched
+  for (int i = 0; i < 4; i++) {
+    launcher.Open("https://ads.example.com/" + std::to_string(i));
+  }
+  EXPECT(launcher.WaitIdle(kIdle));
+  EXPECT_EQ(shell.launched().size(), size_t{3});
+  EXPECT_EQ(launcher.stats().rate_limited, uint64_t{1});
+}
+
+HKCW_TEST(url_launcher_rejects_invalid_urls) {
+  StubShell shell;
+  UrlLauncher::Options options;
+  options.max_url_length = 32;
+  UrlLauncher launcher(shell.Hooks(), options);
+
+  EXPECT(launcher.Open("") == UrlLauncher::Result::kInvalid);
+  EXPECT(launcher.Open(std::string(33, 'a')) == UrlLauncher::Result::kInvalid);
+  EXPECT_EQ(launcher.stats().dropped, uint64_t{2});
+}
+
+HKCW_TEST(url_launcher_bounds_the_queue) {
+  StubShell shell;
+  UrlLauncher::Hooks hooks = shell.Hooks();
+
+  // The shell hangs until released
+  std::mutex gate;
+  gate.lock();
+  hooks.validate = [&gate](const std::string&) {
+    std::lock_guard<std::mutex> lock(gate);
+    return false;
+  };
+  UrlLauncher::Options options;
+  options.queue_capacity = 2;
+  UrlLauncher launcher(hooks, options);
+
+  std::vector<UrlLauncher::Result> results;
+  for (int i = 0; i < 6; i++) {
+    results.push_back(launcher.Open("https://ads.example.com/" + std::to_string(i)));
+  }
+  gate.unlock();
+  EXPECT(launcher.WaitIdle(kIdle));
+
+  // One taken by the worker (or not yet), two queued, the rest refused
+  size_t full = 0;
+  for (auto result : results) {
+    if (result == UrlLauncher::Result::kQueueFull) full++;
+  }
+  EXPECT(full >= 3 && full <= 4);
+}
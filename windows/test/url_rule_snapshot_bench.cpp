@@ -0,0 +1,110 @@
+// URL Rules: startup cost of a 50k-rule file and the per-URL lookup
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bench_harness.h"
+#include "url_rule_snapshot.h"
+
+using namespace hkcw_engine2;
+namespace fs = std::filesystem;
+
+namespace {
+
+// A blocklist export: mostly host prefixes, then path and query fragments
+// and a few thousand exceptions
+std::string SyntheticRuleFile(size_t count) {
+  std::string text = "! Synthetic URL rules\n";
+  for (size_t i = 0; i < count; i++) {
+    std::string n = std::to_string(i);
+    switch (i % 10) {
+      case 0: case 1: case 2: case 3:
+        text += "https://ads" + n + ".example.com/*\n";
+        break;
+      case 4: case 5:
+        text += "tracker" + n + ".net\n";
+        break;
+      case 6:
+        text += "/pixel/" + n + "/\n";
+        break;
+      case 7:
+        text += "?ref=aff" + n + "\n";
+        break;
+      case 8:
+        text += "@@https://ads" + std::to_string(i - 8) + ".example.com/consent*\n";
+        break;
+      default:
+        text += "@@cdn" + n + ".static\n";
+        break;
+    }
+  }
+  return text;
+}
+
+std::vector<std::string> SyntheticUrls(size_t count) {
+  std::vector<std::string> urls;
+  urls.reserve(count);
+  for (size_t i = 0; i < count; i++) {
+    std::string n = std::to_string(i * 7919 % 100000);
+    switch (i % 4) {
+      case 0: urls.push_back("https://ads" + n + ".example.com/serve/ad.js?slot=top"); break;
+      case 1: urls.push_back("https://cdn.wallpaper.example/assets/app." + n + ".js"); break;
+      case 2: urls.push_back("https://www.youtube-nocookie.example/embed/" + n + "?autoplay=1"); break;
+      default: urls.push_back("https://shop.example/item/" + n + "?ref=aff" + n); break;
+    }
+  }
+  return urls;
+}
+
+struct RuleFile {
+  fs::path dir = fs::temp_directory_path() / "hkcw_url_rules_bench";
+  std::string source;
+  std::string snapshot;
+
+  explicit RuleFile(size_t count) {
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    source = (dir / "rules.txt").string();
+    snapshot = source + ".snapshot";
+    std::ofstream(source, std::ios::binary) << SyntheticRuleFile(count);
+  }
+  ~RuleFile() {
+    std::error_code ec;
+    fs::remove_all(dir, ec);
+  }
+};
+
+}  // namespace
+
+HKCW_BENCH(url_rule_snapshot_load) {
+  RuleFile file(50000);
+  hkcw_bench::Measure("rebuild 50k rules", 1, [&] {
+    fs::remove(file.snapshot);
+    hkcw_bench::MuteLog mute;
+    UrlRuleSnapshot snapshot;
+    hkcw_bench::Consume(snapshot.Load(file.source, file.snapshot));
+  });
+  hkcw_bench::Measure("map 50k-rule snapshot", 1, [&] {
+    hkcw_bench::MuteLog mute;
+    UrlRuleSnapshot snapshot;
+    hkcw_bench::Consume(snapshot.Load(file.source, file.snapshot));
+  });
+}
+
+HKCW_BENCH(url_rule_snapshot_match) {
+  RuleFile file(50000);
+  UrlRuleSnapshot snapshot;
+  {
+    hkcw_bench::MuteLog mute;
+    snapshot.Load(file.source, file.snapshot);
+  }
+  std::vector<std::string> urls = SyntheticUrls(4096);
+  hkcw_bench::Measure("match both lists, 50k rules", urls.size(), [&] {
+    for (const std::string& url : urls) {
+      hkcw_bench::Consume(snapshot.Match(url, UrlRuleSnapshot::kWhitelist).size() +
+                          snapshot.Match(url, UrlRuleSnapshot::kBlacklist).size());
+    }
+  });
+}
@@ -0,0 +1,252 @@
+// URL Rules: snapshot build, reuse and the prefix/gram index, checked
+// against a plain scan of the same rules
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test_harness.h"
+#include "url_rule_snapshot.h"
+
+using namespace hkcw_engine2;
+namespace fs = std::filesystem;
+
+namespace {
+
+// Fresh directory per test, removed afterwards
+struct ScratchDir {
+  fs::path path;
+
+  explicit ScratchDir(const char* name) {
+    path = fs::temp_directory_path() / ("hkcw_url_rules_" + std::string(name));
+    fs::remove_all(path);
+    fs::create_directories(path);
+  }
+  ~ScratchDir() {
+    std::error_code ec;
+    fs::remove_all(path, ec);
+  }
+
+  std::string Write(const char* name, const std::string& contents) const {
+    std::string file = (path / name).string();
+    std::ofstream(file, std::ios::binary | std::ios::trunc) << contents;
+    return file;
+  }
+  size_t FileCount() const {
+    size_t count = 0;
+    for (const auto& entry : fs::directory_iterator(path)) count += entry.is_regular_file() ? 1 : 0;
+    return count;
+  }
+};
+
+std::string Join(const std::vector<std::string>& lines) {
+  std::string text;
+  for (const std::string& line : lines) text += line + "\n";
+  return text;
+}
+
+// URLValidator::MatchesPattern over already lowercased text
+bool ScanMatches(const std::vector<std::string>& rules, const std::string& url, UrlRuleSnapshot::List list) {
+  for (std::string rule : rules) {
+    if (rule.empty() || rule[0] == '!' || rule[0] == '#') continue;
+    bool white = rule.compare(0, 2, "@@") == 0;
+    if (white != (list == UrlRuleSnapshot::kWhitelist)) continue;
+    if (white) rule = rule.substr(2);
+    size_t star = rule.find('*');
+    if (star != std::string::npos ? url.compare(0, star, rule, 0, star) == 0 && star > 0
+                                  : url.find(rule) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Overlapping prefixes and grams shared by many patterns, so buckets and
+// the binary search both see collisions
+std::vector<std::string> SyntheticRules(size_t count) {
+  std::vector<std::string> rules;
+  rules.reserve(count);
+  for (size_t i = 0; rules.size() < count; i++) {
+    std::string n = std::to_string(i);
+    switch (i % 8) {
+      case 0: rules.push_back("https://ads" + n + ".example.com/*"); break;
+      case 1: rules.push_back("tracker" + n + ".net"); break;
+      case 2: rules.push_back("/pixel/" + n + "/"); break;
+      case 3: rules.push_back("http://promo.example/" + n + "*"); break;
+      case 4: rules.push_back("@@https://ads" + std::to_string(i - 4) + ".example.com/ok*"); break;
+      case 5: rules.push_back("@@cdn" + n + ".static"); break;
+      case 6: rules.push_back("?ref=aff" + n); break;
+      default: rules.push_back("https://www.example.com/promo/" + n); break;
+    }
+  }
+  return rules;
+}
+
+}  // namespace
+
+HKCW_TEST(url_rule_snapshot_matches_prefix_and_substring) {
+  ScratchDir dir("basic");
+  std::string source = dir.Write("rules.txt", Join({
+      "! comment", "# comment", "",
+      "  HTTPS://Evil.example/*  ",
+      "@@https://good.example*",
+      "tracker",
+      "ad",
+      "file:///c:/windows*",
+  }));
+
+  UrlRuleSnapshot snapshot;
+  EXPECT(snapshot.Load(source, source + ".snapshot"));
+  EXPECT(snapshot.rebuilt());
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kWhitelist), size_t{1});
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kBlacklist), size_t{4});
+
+  EXPECT(snapshot.Match("https://evil.example/x", UrlRuleSnapshot::kBlacklist) == "https://evil.example/");
+  EXPECT(snapshot.Match("http://evil.example/x", UrlRuleSnapshot::kBlacklist).empty());
+  EXPECT(snapshot.Match("https://a.test/?tracker=1", UrlRuleSnapshot::kBlacklist) == "tracker");
+  EXPECT(snapshot.Match("https://a.test/load", UrlRuleSnapshot::kBlacklist) == "ad");  // Shorter than a gram
+  EXPECT(snapshot.Match("file:///c:/windows/system32", UrlRuleSnapshot::kBlacklist) == "file:///c:/windows");
+  EXPECT(snapshot.Match("https://good.example/", UrlRuleSnapshot::kWhitelist) == "https://good.example");
+  EXPECT(snapshot.Match("https://good.example/", UrlRuleSnapshot::kBlacklist).empty());
+  EXPECT(snapshot.Match("", UrlRuleSnapshot::kBlacklist).empty());
+}
+
+HKCW_TEST(url_rule_snapshot_index_agrees_with_scan) {
+  ScratchDir dir("index");
+  std::vector<std::string> rules = SyntheticRules(4000);
+  // Prefixes of each other: the search must back off to the shorter one
+  rules.push_back("https://nested.example/*");
+  rules.push_back("https://nested.example/a/b/*");
+  rules.push_back("https://nested.example/a/bz*");
+  std::string source = dir.Write("rules.txt", Join(rules));
+
+  UrlRuleSnapshot snapshot;
+  EXPECT(snapshot.Load(source, source + ".snapshot"));
+
+  std::vector<std::string> urls = {
+      "https://ads8.example.com/banner.js", "https://ads8.example.com/ok/1",
+      "https://ads9.example.com/banner.js", "https://x.test/?ref=aff6&y=1",
+      "https://x.test/?ref=aff7", "https://cdn5.static/app.js",
+      "https://img.test/pixel/2/a.gif", "https://img.test/pixel/3/a.gif",
+      "http://promo.example/3", "http://promo.example/30",
+      "http://promo.example/", "https://www.example.com/promo/3999",
+      "https://nested.example/a/b", "https://nested.example/a/c",
+      "https://nested.example/a/bz", "https://nested.example",
+      "https://clean.test/index.html", "t", "",
+  };
+  for (size_t i = 0; i < 500; i++) {
+    urls.push_back("https://site" + std::to_string(i) + ".test/tracker" + std::to_string(i * 37 % 4000) +
+                   ".net/x?ref=aff" + std::to_string(i * 13));
+  }
+
+  for (const std::string& url : urls) {
+    for (UrlRuleSnapshot::List list : {UrlRuleSnapshot::kWhitelist, UrlRuleSnapshot::kBlacklist}) {
+      bool indexed = !snapshot.Match(url, list).empty();
+      if (indexed != ScanMatches(rules, url, list)) {
+        hkcw_test::Fail(__FILE__, __LINE__, "index and scan disagree");
+        std::cerr << "    " << url << " (list " << int{list} << ")" << std::endl;
+      }
+    }
+  }
+}
+
+HKCW_TEST(url_rule_snapshot_empty_file_loads_empty) {
+  ScratchDir dir("empty");
+  std::string source = dir.Write("rules.txt", "");
+
+  UrlRuleSnapshot snapshot;
+  EXPECT(snapshot.Load(source, source + ".snapshot"));
+  EXPECT(snapshot.is_loaded());
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kWhitelist), size_t{0});
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kBlacklist), size_t{0});
+  EXPECT(snapshot.Match("https://any.test/", UrlRuleSnapshot::kBlacklist).empty());
+
+  // Only comments: also empty
+  dir.Write("rules.txt", "! nothing yet\n");
+  EXPECT(snapshot.Load(source, source + ".snapshot"));
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kBlacklist), size_t{0});
+
+  EXPECT(!snapshot.Load((dir.path / "missing.txt").string(), source + ".snapshot"));
+  EXPECT(!snapshot.is_loaded());
+}
+
+HKCW_TEST(url_rule_snapshot_reuses_and_rebuilds) {
+  ScratchDir dir("reuse");
+  std::string source = dir.Write("rules.txt", "tracker\n");
+  std::string path = source + ".snapshot";
+
+  UrlRuleSnapshot snapshot;
+  EXPECT(snapshot.Load(source, path) && snapshot.rebuilt());
+  EXPECT(snapshot.Load(source, path) && !snapshot.rebuilt());
+
+  // Different contents: rebuilt
+  dir.Write("rules.txt", "tracker\nbeacon\n");
+  EXPECT(snapshot.Load(source, path) && snapshot.rebuilt());
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kBlacklist), size_t{2});
+
+  // A damaged snapshot is never mapped
+  snapshot.Close();
+  {
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(24);  // entries_offset
+    file.write("\xFF\xFF\xFF\xFF", 4);
+  }
+  EXPECT(snapshot.Load(source, path) && snapshot.rebuilt());
+  EXPECT(snapshot.Match("https://a.test/beacon", UrlRuleSnapshot::kBlacklist) == "beacon");
+  fs::resize_file(path, 20);
+  EXPECT(snapshot.Load(source, path) && snapshot.rebuilt());
+
+  // Rebuilds go through a temporary file that does not stay behind
+  EXPECT_EQ(dir.FileCount(), size_t{2});
+}
+
+HKCW_TEST(url_rule_snapshot_replaces_while_mapped) {
+  ScratchDir dir("replace");
+  std::string source = dir.Write("rules.txt", "tracker\n");
+  std::string path = source + ".snapshot";
+
+  UrlRuleSnapshot live;
+  EXPECT(live.Load(source, path));
+
+  // A reload builds while the live one is still mapped and in use
+  dir.Write("rules.txt", "beacon\n");
+  UrlRuleSnapshot loaded;
+  EXPECT(loaded.Load(source, path) && loaded.rebuilt());
+  EXPECT(live.Match("https://a.test/tracker", UrlRuleSnapshot::kBlacklist) == "tracker");
+
+  live.swap(loaded);
+  loaded.Close();
+  EXPECT(live.FinishRename());
+  EXPECT(live.Match("https://a.test/beacon", UrlRuleSnapshot::kBlacklist) == "beacon");
+  EXPECT(live.Match("https://a.test/tracker", UrlRuleSnapshot::kBlacklist).empty());
+  EXPECT_EQ(dir.FileCount(), size_t{2});
+
+  // The next start maps what the reload left
+  UrlRuleSnapshot next;
+  EXPECT(next.Load(source, path) && !next.rebuilt());
+}
+
+HKCW_TEST(url_rule_snapshot_loads_large_list_quickly) {
+  ScratchDir dir("large");
+  std::string source = dir.Write("rules.txt", Join(SyntheticRules(50000)));
+  std::string path = source + ".snapshot";
+
+  using Clock = std::chrono::steady_clock;
+  UrlRuleSnapshot snapshot;
+  auto start = Clock::now();
+  EXPECT(snapshot.Load(source, path) && snapshot.rebuilt());
+  auto cold = Clock::now() - start;
+
+  start = Clock::now();
+  EXPECT(snapshot.Load(source, path) && !snapshot.rebuilt());
+  auto warm = Clock::now() - start;
+  EXPECT_EQ(snapshot.count(UrlRuleSnapshot::kBlacklist) + snapshot.count(UrlRuleSnapshot::kWhitelist),
+            size_t{50000});
+
+  // Generous bounds, for slow CI machines; the benchmark has the real figures
+  EXPECT(cold < std::chrono::milliseconds(500));
+  EXPECT(warm < std::chrono::milliseconds(100));
+}
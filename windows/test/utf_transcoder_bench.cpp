@@ -0,0 +1,56 @@
+// UTF Transcoding: message-sized and page-sized strings both ways
+
+#include <string>
+
+#include "bench_harness.h"
+#include "utf_transcoder.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+// A postMessage payload: JSON, mostly ASCII
+std::string JsonMessage() {
+  return "{\"type\":\"mouse\",\"x\":1280,\"y\":720,\"buttons\":1,\"modifiers\":[\"shift\"],"
+         "\"target\":\"wallpaper-canvas\",\"timestamp\":1729238400123}";
+}
+
+// Page text in a mix of scripts
+std::string MixedText(size_t bytes) {
+  static const char* const kWords[] = {"wallpaper ", "\xE5\xA3\x81\xE7\xBA\xB8 ", "caf\xC3\xA9 ",
+                                       "\xF0\x9F\x8C\x84 ", "\xD0\xBE\xD0\xB1\xD0\xBE\xD0\xB8 "};
+  std::string text;
+  for (size_t i = 0; text.size() < bytes; i++) text += kWords[i % 5];
+  return text;
+}
+
+}  // namespace
+
+HKCW_BENCH(utf_transcoder_convert) {
+  struct Case {
+    const char* label;
+    std::string text;
+  };
+  const Case kCases[] = {
+      {"JSON message (120 B)", JsonMessage()},
+      {"ASCII page (64 KiB)", std::string(65536, 'a')},
+      {"mixed scripts (64 KiB)", MixedText(65536)},
+  };
+
+  std::u16string wide;
+  std::string narrow;
+  for (const Case& c : kCases) {
+    std::string label = std::string("utf8 -> utf16, ") + c.label;
+    hkcw_bench::Measure(label.c_str(), 1, [&] {
+      Utf8ToUtf16(c.text, wide);
+      hkcw_bench::Consume(wide.size());
+    });
+
+    Utf8ToUtf16(c.text, wide);
+    label = std::string("utf16 -> utf8, ") + c.label;
+    hkcw_bench::Measure(label.c_str(), 1, [&] {
+      Utf16ToUtf8(wide, narrow);
+      hkcw_bench::Consume(narrow.size());
+    });
+  }
+}
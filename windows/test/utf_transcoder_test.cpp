@@ -0,0 +1,145 @@
+// UTF Transcoding: ASCII fast paths at vector boundaries, surrogates and
+// malformed input
+
+#include <string>
+
+#include "allocation_counter.h"
+#include "test_harness.h"
+#include "utf_transcoder.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+std::u16string ToUtf16(std::string_view in) {
+  std::u16string out;
+  Utf8ToUtf16(in, out);
+  return out;
+}
+
+std::string ToUtf8(std::u16string_view in) {
+  std::string out;
+  Utf16ToUtf8(in, out);
+  return out;
+}
+
+const char kReplacementUtf8[] = "\xEF\xBF\xBD";
+
+}  // namespace
+
+HKCW_TEST(utf_transcoder_ascii_across_vector_boundary) {
+  // Every length around the 16-unit blocks, with one non-ASCII character
+  // moved through the positions either side of each block edge
+  for (size_t length = 0; length <= 40; length++) {
+    std::string ascii;
+    for (size_t i = 0; i < length; i++) ascii.push_back(static_cast<char>('!' + i * 7 % 90));
+    std::u16string wide = ToUtf16(ascii);
+    EXPECT_EQ(wide.size(), length);
+    EXPECT(ToUtf8(wide) == ascii);
+
+    for (size_t position : {size_t{14}, size_t{15}, size_t{16}, size_t{17}, size_t{31}, size_t{32}}) {
+      if (position > length) continue;
+      std::string mixed = ascii;
+      mixed.insert(position, "\xC3\xA9");  // é
+      std::u16string mixed_wide = ToUtf16(mixed);
+      if (mixed_wide.size() != length + 1 || mixed_wide[position] != u'é' ||
+          ToUtf8(mixed_wide) != mixed) {
+        hkcw_test::Fail(__FILE__, __LINE__, "non-ASCII at block edge");
+        std::cerr << "    length " << length << ", position " << position << std::endl;
+      }
+    }
+  }
+
+  // A 0x80+ unit inside a block stops the narrow fast path too
+  std::u16string block(16, u'a');
+  block[9] = u'Ā';
+  EXPECT(ToUtf8(block) == "aaaaaaaaa\xC4\x80" "aaaaaa");
+}
+
+HKCW_TEST(utf_transcoder_multibyte_and_surrogate_pairs) {
+  EXPECT(ToUtf16("\xE2\x82\xAC") == u"€");  // 3 bytes
+  EXPECT(ToUtf16("\xF0\x9F\x98\x80") == u"\U0001F600");
+  EXPECT(ToUtf16("\xF4\x8F\xBF\xBF") == u"\U0010FFFF");
+  EXPECT(ToUtf8(u"\U0001F600") == "\xF0\x9F\x98\x80");
+  EXPECT(ToUtf8(u"x\U0001F600y€") == "x\xF0\x9F\x98\x80y\xE2\x82\xAC");
+
+  // Pairs straddling the 1024-unit encode chunks stay whole
+  for (size_t offset : {size_t{1022}, size_t{1023}, size_t{1024}, size_t{2047}}) {
+    std::u16string long_text(offset, u'a');
+    long_text += u"\U0001F600tail";
+    std::string expected(offset, 'a');
+    expected += "\xF0\x9F\x98\x80tail";
+    if (ToUtf8(long_text) != expected) {
+      hkcw_test::Fail(__FILE__, __LINE__, "pair split across chunks");
+      std::cerr << "    offset " << offset << std::endl;
+    }
+  }
+
+  std::string text = "Wallpaper \xE5\xA3\x81\xE7\xBA\xB8 \xF0\x9F\x8C\x84 caf\xC3\xA9";
+  EXPECT(ToUtf8(ToUtf16(text)) == text);
+
+  uint32_t code_point = 0;
+  EXPECT_EQ(DecodeUtf8CodePoint(text, 10, code_point), size_t{3});
+  EXPECT_EQ(code_point, uint32_t{0x58C1});
+  EXPECT_EQ(DecodeUtf8CodePoint(text, 17, code_point), size_t{4});
+  EXPECT_EQ(code_point, uint32_t{0x1F304});
+  EXPECT_EQ(DecodeUtf8CodePoint(text, 0, code_point), size_t{1});
+  EXPECT_EQ(code_point, uint32_t{'W'});
+}
+
+HKCW_TEST(utf_transcoder_lone_surrogates_become_replacement) {
+  std::string r = kReplacementUtf8;
+  EXPECT(ToUtf8(std::u16string(1, char16_t{0xD83D})) == r);             // High at the end
+  EXPECT(ToUtf8(std::u16string(1, char16_t{0xDE00})) == r);             // Low alone
+  EXPECT(ToUtf8(std::u16string{0xD83D, u'a'}) == r + "a");              // High, then not low
+  EXPECT(ToUtf8(std::u16string{0xDE00, 0xD83D}) == r + r);              // Reversed pair
+  EXPECT(ToUtf8(std::u16string{0xD83D, 0xD83D, 0xDE00}) == r + "\xF0\x9F\x98\x80");
+}
+
+HKCW_TEST(utf_transcoder_malformed_utf8_becomes_replacement) {
+  const std::u16string r(1, char16_t{0xFFFD});
+
+  // Overlong forms: one U+FFFD per byte
+  EXPECT(ToUtf16("\xC0\x80") == r + r);
+  EXPECT(ToUtf16("\xC1\xBF") == r + r);
+  EXPECT(ToUtf16("\xE0\x80\xAF") == r + r + r);
+  EXPECT(ToUtf16("\xF0\x80\x80\xAF") == r + r + r + r);
+
+  // Encoded surrogates and values past U+10FFFF
+  EXPECT(ToUtf16("\xED\xA0\x80") == r + r + r);
+  EXPECT(ToUtf16("\xF4\x90\x80\x80") == r + r + r + r);
+
+  // Truncated sequences, at the end and before ASCII that resynchronizes
+  EXPECT(ToUtf16("a\xE2\x82") == u"a" + r + r);
+  EXPECT(ToUtf16("\xF0\x9F\x98") == r + r + r);
+  EXPECT(ToUtf16("\xE2\x82" "b") == r + r + u"b");
+  EXPECT(ToUtf16("\xC3") == r);
+
+  // Stray continuation bytes and invalid leads
+  EXPECT(ToUtf16("\x80\xBF") == r + r);
+  EXPECT(ToUtf16("\xFF\xFEok") == r + r + u"ok");
+}
+
+HKCW_TEST(utf_transcoder_reuses_buffers) {
+  std::string narrow;
+  std::u16string wide;
+  std::string text(300, 'x');
+  text += "\xE2\x82\xAC\xF0\x9F\x98\x80";
+  Utf8ToUtf16(text, wide);
+  Utf16ToUtf8(wide, narrow);
+  EXPECT(narrow == text);
+
+  // Same or shorter input: no allocation
+  size_t before = hkcw_test::AllocationCount();
+  for (int i = 0; i < 10; i++) {
+    Utf8ToUtf16(text, wide);
+    Utf16ToUtf8(wide, narrow);
+    Utf8ToUtf16("short", wide);
+    Utf16ToUtf8(u"short", narrow);
+  }
+  EXPECT_EQ(hkcw_test::AllocationCount() - before, size_t{0});
+
+  Utf8ToUtf16("", wide);
+  Utf16ToUtf8(u"", narrow);
+  EXPECT(wide.empty() && narrow.empty());
+}
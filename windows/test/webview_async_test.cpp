@@ -0,0 +1,166 @@
+// WebView Async: delivery order, cancellation before and after a result,
+// the error path, and matching a navigation to its completion
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "test_harness.h"
+#include "webview_async.h"
+
+using namespace hkcw_engine2;
+
+namespace {
+
+const AsyncStatus kOk = 0;
+const AsyncStatus kFailed = static_cast<int32_t>(0x80004005u);  // E_FAIL
+
+}  // namespace
+
+HKCW_TEST(webview_async_continuations_run_in_order) {
+  auto async = Async<int>::Create();
+  std::vector<std::string> order;
+  async.Then(CancellationToken(), [&](AsyncStatus, int value) { order.push_back("a" + std::to_string(value)); });
+  async.Then(CancellationToken(), [&](AsyncStatus, int value) { order.push_back("b" + std::to_string(value)); });
+  EXPECT(order.empty());
+  EXPECT(!async.done());
+
+  async.Resolve(kOk, 7);
+  EXPECT(async.done());
+  EXPECT(order == (std::vector<std::string>{"a7", "b7"}));
+
+  // Added after the result: runs at once, in place
+  async.Then(CancellationToken(), [&](AsyncStatus, int value) { order.push_back("c" + std::to_string(value)); });
+  EXPECT_EQ(order.size(), size_t{3});
+  EXPECT(order[2] == "c7");
+
+  // Delivered once: a second result is ignored
+  async.Resolve(kFailed, 8);
+  EXPECT_EQ(async.status(), kOk);
+  EXPECT_EQ(order.size(), size_t{3});
+
+  // Chained inside a continuation: delivered in place, before the outer
+  // result reaches its later waiters
+  auto first = Async<int>::Create();
+  auto second = Async<int>::Create();
+  std::vector<int> chained;
+  first.Then(CancellationToken(), [&](AsyncStatus, int value) {
+    chained.push_back(value);
+    second.Then(CancellationToken(), [&](AsyncStatus, int next) { chained.push_back(next); });
+    second.Resolve(kOk, value + 1);
+  });
+  first.Then(CancellationToken(), [&](AsyncStatus, int value) { chained.push_back(value * 10); });
+  first.Resolve(kOk, 1);
+  EXPECT(chained == (std::vector<int>{1, 2, 10}));
+}
+
+HKCW_TEST(webview_async_cancel_before_result) {
+  CancellationSource source;
+  auto async = Async<std::string>::Create();
+  bool ran = false;
+  std::string handed_back;
+  async.Then(source.token(), [&](AsyncStatus, const std::string&) { ran = true; },
+             [&](const std::string& value) { handed_back = value; });
+  bool other_ran = false;
+  async.Then(CancellationToken(), [&](AsyncStatus, const std::string&) { other_ran = true; });
+
+  source.Cancel();
+  EXPECT(handed_back.empty());  // Nothing to hand back until the result arrives
+  async.Resolve(kOk, "controller");
+  EXPECT(!ran);
+  EXPECT(handed_back == "controller");  // The cancel handler can release it
+  EXPECT(other_ran);  // Other tokens are unaffected
+
+  // Tokens taken after Cancel start fresh
+  CancellationToken fresh = source.token();
+  EXPECT(!fresh.cancelled());
+  bool fresh_ran = false;
+  async.Then(fresh, [&](AsyncStatus, const std::string&) { fresh_ran = true; });
+  EXPECT(fresh_ran);
+
+  // A cancelled token without a cancel handler just drops the result
+  CancellationSource dropped;
+  CancellationToken dropped_token = dropped.token();
+  dropped.Cancel();
+  EXPECT(dropped_token.cancelled());
+  async.Then(dropped_token, [&](AsyncStatus, const std::string&) { ran = true; });
+  EXPECT(!ran);
+}
+
+HKCW_TEST(webview_async_cancel_after_result) {
+  CancellationSource source;
+  auto async = Async<int>::Create();
+  int runs = 0;
+  int cancels = 0;
+  async.Then(source.token(), [&](AsyncStatus, int) { runs++; }, [&](int) { cancels++; });
+  async.Resolve(kOk, 1);
+  EXPECT_EQ(runs, 1);
+
+  // Too late to matter for what already ran
+  source.Cancel();
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(cancels, 0);
+
+  // A token cancelled before Then on a finished result gets the cancel handler
+  CancellationSource late;
+  CancellationToken token = late.token();
+  late.Cancel();
+  async.Then(token, [&](AsyncStatus, int) { runs++; }, [&](int) { cancels++; });
+  EXPECT_EQ(runs, 1);
+  EXPECT_EQ(cancels, 1);
+
+  // The default token is never cancelled
+  EXPECT(!CancellationToken().cancelled());
+}
+
+HKCW_TEST(webview_async_error_path) {
+  // A call that fails to start resolves at once with its status
+  Async<bool> failed = Async<bool>::Resolved(kFailed, false);
+  EXPECT(failed.done());
+  EXPECT_EQ(failed.status(), kFailed);
+  AsyncStatus seen = kOk;
+  bool value = true;
+  failed.Then(CancellationToken(), [&](AsyncStatus status, bool result) {
+    seen = status;
+    value = result;
+  });
+  EXPECT_EQ(seen, kFailed);
+  EXPECT(!value);
+
+  // Invalid: nothing to wait on, nothing runs
+  Async<int> invalid;
+  EXPECT(!invalid.valid());
+  EXPECT(!invalid.done());
+  bool ran = false;
+  invalid.Then(CancellationToken(), [&](AsyncStatus, int) { ran = true; });
+  invalid.Resolve(kOk, 1);
+  EXPECT(!ran);
+
+  // A continuation may release the last handle to its own result
+  auto owned = std::make_unique<Async<int>>(Async<int>::Create());
+  int delivered = 0;
+  owned->Then(CancellationToken(), [&](AsyncStatus, int result) {
+    owned.reset();
+    delivered += result;
+  });
+  owned->Then(CancellationToken(), [&](AsyncStatus, int result) { delivered += result; });
+  owned->Resolve(kOk, 5);  // Only owned holds the state
+  EXPECT(owned == nullptr);
+  EXPECT_EQ(delivered, 10);  // The rest are still delivered
+}
+
+HKCW_TEST(webview_async_navigation_matches_its_id) {
+  NavigationMatcher matcher;
+  EXPECT(!matcher.IsOurs(0));  // Nothing started yet
+  EXPECT(!matcher.IsOurs(41));
+
+  matcher.OnStarting(42);
+  EXPECT(matcher.IsOurs(42));
+  EXPECT(!matcher.IsOurs(41));  // The page's navigation ours cancelled
+
+  // A later navigation (page-initiated, after ours) does not take over
+  matcher.OnStarting(43);
+  EXPECT(matcher.IsOurs(42));
+  EXPECT(!matcher.IsOurs(43));
+}
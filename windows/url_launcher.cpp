@@ -0,0 +1,174 @@
+#include "url_launcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace hkcw_engine2 {
+
+UrlLauncher::UrlLauncher(Hooks hooks, Options options)
+    : hooks_(std::move(hooks)), options_(options) {
+  options_.queue_capacity = (std::max)(options_.queue_capacity, size_t{1});
+  options_.max_launches = (std::max)(options_.max_launches, size_t{1});
+
+  // All URL storage is reserved up front so Open() never allocates
+  slots_.resize(options_.queue_capacity);
+  for (auto& slot : slots_) slot.reserve(options_.max_url_length);
+  recent_.resize(options_.queue_capacity);
+  for (auto& recent : recent_) recent.url.reserve(options_.max_url_length);
+  launches_.resize(options_.max_launches);
+
+  worker_ = std::thread(&UrlLauncher::WorkerLoop, this);
+}
+
+UrlLauncher::~UrlLauncher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+    if (count_ > 0) {
+      std::cout << "[HKCW] [Launcher] Dropping " << count_ << " pending URL(s) on shutdown" << std::endl;
+    }
+  }
+  wake_.notify_all();
+  if (worker_.joinable()) worker_.join();
+}
+
+UrlLauncher::Clock::time_point UrlLauncher::Now() const {
+  return hooks_.now ? hooks_.now() : Clock::now();
+}
+
+UrlLauncher::Result UrlLauncher::Open(std::string_view url) {
+  auto now = Now();
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (stopping_) return Result::kStopped;
+  if (url.empty() || url.size() > options_.max_url_length) {
+    stats_.dropped++;
+    return Result::kInvalid;
+  }
+
+  // A double-click or a page re-posting the same URL opens one tab
+  for (const auto& recent : recent_) {
+    if (!recent.url.empty() && recent.url == url && now - recent.time < options_.debounce) {
+      stats_.duplicates++;
+      return Result::kDuplicate;
+    }
+  }
+
+  // Early out only: the quota is charged once the worker has validated
+  if (RateLimited(now)) {
+    stats_.rate_limited++;
+    return Result::kRateLimited;
+  }
+
+  if (count_ == slots_.size()) {
+    stats_.dropped++;
+    return Result::kQueueFull;
+  }
+
+  slots_[(head_ + count_) % slots_.size()].assign(url.data(), url.size());
+  count_++;
+
+  recent_[recent_next_].url.assign(url.data(), url.size());
+  recent_[recent_next_].time = now;
+  recent_next_ = (recent_next_ + 1) % recent_.size();
+
+  stats_.queued++;
+  lock.unlock();
+  wake_.notify_one();
+  return Result::kQueued;
+}
+
+bool UrlLauncher::RateLimited(Clock::time_point now) const {
+  return launches_filled_ == launches_.size() &&
+         now - launches_[launches_next_] < options_.rate_window;
+}
+
+bool UrlLauncher::WaitIdle(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return idle_.wait_for(lock, timeout, [this] { return count_ == 0 && !busy_; });
+}
+
+UrlLauncher::Stats UrlLauncher::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+const char* UrlLauncher::ResultName(Result result) {
+  switch (result) {
+    case Result::kQueued: return "queued";
+    case Result::kDuplicate: return "duplicate";
+    case Result::kRateLimited: return "rate limited";
+    case Result::kQueueFull: return "queue full";
+    case Result::kInvalid: return "invalid";
+    case Result::kStopped: return "stopped";
+  }
+  return "unknown";
+}
+
+void UrlLauncher::WorkerLoop() {
+  if (hooks_.thread_start) hooks_.thread_start();
+
+  std::string url;
+  url.reserve(options_.max_url_length);
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wake_.wait(lock, [this] { return stopping_ || count_ > 0; });
+      if (stopping_) break;
+
+      // Swap keeps both buffers at full capacity
+      url.swap(slots_[head_]);
+      head_ = (head_ + 1) % slots_.size();
+      count_--;
+      busy_ = true;
+    }
+
+    bool allowed = !hooks_.validate || hooks_.validate(url);
+    bool within_quota = false;
+    if (allowed) {
+      auto now = Now();
+      std::lock_guard<std::mutex> lock(mutex_);
+      within_quota = !RateLimited(now);
+      if (within_quota) {
+        launches_[launches_next_] = now;
+        launches_next_ = (launches_next_ + 1) % launches_.size();
+        launches_filled_ = (std::min)(launches_filled_ + 1, launches_.size());
+      } else {
+        stats_.rate_limited++;
+      }
+    }
+
+    bool launched = false;
+    if (allowed && within_quota) {
+      auto start = std::chrono::steady_clock::now();
+      launched = hooks_.launch && hooks_.launch(url);
+      auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start);
+      std::cout << "[HKCW] [Launcher] " << (launched ? "Opened" : "Failed to open") << " in "
+                << elapsed.count() << " ms: " << url << std::endl;
+    } else if (allowed) {
+      std::cout << "[HKCW] [Launcher] Rate limited: " << url << std::endl;
+    } else {
+      std::cout << "[HKCW] [Launcher] URL rejected by validator: " << url << std::endl;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!allowed) {
+        stats_.rejected++;
+      } else if (launched) {
+        stats_.launched++;
+      } else if (within_quota) {
+        stats_.failed++;
+      }
+      busy_ = false;
+    }
+    idle_.notify_all();
+  }
+
+  if (hooks_.thread_stop) hooks_.thread_stop();
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,109 @@
+#ifndef FLUTTER_PLUGIN_URL_LAUNCHER_H_
+#define FLUTTER_PLUGIN_URL_LAUNCHER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+// URL Launcher: opens external URLs (ad clicks, HKCW.openURL) on a worker
+// thread so the shell never blocks the mouse hook or the UI thread.
+//
+// Open() only applies policy and copies the URL into a preallocated slot:
+// repeats of a URL inside the debounce window, and anything while the rate
+// limit is used up, are dropped there. The worker validates, and only URLs
+// that pass are charged to the rate limit, so a page posting blocked URLs
+// cannot lock out real ad clicks. The validator, launcher and clock are
+// injected so the policy runs on Linux with a stub.
+class UrlLauncher {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Hooks {
+    std::function<bool(const std::string& url)> validate;
+    std::function<bool(const std::string& url)> launch;
+    std::function<void()> thread_start;  // e.g. CoInitializeEx
+    std::function<void()> thread_stop;
+    std::function<Clock::time_point()> now;  // Defaults to Clock::now; called from both threads
+  };
+
+  struct Options {
+    std::chrono::milliseconds debounce{1000};
+    size_t max_launches = 3;  // Per rate_window
+    std::chrono::milliseconds rate_window{10000};
+    size_t queue_capacity = 8;
+    size_t max_url_length = 2048;  // Slot capacity; longer URLs are invalid
+  };
+
+  enum class Result { kQueued, kDuplicate, kRateLimited, kQueueFull, kInvalid, kStopped };
+
+  struct Stats {
+    uint64_t queued = 0;
+    uint64_t duplicates = 0;
+    uint64_t rate_limited = 0;  // Refused by Open or after validation
+    uint64_t dropped = 0;  // Queue full, empty or too long
+    uint64_t rejected = 0;  // Failed validation
+    uint64_t launched = 0;
+    uint64_t failed = 0;
+  };
+
+  UrlLauncher(Hooks hooks, Options options);
+  ~UrlLauncher();
+
+  UrlLauncher(const UrlLauncher&) = delete;
+  UrlLauncher& operator=(const UrlLauncher&) = delete;
+
+  // Does not allocate for URLs up to max_url_length
+  Result Open(std::string_view url);
+
+  // Block until the queue is drained and the worker is idle
+  bool WaitIdle(std::chrono::milliseconds timeout);
+
+  Stats stats() const;
+  static const char* ResultName(Result result);
+
+ private:
+  struct Recent {
+    std::string url;
+    Clock::time_point time;
+  };
+
+  void WorkerLoop();
+  Clock::time_point Now() const;
+  bool RateLimited(Clock::time_point now) const;  // Caller holds mutex_
+
+  Hooks hooks_;
+  Options options_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+
+  // Fixed ring of preallocated URL slots
+  std::vector<std::string> slots_;
+  size_t head_ = 0;
+  size_t count_ = 0;
+  bool busy_ = false;
+  bool stopping_ = false;
+
+  // Debounce: the last few queued URLs; rate limit: validated launch times
+  std::vector<Recent> recent_;
+  size_t recent_next_ = 0;
+  std::vector<Clock::time_point> launches_;
+  size_t launches_next_ = 0;
+  size_t launches_filled_ = 0;
+
+  Stats stats_;
+  std::thread worker_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_URL_LAUNCHER_H_
@@ -0,0 +1,408 @@
+#include "url_rule_snapshot.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const char kSnapshotMagic[8] = {'H', 'K', 'C', 'W', 'U', 'R', 'L', 'S'};
+const uint32_t kSnapshotVersion = 2;
+const size_t kGramSize = 4;
+
+uint32_t LoadGram(const char* data) {
+  uint32_t gram;
+  memcpy(&gram, data, sizeof(gram));
+  return gram;
+}
+
+uint32_t GramBucket(uint32_t gram, uint32_t bucket_count) {
+  uint32_t hash = gram * 0x9E3779B1u;
+  return (hash ^ (hash >> 16)) & (bucket_count - 1);
+}
+
+}  // namespace
+
+// Entry ranges of one list. Substring patterns shorter than a gram are
+// few and scanned; bucket b of the rest spans the entries
+// [buckets[bucket_start + b], buckets[bucket_start + b + 1]).
+struct SnapshotSection {
+  uint32_t prefix_begin;
+  uint32_t prefix_end;
+  uint32_t short_begin;
+  uint32_t short_end;
+  uint32_t bucket_start;
+  uint32_t bucket_count;  // Power of two, or 0
+  uint32_t reserved[2];
+};
+
+struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t entry_count;
+  uint64_t source_hash;
+  uint32_t entries_offset;
+  uint32_t buckets_offset;
+  uint32_t bucket_words;
+  uint32_t strings_offset;
+  uint32_t strings_size;
+  uint32_t reserved;
+  SnapshotSection sections[2];  // By UrlRuleSnapshot::List
+};
+
+struct SnapshotEntry {
+  uint32_t offset;    // Into the string table
+  uint16_t length;
+  uint8_t list;       // UrlRuleSnapshot::List
+  uint8_t prefix;     // 1 = "prefix*", 0 = substring
+  uint32_t gram;      // Substring patterns: the bucket key...
+  uint16_t gram_pos;  // ...and where it sits in the pattern
+  uint16_t reserved;
+};
+
+// UrlRuleSnapshot implementation
+bool UrlRuleSnapshot::Build(const char* source, size_t size, uint64_t source_hash,
+                            const std::string& snapshot_path) {
+  std::vector<SnapshotEntry> parsed[2];  // By list
+  std::string strings;
+
+  size_t pos = 0;
+  while (pos < size) {
+    const char* line_end = static_cast<const char*>(memchr(source + pos, '\n', size - pos));
+    size_t end = line_end ? static_cast<size_t>(line_end - source) : size;
+    std::string_view line(source + pos, end - pos);
+    pos = end + 1;
+
+    while (!line.empty() && (line.front() == ' ' || line.front() == '\t')) line.remove_prefix(1);
+    while (!line.empty() && (line.back() == ' ' || line.back() == '\t' || line.back() == '\r')) {
+      line.remove_suffix(1);
+    }
+    if (line.empty() || line[0] == '!' || line[0] == '#') continue;
+
+    SnapshotEntry entry = {};
+    entry.list = kBlacklist;
+    if (line.compare(0, 2, "@@") == 0) {
+      entry.list = kWhitelist;
+      line.remove_prefix(2);
+    }
+
+    // Same rule as URLValidator::MatchesPattern: text before '*' is a prefix
+    size_t star = line.find('*');
+    entry.prefix = star != std::string_view::npos ? 1 : 0;
+    if (entry.prefix) line = line.substr(0, star);
+    if (line.empty() || line.size() > 0xFFFF) continue;
+
+    entry.offset = static_cast<uint32_t>(strings.size());
+    entry.length = static_cast<uint16_t>(line.size());
+    for (char c : line) {
+      strings.push_back((c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c);
+    }
+    parsed[entry.list].push_back(entry);
+  }
+
+  auto pattern = [&strings](const SnapshotEntry& entry) {
+    return std::string_view(strings).substr(entry.offset, entry.length);
+  };
+
+  SnapshotHeader header = {};
+  std::vector<SnapshotEntry> entries;
+  std::vector<uint32_t> buckets;
+  for (int list = 0; list < 2; list++) {
+    SnapshotSection& section = header.sections[list];
+    std::vector<SnapshotEntry> prefixes, shorts, grams;
+    for (const SnapshotEntry& entry : parsed[list]) {
+      (entry.prefix ? prefixes : entry.length < kGramSize ? shorts : grams).push_back(entry);
+    }
+
+    std::sort(prefixes.begin(), prefixes.end(), [&pattern](const SnapshotEntry& a, const SnapshotEntry& b) {
+      return pattern(a) < pattern(b);
+    });
+    section.prefix_begin = static_cast<uint32_t>(entries.size());
+    entries.insert(entries.end(), prefixes.begin(), prefixes.end());
+    section.prefix_end = static_cast<uint32_t>(entries.size());
+
+    section.short_begin = section.prefix_end;
+    entries.insert(entries.end(), shorts.begin(), shorts.end());
+    section.short_end = static_cast<uint32_t>(entries.size());
+
+    if (grams.empty()) continue;
+
+    // Key each substring pattern by its rarest gram, so common ones like
+    // "http" or "www." do not pile up in one bucket
+    std::unordered_map<uint32_t, uint32_t> frequency;
+    for (const SnapshotEntry& entry : grams) {
+      for (size_t i = 0; i + kGramSize <= entry.length; i++) {
+        frequency[LoadGram(strings.data() + entry.offset + i)]++;
+      }
+    }
+    for (SnapshotEntry& entry : grams) {
+      uint32_t best = UINT32_MAX;
+      for (size_t i = 0; i + kGramSize <= entry.length; i++) {
+        uint32_t gram = LoadGram(strings.data() + entry.offset + i);
+        if (frequency[gram] < best) {
+          best = frequency[gram];
+          entry.gram = gram;
+          entry.gram_pos = static_cast<uint16_t>(i);
+        }
+      }
+    }
+
+    // Counting sort into buckets; offsets are absolute entry indices
+    uint32_t bucket_count = 1;
+    while (bucket_count < grams.size() * 2) bucket_count <<= 1;
+    std::vector<uint32_t> starts(bucket_count + 1, 0);
+    for (const SnapshotEntry& entry : grams) starts[GramBucket(entry.gram, bucket_count) + 1]++;
+    for (uint32_t b = 0; b < bucket_count; b++) starts[b + 1] += starts[b];
+
+    std::vector<SnapshotEntry> sorted(grams.size());
+    std::vector<uint32_t> fill(starts.begin(), starts.end() - 1);
+    for (const SnapshotEntry& entry : grams) sorted[fill[GramBucket(entry.gram, bucket_count)]++] = entry;
+
+    uint32_t base = static_cast<uint32_t>(entries.size());
+    section.bucket_start = static_cast<uint32_t>(buckets.size());
+    section.bucket_count = bucket_count;
+    for (uint32_t start : starts) buckets.push_back(base + start);
+    entries.insert(entries.end(), sorted.begin(), sorted.end());
+  }
+
+  memcpy(header.magic, kSnapshotMagic, sizeof(header.magic));
+  header.version = kSnapshotVersion;
+  header.entry_count = static_cast<uint32_t>(entries.size());
+  header.source_hash = source_hash;
+  header.entries_offset = sizeof(SnapshotHeader);
+  header.buckets_offset = header.entries_offset +
+                          static_cast<uint32_t>(entries.size() * sizeof(SnapshotEntry));
+  header.bucket_words = static_cast<uint32_t>(buckets.size());
+  header.strings_offset = header.buckets_offset +
+                          static_cast<uint32_t>(buckets.size() * sizeof(uint32_t));
+  header.strings_size = static_cast<uint32_t>(strings.size());
+
+  std::ofstream out(snapshot_path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    std::cout << "[HKCW] [URLRules] ERROR: Cannot write snapshot: " << snapshot_path << std::endl;
+    return false;
+  }
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(entries.data()),
+            static_cast<std::streamsize>(entries.size() * sizeof(SnapshotEntry)));
+  out.write(reinterpret_cast<const char*>(buckets.data()),
+            static_cast<std::streamsize>(buckets.size() * sizeof(uint32_t)));
+  out.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+  return out.good();
+}
+
+bool UrlRuleSnapshot::MapSnapshot(const std::string& snapshot_path, uint64_t expected_hash) {
+  if (!snapshot_.Open(snapshot_path)) return false;
+
+  const char* data = snapshot_.data();
+  size_t size = snapshot_.size();
+  if (size < sizeof(SnapshotHeader)) {
+    snapshot_.Close();
+    return false;
+  }
+
+  SnapshotHeader header;
+  memcpy(&header, data, sizeof(header));
+  uint64_t entries_end = header.entries_offset +
+                         uint64_t{header.entry_count} * sizeof(SnapshotEntry);
+  uint64_t buckets_end = uint64_t{header.buckets_offset} + uint64_t{header.bucket_words} * sizeof(uint32_t);
+  if (memcmp(header.magic, kSnapshotMagic, sizeof(header.magic)) != 0 ||
+      header.version != kSnapshotVersion || header.source_hash != expected_hash ||
+      header.entries_offset != sizeof(SnapshotHeader) || entries_end != header.buckets_offset ||
+      buckets_end != header.strings_offset ||
+      uint64_t{header.strings_offset} + header.strings_size != size) {
+    snapshot_.Close();
+    return false;
+  }
+
+  entries_ = reinterpret_cast<const SnapshotEntry*>(data + header.entries_offset);
+  buckets_ = reinterpret_cast<const uint32_t*>(data + header.buckets_offset);
+  strings_ = data + header.strings_offset;
+  sections_ = reinterpret_cast<const SnapshotHeader*>(data)->sections;
+  entry_count_ = header.entry_count;
+  source_hash_ = header.source_hash;
+
+  // Everything Match reads must stay inside the file
+  bool valid = true;
+  for (const SnapshotSection& section : header.sections) {
+    valid = valid && section.prefix_begin <= section.prefix_end && section.prefix_end <= entry_count_ &&
+            section.short_begin <= section.short_end && section.short_end <= entry_count_;
+    if (!valid || section.bucket_count == 0) continue;
+    valid = (section.bucket_count & (section.bucket_count - 1)) == 0 &&
+            uint64_t{section.bucket_start} + section.bucket_count + 1 <= header.bucket_words;
+    for (uint32_t b = 0; valid && b < section.bucket_count; b++) {
+      const uint32_t* starts = buckets_ + section.bucket_start;
+      valid = starts[b] <= starts[b + 1] && starts[b + 1] <= entry_count_;
+    }
+  }
+
+  whitelist_count_ = 0;
+  blacklist_count_ = 0;
+  for (uint32_t i = 0; valid && i < entry_count_; i++) {
+    const SnapshotEntry& entry = entries_[i];
+    valid = static_cast<size_t>(entry.offset) + entry.length <= header.strings_size && entry.list <= kBlacklist &&
+            (entry.prefix || entry.length < kGramSize || entry.gram_pos + kGramSize <= entry.length);
+    if (valid) (entry.list == kWhitelist ? whitelist_count_ : blacklist_count_)++;
+  }
+  if (!valid) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool UrlRuleSnapshot::Load(const std::string& source_path, const std::string& snapshot_path) {
+  auto start = std::chrono::steady_clock::now();
+  Close();
+
+  MappedFile source;
+  if (!source.Open(source_path)) {
+    std::cout << "[HKCW] [URLRules] ERROR: Cannot open rule file: " << source_path << std::endl;
+    return false;
+  }
+  uint64_t hash = HashBytes(source.data(), source.size());
+
+  if (!MapSnapshot(snapshot_path, hash)) {
+    // Named after the contents, so a temporary an older instance still
+    // maps is never the one rewritten
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.tmp", static_cast<unsigned long long>(hash));
+    std::string temp_path = snapshot_path + suffix;
+    if (!Build(source.data(), source.size(), hash, temp_path)) {
+      std::cout << "[HKCW] [URLRules] ERROR: Failed to build snapshot for: " << source_path << std::endl;
+      return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(std::filesystem::u8path(temp_path), std::filesystem::u8path(snapshot_path), ec);
+    if (!MapSnapshot(ec ? temp_path : snapshot_path, hash)) {
+      std::cout << "[HKCW] [URLRules] ERROR: Failed to map snapshot for: " << source_path << std::endl;
+      return false;
+    }
+    if (ec) {
+      mapped_path_ = temp_path;  // The old snapshot is mapped; FinishRename retries
+    }
+    rebuilt_ = true;
+  }
+  snapshot_path_ = snapshot_path;
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - start);
+  std::cout << "[HKCW] [URLRules] " << (rebuilt_ ? "Rebuilt" : "Mapped") << " snapshot: "
+            << whitelist_count_ << " whitelist, " << blacklist_count_ << " blacklist entries in "
+            << elapsed.count() << " us" << std::endl;
+  return true;
+}
+
+bool UrlRuleSnapshot::FinishRename() {
+  if (mapped_path_.empty()) return true;
+
+  std::error_code ec;
+  std::filesystem::rename(std::filesystem::u8path(mapped_path_), std::filesystem::u8path(snapshot_path_), ec);
+  if (ec) {
+    std::cout << "[HKCW] [URLRules] Snapshot still in use, kept as " << mapped_path_ << std::endl;
+    return false;
+  }
+  mapped_path_.clear();
+  return true;
+}
+
+void UrlRuleSnapshot::Close() {
+  snapshot_.Close();
+  sections_ = nullptr;
+  entries_ = nullptr;
+  buckets_ = nullptr;
+  strings_ = nullptr;
+  entry_count_ = 0;
+  whitelist_count_ = 0;
+  blacklist_count_ = 0;
+  source_hash_ = 0;
+  rebuilt_ = false;
+  mapped_path_.clear();
+  snapshot_path_.clear();
+}
+
+void UrlRuleSnapshot::swap(UrlRuleSnapshot& other) {
+  snapshot_.swap(other.snapshot_);
+  std::swap(sections_, other.sections_);
+  std::swap(entries_, other.entries_);
+  std::swap(buckets_, other.buckets_);
+  std::swap(strings_, other.strings_);
+  std::swap(entry_count_, other.entry_count_);
+  std::swap(whitelist_count_, other.whitelist_count_);
+  std::swap(blacklist_count_, other.blacklist_count_);
+  std::swap(source_hash_, other.source_hash_);
+  std::swap(rebuilt_, other.rebuilt_);
+  mapped_path_.swap(other.mapped_path_);
+  snapshot_path_.swap(other.snapshot_path_);
+}
+
+std::string_view UrlRuleSnapshot::Match(std::string_view lower_url, List list) const {
+  if (!sections_) return std::string_view();
+  const SnapshotSection& section = sections_[list];
+  std::string_view rule = MatchPrefix(section, lower_url);
+  return rule.empty() ? MatchSubstring(section, lower_url) : rule;
+}
+
+std::string_view UrlRuleSnapshot::MatchPrefix(const SnapshotSection& section,
+                                              std::string_view lower_url) const {
+  const SnapshotEntry* begin = entries_ + section.prefix_begin;
+  const SnapshotEntry* end = entries_ + section.prefix_end;
+  auto pattern = [this](const SnapshotEntry& entry) {
+    return std::string_view(strings_ + entry.offset, entry.length);
+  };
+
+  // Any matching prefix sorts at or before the greatest pattern <= key. If
+  // that one is not a prefix, a match can only be a prefix of what the two
+  // share, so search again for that; the key shrinks every round.
+  std::string_view key = lower_url;
+  while (!key.empty()) {
+    const SnapshotEntry* it = std::upper_bound(begin, end, key,
+        [&pattern](std::string_view k, const SnapshotEntry& entry) { return k < pattern(entry); });
+    if (it == begin) break;
+    std::string_view candidate = pattern(*(it - 1));
+    if (key.compare(0, candidate.size(), candidate) == 0) return candidate;
+
+    size_t common = 0;
+    while (common < candidate.size() && common < key.size() && candidate[common] == key[common]) common++;
+    key = key.substr(0, common);
+  }
+  return std::string_view();
+}
+
+std::string_view UrlRuleSnapshot::MatchSubstring(const SnapshotSection& section,
+                                                 std::string_view lower_url) const {
+  for (uint32_t i = section.short_begin; i < section.short_end; i++) {
+    std::string_view pattern(strings_ + entries_[i].offset, entries_[i].length);
+    if (lower_url.find(pattern) != std::string_view::npos) return pattern;
+  }
+  if (section.bucket_count == 0) return std::string_view();
+
+  // One probe per position of the URL
+  const uint32_t* starts = buckets_ + section.bucket_start;
+  for (size_t pos = 0; pos + kGramSize <= lower_url.size(); pos++) {
+    uint32_t gram = LoadGram(lower_url.data() + pos);
+    uint32_t bucket = GramBucket(gram, section.bucket_count);
+    for (uint32_t k = starts[bucket]; k < starts[bucket + 1]; k++) {
+      const SnapshotEntry& entry = entries_[k];
+      if (entry.gram != gram || pos < entry.gram_pos) continue;
+      size_t begin = pos - entry.gram_pos;
+      if (begin + entry.length > lower_url.size()) continue;
+      if (memcmp(lower_url.data() + begin, strings_ + entry.offset, entry.length) == 0) {
+        return std::string_view(strings_ + entry.offset, entry.length);
+      }
+    }
+  }
+  return std::string_view();
+}
+
+}  // namespace hkcw_engine2
@@ -0,0 +1,81 @@
+#ifndef FLUTTER_PLUGIN_URL_RULE_SNAPSHOT_H_
+#define FLUTTER_PLUGIN_URL_RULE_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.h"
+
+namespace hkcw_engine2 {
+
+struct SnapshotEntry;
+struct SnapshotSection;
+
+// URL Rules: precompiled binary snapshot of a URL rule file.
+//
+// Source format, one rule per line:
+//   ! or #      comment
+//   @@pattern   whitelist entry
+//   pattern     blacklist entry
+// Patterns follow URLValidator semantics: "prefix*" matches URLs starting
+// with prefix, anything else matches as a substring. Case-insensitive.
+//
+// The snapshot stores lowercased patterns plus a hash of the source file,
+// indexed per list: prefix patterns in a sorted table searched by binary
+// search, substring patterns in hash buckets keyed by their rarest 4-byte
+// gram, so a lookup costs O(URL length) probes however long the list is.
+// It is memory-mapped and queried in place, so startup only hashes the
+// source and validates the index; the text is re-parsed only when the
+// hash changes. A rebuilt snapshot is written to a temporary file and
+// renamed over the old one.
+class UrlRuleSnapshot {
+ public:
+  enum List : uint8_t { kWhitelist = 0, kBlacklist = 1 };
+
+  // Map snapshot_path, rebuilding it from source_path if it is missing,
+  // corrupt or was built from different source contents
+  bool Load(const std::string& source_path, const std::string& snapshot_path);
+  void Close();
+  // Reloads build into a separate instance and swap in only on success
+  void swap(UrlRuleSnapshot& other);
+  // Windows cannot replace a file that is mapped: a rebuild made while the
+  // previous snapshot was still mapped stays in its temporary file until
+  // this is called again, after the previous one is closed
+  bool FinishRename();
+
+  static bool Build(const char* source, size_t size, uint64_t source_hash,
+                    const std::string& snapshot_path);
+
+  // lower_url must already be lowercased; returns the matching pattern
+  // (empty if none)
+  std::string_view Match(std::string_view lower_url, List list) const;
+
+  size_t count(List list) const { return list == kWhitelist ? whitelist_count_ : blacklist_count_; }
+  uint64_t source_hash() const { return source_hash_; }
+  bool is_loaded() const { return snapshot_.is_open(); }
+  bool rebuilt() const { return rebuilt_; }  // By the last Load
+
+ private:
+  bool MapSnapshot(const std::string& snapshot_path, uint64_t expected_hash);
+  std::string_view MatchPrefix(const SnapshotSection& section, std::string_view lower_url) const;
+  std::string_view MatchSubstring(const SnapshotSection& section, std::string_view lower_url) const;
+
+  MappedFile snapshot_;
+  const SnapshotSection* sections_ = nullptr;
+  const SnapshotEntry* entries_ = nullptr;
+  const uint32_t* buckets_ = nullptr;
+  const char* strings_ = nullptr;
+  uint32_t entry_count_ = 0;
+  size_t whitelist_count_ = 0;
+  size_t blacklist_count_ = 0;
+  uint64_t source_hash_ = 0;
+  bool rebuilt_ = false;
+  std::string mapped_path_;   // Temporary file awaiting FinishRename, or empty
+  std::string snapshot_path_;
+};
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_URL_RULE_SNAPSHOT_H_
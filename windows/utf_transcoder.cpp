@@ -0,0 +1,219 @@
+#include "utf_transcoder.h"
+
+#include "simd_config.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace hkcw_engine2 {
+
+namespace {
+
+const char16_t kReplacement = 0xFFFD;
+
+inline bool IsContinuation(uint8_t byte) {
+  return (byte & 0xC0) == 0x80;
+}
+
+// Widen as many leading ASCII bytes as possible; returns bytes consumed
+template <typename Char16>
+size_t WidenAscii(const uint8_t* in, size_t size, Char16* out) {
+  size_t i = 0;
+#if HKCW_HAS_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    if (_mm_movemask_epi8(bytes) != 0) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi8(bytes, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_unpackhi_epi8(bytes, zero));
+  }
+#endif
+  for (; i < size && in[i] < 0x80; i++) {
+    out[i] = static_cast<Char16>(in[i]);
+  }
+  return i;
+}
+
+// Narrow as many leading ASCII units as possible; returns units consumed
+template <typename Char16>
+size_t NarrowAscii(const Char16* in, size_t size, char* out) {
+  size_t i = 0;
+#if HKCW_HAS_SSE2
+  const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= size; i += 16) {
+    __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+    __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i + 8));
+    __m128i bits = _mm_and_si128(_mm_or_si128(low, high), non_ascii);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(bits, zero)) != 0xFFFF) break;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(low, high));
+  }
+#endif
+  for (; i < size && static_cast<uint32_t>(in[i]) < 0x80; i++) {
+    out[i] = static_cast<char>(in[i]);
+  }
+  return i;
+}
+
+// One non-ASCII sequence at in[i]; malformed input yields U+FFFD for a
+// single byte so decoding resynchronizes on the next lead byte
+inline size_t DecodeSequence(const uint8_t* in, size_t size, size_t i, uint32_t& code_point) {
+  uint8_t lead = in[i];
+  code_point = kReplacement;
+  if (lead >= 0xC2 && lead <= 0xDF && i + 1 < size && IsContinuation(in[i + 1])) {
+    code_point = (static_cast<uint32_t>(lead & 0x1F) << 6) | (in[i + 1] & 0x3F);
+    return 2;
+  }
+  if (lead >= 0xE0 && lead <= 0xEF && i + 2 < size &&
+      IsContinuation(in[i + 1]) && IsContinuation(in[i + 2])) {
+    uint32_t value = (static_cast<uint32_t>(lead & 0x0F) << 12) |
+                     (static_cast<uint32_t>(in[i + 1] & 0x3F) << 6) | (in[i + 2] & 0x3F);
+    // Reject overlong forms and encoded surrogates
+    if (value >= 0x800 && (value < 0xD800 || value > 0xDFFF)) {
+      code_point = value;
+      return 3;
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4 && i + 3 < size && IsContinuation(in[i + 1]) &&
+             IsContinuation(in[i + 2]) && IsContinuation(in[i + 3])) {
+    uint32_t value = (static_cast<uint32_t>(lead & 0x07) << 18) |
+                     (static_cast<uint32_t>(in[i + 1] & 0x3F) << 12) |
+                     (static_cast<uint32_t>(in[i + 2] & 0x3F) << 6) | (in[i + 3] & 0x3F);
+    if (value >= 0x10000 && value <= 0x10FFFF) {
+      code_point = value;
+      return 4;
+    }
+  }
+  return 1;
+}
+
+// Writes at most in.size() units
+template <typename Char16>
+size_t DecodeUtf8(std::string_view text, Char16* out) {
+  const auto* in = reinterpret_cast<const uint8_t*>(text.data());
+  size_t size = text.size();
+  size_t i = 0;
+  size_t written = 0;
+
+  while (i < size) {
+    if (in[i] < 0x80) {
+      size_t run = WidenAscii(in + i, size - i, out + written);
+      i += run;
+      written += run;
+      continue;
+    }
+
+    uint32_t code_point = 0;
+    size_t length = DecodeSequence(in, size, i, code_point);
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      out[written++] = static_cast<Char16>(0xD800 + (code_point >> 10));
+      out[written++] = static_cast<Char16>(0xDC00 + (code_point & 0x3FF));
+    } else {
+      out[written++] = static_cast<Char16>(code_point);
+    }
+    i += length;
+  }
+
+  return written;
+}
+
+// Writes at most 3 * size bytes
+template <typename Char16>
+size_t EncodeUtf8(const Char16* in, size_t size, char* out) {
+  size_t i = 0;
+  size_t written = 0;
+
+  while (i < size) {
+    uint32_t unit = static_cast<uint32_t>(in[i]);
+    if (unit < 0x80) {
+      size_t run = NarrowAscii(in + i, size - i, out + written);
+      i += run;
+      written += run;
+      continue;
+    }
+
+    uint32_t code_point = unit;
+    i++;
+    if (unit >= 0xD800 && unit <= 0xDBFF && i < size &&
+        static_cast<uint32_t>(in[i]) >= 0xDC00 && static_cast<uint32_t>(in[i]) <= 0xDFFF) {
+      code_point = 0x10000 + ((unit - 0xD800) << 10) + (static_cast<uint32_t>(in[i]) - 0xDC00);
+      i++;
+    } else if (unit >= 0xD800 && unit <= 0xDFFF) {
+      code_point = kReplacement;
+    }
+
+    if (code_point < 0x800) {
+      out[written++] = static_cast<char>(0xC0 | (code_point >> 6));
+      out[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else if (code_point < 0x10000) {
+      out[written++] = static_cast<char>(0xE0 | (code_point >> 12));
+      out[written++] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+    } else {
+      out[written++] = static_cast<char>(0xF0 | (code_point >> 18));
+      out[written++] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      out[written++] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      out[written++] = static_cast<char>(0x80 | (code_point & 0x3F));
+    }
+  }
+
+  return written;
+}
+
+template <typename String16>
+void DecodeInto(std::string_view in, String16& out) {
+  out.resize(in.size());
+  out.resize(in.empty() ? 0 : DecodeUtf8(in, &out[0]));
+}
+
+// Encoded through a stack chunk and appended: std::string cannot be
+// written past size() before C++23, and resizing to the 3-byte worst case
+// zero-filled up to three times the output on every call
+const size_t kEncodeChunk = 1024;
+
+template <typename Char16>
+void EncodeInto(const Char16* in, size_t size, std::string& out) {
+  out.clear();
+  out.reserve(size);  // Exact for ASCII, the common case
+  char chunk[kEncodeChunk * 3];
+  size_t position = 0;
+  while (position < size) {
+    size_t count = (std::min)(size - position, kEncodeChunk);
+    // Keep surrogate pairs within one chunk
+    uint32_t last = static_cast<uint32_t>(in[position + count - 1]);
+    if (count > 1 && position + count < size && last >= 0xD800 && last <= 0xDBFF) count--;
+    out.append(chunk, EncodeUtf8(in + position, count, chunk));
+    position += count;
+  }
+}
+
+}  // namespace
+
+size_t DecodeUtf8CodePoint(std::string_view in, size_t position, uint32_t& code_point) {
+  const auto* bytes = reinterpret_cast<const uint8_t*>(in.data());
+  if (bytes[position] < 0x80) {
+    code_point = bytes[position];
+    return 1;
+  }
+  return DecodeSequence(bytes, in.size(), position, code_point);
+}
+
+void Utf8ToUtf16(std::string_view in, std::u16string& out) {
+  DecodeInto(in, out);
+}
+
+void Utf16ToUtf8(std::u16string_view in, std::string& out) {
+  EncodeInto(in.data(), in.size(), out);
+}
+
+#ifdef _WIN32
+void Utf8ToWide(std::string_view in, std::wstring& out) {
+  DecodeInto(in, out);
+}
+
+void WideToUtf8(std::wstring_view in, std::string& out) {
+  EncodeInto(in.data(), in.size(), out);
+}
+#endif
+
+}  // namespace hkcw_engine2
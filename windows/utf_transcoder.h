@@ -0,0 +1,44 @@
+#ifndef FLUTTER_PLUGIN_UTF_TRANSCODER_H_
+#define FLUTTER_PLUGIN_UTF_TRANSCODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace hkcw_engine2 {
+
+// UTF Transcoding: UTF-8 <-> UTF-16 for every string crossing the
+// WebView2/Win32 boundary.
+//
+// Output goes into a caller-owned string whose capacity is reused, so a
+// long-lived buffer makes steady-state conversions allocation-free. ASCII
+// runs are widened/narrowed 16 bytes at a time with SSE2. Malformed input
+// (bad UTF-8, unpaired surrogates) becomes U+FFFD instead of being dropped.
+void Utf8ToUtf16(std::string_view in, std::u16string& out);
+void Utf16ToUtf8(std::u16string_view in, std::string& out);
+
+// Decode the code point starting at in[position]; returns bytes consumed
+size_t DecodeUtf8CodePoint(std::string_view in, size_t position, uint32_t& code_point);
+
+#ifdef _WIN32
+// wchar_t is UTF-16 on Windows
+void Utf8ToWide(std::string_view in, std::wstring& out);
+void WideToUtf8(std::wstring_view in, std::string& out);
+
+inline std::wstring Utf8ToWide(std::string_view in) {
+  std::wstring out;
+  Utf8ToWide(in, out);
+  return out;
+}
+
+inline std::string WideToUtf8(std::wstring_view in) {
+  std::string out;
+  WideToUtf8(in, out);
+  return out;
+}
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_UTF_TRANSCODER_H_
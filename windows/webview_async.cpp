@@ -0,0 +1,121 @@
+#include "webview_async.h"
+
+#ifdef _WIN32
+
+namespace hkcw_engine2 {
+
+using Microsoft::WRL::Callback;
+using Microsoft::WRL::ComPtr;
+
+Async<ComPtr<ICoreWebView2Environment>> CreateEnvironmentAsync(const std::wstring& user_data_folder) {
+  auto result = Async<ComPtr<ICoreWebView2Environment>>::Create();
+  HRESULT hr = CreateCoreWebView2EnvironmentWithOptions(
+      nullptr, user_data_folder.c_str(), nullptr,
+      Callback<ICoreWebView2CreateCoreWebView2EnvironmentCompletedHandler>(
+          [result](HRESULT error, ICoreWebView2Environment* environment) -> HRESULT {
+            result.Resolve(error, ComPtr<ICoreWebView2Environment>(environment));
+            return S_OK;
+          }).Get());
+  if (FAILED(hr)) {
+    result.Resolve(hr, nullptr);
+  }
+  return result;
+}
+
+Async<ComPtr<ICoreWebView2Controller>> CreateControllerAsync(ICoreWebView2Environment* environment,
+                                                            HWND parent) {
+  auto result = Async<ComPtr<ICoreWebView2Controller>>::Create();
+  HRESULT hr = environment->CreateCoreWebView2Controller(
+      parent,
+      Callback<ICoreWebView2CreateCoreWebView2ControllerCompletedHandler>(
+          [result](HRESULT error, ICoreWebView2Controller* controller) -> HRESULT {
+            result.Resolve(error, ComPtr<ICoreWebView2Controller>(controller));
+            return S_OK;
+          }).Get());
+  if (FAILED(hr)) {
+    result.Resolve(hr, nullptr);
+  }
+  return result;
+}
+
+Async<bool> NavigateAsync(ICoreWebView2* webview, const std::wstring& url,
+                          const CancellationToken& token) {
+  auto result = Async<bool>::Create();
+
+  // Shared by both handlers; they reach the WebView through sender, so
+  // holding it here would keep it alive through its own handlers
+  struct Pending {
+    NavigationMatcher matcher;
+    EventRegistrationToken starting = {};
+    EventRegistrationToken completed = {};
+  };
+  auto pending = std::make_shared<Pending>();
+  auto finish = [result, pending](ICoreWebView2* sender, AsyncStatus status, bool success) {
+    sender->remove_NavigationStarting(pending->starting);
+    sender->remove_NavigationCompleted(pending->completed);
+    result.Resolve(status, success);
+  };
+
+  HRESULT hr = webview->add_NavigationStarting(
+      Callback<ICoreWebView2NavigationStartingEventHandler>(
+          [token, pending, finish](ICoreWebView2* sender,
+                                   ICoreWebView2NavigationStartingEventArgs* args) -> HRESULT {
+            if (token.cancelled()) {
+              finish(sender, E_ABORT, false);
+              return S_OK;
+            }
+            UINT64 id = 0;
+            if (SUCCEEDED(args->get_NavigationId(&id))) pending->matcher.OnStarting(id);
+            return S_OK;
+          }).Get(),
+      &pending->starting);
+  if (SUCCEEDED(hr)) {
+    hr = webview->add_NavigationCompleted(
+        Callback<ICoreWebView2NavigationCompletedEventHandler>(
+            [token, pending, finish](ICoreWebView2* sender,
+                                     ICoreWebView2NavigationCompletedEventArgs* args) -> HRESULT {
+              if (token.cancelled()) {
+                finish(sender, E_ABORT, false);
+                return S_OK;
+              }
+              UINT64 id = 0;
+              if (FAILED(args->get_NavigationId(&id)) || !pending->matcher.IsOurs(id)) return S_OK;
+              BOOL success = FALSE;
+              args->get_IsSuccess(&success);
+              finish(sender, S_OK, success != FALSE);
+              return S_OK;
+            }).Get(),
+        &pending->completed);
+    if (FAILED(hr)) webview->remove_NavigationStarting(pending->starting);
+  }
+  if (SUCCEEDED(hr)) {
+    hr = webview->Navigate(url.c_str());
+    if (FAILED(hr)) {
+      webview->remove_NavigationStarting(pending->starting);
+      webview->remove_NavigationCompleted(pending->completed);
+    }
+  }
+  if (FAILED(hr)) {
+    result.Resolve(hr, false);
+  }
+  return result;
+}
+
+Async<bool> ExecuteScriptAsync(ICoreWebView2* webview, const wchar_t* script) {
+  auto result = Async<bool>::Create();
+  HRESULT hr = webview->ExecuteScript(
+      script,
+      Callback<ICoreWebView2ExecuteScriptCompletedHandler>(
+          [result](HRESULT error, LPCWSTR) -> HRESULT {
+            result.Resolve(error, SUCCEEDED(error));
+            return S_OK;
+          }).Get());
+  if (FAILED(hr)) {
+    result.Resolve(hr, false);
+  }
+  return result;
+}
+
+}  // namespace hkcw_engine2
+
+#endif
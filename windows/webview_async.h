@@ -0,0 +1,166 @@
+#ifndef FLUTTER_PLUGIN_WEBVIEW_ASYNC_H_
+#define FLUTTER_PLUGIN_WEBVIEW_ASYNC_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wrl.h>
+#include <WebView2.h>
+#endif
+
+namespace hkcw_engine2 {
+
+using AsyncStatus = long;  // HRESULT
+
+// Cancellation: A token is checked when a result is delivered, so a
+// cancelled continuation never runs, however late the callback arrives
+class CancellationToken {
+ public:
+  CancellationToken() = default;  // Never cancelled
+
+  bool cancelled() const { return state_ && *state_; }
+
+ private:
+  friend class CancellationSource;
+  explicit CancellationToken(std::shared_ptr<const bool> state) : state_(std::move(state)) {}
+
+  std::shared_ptr<const bool> state_;
+};
+
+class CancellationSource {
+ public:
+  CancellationSource() : state_(std::make_shared<bool>(false)) {}
+
+  CancellationToken token() const { return CancellationToken(state_); }
+  // Cancels every token handed out so far; later tokens start fresh
+  void Cancel() {
+    *state_ = true;
+    state_ = std::make_shared<bool>(false);
+  }
+
+ private:
+  std::shared_ptr<bool> state_;
+};
+
+// Async: One result (status + value) delivered once, on the thread that
+// resolves it; for WebView2 that is always the UI thread. Continuations
+// added after resolution run at once. C++17 stand-in for an awaitable:
+// chain with Then instead of co_await.
+template <typename T>
+class Async {
+ public:
+  using Continuation = std::function<void(AsyncStatus status, const T& value)>;
+  // Runs instead of the continuation when its token was cancelled, e.g.
+  // to close a controller nobody wants any more
+  using CancelHandler = std::function<void(const T& value)>;
+
+  Async() = default;  // Invalid: Then and Resolve do nothing
+
+  static Async Create() {
+    Async async;
+    async.state_ = std::make_shared<State>();
+    return async;
+  }
+  static Async Resolved(AsyncStatus status, T value) {
+    Async async = Create();
+    async.Resolve(status, std::move(value));
+    return async;
+  }
+
+  bool valid() const { return state_ != nullptr; }
+  bool done() const { return state_ && state_->done; }
+  AsyncStatus status() const { return state_ ? state_->status : 0; }
+
+  void Resolve(AsyncStatus status, T value) {
+    std::shared_ptr<State> state = state_;  // A continuation may drop ours
+    if (!state || state->done) return;
+    state->done = true;
+    state->status = status;
+    state->value = std::move(value);
+    std::vector<Waiter> waiters = std::move(state->waiters);
+    state->waiters.clear();
+    for (Waiter& waiter : waiters) Deliver(*state, waiter);
+  }
+
+  void Then(const CancellationToken& token, Continuation continuation,
+            CancelHandler on_cancelled = nullptr) const {
+    std::shared_ptr<State> state = state_;
+    if (!state) return;
+    Waiter waiter{token, std::move(continuation), std::move(on_cancelled)};
+    if (state->done) {
+      Deliver(*state, waiter);
+    } else {
+      state->waiters.push_back(std::move(waiter));
+    }
+  }
+
+ private:
+  struct Waiter {
+    CancellationToken token;
+    Continuation continuation;
+    CancelHandler on_cancelled;
+  };
+
+  struct State {
+    bool done = false;
+    AsyncStatus status = 0;
+    T value{};
+    std::vector<Waiter> waiters;
+  };
+
+  static void Deliver(const State& state, const Waiter& waiter) {
+    if (waiter.token.cancelled()) {
+      if (waiter.on_cancelled) waiter.on_cancelled(state.value);
+    } else if (waiter.continuation) {
+      waiter.continuation(state.status, state.value);
+    }
+  }
+
+  std::shared_ptr<State> state_;
+};
+
+// Navigation: Pairs one Navigate call with its NavigationCompleted.
+// WebView2 only reports navigation ids in events, so the first
+// NavigationStarting after the handlers are registered (before Navigate
+// is called) names ours; completions of other navigations, such as a page
+// navigation ours cancelled, are ignored. Redirects keep the id.
+class NavigationMatcher {
+ public:
+  void OnStarting(uint64_t id) {
+    if (has_id_) return;
+    id_ = id;
+    has_id_ = true;
+  }
+  bool IsOurs(uint64_t id) const { return has_id_ && id == id_; }
+
+ private:
+  uint64_t id_ = 0;
+  bool has_id_ = false;
+};
+
+#ifdef _WIN32
+// WebView2 operations as Async results. Each resolves with the HRESULT of
+// the call if it fails to start, otherwise with the completion's.
+Async<Microsoft::WRL::ComPtr<ICoreWebView2Environment>> CreateEnvironmentAsync(
+    const std::wstring& user_data_folder);
+Async<Microsoft::WRL::ComPtr<ICoreWebView2Controller>> CreateControllerAsync(
+    ICoreWebView2Environment* environment, HWND parent);
+// Resolves with IsSuccess when the navigation it started completes, or
+// with E_ABORT at the next navigation event once token is cancelled; the
+// handlers are removed either way (or go with the WebView when it closes)
+Async<bool> NavigateAsync(ICoreWebView2* webview, const std::wstring& url,
+                          const CancellationToken& token);
+// Resolves once the script has run; its JSON result is not kept, no
+// caller reads it
+Async<bool> ExecuteScriptAsync(ICoreWebView2* webview, const wchar_t* script);
+#endif
+
+}  // namespace hkcw_engine2
+
+#endif  // FLUTTER_PLUGIN_WEBVIEW_ASYNC_H_